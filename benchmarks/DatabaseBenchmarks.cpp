@@ -0,0 +1,177 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "database/UserDatabase.h"
+#include "database/core/DatabaseUtils.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QSqlQuery>
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <memory>
+
+using namespace vm;
+
+namespace {
+//
+//  Chat size is fixed, so the select cost shows how lookups scale with the table size.
+//
+constexpr qint64 kMessagesPerChat = 100;
+
+constexpr qint64 kInsertBatchSize = 10000;
+
+qint64 messageCount(Database *database)
+{
+    auto query = database->createQuery();
+    if (!query.exec(QLatin1String("SELECT COUNT(*) FROM messages")) || !query.next()) {
+        return 0;
+    }
+    return query.value(0).toLongLong();
+}
+
+bool fillDatabase(Database *database, qint64 count)
+{
+    const auto createdAt = QDateTime::currentDateTime().toTime_t();
+    for (qint64 batchStart = 0; batchStart < count; batchStart += kInsertBatchSize) {
+        ScopedTransaction transaction(*database);
+        for (auto index = batchStart; index < std::min(count, batchStart + kInsertBatchSize); ++index) {
+            const auto chatId = QString("chat-%1").arg(index / kMessagesPerChat);
+            if (index % kMessagesPerChat == 0) {
+                const DatabaseUtils::BindValues chatValues { { ":id", chatId },
+                                                             { ":type", QLatin1String("personal") },
+                                                             { ":title", chatId },
+                                                             { ":createdAt", createdAt },
+                                                             { ":lastMessageId", QVariant() } };
+                if (!DatabaseUtils::readExecQuery(database, QLatin1String("insertChat"), chatValues)) {
+                    return transaction.rollback();
+                }
+            }
+
+            const bool isOutgoing = index % 2 == 0;
+            const DatabaseUtils::BindValues messageValues {
+                { ":id", QString("message-%1").arg(index) },
+                { ":recipientId", isOutgoing ? chatId : QLatin1String("benchmark") },
+                { ":senderId", isOutgoing ? QLatin1String("benchmark") : chatId },
+                { ":chatId", chatId },
+                { ":createdAt", createdAt + static_cast<uint>(index) },
+                { ":isOutgoing", isOutgoing },
+                { ":stage", isOutgoing ? QLatin1String("read") : QLatin1String("decrypted") },
+                { ":contentType", QLatin1String("text") },
+                { ":body", QString("Synthetic message #%1 with a text of a typical length").arg(index) },
+                { ":ciphertext", QByteArray() }
+            };
+            if (!DatabaseUtils::readExecQuery(database, QLatin1String("insertMessage"), messageValues)) {
+                return transaction.rollback();
+            }
+        }
+    }
+    return true;
+}
+
+//
+//  Synthetic databases are kept in the temporary directory between runs, since filling takes a while.
+//
+UserDatabase *syntheticDatabase(qint64 count)
+{
+    static std::map<qint64, std::unique_ptr<UserDatabase>> databases;
+    auto &database = databases[count];
+    if (database) {
+        return database.get();
+    }
+
+    const QDir databaseDir(QDir::temp().filePath(QString("messenger-benchmarks/messages-%1").arg(count)));
+    databaseDir.mkpath(QLatin1String("."));
+
+    database = std::make_unique<UserDatabase>(databaseDir, nullptr);
+    emit database->openUser(QLatin1String("benchmark"));
+
+    ScopedConnection connection(*database);
+    const auto existingCount = messageCount(database.get());
+    if (existingCount > 0 && existingCount != count) {
+        qFatal("Remove outdated synthetic database: %s", qPrintable(databaseDir.path()));
+    }
+    if (existingCount == 0 && !fillDatabase(database.get(), count)) {
+        qFatal("Failed to fill synthetic database: %s", qPrintable(databaseDir.path()));
+    }
+    return database.get();
+}
+
+QString chatIdForIteration(qint64 count, qint64 iteration)
+{
+    const auto chatCount = std::max<qint64>(1, count / kMessagesPerChat);
+    return QString("chat-%1").arg((iteration * 7919) % chatCount);
+}
+
+void BM_ReadExecQuery_SelectChatMessages(benchmark::State &state)
+{
+    const auto count = state.range(0);
+    auto database = syntheticDatabase(count);
+    ScopedConnection connection(*database);
+
+    qint64 iteration = 0;
+    for (auto _ : state) {
+        const DatabaseUtils::BindValues values { { ":chatId", chatIdForIteration(count, iteration++) } };
+        auto query = DatabaseUtils::readExecQuery(database, QLatin1String("selectChatMessages"), values);
+        benchmark::DoNotOptimize(query && query->next());
+    }
+}
+
+void BM_ReadMessage_ChatMessages(benchmark::State &state)
+{
+    const auto count = state.range(0);
+    auto database = syntheticDatabase(count);
+    ScopedConnection connection(*database);
+
+    qint64 iteration = 0;
+    qint64 readCount = 0;
+    for (auto _ : state) {
+        const DatabaseUtils::BindValues values { { ":chatId", chatIdForIteration(count, iteration++) } };
+        auto query = DatabaseUtils::readExecQuery(database, QLatin1String("selectChatMessages"), values);
+        while (query && query->next()) {
+            benchmark::DoNotOptimize(DatabaseUtils::readMessage(*query));
+            ++readCount;
+        }
+    }
+    state.SetItemsProcessed(readCount);
+}
+} // namespace
+
+//
+//  Filling of the database with 10M messages takes a while and a few gigabytes, skip it with --benchmark_filter.
+//
+BENCHMARK(BM_ReadExecQuery_SelectChatMessages)->RangeMultiplier(10)->Range(10000, 10000000);
+BENCHMARK(BM_ReadMessage_ChatMessages)->RangeMultiplier(10)->Range(10000, 10000000);
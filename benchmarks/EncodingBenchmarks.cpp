@@ -0,0 +1,123 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "BenchmarkUtils.h"
+#include "EncodingUtils.h"
+#include "FileUtils.h"
+
+#include <QTemporaryFile>
+
+#include <benchmark/benchmark.h>
+
+using namespace vm;
+
+using BenchmarkUtils::randomBytes;
+
+namespace {
+void BM_ToBase64_Qt(benchmark::State &state)
+{
+    const auto data = randomBytes(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(data.toBase64());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ToBase64_EncodingUtils(benchmark::State &state)
+{
+    const auto data = randomBytes(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(EncodingUtils::toBase64(data));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_FromBase64_Qt(benchmark::State &state)
+{
+    const auto base64 = randomBytes(state.range(0)).toBase64();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(QByteArray::fromBase64Encoding(base64));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_FromBase64_EncodingUtils(benchmark::State &state)
+{
+    const auto base64 = randomBytes(state.range(0)).toBase64();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(EncodingUtils::fromBase64(base64));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ToHex_Qt(benchmark::State &state)
+{
+    const auto data = randomBytes(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(data.toHex());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ToHex_EncodingUtils(benchmark::State &state)
+{
+    const auto data = randomBytes(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(EncodingUtils::toHex(data));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_CalculateFingerprint(benchmark::State &state)
+{
+    QTemporaryFile file;
+    if (!file.open() || file.write(randomBytes(state.range(0))) != state.range(0) || !file.flush()) {
+        state.SkipWithError("Can not write temporary file");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(FileUtils::calculateFingerprint(file.fileName()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+} // namespace
+
+BENCHMARK(BM_ToBase64_Qt)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_ToBase64_EncodingUtils)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_FromBase64_Qt)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_FromBase64_EncodingUtils)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_ToHex_Qt)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_ToHex_EncodingUtils)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_CalculateFingerprint)->RangeMultiplier(16)->Range(4 * 1024, 64 * 1024 * 1024);
@@ -0,0 +1,148 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "Utils.h"
+
+#include <QDir>
+#include <QImageReader>
+#include <QPainter>
+#include <QRandomGenerator>
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+
+using namespace vm;
+
+namespace {
+//
+//  Same as Settings::thumbnailMaxSize().
+//
+const QSize kThumbnailMaxSize(100, 80);
+
+//
+//  Return path to a photo-like JPEG image with the given width and 4:3 aspect ratio.
+//  Gradient with noise is used, so the encoder can't take shortcuts on a flat image.
+//
+QString sampleImagePath(int width)
+{
+    static std::map<int, QString> paths;
+    auto &path = paths[width];
+    if (!path.isEmpty()) {
+        return path;
+    }
+
+    const QDir imagesDir(QDir::temp().filePath(QLatin1String("messenger-benchmarks/images")));
+    imagesDir.mkpath(QLatin1String("."));
+    path = imagesDir.filePath(QString("sample-%1.jpg").arg(width));
+    if (QFile::exists(path)) {
+        return path;
+    }
+
+    QImage image(width, width * 3 / 4, QImage::Format_RGB32);
+    QPainter painter(&image);
+    QLinearGradient gradient(0, 0, image.width(), image.height());
+    gradient.setColorAt(0, Qt::darkBlue);
+    gradient.setColorAt(0.5, Qt::darkGreen);
+    gradient.setColorAt(1, Qt::yellow);
+    painter.fillRect(image.rect(), gradient);
+    painter.end();
+
+    QRandomGenerator generator(static_cast<quint32>(width));
+    for (int y = 0; y < image.height(); ++y) {
+        auto line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            const int noise = generator.bounded(-16, 16);
+            line[x] = qRgb(qBound(0, qRed(line[x]) + noise, 255), qBound(0, qGreen(line[x]) + noise, 255),
+                           qBound(0, qBlue(line[x]) + noise, 255));
+        }
+    }
+
+    if (!image.save(path, "JPEG", 90)) {
+        qFatal("Can not save sample image: %s", qPrintable(path));
+    }
+    return path;
+}
+
+void BM_ReadImage(benchmark::State &state)
+{
+    const auto path = sampleImagePath(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        QImageReader reader(path);
+        QImage image;
+        benchmark::DoNotOptimize(Utils::readImage(&reader, &image));
+    }
+}
+
+//
+//  Same steps as CreateThumbnailOperation does: read, apply orientation, scale and save.
+//
+void BM_CreateThumbnail(benchmark::State &state)
+{
+    const auto path = sampleImagePath(static_cast<int>(state.range(0)));
+    const auto thumbnailPath = QDir::temp().filePath(QLatin1String("messenger-benchmarks/images/thumbnail.png"));
+    for (auto _ : state) {
+        QImageReader reader(path);
+        QImage source;
+        if (!Utils::readImage(&reader, &source)) {
+            state.SkipWithError("Can not read sample image");
+            return;
+        }
+        const auto image = Utils::applyOrientation(source, reader.transformation());
+        const auto size = Utils::calculateThumbnailSize(image.size(), kThumbnailMaxSize);
+        const auto thumbnail =
+                image.scaled(size.width(), size.height(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        benchmark::DoNotOptimize(thumbnail.save(thumbnailPath));
+    }
+}
+
+void BM_ScaleThumbnail(benchmark::State &state)
+{
+    QImageReader reader(sampleImagePath(static_cast<int>(state.range(0))));
+    QImage image;
+    if (!Utils::readImage(&reader, &image)) {
+        state.SkipWithError("Can not read sample image");
+        return;
+    }
+    const auto size = Utils::calculateThumbnailSize(image.size(), kThumbnailMaxSize);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+                image.scaled(size.width(), size.height(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    }
+}
+} // namespace
+
+BENCHMARK(BM_ReadImage)->Arg(1024)->Arg(2048)->Arg(4032)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CreateThumbnail)->Arg(1024)->Arg(2048)->Arg(4032)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ScaleThumbnail)->Arg(1024)->Arg(2048)->Arg(4032)->Unit(benchmark::kMillisecond);
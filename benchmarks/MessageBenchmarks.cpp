@@ -0,0 +1,193 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "BenchmarkUtils.h"
+#include "EncodingUtils.h"
+#include "MessageContentFile.h"
+#include "MessageContentJsonUtils.h"
+#include "MessageContentText.h"
+#include "MessagePacking.h"
+#include "OutgoingMessage.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace vm;
+
+using BenchmarkUtils::randomBytes;
+
+namespace {
+//
+//  Compression threshold of the compact envelope, matches the default setting.
+//
+constexpr int kCompressionThreshold = 1024;
+
+MessageContent textContent(qint64 size)
+{
+    return MessageContentText(QString(static_cast<int>(size), QLatin1Char('a')));
+}
+
+MessageContent fileContent()
+{
+    MessageContentFile file;
+    file.setId(AttachmentId(QLatin1String("2f4bb2ad-25c8-4e42-9b53-cd5b2c3ec37b")));
+    file.setFileName(QLatin1String("report.pdf"));
+    file.setFingerprint(QString::fromLatin1(EncodingUtils::toHex(randomBytes(32))));
+    file.setDecryptionKey(randomBytes(188));
+    file.setSignature(randomBytes(64));
+    file.setSize(1024 * 1024);
+    file.setEncryptedSize(1024 * 1024 + 16);
+    file.setRemoteUrl(QUrl(QLatin1String("https://upload.example.com/slot/2f4bb2ad/report.pdf")));
+    return file;
+}
+
+OutgoingMessage textMessage(qint64 size)
+{
+    OutgoingMessage message;
+    message.setCreatedAt(QDateTime::fromTime_t(1600000000));
+    message.setSenderUsername(QLatin1String("alice"));
+    message.setRecipientUsername(QLatin1String("bob"));
+    message.setContent(textContent(size));
+    return message;
+}
+
+void packMessage(benchmark::State &state, bool isCompactEnvelope)
+{
+    const auto message = textMessage(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MessagePacking::packMessage(message, isCompactEnvelope, kCompressionThreshold));
+    }
+    state.counters["bytes"] = MessagePacking::packMessage(message, isCompactEnvelope, kCompressionThreshold).size();
+}
+
+void unpackMessage(benchmark::State &state, bool isCompactEnvelope)
+{
+    auto message = textMessage(state.range(0));
+    const auto data = MessagePacking::packMessage(message, isCompactEnvelope, kCompressionThreshold);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MessagePacking::unpackMessage(data, message));
+    }
+}
+
+void packXmppMessageBody(benchmark::State &state, bool isCompactEnvelope)
+{
+    const auto ciphertext = randomBytes(state.range(0));
+    const auto pushType = MessagePacking::PushType::Alert;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MessagePacking::packXmppMessageBody(ciphertext, pushType, isCompactEnvelope));
+    }
+    state.counters["bytes"] = MessagePacking::packXmppMessageBody(ciphertext, pushType, isCompactEnvelope).size();
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void unpackXmppMessageBody(benchmark::State &state, bool isCompactEnvelope)
+{
+    const auto body = QString::fromLatin1(MessagePacking::packXmppMessageBody(
+            randomBytes(state.range(0)), MessagePacking::PushType::Alert, isCompactEnvelope));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MessagePacking::unpackXmppMessageBody(body));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_PackMessage_Json(benchmark::State &state)
+{
+    packMessage(state, false);
+}
+
+void BM_PackMessage_Envelope(benchmark::State &state)
+{
+    packMessage(state, true);
+}
+
+void BM_UnpackMessage_Json(benchmark::State &state)
+{
+    unpackMessage(state, false);
+}
+
+void BM_UnpackMessage_Envelope(benchmark::State &state)
+{
+    unpackMessage(state, true);
+}
+
+void BM_PackXmppMessageBody_Json(benchmark::State &state)
+{
+    packXmppMessageBody(state, false);
+}
+
+void BM_PackXmppMessageBody_Envelope(benchmark::State &state)
+{
+    packXmppMessageBody(state, true);
+}
+
+void BM_UnpackXmppMessageBody_Json(benchmark::State &state)
+{
+    unpackXmppMessageBody(state, false);
+}
+
+void BM_UnpackXmppMessageBody_Envelope(benchmark::State &state)
+{
+    unpackXmppMessageBody(state, true);
+}
+
+void BM_MessageContentJson_FileRoundTrip(benchmark::State &state)
+{
+    const auto content = fileContent();
+    QString errorString;
+    for (auto _ : state) {
+        const auto bytes = MessageContentJsonUtils::toBytes(content);
+        benchmark::DoNotOptimize(MessageContentJsonUtils::fromBytes(bytes, errorString));
+    }
+}
+
+void BM_MessageContentJson_TextRoundTrip(benchmark::State &state)
+{
+    const auto content = textContent(state.range(0));
+    QString errorString;
+    for (auto _ : state) {
+        const auto bytes = MessageContentJsonUtils::toBytes(content);
+        benchmark::DoNotOptimize(MessageContentJsonUtils::fromBytes(bytes, errorString));
+    }
+}
+} // namespace
+
+BENCHMARK(BM_PackMessage_Json)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_PackMessage_Envelope)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_UnpackMessage_Json)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_UnpackMessage_Envelope)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_PackXmppMessageBody_Json)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_PackXmppMessageBody_Envelope)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_UnpackXmppMessageBody_Json)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_UnpackXmppMessageBody_Envelope)->RangeMultiplier(8)->Range(64, 64 * 1024);
+BENCHMARK(BM_MessageContentJson_FileRoundTrip);
+BENCHMARK(BM_MessageContentJson_TextRoundTrip)->RangeMultiplier(8)->Range(64, 64 * 1024);
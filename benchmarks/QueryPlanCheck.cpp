@@ -0,0 +1,192 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "database/UserDatabase.h"
+#include "FileUtils.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <map>
+
+using namespace vm;
+
+namespace {
+//
+//  Expectations to the plans of queries that run on every chat open, chat list load and reconnect.
+//  Plans of other queries are printed only.
+//
+struct PlanExpectation
+{
+    QStringList allowedScans;
+    bool isTempBTreeAllowed = false;
+};
+
+const std::map<QString, PlanExpectation> &hotQueries()
+{
+    static const std::map<QString, PlanExpectation> queries {
+        { QLatin1String("selectChatMessages"), {} },
+        //
+        //  All chats are loaded at once, so chats are scanned by design.
+        //
+        { QLatin1String("selectChats"), { { QLatin1String("chats"), QLatin1String("notReadMessages") } } },
+        //
+        //  Only messages that are not sent yet are sorted, there are a few of them.
+        //
+        { QLatin1String("selectNotSentMessages"), { {}, true } },
+        { QLatin1String("selectUnreadMessageCount"), {} },
+        { QLatin1String("selectLastUnreadMessage"), {} },
+        { QLatin1String("selectCloudFolderFiles"), {} },
+    };
+    return queries;
+}
+
+std::optional<QStringList> explainQueryPlan(const Database &database, const QString &queryText)
+{
+    auto query = database.createQuery();
+    if (!query.prepare(QLatin1String("EXPLAIN QUERY PLAN ") + queryText)) {
+        return {};
+    }
+    //
+    //  Plan does not depend on values, since the messenger does not collect statistics with ANALYZE.
+    //
+    const auto boundValues = query.boundValues();
+    for (auto it = boundValues.cbegin(); it != boundValues.cend(); ++it) {
+        query.bindValue(it.key(), QString());
+    }
+    if (!query.exec()) {
+        return {};
+    }
+
+    QStringList details;
+    while (query.next()) {
+        details << query.value(QLatin1String("detail")).toString();
+    }
+    return details;
+}
+
+QStringList checkQueryPlan(const QStringList &details, const PlanExpectation &expectation)
+{
+    //
+    //  SQLite before 3.36 prints "SCAN TABLE name", later versions print "SCAN name".
+    //
+    static const QRegularExpression fullScanRegExp(QLatin1String("^SCAN (?:TABLE )?(\\w+)(?!.*\\bINDEX\\b)"));
+
+    QStringList violations;
+    for (auto &detail : details) {
+        const auto match = fullScanRegExp.match(detail);
+        if (match.hasMatch() && !expectation.allowedScans.contains(match.captured(1))) {
+            violations << QString("full scan of %1").arg(match.captured(1));
+        }
+        if (detail.startsWith(QLatin1String("USE TEMP B-TREE")) && !expectation.isTempBTreeAllowed) {
+            violations << detail.toLower();
+        }
+    }
+    return violations;
+}
+} // namespace
+
+//
+//  Print plans of all select queries and fail if a hot query falls back to a full scan or to a sort without index.
+//  Run it after every change of SQL queries or database patches.
+//
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QLatin1String("messenger-query-plans"));
+    QLoggingCategory::setFilterRules(QLatin1String("*.debug=false\n*.info=false"));
+
+    QTextStream out(stdout);
+    QTemporaryDir databaseDir;
+    if (!databaseDir.isValid()) {
+        out << "Failed to create temporary database directory" << "\n";
+        return 1;
+    }
+
+    //
+    //  Fresh database runs all patches, so plans use the same indexes as a migrated one.
+    //
+    UserDatabase database(QDir(databaseDir.path()), nullptr);
+    emit database.openUser(QLatin1String("query-plans"));
+    ScopedConnection connection(database);
+
+    const QDir queriesDir(QLatin1String(":/resources/database"));
+    const auto queryFileNames = queriesDir.entryList({ QLatin1String("select*.sql") }, QDir::Files, QDir::Name);
+
+    int failedCount = 0;
+    for (auto &queryFileName : queryFileNames) {
+        const auto queryId = QFileInfo(queryFileName).completeBaseName();
+        const auto queryText = FileUtils::readTextFile(queriesDir.filePath(queryFileName));
+        const auto details = queryText ? explainQueryPlan(database, queryText->section(QLatin1Char(';'), 0, 0))
+                                       : std::nullopt;
+        if (!details) {
+            out << "FAIL " << queryId << ": query can not be explained" << "\n";
+            ++failedCount;
+            continue;
+        }
+
+        QStringList violations;
+        const auto hotQuery = hotQueries().find(queryId);
+        if (hotQuery != hotQueries().end()) {
+            violations = checkQueryPlan(*details, hotQuery->second);
+        }
+
+        out << (violations.isEmpty() ? "OK   " : "FAIL ") << queryId << "\n";
+        for (auto &detail : *details) {
+            out << "        " << detail << "\n";
+        }
+        for (auto &violation : violations) {
+            out << "    ! " << violation << "\n";
+        }
+        failedCount += violations.isEmpty() ? 0 : 1;
+    }
+
+    for (auto &hotQuery : hotQueries()) {
+        if (!queryFileNames.contains(hotQuery.first + QLatin1String(".sql"))) {
+            out << "FAIL " << hotQuery.first << ": query is not found" << "\n";
+            ++failedCount;
+        }
+    }
+
+    out << queryFileNames.size() << " queries, " << failedCount << " failed" << "\n";
+    out.flush();
+    return failedCount == 0 ? 0 : 1;
+}
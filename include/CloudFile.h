@@ -77,6 +77,10 @@ public:
     void setFingerprint(const QString &fingerprint);
     CloudFsSharedGroupId sharedGroupId() const;
     void setSharedGroupId(const CloudFsSharedGroupId &sharedGroupId);
+    QDateTime listedUpdatedAt() const noexcept;
+    void setListedUpdatedAt(const QDateTime &dateTime);
+    QDateTime listedAt() const noexcept;
+    void setListedAt(const QDateTime &dateTime);
 
     bool isRoot() const;
     bool isShared() const;
@@ -98,6 +102,9 @@ private:
     QString m_localPath;
     QString m_fingerprint;
     CloudFsSharedGroupId m_sharedGroupId;
+    // Folder listing watermark, it's kept in the database only
+    QDateTime m_listedUpdatedAt;
+    QDateTime m_listedAt;
 };
 
 using CloudFileHandler = std::shared_ptr<const CloudFile>;
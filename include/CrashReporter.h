@@ -36,6 +36,7 @@
 #define VM_CRASH_REPORTER_H
 
 #include <QObject>
+#include <QThreadPool>
 
 #include "CoreMessenger.h"
 
@@ -65,13 +66,17 @@ signals:
     void reportSent(const QString &msg);
     void reportErrorOccurred(const QString &msg);
 
+    void logFilesCompressed(const QByteArray &activeSegmentData, QPrivateSignal);
+
 private:
     bool sendFileToBackendRequest(QByteArray fileData);
+    void postLogFiles(const QByteArray &activeSegmentData);
     void sendSendCrashReportReply(QNetworkReply *reply);
 
     Settings *m_settings;
     vm::CoreMessenger *m_coreMessenger;
     QNetworkAccessManager *m_networkManager;
+    QThreadPool m_compressionPool; // waits for compression in destructor
 
     static const QString s_endpointSendReport;
 };
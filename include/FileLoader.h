@@ -36,15 +36,25 @@
 #define VM_FILELOADER_H
 
 #include "CoreMessenger.h"
+#include "TransferScheduler.h"
+#include "UploadSlotBroker.h"
 
+#include <QElapsedTimer>
+#include <QFile>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QLoggingCategory>
 
+#include <array>
+#include <deque>
+#include <map>
+
 Q_DECLARE_LOGGING_CATEGORY(lcFileLoader);
 
 namespace vm {
 
+class Settings;
+
 class FileLoader : public QObject
 {
     Q_OBJECT
@@ -52,10 +62,33 @@ class FileLoader : public QObject
 public:
     using ConnectionSetup = std::function<void(QNetworkReply *)>;
 
-    FileLoader(CoreMessenger *client, QObject *parent);
+    enum class TransferDirection { Upload, Download };
+
+    //
+    //  Timing of a single transfer in milliseconds measured from the moment it was started.
+    //  Qt does not report DNS lookup and TCP connect separately, so they are included to the
+    //  secure connection time. Time is -1 when the stage was skipped, e.g. a connection was reused.
+    //
+    struct TransferTiming
+    {
+        QUrl url;
+        TransferDirection direction = TransferDirection::Download;
+        TransferPriority priority = TransferPriority::Interactive;
+        qint64 bytes = 0;
+        qint64 queuedMs = 0;
+        qint64 encryptedMs = -1;
+        qint64 firstByteMs = -1;
+        qint64 finishedMs = -1;
+        bool isHttp2 = false;
+        bool isSucceeded = false;
+    };
+
+    FileLoader(Settings *settings, CoreMessenger *coreMessenger, QObject *parent);
 
     bool isServiceFound() const;
 
+    UploadSlotBroker::Stats uploadSlotStats() const;
+
 signals:
     void uploadServiceFound(const bool found);
     void uploadSlotRequestFinished(const QString &requestId, const QString &slotId);
@@ -63,21 +96,64 @@ signals:
     void uploadSlotReceived(const QString &slotId, const QUrl &putUrl, const QUrl &getUrl);
     void uploadSlotErrorOccurred(const QString &slotId, const QString &errorText);
 
-    void startDownload(const QUrl &url, QFile *file, const ConnectionSetup &connectionSetup);
-    void startUpload(const QUrl &url, QFile *file, const ConnectionSetup &connectionSetup);
+    void transferFinished(const vm::FileLoader::TransferTiming &timing);
+
+    void startDownload(const QUrl &url, QFile *file, vm::TransferPriority priority,
+                       const ConnectionSetup &connectionSetup);
+    void startUpload(const QUrl &url, QFile *file, vm::TransferPriority priority,
+                     const ConnectionSetup &connectionSetup);
     void requestUploadSlot(const QString &requestId, const QString &filePath);
+    void prefetchUploadSlot(const QString &requestId, qint64 sourceFileSize);
+    void releaseUploadSlot(const QString &requestId);
 
 private:
+    struct Transfer
+    {
+        TransferDirection direction = TransferDirection::Download;
+        TransferPriority priority = TransferPriority::Interactive;
+        QUrl url;
+        QPointer<QFile> file;
+        ConnectionSetup connectionSetup;
+        QElapsedTimer queuedTimer;
+    };
+
+    struct HostPool
+    {
+        //
+        //  Active transfers per priority class.
+        //
+        std::array<int, 3> activeCounts = {};
+        std::deque<Transfer> pending;
+        QElapsedTimer warmedUpTimer;
+    };
+
     void onServiceFound(bool found);
-    void onStartDownload(const QUrl &url, QFile *file, const ConnectionSetup &connectionSetup);
-    void onStartUpload(const QUrl &url, QFile *file, const ConnectionSetup &connectionSetup);
+    void onStartDownload(const QUrl &url, QFile *file, TransferPriority priority,
+                         const ConnectionSetup &connectionSetup);
+    void onStartUpload(const QUrl &url, QFile *file, TransferPriority priority, const ConnectionSetup &connectionSetup);
     void onRequestUploadSlot(const QString &requestId, const QString &filePath);
+    void onUploadSlotReceived(const QString &slotId, const QUrl &putUrl, const QUrl &getUrl);
+    void onConnectionStateChanged(CoreMessenger::ConnectionState state);
+
+    void enqueueTransfer(Transfer transfer);
+    void dispatchTransfers(const QString &hostKey);
+    static int occupiedSlotCount(const HostPool &hostPool, TransferPriority priority);
+    void startTransfer(const QString &hostKey, Transfer transfer);
+    void warmUpConnection(const QUrl &url, bool force);
+    QNetworkRequest createRequest(const QUrl &url) const;
+    static QString hostKey(const QUrl &url);
 
+    QPointer<Settings> m_settings;
     QPointer<CoreMessenger> m_coreMessenger;
     QPointer<QNetworkAccessManager> m_networkAccessManager;
+    QPointer<UploadSlotBroker> m_uploadSlotBroker;
+    QPointer<TransferScheduler> m_transferScheduler;
+    std::map<QString, HostPool> m_hostPools;
 };
 } // namespace vm
 
 Q_DECLARE_METATYPE(vm::FileLoader::ConnectionSetup);
+Q_DECLARE_METATYPE(vm::FileLoader::TransferTiming);
+Q_DECLARE_METATYPE(vm::TransferPriority);
 
 #endif // VM_FILELOADER_H
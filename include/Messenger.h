@@ -71,23 +71,31 @@ public:
     //
     //  Return true if messenger has Internet connection with all services.
     //
-    bool isOnline() const noexcept;
+    virtual bool isOnline() const noexcept;
 
     //
     //  Messages.
     //
     virtual bool sendMessage(MessageHandler message) override;
 
+    //
+    //  Decrypt stored messages with an encrypted content that were received from the given sender.
+    //  Return updates for messages that were decrypted or appeared to be broken.
+    //  Return std::nullopt if the sender can not be resolved, so no message was tried.
+    //
+    std::optional<MessageUpdates> decryptStoredMessages(const UserId &senderId, const ModifiableMessages &messages);
+
     //
     //  Encrypt given file and returns a key for decryption.
     //
-    std::tuple<bool, QByteArray, QByteArray> encryptFile(const QString &sourceFilePath, const QString &destFilePath);
+    virtual std::tuple<bool, QByteArray, QByteArray> encryptFile(const QString &sourceFilePath,
+                                                                 const QString &destFilePath);
 
     //
     //  Decrypt given file and returns a key for decryption.
     //
-    bool decryptFile(const QString &sourceFilePath, const QString &destFilePath, const QByteArray &decryptionKey,
-                     const QByteArray &signature, const UserId senderId);
+    virtual bool decryptFile(const QString &sourceFilePath, const QString &destFilePath,
+                             const QByteArray &decryptionKey, const QByteArray &signature, const UserId senderId);
 
     //
     // User control.
@@ -222,6 +230,13 @@ signals:
     void sendMessageStatusDisplayed(const MessageHandler &message);
     // --
 
+protected:
+    //
+    //  Create messenger without Comm Kit that uses the given settings and file loader, i.e. within the load test.
+    //  Derived class must override functions that send messages, process files and report online status.
+    //
+    Messenger(Settings *settings, FileLoader *fileLoader, QObject *parent);
+
 private slots:
     void onConnectionStateChanged(CoreMessenger::ConnectionState state);
     void onMessageReceived(ModifiableMessageHandler message);
@@ -0,0 +1,75 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_METRICS_EXPORTER_H
+#define VM_METRICS_EXPORTER_H
+
+#include <QObject>
+#include <QTimer>
+
+class QTcpServer;
+
+namespace vm {
+class Settings;
+
+//
+//  Expose metrics registry snapshots: periodically dump them to the logs directory
+//  and optionally serve them in Prometheus text format on the localhost-only port.
+//  Database statement stats are served on the same port by the /statements path.
+//
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Self = MetricsExporter;
+
+    MetricsExporter(Settings *settings, QObject *parent);
+
+    //
+    //  Write current snapshot to the dump file.
+    //
+    bool dump();
+
+private:
+    void startServer(quint16 port);
+    void onNewConnection();
+
+    QString m_dumpFilePath;
+    QTimer m_dumpTimer;
+    QTcpServer *m_server = nullptr;
+};
+} // namespace vm
+
+#endif // VM_METRICS_EXPORTER_H
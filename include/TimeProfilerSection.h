@@ -35,6 +35,8 @@
 #ifndef VM_TIME_PROFILER_SECTION_H
 #define VM_TIME_PROFILER_SECTION_H
 
+#include "Tracer.h"
+
 #include <QString>
 
 namespace vm {
@@ -54,6 +56,7 @@ private:
     QString m_preffix;
     TimeProfiler *m_profiler = nullptr;
     qint64 m_initialElapsed = 0;
+    TraceSpan m_traceSpan;
 };
 } // namespace vm
 
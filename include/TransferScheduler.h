@@ -0,0 +1,122 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+
+#ifndef VM_TRANSFER_SCHEDULER_H
+#define VM_TRANSFER_SCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <array>
+#include <functional>
+#include <map>
+
+namespace vm {
+class MetricCounter;
+class MetricGauge;
+class Settings;
+
+//
+//  Transfer priority classes, from the highest to the lowest.
+//
+enum class TransferPriority { Interactive, Preload, Background };
+
+//
+//  Share bandwidth between file transfers.
+//  Every class of transfers is limited by its own token bucket and all of them by a global one.
+//  While transfers of a higher class are active, transfers of lower classes are paused.
+//  Lives in the FileLoader thread.
+//
+class TransferScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Self = TransferScheduler;
+    using ChannelId = quint64;
+    using ResumeFunc = std::function<void()>;
+
+    TransferScheduler(Settings *settings, QObject *parent);
+
+    //
+    //  Register an active transfer. Resume function is called when a throttled transfer may continue.
+    //
+    ChannelId openChannel(TransferPriority priority, ResumeFunc resume);
+
+    void closeChannel(ChannelId channelId);
+
+    //
+    //  Return number of bytes the transfer is allowed to process now, up to maxBytes.
+    //  Zero means the transfer is throttled or preempted and will be resumed later.
+    //
+    qint64 acquire(ChannelId channelId, qint64 maxBytes);
+
+private:
+    struct TokenBucket
+    {
+        qint64 rate = 0; // bytes per second, 0 means unlimited
+        qint64 tokens = 0;
+
+        bool isLimited() const noexcept;
+        qint64 capacity() const noexcept;
+        void refill(qint64 elapsedMs) noexcept;
+    };
+
+    struct Channel
+    {
+        TransferPriority priority = TransferPriority::Interactive;
+        ResumeFunc resume;
+        bool isStarved = false;
+    };
+
+    static constexpr size_t kPriorityCount = 3;
+
+    bool isPreempted(TransferPriority priority) const;
+    void onTick();
+
+    std::map<ChannelId, Channel> m_channels;
+    std::array<int, kPriorityCount> m_channelCounts = {};
+    std::array<TokenBucket, kPriorityCount> m_buckets;
+    TokenBucket m_globalBucket;
+    std::array<MetricCounter *, kPriorityCount> m_transferredBytes = {};
+    std::array<MetricGauge *, kPriorityCount> m_activeChannels = {};
+    ChannelId m_nextChannelId = 1;
+    QTimer m_tickTimer;
+    QElapsedTimer m_refillTimer;
+};
+} // namespace vm
+
+#endif // VM_TRANSFER_SCHEDULER_H
@@ -0,0 +1,142 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+
+#ifndef VM_UPLOAD_SLOT_BROKER_H
+#define VM_UPLOAD_SLOT_BROKER_H
+
+#include "CoreMessenger.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+
+namespace vm {
+//
+//  Request XEP-0363 upload slots ahead of time.
+//  A slot is bound to the maximum file size, so a slot for a queued upload is requested with the expected size
+//  of the encrypted file rounded up to a ceiling, and handed out to a file that does not exceed the slot size.
+//  Unclaimed slots expire on a timer, files without a matching slot request one on demand.
+//
+class UploadSlotBroker : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Self = UploadSlotBroker;
+
+    struct Stats
+    {
+        quint64 requestedCount = 0;
+        quint64 prefetchedCount = 0;
+        quint64 prefetchHitCount = 0;
+        quint64 expiredCount = 0;
+        std::chrono::milliseconds lastWaitTime{ 0 };
+        std::chrono::milliseconds totalWaitTime{ 0 };
+    };
+
+    UploadSlotBroker(CoreMessenger *coreMessenger, QObject *parent);
+
+    //
+    //  Request a slot for the upload that will start after the source file is encrypted.
+    //
+    void prefetch(const QString &requestId, qint64 sourceFileSize);
+
+    //
+    //  Assign a slot to the upload of the given file.
+    //
+    void acquire(const QString &requestId, const QString &filePath);
+
+    //
+    //  Forget the upload that was prefetched but will not be acquired.
+    //
+    void release(const QString &requestId);
+
+    //
+    //  Return slot statistics. Thread-safe.
+    //
+    Stats stats() const;
+
+signals:
+    void slotRequestFinished(const QString &requestId, const QString &slotId);
+    void slotRequestFailed(const QString &requestId);
+    void slotReceived(const QString &slotId, const QUrl &putUrl, const QUrl &getUrl);
+    void slotErrorOccurred(const QString &slotId, const QString &errorText);
+
+private:
+    struct Slot
+    {
+        qint64 fileSize = 0;
+        QString requestId;
+        QUrl putUrl;
+        QUrl getUrl;
+        bool isReceived = false;
+        QElapsedTimer age;
+        QElapsedTimer waitTimer;
+    };
+
+    using Slots = std::map<QString, Slot>;
+
+    struct PendingUpload
+    {
+        qint64 sourceFileSize = 0;
+        bool isSlotRequested = false;
+    };
+
+    void onSlotReceived(const QString &slotId, const QUrl &putUrl, const QUrl &getUrl);
+    void onSlotErrorOccurred(const QString &slotId, const QString &errorText);
+
+    void removeExpiredSlots();
+    Slots::iterator findFreeSlot(qint64 fileSize);
+    static qint64 slotSizeCeiling(qint64 fileSize);
+    void reportWaitTime(const QString &slotId, const Slot &slot);
+
+    QPointer<CoreMessenger> m_coreMessenger;
+    Slots m_slots;
+    std::map<QString, PendingUpload> m_pendingUploads;
+    qint64 m_encryptionOverhead = -1;
+    QTimer m_expirationTimer;
+
+    Stats m_stats;
+    mutable std::mutex m_statsMutex;
+};
+} // namespace vm
+
+#endif // VM_UPLOAD_SLOT_BROKER_H
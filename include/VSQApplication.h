@@ -47,6 +47,7 @@
 #include "UserDatabase.h"
 #include "Models.h"
 #include "ApplicationStateManager.h"
+#include "MetricsExporter.h"
 
 class QNetworkAccessManager;
 
@@ -99,6 +100,11 @@ private:
     void onApplicationStateChanged(Qt::ApplicationState state);
     void onAboutToQuit();
 
+    void onStartupUserLoaded();
+    void onStartupChatsLoaded();
+    void updateStartupTimeline();
+    void finishStartup(const QString &milestone);
+
     vm::ApplicationStateManager *stateManager();
 
     static const QString kVersion;
@@ -112,6 +118,7 @@ private:
     vm::Controllers m_controllers;
     vm::KeyboardEventFilter *m_keyboardEventFilter;
     vm::ApplicationStateManager m_applicationStateManager;
+    vm::MetricsExporter *m_metricsExporter;
 };
 
 } // namespace vm
@@ -94,7 +94,7 @@ signals:
 private:
     using FoldersHierarchy = ModifiableCloudFiles;
 
-    void switchToHierarchy(const FoldersHierarchy &hierarchy);
+    void switchToHierarchy(const FoldersHierarchy &hierarchy, bool forceOnline = false);
     void refreshIfOnline(bool isOnline);
 
     QString displayPath() const;
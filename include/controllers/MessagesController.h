@@ -35,6 +35,7 @@
 #ifndef VM_MESSAGESCONTROLLER_H
 #define VM_MESSAGESCONTROLLER_H
 
+#include "MessageMarkerAggregator.h"
 #include "Messenger.h"
 #include "Models.h"
 #include "Settings.h"
@@ -94,12 +95,15 @@ private:
 
     void onMessageReceived(ModifiableMessageHandler message);
     void onUpdateMessage(const MessageUpdate &messageUpdate);
+    void onReadMarkerReady(const MessageHandler &message);
+    void onMessagesDecrypted(const MessageUpdates &messageUpdates);
     void onPictureIconNotFound(const MessageId &messageId);
 
     QPointer<const Settings> m_settings;
     QPointer<Messenger> m_messenger;
     QPointer<Models> m_models;
     QPointer<UserDatabase> m_userDatabase;
+    MessageMarkerAggregator m_readMarkers;
 };
 } // namespace vm
 
@@ -57,6 +57,11 @@ class UsersController : public QObject
 public:
     UsersController(Messenger *messenger, Models *models, UserDatabase *userDatabase, QObject *parent);
 
+    //
+    //  Start sign-in of the last user and preparation of the user database before QML is loaded,
+    //  so they run concurrently with QML loading. The following initialSignIn() waits for them.
+    //
+    void startInitialSignIn();
     Q_INVOKABLE void initialSignIn();
 
 signals:
@@ -69,6 +74,9 @@ signals:
     void notificationCreated(const QString &notification, const bool error) const;
 
 private:
+    enum class InitialSignInState { NotStarted, Started, UserLoaded, UserNotLoaded };
+
+    QString initialUsername() const;
     QString currentUserId() const;
     QString currentUsername() const;
 
@@ -84,6 +92,7 @@ private:
 private:
     QPointer<Messenger> m_messenger;
     QPointer<UserDatabase> m_userDatabase;
+    InitialSignInState m_initialSignInState = InitialSignInState::NotStarted;
 #if VS_ANDROID
     bool m_splashScreenVisible = true;
 #endif
@@ -40,6 +40,8 @@
 
 #include <QDateTime>
 
+#include <optional>
+
 namespace vm {
 class ChatsTable : public DatabaseTable
 {
@@ -53,6 +55,10 @@ signals:
     //  Control signals.
     //--
     void fetch();
+    //
+    //  Read chats ahead of time, so the next fetch is served from memory if data was not changed since.
+    //
+    void prefetch();
     void addChat(const ChatHandler &chat);
     void deleteChat(const ChatId &chatId);
     void requestChatUnreadMessageCount(const ChatId &chatId);
@@ -77,7 +83,10 @@ signals:
 private:
     bool create() override;
 
+    std::optional<ModifiableChats> readChats();
+
     void onFetch();
+    void onPrefetch();
     void onAddChat(const ChatHandler &chat);
     void onDeleteChat(const ChatId &chatId);
     void onResetUnreadCount(const ChatHandler &chat);
@@ -86,6 +95,10 @@ private:
     void onRequestChatUnreadMessageCount(const ChatId &chatId);
     void onMarkMessagesAsRead(const ChatHandler &chat);
     void onMarkMessagesAsReadBeforeDate(const ChatHandler &chat, const QDateTime &beforeDate);
+
+private:
+    std::optional<ModifiableChats> m_prefetchedChats;
+    quint64 m_prefetchWriteCount = 0;
 };
 } // namespace vm
 
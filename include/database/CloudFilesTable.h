@@ -63,6 +63,8 @@ private:
     bool createFile(const CloudFileHandler &cloudFile);
     bool updateFiles(const CloudFiles &cloudFiles, CloudFileUpdateSource source);
     bool updateFile(const CloudFileHandler &cloudFile, CloudFileUpdateSource source);
+    bool updateFolderListing(const CloudFileHandler &cloudFolder);
+    CloudFileHandler readFolderListing(const CloudFileHandler &cloudFolder);
     bool updateDownloadedFile(const DownloadCloudFileUpdate &update);
     bool deleteFiles(const CloudFiles &cloudFiles);
 
@@ -56,6 +56,7 @@ signals:
     //
     void fetchChatMessages(const ChatId &chatId);
     void fetchNotSentMessages();
+    void fetchEncryptedMessages();
     void addMessage(const MessageHandler &message);
     void deleteChatMessages(const ChatId &chatId);
 
@@ -69,6 +70,7 @@ signals:
     void errorOccurred(const QString &errorText);
     void chatMessagesFetched(ModifiableMessages messages);
     void notSentMessagesFetched(ModifiableMessages messages);
+    void encryptedMessagesFetched(ModifiableMessages messages);
     void messageAdded(const MessageHandler &message);
     void chatUnreadMessageCountChanged(const ChatId &chatId);
 
@@ -77,6 +79,7 @@ private:
 
     void onFetchChatMessages(const ChatId &chatId);
     void onFetchNotSentMessages();
+    void onFetchEncryptedMessages();
     void onAddMessage(const MessageHandler &message);
     void onDeleteChatMessages(const ChatId &chatId);
 
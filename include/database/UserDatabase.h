@@ -81,11 +81,21 @@ public:
     const MessagesTable *messagesTable() const;
     MessagesTable *messagesTable();
 
+    //
+    //  Post a timestamped no-op to the database thread and report its wait time as the queue backlog.
+    //  The wait covers signals of all tables, so call it periodically from another thread.
+    //
+    void probeQueue();
+
 signals:
     //
     //  Control signals.
     //
     void openUser(const QString &username);
+    //
+    //  Open, migrate and prefetch chats of the user ahead of sign-in, the next openUser() reuses it.
+    //
+    void prepareUser(const QString &username);
     void closeUser();
 
     void userOpened(const QString &username);
@@ -93,19 +103,27 @@ signals:
 
     void writeMessage(const MessageHandler &message);
     void updateMessage(const MessageUpdate &messageUpdate);
+    void updateMessages(const MessageUpdates &messageUpdates);
     void writeChatAndLastMessage(const ChatHandler &chat);
     void writeGroupChat(const ChatHandler &chat, const GroupHandler &group, const GroupMembers &groupMembers);
     void deleteNewGroupChat(const ChatId &chatId);
 
     void updateGroup(const GroupUpdate &groupUpdate);
 
+    void queueProbePosted(qint64 postedAtMicroseconds, QPrivateSignal);
+
 private:
     bool create() override;
+
+    void onQueueProbePosted(qint64 postedAtMicroseconds);
+
     void onOpenUser(const QString &username);
+    void onPrepareUser(const QString &username);
     void onCloseUser();
 
     void onWriteMessage(const MessageHandler &message);
     void onUpdateMessage(const MessageUpdate &messageUpdate);
+    void onUpdateMessages(const MessageUpdates &messageUpdates);
     void onWriteChatAndLastMessage(const ChatHandler &chat);
     void onWriteGroupChat(const ChatHandler &chat, const GroupHandler &group, const GroupMembers &groupMembers);
     void onDeleteNewGroupChat(const ChatId &chatId);
@@ -113,6 +131,7 @@ private:
     void onUpdateGroup(const GroupUpdate &groupUpdate);
 
     const QDir m_databaseDir;
+    QString m_preparedUsername;
 };
 } // namespace vm
 
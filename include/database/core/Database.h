@@ -60,6 +60,10 @@ public:
     virtual ~Database();
 
     bool open(const QString &databaseFileName, const QString &connectionName);
+    //
+    //  Open and migrate database without notification, so it can be done ahead of time.
+    //
+    bool prepare(const QString &databaseFileName, const QString &connectionName);
     void close();
     QSqlQuery createQuery() const;
 
@@ -78,6 +82,12 @@ public:
     //
     qsizetype rowsChangedCount() const;
 
+    //
+    //  Number of statements that changed data since the database was prepared, so caches can detect staleness.
+    //
+    quint64 writeCount() const;
+    void incrementWriteCount();
+
     operator QSqlDatabase() const;
 
 signals:
@@ -98,6 +108,7 @@ private:
     std::unique_ptr<Migration> m_migration;
     QSqlDatabase m_qtDatabase;
     Tables m_tables;
+    quint64 m_writeCount = 0;
 };
 } // namespace vm
 
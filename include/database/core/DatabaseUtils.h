@@ -62,10 +62,12 @@ public:
 
     static ModifiableMessageHandler readMessage(const QSqlQuery &query, const QString &idColumn = {});
     static ModifiableCloudFileHandler readCloudFile(const QSqlQuery &query);
+    static void readCloudFolderListing(const QSqlQuery &query, CloudFile &cloudFolder);
 
     static BindValues createNewCloudFileBindings(const CloudFileHandler &cloudFile);
     static BindValues createUpdatedCloudFileBindings(const CloudFileHandler &cloudFile, CloudFileUpdateSource source);
     static BindValues createDownloadedCloudFileBindings(const CloudFileHandler &cloudFile, const QString &fingerprint);
+    static BindValues createCloudFolderListingBindings(const CloudFileHandler &cloudFolder);
 
 private:
     static bool readMessageContentAttachment(const QSqlQuery &query, MessageContentAttachment &attachment);
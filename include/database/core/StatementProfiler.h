@@ -0,0 +1,136 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_STATEMENT_PROFILER_H
+#define VM_STATEMENT_PROFILER_H
+
+#include "Metrics.h"
+
+#include <QMutex>
+#include <QString>
+#include <QVariant>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace vm {
+//
+//  Opt-in profiling of SQL statements keyed by query id. Prepare, exec and row iteration are timed apart,
+//  statements that are slower than the threshold are logged with redacted bind values.
+//
+//  Wait time of the database thread queues is tracked always, since it is probed once in a while.
+//
+class StatementProfiler
+{
+public:
+    using BindValue = std::pair<QString, QVariant>;
+    using BindValues = std::vector<BindValue>;
+
+    struct Sample
+    {
+        std::chrono::microseconds prepareDuration = {};
+        std::chrono::microseconds execDuration = {};
+        std::chrono::microseconds fetchDuration = {};
+        //
+        //  Number of fetched rows, negative for statements that do not return rows.
+        //
+        qint64 rowCount = -1;
+
+        std::chrono::microseconds totalDuration() const { return prepareDuration + execDuration + fetchDuration; }
+    };
+
+    static StatementProfiler *instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    void setSlowThreshold(std::chrono::milliseconds threshold);
+    std::chrono::milliseconds slowThreshold() const;
+
+    void record(const QString &queryId, const Sample &sample, const BindValues &values = {});
+
+    //
+    //  Track time the latest probe waited for processing within the database thread.
+    //
+    void setQueueWait(const QString &queueName, std::chrono::microseconds wait);
+
+    //
+    //  Return aggregated statement stats sorted by total time and queue wait times as a text table.
+    //
+    QString report() const;
+    bool writeReport(const QString &filePath) const;
+
+    void clear();
+
+    //
+    //  Keep bind names, types and sizes only, since values hold message bodies and keys.
+    //
+    static QString redactBindValues(const BindValues &values);
+
+private:
+    struct StatementStats
+    {
+        quint64 count = 0;
+        quint64 slowCount = 0;
+        quint64 prepareMicroseconds = 0;
+        quint64 execMicroseconds = 0;
+        quint64 fetchMicroseconds = 0;
+        quint64 rowCount = 0;
+        MetricHistogram totalHistogram;
+    };
+
+    struct QueueWait
+    {
+        qint64 currentMicroseconds = 0;
+        qint64 maxMicroseconds = 0;
+        MetricGauge *gauge = nullptr;
+        MetricGauge *maxGauge = nullptr;
+    };
+
+    StatementProfiler() = default;
+
+private:
+    std::atomic<bool> m_enabled = false;
+    std::atomic<qint64> m_slowThresholdMilliseconds = 100;
+    mutable QMutex m_mutex;
+    std::map<QString, std::unique_ptr<StatementStats>> m_statements;
+    std::map<QString, QueueWait> m_queues;
+};
+} // namespace vm
+
+#endif // VM_STATEMENT_PROFILER_H
@@ -32,21 +32,23 @@
 //
 //  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
 
-#ifndef VM_LOG_CONTEXT
-#define VM_LOG_CONTEXT
+#ifndef VM_VERSION5_PATCH_MESSAGES_H
+#define VM_VERSION5_PATCH_MESSAGES_H
 
-#include <QObject>
-#include <QString>
+#include "core/Patch.h"
 
-// Copyable alternative of QMessageLogContext
-struct LogContext
+namespace vm {
+namespace version5 {
+
+class PatchMessages : public Patch
 {
-    QString category;
-    QString fileName;
-    int line = 0;
+public:
+    PatchMessages();
+
+    bool apply(Database *database) override;
 };
 
-Q_DECLARE_METATYPE(QtMsgType);
-Q_DECLARE_METATYPE(LogContext);
+} // namespace version5
+} // namespace vm
 
-#endif // VM_LOG_CONTEXT
+#endif // VM_VERSION5_PATCH_MESSAGES_H
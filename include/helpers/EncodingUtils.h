@@ -0,0 +1,82 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_ENCODING_UTILS_H
+#define VM_ENCODING_UTILS_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <optional>
+
+namespace vm {
+//
+//  Base64 and hex codecs.
+//  Vectorized (AVX2 / SSE4.1) implementation is selected at runtime on x86, scalar one is used otherwise.
+//
+class EncodingUtils
+{
+public:
+    //
+    //  Encode data to the standard Base64 with padding.
+    //
+    static QByteArray toBase64(const QByteArray &data);
+
+    enum class Base64Mode { Lenient, Strict };
+
+    //
+    //  Decode standard Base64 with or without padding.
+    //  Lenient mode decodes input that the fast decoder rejects (whitespace, line breaks, invalid characters)
+    //  with QByteArray::fromBase64(), as it was done before, and logs it. It never returns std::nullopt.
+    //  Strict mode returns std::nullopt if the input contains invalid characters.
+    //
+    static std::optional<QByteArray> fromBase64(const QByteArray &base64, Base64Mode mode = Base64Mode::Lenient);
+    static std::optional<QByteArray> fromBase64(const QString &base64, Base64Mode mode = Base64Mode::Lenient);
+
+    //
+    //  Decode standard Base64 into the caller buffer without allocations, the input is processed in strict mode.
+    //  Return decoded size, or std::nullopt if the input is invalid or the buffer is too small.
+    //  The buffer of base64DecodedMaxSize() bytes always fits.
+    //
+    static std::optional<int> fromBase64(const char *base64, int base64Size, char *buffer, int bufferSize);
+    static int base64DecodedMaxSize(int base64Size);
+
+    //
+    //  Encode data to the lower-case hex.
+    //
+    static QByteArray toHex(const QByteArray &data);
+};
+} // namespace vm
+
+#endif // VM_ENCODING_UTILS_H
@@ -0,0 +1,174 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_METRICS_H
+#define VM_METRICS_H
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QReadWriteLock>
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+
+namespace vm {
+//
+//  Monotonic counter.
+//
+class MetricCounter
+{
+public:
+    void increment(quint64 value = 1) noexcept { m_value.fetch_add(value, std::memory_order_relaxed); }
+    quint64 value() const noexcept { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value = 0;
+};
+
+//
+//  Value that can go up and down.
+//
+class MetricGauge
+{
+public:
+    void set(qint64 value) noexcept { m_value.store(value, std::memory_order_relaxed); }
+    void add(qint64 value) noexcept { m_value.fetch_add(value, std::memory_order_relaxed); }
+    qint64 value() const noexcept { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> m_value = 0;
+};
+
+//
+//  HDR-style histogram: every power of two range is split into sub-buckets,
+//  so the relative error is bounded by 1 / kSubBucketCount for any value.
+//
+class MetricHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+    static constexpr int kBucketCount = kSubBucketCount + (64 - kSubBucketBits) * kSubBucketCount;
+
+    struct Snapshot
+    {
+        quint64 count = 0;
+        quint64 sum = 0;
+        quint64 max = 0;
+        std::array<quint64, kBucketCount> buckets = {};
+
+        //
+        //  Return upper bound of the bucket that holds the given quantile, quantile is in range [0, 1].
+        //
+        quint64 valueAtQuantile(double quantile) const;
+    };
+
+    void record(quint64 value) noexcept;
+    Snapshot snapshot() const;
+
+    static int bucketIndex(quint64 value) noexcept;
+    static quint64 bucketUpperBound(int index) noexcept;
+
+private:
+    std::atomic<quint64> m_count = 0;
+    std::atomic<quint64> m_sum = 0;
+    std::atomic<quint64> m_max = 0;
+    std::array<std::atomic<quint64>, kBucketCount> m_buckets = {};
+};
+
+//
+//  Record elapsed microseconds to the histogram on destruction.
+//
+class MetricLatencyTimer
+{
+public:
+    explicit MetricLatencyTimer(MetricHistogram *histogram);
+    ~MetricLatencyTimer();
+
+    MetricLatencyTimer(const MetricLatencyTimer &) = delete;
+    MetricLatencyTimer &operator=(const MetricLatencyTimer &) = delete;
+
+private:
+    MetricHistogram *m_histogram;
+    QElapsedTimer m_timer;
+};
+
+//
+//  Process-wide registry of metrics identified by name and labels.
+//  Returned metrics live as long as the process, so callers may cache pointers
+//  and update metrics without any lock.
+//
+class Metrics
+{
+public:
+    using Labels = QMap<QString, QString>;
+
+    static Metrics *instance();
+
+    MetricCounter *counter(const QString &name, const Labels &labels = {});
+    MetricGauge *gauge(const QString &name, const Labels &labels = {});
+    MetricHistogram *histogram(const QString &name, const Labels &labels = {});
+
+    //
+    //  Return snapshot of all metrics in Prometheus text exposition format.
+    //  Histograms are exposed as summaries with p50, p90, p99 and max quantiles.
+    //
+    QByteArray toPrometheusText() const;
+
+private:
+    template<typename Metric>
+    using Family = std::map<QString, std::unique_ptr<Metric>>;
+
+    template<typename Metric>
+    using Families = std::map<QString, Family<Metric>>;
+
+    Metrics() = default;
+
+    template<typename Metric>
+    Metric *findOrCreate(Families<Metric> &families, const QString &name, const Labels &labels);
+
+    static QString formatLabels(const Labels &labels);
+
+private:
+    mutable QReadWriteLock m_lock;
+    Families<MetricCounter> m_counters;
+    Families<MetricGauge> m_gauges;
+    Families<MetricHistogram> m_histograms;
+};
+} // namespace vm
+
+#endif // VM_METRICS_H
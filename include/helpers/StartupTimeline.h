@@ -0,0 +1,129 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_STARTUP_TIMELINE_H
+#define VM_STARTUP_TIMELINE_H
+
+#include "Tracer.h"
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+
+#include <vector>
+
+namespace vm {
+//
+//  Record startup phases and milestones of the application with the thread they run in.
+//  Time is counted from the first use of the timeline, so it should be touched first thing in main().
+//
+//  Recording stops when the timeline is finished, so code that also runs after startup
+//  (e.g. sign-in) may report phases unconditionally.
+//
+class StartupTimeline
+{
+public:
+    static StartupTimeline *instance();
+
+    //
+    //  Return milliseconds since the timeline creation.
+    //
+    qint64 elapsed() const;
+
+    void beginPhase(const QString &name);
+    void endPhase(const QString &name);
+    void mark(const QString &name);
+
+    //
+    //  Stop recording, the milestone that finished startup is recorded as the last mark.
+    //
+    void finish(const QString &milestone);
+    bool isFinished() const;
+
+    //
+    //  Return the latest time of the milestone, or negative value if it was not reached.
+    //
+    qint64 milestoneTime(const QString &name) const;
+
+    QJsonObject toJson() const;
+    bool writeReport(const QString &filePath, const QJsonObject &extras = {}) const;
+
+private:
+    struct Phase
+    {
+        QString name;
+        QString threadName;
+        qint64 beganAt = -1;
+        qint64 endedAt = -1;
+    };
+
+    struct Mark
+    {
+        QString name;
+        QString threadName;
+        qint64 at = -1;
+    };
+
+    StartupTimeline();
+
+    static QString currentThreadName();
+
+private:
+    QElapsedTimer m_timer;
+    mutable QMutex m_mutex;
+    bool m_isFinished = false;
+    std::vector<Phase> m_phases;
+    std::vector<Mark> m_marks;
+};
+
+//
+//  Record startup phase within the scope, it is also traced when tracer is enabled.
+//
+class StartupPhase
+{
+public:
+    explicit StartupPhase(QString name);
+    ~StartupPhase();
+
+    StartupPhase(const StartupPhase &) = delete;
+    StartupPhase &operator=(const StartupPhase &) = delete;
+
+private:
+    QString m_name;
+    TraceSpan m_traceSpan;
+};
+} // namespace vm
+
+#endif // VM_STARTUP_TIMELINE_H
@@ -0,0 +1,133 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_STRAND_EXECUTOR_H
+#define VM_STRAND_EXECUTOR_H
+
+#include <QFuture>
+#include <QFutureInterface>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <type_traits>
+
+namespace vm {
+//
+//  Run tasks on a dedicated thread pool within serial queues (strands) identified by a key.
+//  Tasks with the same key are executed one after another in the submission order,
+//  while tasks with different keys are executed concurrently.
+//
+//  Submission never blocks the caller. The limit of pending tasks is a soft one:
+//  producers that can pause (i.e. history fetch) should check isSaturated() before submitting more.
+//
+//  Exceptions thrown by tasks are logged and swallowed, so the strand proceeds with the next task.
+//
+class StrandExecutor
+{
+public:
+    using Task = std::function<void()>;
+
+    StrandExecutor(int maxThreadCount, int maxPendingTasks);
+
+    //
+    //  Wait until all pending tasks are finished.
+    //
+    ~StrandExecutor() noexcept;
+
+    StrandExecutor(const StrandExecutor &) = delete;
+    StrandExecutor &operator=(const StrandExecutor &) = delete;
+
+    //
+    //  Submit function to the strand and return future with the function result.
+    //
+    template<typename Function, typename Result = std::invoke_result_t<Function>>
+    QFuture<Result> submit(const QString &strandKey, Function function)
+    {
+        auto futureInterface = std::make_shared<QFutureInterface<Result>>();
+        futureInterface->reportStarted();
+        auto future = futureInterface->future();
+
+        post(strandKey, [futureInterface, function = std::move(function)]() mutable {
+            if constexpr (std::is_void_v<Result>) {
+                function();
+            } else {
+                futureInterface->reportResult(function());
+            }
+            futureInterface->reportFinished();
+        });
+
+        return future;
+    }
+
+    //
+    //  Enqueue task to the strand.
+    //
+    void post(const QString &strandKey, Task task);
+
+    //
+    //  Return number of tasks that are queued or running.
+    //
+    int pendingTaskCount() const;
+
+    //
+    //  Return true if number of pending tasks reached the limit.
+    //
+    bool isSaturated() const;
+
+private:
+    void runNext(const QString &strandKey);
+    void schedule(const QString &strandKey);
+
+private:
+    QThreadPool m_pool;
+    const int m_maxPendingTasks;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_pendingTasksDecreased;
+
+    //
+    //  Strand exists while it has tasks, the front task is the running one.
+    //
+    std::map<QString, std::deque<Task>> m_strands;
+    int m_pendingTaskCount = 0;
+};
+} // namespace vm
+
+#endif // VM_STRAND_EXECUTOR_H
@@ -0,0 +1,150 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_TRACER_H
+#define VM_TRACER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace vm {
+//
+//  Collect trace events into per-thread buffers and export them in the Chrome trace-event format,
+//  that can be opened with chrome://tracing or https://ui.perfetto.dev.
+//
+//  Synchronous spans are recorded as complete events, so nesting is restored by the viewer
+//  from the timestamps within a thread. Spans that begin and end in different places
+//  (e.g. operations) are recorded as async events bound by identifier.
+//
+//  Recording is a no-op while tracer is disabled.
+//
+class Tracer
+{
+public:
+    using Args = QVariantMap;
+
+    //
+    //  Maximum number of events kept per thread, the oldest events are dropped first.
+    //
+    static constexpr int kMaxThreadEvents = 16384;
+
+    static Tracer *instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    //
+    //  Return microseconds since tracer creation.
+    //
+    qint64 now() const;
+
+    void addSpan(const char *category, const QString &name, qint64 startedAt, qint64 duration, Args args = {});
+    void addInstant(const char *category, const QString &name, Args args = {});
+    void beginAsyncSpan(const char *category, const QString &name, quint64 id, Args args = {});
+    void endAsyncSpan(const char *category, const QString &name, quint64 id, Args args = {});
+
+    //
+    //  Write collected events to the JSON file. Events are kept, so export can be repeated.
+    //
+    bool exportChromeTrace(const QString &filePath);
+
+    void clear();
+
+private:
+    struct Event
+    {
+        char phase;
+        const char *category;
+        QString name;
+        qint64 timestamp;
+        qint64 duration;
+        quint64 id;
+        Args args;
+    };
+
+    struct ThreadBuffer
+    {
+        int threadId;
+        QString threadName;
+        bool isRetired = false;
+        QMutex mutex;
+        std::deque<Event> events;
+    };
+
+    Tracer();
+
+    ThreadBuffer *currentThreadBuffer();
+    void retireThreadBuffer(ThreadBuffer *buffer);
+    void record(Event event);
+
+    friend struct ThreadBufferHolder;
+
+private:
+    std::atomic_bool m_enabled = false;
+    QElapsedTimer m_clock;
+    QMutex m_buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    int m_nextThreadId = 1;
+};
+
+//
+//  Record the synchronous span from construction till destruction.
+//
+class TraceSpan
+{
+public:
+    TraceSpan(const char *category, QString name, Tracer::Args args = {});
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    void addArg(const QString &key, const QVariant &value);
+
+private:
+    const char *m_category;
+    QString m_name;
+    Tracer::Args m_args;
+    qint64 m_startedAt = -1;
+};
+} // namespace vm
+
+#endif // VM_TRACER_H
@@ -0,0 +1,125 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_LOG_RING_BUFFER
+#define VM_LOG_RING_BUFFER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace vm {
+//
+//  Bounded lock-free queue with many producers and a single consumer.
+//  Producers never block: push fails when the buffer is full.
+//  Capacity must be a power of two.
+//
+template<typename T>
+class LogRingBuffer
+{
+public:
+    explicit LogRingBuffer(std::size_t capacity) : m_cells(new Cell[capacity]), m_mask(capacity - 1)
+    {
+        if ((capacity < 2) || ((capacity & m_mask) != 0)) {
+            throw std::logic_error("Log ring buffer capacity must be a power of two");
+        }
+        for (std::size_t i = 0; i < capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LogRingBuffer(const LogRingBuffer &) = delete;
+    LogRingBuffer &operator=(const LogRingBuffer &) = delete;
+
+    //
+    //  Push value from any thread. Value isn't moved if false is returned.
+    //
+    bool tryPush(T &&value)
+    {
+        auto pos = m_pushPos.load(std::memory_order_relaxed);
+        for (;;) {
+            auto &cell = m_cells[pos & m_mask];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_pushPos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //
+    //  Pop value. Must be called from the consumer thread only.
+    //
+    bool tryPop(T &value)
+    {
+        const auto pos = m_popPos.load(std::memory_order_relaxed);
+        auto &cell = m_cells[pos & m_mask];
+        const auto sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1) < 0) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.value = T();
+        cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+        m_popPos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    std::size_t capacity() const noexcept { return m_mask + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    const std::unique_ptr<Cell[]> m_cells;
+    const std::size_t m_mask;
+    alignas(64) std::atomic<std::size_t> m_pushPos = 0;
+    alignas(64) std::atomic<std::size_t> m_popPos = 0;
+};
+} // namespace vm
+
+#endif // VM_LOG_RING_BUFFER
@@ -0,0 +1,80 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_LOG_STORE
+#define VM_LOG_STORE
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace vm {
+//
+//  Log segments on disk. The active segment is written by the log worker.
+//  Closed segments are compressed with gzip and the oldest ones are removed
+//  when they exceed the segment count or the total size budget.
+//
+class LogStore
+{
+public:
+    static constexpr qint64 kMaxSegmentSize = 1024 * 1024; // Uncompressed size of the active segment
+    static constexpr int kMaxSegmentCount = 32; // Compressed segments
+    static constexpr qint64 kMaxTotalSize = 8 * 1024 * 1024; // Size of compressed segments
+
+    static QString activeSegmentPath();
+
+    //
+    //  Rename active segment, so it's compressed by compressClosedSegments.
+    //
+    static bool closeActiveSegment();
+
+    //
+    //  Compress closed segments and remove the oldest ones that exceed the budget.
+    //  Thread-safe, calls are serialized.
+    //
+    static void compressClosedSegments();
+
+    //
+    //  Paths of compressed segments from the oldest to the newest.
+    //
+    static QStringList compressedSegmentPaths();
+
+    //
+    //  Compress data into gzip member. Members can be concatenated into a single gzip stream.
+    //
+    static QByteArray gzip(const QByteArray &data);
+};
+} // namespace vm
+
+#endif // VM_LOG_STORE
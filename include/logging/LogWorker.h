@@ -35,15 +35,24 @@
 #ifndef VM_LOG_WORKER
 #define VM_LOG_WORKER
 
-#include "LogContext.h"
+#include "LogRecord.h"
+#include "LogRingBuffer.h"
 
 #include <QObject>
 #include <QFile>
 #include <QDir>
+#include <QHash>
+#include <QThreadPool>
 
-#include <optional>
+#include <atomic>
 
 namespace vm {
+//
+//  Collects raw log records from any thread and formats them within the worker thread.
+//  Drop policy: debug and info records are dropped when the buffer is full, warnings and
+//  critical records wait for a short while before they are dropped, fatal records always wait.
+//  Dropped records are counted and reported to the log file.
+//
 class LogWorker : public QObject
 {
     Q_OBJECT
@@ -52,14 +61,34 @@ public:
     explicit LogWorker(QObject *parent = nullptr);
     ~LogWorker() override = default;
 
-    void processMessage(QtMsgType type, const LogContext &context, const QString &message);
+    //
+    //  Enqueue record. Thread-safe and lock-free until the worker is woken up.
+    //
+    void enqueue(LogRecord &&record);
+
+    //
+    //  Process all enqueued records. Must be called within the worker thread.
+    //
+    void drain();
+
+    //
+    //  Enable creation of HTML messages for the log viewer.
+    //
+    void setHtmlFormattingEnabled(bool enabled);
+
+signals:
+    void formattedMessageCreated(const QString &message);
 
 private:
-    static QString formatLogType(QtMsgType type);
-    static QString getLogFileName(int logIndex);
+    static QLatin1String formatLogType(QtMsgType type);
+
+    QString categoryName(const char *category);
+    void processRecord(const LogRecord &record, QString &htmlMessages);
+    void reportDroppedRecords();
 
-    void fileMessageHandler(QtMsgType type, const LogContext &context, const QString &message);
-    void consoleMessageHandler(QtMsgType type, const LogContext &context, const QString &message);
+    void fileMessageHandler(const LogRecord &record, const QString &category);
+    void consoleMessageHandler(const LogRecord &record, const QString &category);
+    void htmlMessageHandler(const LogRecord &record, const QString &category, QString &htmlMessages);
 
     //
     //  Prepare log file for writing of message with size messageLen
@@ -68,16 +97,23 @@ private:
     bool prepareLogFile(qint64 messageLen);
 
     //
-    //  Rotate log files
+    //  Close active log segment and compress it in background
     //
     void rotateLogFiles();
 
-    void logToFile(const QString &formattedMessage);
+    void logToFile(const QByteArray &formattedMessage);
     void logToConsole(const QString &formattedMessage);
 
 private:
+    LogRingBuffer<LogRecord> m_records;
+    std::atomic_bool m_isDrainScheduled = false;
+    std::atomic<quint64> m_droppedCount = 0;
+    std::atomic_bool m_isHtmlFormattingEnabled = false;
+
+    QHash<const char *, QString> m_categoryNames;
     QFile m_logFile; // automatically closed in destructor
     bool m_isFirstMessage = true;
+    QThreadPool m_compressionPool; // waits for compression in destructor
 };
 } // namespace vm
 
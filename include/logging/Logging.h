@@ -35,8 +35,6 @@
 #ifndef VM_LOGGING_H
 #define VM_LOGGING_H
 
-#include "LogContext.h"
-
 #include <QObject>
 #include <QMessageLogContext>
 
@@ -45,6 +43,8 @@
 class QThread;
 
 namespace vm {
+class LogWorker;
+
 class Logging : public QObject
 {
     Q_OBJECT
@@ -54,17 +54,22 @@ public:
     virtual ~Logging();
 
 signals:
-    void messageCreated(QtMsgType type, const LogContext &context, const QString &message);
+    //
+    //  HTML messages are created only while this signal has receivers.
+    //
     void formattedMessageCreated(const QString &message);
 
-private:
-    void formatMessage(QtMsgType type, const LogContext &context, const QString &message);
+protected:
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
 
+private:
     static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
 
     static Logging *m_instance;
 
     std::unique_ptr<QThread> m_workerThread;
+    LogWorker *m_worker = nullptr;
 };
 
 } // namespace vm
@@ -42,11 +42,13 @@
 #include "CoreMessengerStatus.h"
 #include "Group.h"
 #include "Message.h"
+#include "MessagePacking.h"
 #include "Settings.h"
 #include "User.h"
 #include "Group.h"
 #include "GroupMember.h"
 #include "GroupUpdate.h"
+#include "ReconnectScheduler.h"
 #include "Contact.h"
 #include "ContactUpdate.h"
 #include "xmpp/XmppMucSubIq.h"
@@ -61,7 +63,9 @@
 #include <QUrl>
 #include <QPointer>
 
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <tuple>
 #include <list>
 #include <variant>
@@ -78,13 +82,25 @@ class CoreMessenger : public QObject
 {
     Q_OBJECT
 private:
-    enum class PushType { None, Alert, Voip };
+    using PushType = MessagePacking::PushType;
 
 public:
     using Result = CoreMessengerStatus;
 
     enum class ConnectionState { Disconnected, Connecting, Connected, Error };
 
+    //
+    //  XMPP session statistics: how reconnects were completed - by XEP-0198 resumption or full reconnect.
+    //
+    struct XmppSessionStats
+    {
+        quint64 resumedCount = 0;
+        quint64 fullReconnectCount = 0;
+        quint64 resumeRejectedCount = 0;
+        std::chrono::milliseconds lastResumeLatency { 0 };
+        std::chrono::milliseconds lastFullReconnectLatency { 0 };
+    };
+
     //
     //  Create a new group chat and became the owner.
     //  Note, it runs concurrently.
@@ -165,6 +181,7 @@ signals:
     void deregisterPushNotifications();
     void xmppCreateGroupChat(const GroupHandler &group, const GroupMembers &members);
     void xmppMessageDelivered(const QString &jid, const QString &messageId);
+    void scheduleSendPipelineResume(const QString &pipelineKey, int msec);
     void xmppFetchRoomsFromServer();
     void xmppJoinRoom(const GroupId &groupId);
 
@@ -204,6 +221,16 @@ public:
 
     ConnectionState connectionState() const;
 
+    //
+    //  Return XMPP session resumption / full reconnect statistics.
+    //
+    XmppSessionStats xmppSessionStats() const;
+
+    //
+    //  Return reconnection attempts count and time to connected.
+    //
+    ReconnectScheduler::Stats reconnectStats() const;
+
     //
     //  Sign-in / Sign-up / Backup.
     //
@@ -222,9 +249,19 @@ public:
 
     //
     //  Messages.
+    //  Pending messages of the same conversation are sent as a batch in order,
+    //  and different conversations are encrypted concurrently.
     //
     QFuture<Result> sendMessage(MessageHandler message);
 
+    //
+    //  Decrypt stored messages with an encrypted content that were received from the given sender.
+    //  Return updates for messages that were decrypted or appeared to be broken, other messages remain encrypted.
+    //  Return std::nullopt if the sender can not be resolved, so no message was tried.
+    //  Note, messages are decrypted one by one within the calling thread.
+    //
+    std::optional<MessageUpdates> decryptStoredMessages(const UserId &senderId, const ModifiableMessages &messages);
+
     //
     //  Try to decrypt given message for any local user.
     //  It is used to decrypt notification messages.
@@ -268,6 +305,7 @@ public:
 public:
     bool isUploadServiceFound() const;
     QString requestUploadSlot(const QString &filePath);
+    QString requestUploadSlot(const QString &fileName, qint64 fileSize);
 
 signals:
     void uploadServiceFound(bool found);
@@ -319,11 +357,10 @@ private:
     //
     //  Message processing helpers.
     //
-    QByteArray packMessage(const MessageHandler &message);
-    static CoreMessengerStatus unpackMessage(const QByteArray &messageData, Message &message);
-
-    QByteArray packXmppMessageBody(const QByteArray &messageCiphertext, PushType pushType);
-    static std::variant<CoreMessengerStatus, QByteArray> unpackXmppMessageBody(const QString &xmppMessageBody);
+    QByteArray packMessage(const MessageHandler &message, bool isCompactEnvelope) const;
+    bool isCompactEnvelopeSupported(const UserId &recipientId) const;
+    void addCompactEnvelopeCapability(QXmppMessage &xmppMessage) const;
+    void rememberCompactEnvelopeCapability(const QXmppMessage &xmppMessage);
 
     //
     //  Message sending / processing helpers.
@@ -331,11 +368,38 @@ private:
     std::variant<CoreMessengerStatus, QByteArray> encryptPersonalMessage(const UserId &recipientId,
                                                                          const QByteArray &messageData);
 
+    std::variant<CoreMessengerStatus, QByteArray> encryptPersonalMessage(const User &recipient,
+                                                                         const QByteArray &messageData);
+
     std::variant<CoreMessengerStatus, QByteArray> decryptPersonalMessage(const UserId &senderId,
                                                                          const QByteArray &encryptedMessageData);
 
-    Result sendPersonalMessage(const MessageHandler &message);
-    Result sendGroupMessage(const MessageHandler &message);
+    std::optional<MessageUpdate> decryptStoredMessage(const Message &encryptedMessage);
+
+    //
+    //  Send pipeline.
+    //
+    static QString sendPipelineKey(const MessageHandler &message);
+    void sendPendingMessages(const QString &pipelineKey);
+    bool tryAcquireSendWindow(const QString &pipelineKey, const QString &messageId);
+    void releaseSendWindow(const QString &messageId);
+    void resetSendWindow();
+    void resumeSendPipeline(const QString &pipelineKey);
+    void failPendingSends(Result result);
+
+    Result sendPersonalMessage(const MessageHandler &message, const User &recipient);
+    Result sendGroupMessage(const MessageHandler &message, const GroupImplHandler &group);
+
+    //
+    //  Received messages are processed in order within a conversation identified by this key.
+    //
+    static QString xmppConversationKey(const QXmppMessage &xmppMessage, bool isCarbon);
+
+    //
+    //  Live and carbon messages are queued even when the queue is saturated: QXmppClient gives no way
+    //  to pause reading the stream, so only history fetch is paused. A saturated queue is logged once.
+    //
+    void checkReceivedMessagesBacklog();
 
     QFuture<Result> processReceivedXmppMessage(const QXmppMessage &xmppMessage);
     Result processChatReceivedXmppMessage(const QXmppMessage &xmppMessage);
@@ -362,7 +426,7 @@ private:
 
     const GroupImplHandler findGroupInCache(const GroupId &groupId) const;
 
-    std::variant<CoreMessengerStatus, QByteArray> encryptGroupMessage(const GroupId &groupId,
+    std::variant<CoreMessengerStatus, QByteArray> encryptGroupMessage(const GroupImplHandler &group,
                                                                       const QByteArray &messageData);
 
     std::variant<CoreMessengerStatus, QByteArray> decryptGroupMessage(const GroupId &groupId, const UserId &senderId,
@@ -376,6 +440,28 @@ private:
     bool isXmppConnecting() const noexcept;
     bool isXmppDisconnected() const noexcept;
 
+    //
+    //  Return true if XMPP stream management (XEP-0198) is enabled within the current session,
+    //  so the session can be resumed after the connection loss.
+    //
+    bool isXmppStreamResumable() const noexcept;
+
+    //
+    //  Return true if the last XMPP connection resumed previous session.
+    //
+    bool isXmppStreamResumed() const noexcept;
+
+    //
+    //  Drop XMPP socket without closing the stream, so the server keeps the session and the next connection
+    //  resumes it. Return false if the session is not resumable, so the caller should disconnect gracefully.
+    //
+    bool abortResumableXmppConnection();
+
+    //
+    //  Join XMPP rooms that are not joined within the current connection.
+    //
+    void rejoinXmppRooms();
+
     //
     //  XMPP helpers.
     //
@@ -394,6 +480,7 @@ private slots:
     void xmppOnPresenceReceived(const QXmppPresence &presence);
     void xmppOnIqReceived(const QXmppIq &iq);
     void xmppOnSslErrors(const QList<QSslError> &errors);
+    void xmppOnClientMessageReceived(const QXmppMessage &xmppMessage);
     void xmppOnMessageReceived(const QXmppMessage &xmppMessage);
     void xmppOnCarbonMessageReceived(const QXmppMessage &xmppMessage);
     void xmppOnMessageDelivered(const QString &jid, const QString &messageId);
@@ -411,6 +498,7 @@ private slots:
     void xmppOnArchivedMessageReceived(const QString &queryId, const QXmppMessage &message);
     void xmppOnArchivedResultsRecieved(const QString &queryId, const QXmppResultSetReply &resultSetReply,
                                        bool complete);
+    void requestNextArchivedMessages(const GroupId &groupId, const QString &after);
     //
     //  MUC/Sub slots.
     //--
@@ -447,10 +535,13 @@ private slots:
     void onLogConnectionStateChanged(CoreMessenger::ConnectionState state);
 
     void onSendMessageStatusDisplayed(const MessageHandler &message);
+    void onSendDisplayedMarker(const MessageHandler &message);
 
     void onSyncPrivateChatsHistory();
     void onSyncGroupChatHistory(const GroupId &groupId);
 
+    void onScheduleSendPipelineResume(const QString &pipelineKey, int msec);
+
 private:
     friend class CoreMessengerCloudFs;
     const vssq_messenger_cloud_fs_t *cloudFsC() const;
@@ -487,6 +578,7 @@ Q_DECLARE_METATYPE(vm::GroupMembers);
 Q_DECLARE_METATYPE(vm::Contact);
 Q_DECLARE_METATYPE(vm::Contacts);
 Q_DECLARE_METATYPE(vm::MessageUpdate);
+Q_DECLARE_METATYPE(vm::MessageUpdates);
 Q_DECLARE_METATYPE(vm::ContactUpdate);
 
 Q_DECLARE_METATYPE(QXmppClient::State);
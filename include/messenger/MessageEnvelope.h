@@ -0,0 +1,122 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_MESSAGE_ENVELOPE_H
+#define VM_MESSAGE_ENVELOPE_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <optional>
+
+namespace vm {
+
+//
+//  Compact binary envelope (v4) for messages and XMPP message bodies.
+//
+//  Layout: magic "VM" (2 bytes), version (1 byte), then a sequence of fields,
+//  where each field is encoded as: tag (1 byte), value length (varint), value.
+//  Unknown tags are skipped, so new fields can be added without a version change.
+//
+//  Large message content is compressed with Deflate before encryption,
+//  and it is stored within a dedicated field that works as a compression flag.
+//
+class MessageEnvelope
+{
+public:
+    static constexpr quint8 kVersion = 4;
+
+    //
+    //  Namespace of the stanza element that tells the peer the sender reads envelopes of kVersion.
+    //  Senders switch a peer to envelopes only after they got this element from the peer.
+    //
+    static constexpr const char *kCapabilityNamespace = "urn:virgil:messenger:envelope:4";
+
+    //
+    //  Maximum size of the decompressed message content, protects from decompression bombs.
+    //
+    static constexpr int kMaxContentSize = 8 * 1024 * 1024;
+
+    //
+    //  Message fields that are encrypted.
+    //
+    struct Message
+    {
+        quint64 timestamp = 0;
+        QString from;
+        QString to;
+        QByteArray content;
+    };
+
+    //
+    //  XMPP message body fields that are sent in plain.
+    //
+    struct Body
+    {
+        quint8 pushType = 0;
+        QByteArray ciphertext;
+    };
+
+    //
+    //  Return true if given data starts with the envelope header.
+    //
+    static bool isEnvelope(const QByteArray &data) noexcept;
+
+    //
+    //  Serialize message fields.
+    //  Content is compressed if its size is not less than the given threshold and compression pays off.
+    //  Zero threshold disables compression.
+    //
+    static QByteArray packMessage(const Message &message, int compressionThreshold = 0);
+
+    //
+    //  Parse message fields without intermediate copies of the whole data.
+    //  Return std::nullopt if data is malformed or decompressed content exceeds kMaxContentSize.
+    //
+    static std::optional<Message> unpackMessage(const QByteArray &data);
+
+    //
+    //  Serialize XMPP message body fields.
+    //
+    static QByteArray packBody(const Body &body);
+
+    //
+    //  Parse XMPP message body fields.
+    //  Return std::nullopt if data is malformed.
+    //
+    static std::optional<Body> unpackBody(const QByteArray &data);
+};
+} // namespace vm
+
+#endif // VM_MESSAGE_ENVELOPE_H
@@ -0,0 +1,89 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_MESSAGE_MARKER_AGGREGATOR_H
+#define VM_MESSAGE_MARKER_AGGREGATOR_H
+
+#include "ChatId.h"
+#include "Message.h"
+
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+#include <map>
+
+namespace vm {
+//
+//  Coalesce "read" markers of incoming messages.
+//  Within a flush interval only the newest message of each chat is kept,
+//  so a burst of displayed messages results in a single marker per chat.
+//
+class MessageMarkerAggregator : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Self = MessageMarkerAggregator;
+
+    explicit MessageMarkerAggregator(std::chrono::milliseconds flushInterval, QObject *parent = nullptr);
+
+    //
+    //  Remember message as a chat read position. Messages that are older than pending one are ignored.
+    //
+    void push(const MessageHandler &message);
+
+    //
+    //  Emit pending markers immediately.
+    //
+    void flush();
+
+    //
+    //  Drop pending markers.
+    //
+    void clear();
+
+signals:
+    //
+    //  Emitted once per chat and per flush interval with the newest pushed message.
+    //
+    void markerReady(const MessageHandler &message);
+
+private:
+    QTimer m_flushTimer;
+    std::map<ChatId, MessageHandler> m_pendingMarkers;
+};
+} // namespace vm
+
+#endif // VM_MESSAGE_MARKER_AGGREGATOR_H
@@ -0,0 +1,80 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_MESSAGE_PACKING_H
+#define VM_MESSAGE_PACKING_H
+
+#include "CoreMessengerStatus.h"
+#include "Message.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <variant>
+
+namespace vm {
+//
+//  Pack messages and XMPP message bodies either to the legacy v3 JSON layout or to the compact envelope (v4).
+//  Settings are passed explicitly, so packing does not depend on the messenger state.
+//
+class MessagePacking
+{
+public:
+    enum class PushType { None, Alert, Voip };
+
+    //
+    //  Pack message fields that are encrypted.
+    //  Content of the compact envelope is compressed if its size is not less than the compression threshold.
+    //
+    static QByteArray packMessage(const Message &message, bool isCompactEnvelope, int compressionThreshold);
+
+    //
+    //  Unpack decrypted message fields of any layout to the given message.
+    //
+    static CoreMessengerStatus unpackMessage(const QByteArray &messageData, Message &message);
+
+    //
+    //  Pack ciphertext to the XMPP message body that is Base64 encoded.
+    //
+    static QByteArray packXmppMessageBody(const QByteArray &messageCiphertext, PushType pushType,
+                                          bool isCompactEnvelope);
+
+    //
+    //  Unpack ciphertext from the XMPP message body of any layout.
+    //
+    static std::variant<CoreMessengerStatus, QByteArray> unpackXmppMessageBody(const QString &xmppMessageBody);
+};
+} // namespace vm
+
+#endif // VM_MESSAGE_PACKING_H
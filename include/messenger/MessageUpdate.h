@@ -47,10 +47,13 @@
 #include <QString>
 #include <QUrl>
 
+#include <memory>
 #include <optional>
 #include <variant>
+#include <vector>
 
 namespace vm {
+class Message;
 
 struct MessageUpdateBase
 {
@@ -67,6 +70,11 @@ struct IncomingMessageStageUpdate : public MessageUpdateBase
     IncomingMessageStage stage;
 };
 
+struct IncomingMessageDecryptedUpdate : public MessageUpdateBase
+{
+    std::shared_ptr<const Message> decryptedMessage;
+};
+
 struct OutgoingMessageStageUpdate : public MessageUpdateBase
 {
     OutgoingMessageStage stage;
@@ -137,11 +145,14 @@ struct MessageAttachmentExtrasJsonUpdate : public MessageAttachmentUpdateBase
 };
 
 using MessageUpdate = std::variant<
-        IncomingMessageStageUpdate, OutgoingMessageStageUpdate, MessageAttachmentUploadStageUpdate,
-        MessageAttachmentDownloadStageUpdate, MessageAttachmentFingerprintUpdate, MessageAttachmentRemoteUrlUpdate,
-        MessageAttachmentEncryptionUpdate, MessageAttachmentLocalPathUpdate, MessageAttachmentProcessedSizeUpdate,
-        MessagePictureThumbnailPathUpdate, MessagePictureThumbnailEncryptionUpdate,
-        MessagePictureThumbnailRemoteUrlUpdate, MessagePicturePreviewPathUpdate, MessageAttachmentExtrasJsonUpdate>;
+        IncomingMessageStageUpdate, IncomingMessageDecryptedUpdate, OutgoingMessageStageUpdate,
+        MessageAttachmentUploadStageUpdate, MessageAttachmentDownloadStageUpdate, MessageAttachmentFingerprintUpdate,
+        MessageAttachmentRemoteUrlUpdate, MessageAttachmentEncryptionUpdate, MessageAttachmentLocalPathUpdate,
+        MessageAttachmentProcessedSizeUpdate, MessagePictureThumbnailPathUpdate,
+        MessagePictureThumbnailEncryptionUpdate, MessagePictureThumbnailRemoteUrlUpdate,
+        MessagePicturePreviewPathUpdate, MessageAttachmentExtrasJsonUpdate>;
+
+using MessageUpdates = std::vector<MessageUpdate>;
 
 //
 //  Return message unique identifier the update relates to.
@@ -0,0 +1,121 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_RECONNECT_SCHEDULER_H
+#define VM_RECONNECT_SCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+#include <mutex>
+
+namespace vm {
+//
+//  Schedule reconnection attempts with capped exponential backoff and full jitter,
+//  so clients do not reconnect in lockstep after a server restart.
+//  Backoff is reset when connection stays established for a while or network is changed.
+//
+class ReconnectScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Self = ReconnectScheduler;
+
+    struct Stats
+    {
+        quint64 attemptCount = 0;
+        quint64 connectedCount = 0;
+        std::chrono::milliseconds lastTimeToConnected { 0 };
+    };
+
+    explicit ReconnectScheduler(QObject *parent = nullptr);
+
+    //
+    //  Schedule next attempt after a failure, delay grows with every consecutive failure.
+    //
+    void scheduleRetry();
+
+    //
+    //  Schedule next attempt after the given delay without counting a failure,
+    //  for instance when previous connection is still being closed.
+    //
+    void postpone(std::chrono::milliseconds delay);
+
+    //
+    //  Request reconnect immediately and reset backoff, for instance when network was changed.
+    //
+    void reconnectNow();
+
+    //
+    //  Cancel scheduled attempt and reset backoff.
+    //
+    void reset();
+
+    //
+    //  Track attempts and connection state to calculate statistics.
+    //
+    void attemptStarted();
+    void connected();
+    void disconnected();
+
+    Stats stats() const;
+
+signals:
+    void reconnectRequested();
+
+private:
+    std::chrono::milliseconds nextDelay() const;
+
+    void onConnectionStable();
+
+private:
+    static constexpr std::chrono::milliseconds kBaseDelay { 1000 };
+    static constexpr std::chrono::milliseconds kMaxDelay { 120000 };
+    static constexpr std::chrono::milliseconds kStableConnectionInterval { 60000 };
+    static constexpr int kMaxBackoffExponent = 16;
+
+    QTimer m_retryTimer;
+    QTimer m_stableTimer;
+    QElapsedTimer m_disconnectedTimer;
+    int m_failureCount = 0;
+
+    Stats m_stats;
+    mutable std::mutex m_statsMutex;
+};
+} // namespace vm
+
+#endif // VM_RECONNECT_SCHEDULER_H
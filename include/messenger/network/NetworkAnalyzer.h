@@ -41,12 +41,23 @@
 #include <QMap>
 #include <QTimer>
 
+#if VS_LINUX
+class QSocketNotifier;
+#endif
+
 #if VS_MACOS || VS_LINUX
 #    pragma GCC diagnostic push
 #    pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 #endif
 
 namespace vm {
+//
+//  Monitor network reachability and emit connectedChanged() when it changes.
+//
+//  On Linux interface and address changes are pushed by the kernel via rtnetlink,
+//  so changes are detected immediately and flaps are debounced.
+//  Other platforms poll network configurations.
+//
 class NetworkAnalyzer : public QObject
 {
     Q_OBJECT
@@ -77,8 +88,15 @@ protected:
 
     void printMap(const VSQNetworkInterfaceData &networkInterfaceData) const;
 
+    //
+    //  Collect routable IPv4 or global IPv6 addresses of running interfaces without opening network sessions.
+    //
+    VSQNetworkInterfaceData collectInterfaceAddresses() const;
+
     static const int kTimerInterval = 5000;
     static const int kSessionTimeoutMs = 1000;
+    static const int kEventDrivenTimerInterval = 60000;
+    static const int kDebounceIntervalMs = 300;
 
     QNetworkConfigurationManager m_nwManager;
     bool m_isConnected;
@@ -87,11 +105,22 @@ protected:
 
 private slots:
     void onStart();
+#if VS_LINUX
+    void onNetlinkEvent();
+#endif
 
 private:
     QThread *m_thread;
 
     bool checkIsNeedStop();
+
+#if VS_LINUX
+    bool startNetlinkMonitor();
+
+    int m_netlinkSocket = -1;
+    QSocketNotifier *m_netlinkNotifier = nullptr;
+    QTimer m_debounceTimer;
+#endif
 };
 } // namespace vm
 
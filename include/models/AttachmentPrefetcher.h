@@ -0,0 +1,139 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+
+#ifndef VM_ATTACHMENT_PREFETCHER_H
+#define VM_ATTACHMENT_PREFETCHER_H
+
+#include "ChatId.h"
+#include "Message.h"
+#include "OperationQueueListener.h"
+
+#include <QLoggingCategory>
+#include <QMutex>
+
+#include <map>
+#include <optional>
+#include <set>
+
+Q_DECLARE_LOGGING_CATEGORY(lcAttachmentPrefetcher);
+
+namespace vm {
+//
+//  Decide which picture previews are preloaded and in which order.
+//  Visible messages go first, then messages near the viewport. Prefetches of messages that were
+//  scrolled out of range are canceled. Pictures received in closed chats are preloaded within
+//  a per-chat budget that grows when the user looks at them and shrinks when they are ignored.
+//  Listens to the messages queue to skip canceled prefetches and to track running ones.
+//
+class AttachmentPrefetcher : public OperationQueueListener
+{
+    Q_OBJECT
+
+public:
+    using Self = AttachmentPrefetcher;
+
+    explicit AttachmentPrefetcher(QObject *parent);
+
+    //
+    //  Prefetch preview of the received message if the chat budget allows.
+    //
+    void pushArrived(const ModifiableMessageHandler &message);
+
+    //
+    //  Prefetch preview of the visible message.
+    //
+    void pushVisible(const ModifiableMessageHandler &message);
+
+    //
+    //  Update messages that are visible and near the viewport of the given chat.
+    //
+    void setViewport(const ChatId &chatId, const ModifiableMessages &visibleMessages,
+                     const ModifiableMessages &nearbyMessages);
+
+    //
+    //  Current chat was closed, so cancel prefetches of its viewport.
+    //
+    void closeViewport();
+
+signals:
+    void prefetchRequested(const ModifiableMessageHandler &message);
+
+    void prefetchFinished(const MessageId &messageId, QPrivateSignal);
+
+private:
+    enum class Urgency { Visible, Nearby, Arrived };
+
+    struct Request
+    {
+        ModifiableMessageHandler message;
+        Urgency urgency = Urgency::Arrived;
+        quint64 order = 0;
+    };
+
+    struct RunningRequest
+    {
+        Urgency urgency = Urgency::Arrived;
+        bool isCanceled = false;
+    };
+
+    bool preRun(OperationSourcePtr source) override;
+    void postRun(OperationSourcePtr source) override;
+    void clear() override;
+
+    void onPrefetchFinished(const MessageId &messageId);
+
+    void enqueue(const ModifiableMessageHandler &message, Urgency urgency);
+    void cancelOutOfRange(const std::set<MessageId> &inRangeIds);
+    void submitPending();
+    void finishChatVisit();
+    int chatBudget(const ChatId &chatId) const;
+
+    static bool needsPrefetch(const MessageHandler &message);
+    static std::optional<MessageId> prefetchId(const OperationSourcePtr &source);
+
+    std::map<MessageId, Request> m_pending;
+    quint64 m_nextOrder = 0;
+
+    std::map<MessageId, RunningRequest> m_running;
+    QMutex m_runningMutex;
+
+    ChatId m_currentChatId;
+    int m_currentChatHits = 0;
+    std::map<ChatId, std::set<MessageId>> m_unseenArrivals;
+    std::map<ChatId, int> m_chatBudgets;
+};
+} // namespace vm
+
+#endif // VM_ATTACHMENT_PREFETCHER_H
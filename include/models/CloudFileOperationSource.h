@@ -43,7 +43,7 @@ namespace vm {
 class CloudFileOperationSource : public OperationSource
 {
 public:
-    enum class Type { ListFolder, CreateFolder, Upload, Download, Delete, ListMembers, SetMembers };
+    enum class Type { ListFolder, PrefetchFolder, CreateFolder, Upload, Download, Delete, ListMembers, SetMembers };
 
     explicit CloudFileOperationSource(Type type);
 
@@ -62,6 +62,8 @@ public:
     void setPostFunction(const PostFunction &func);
     CloudFileMembers members() const;
     void setMembers(const CloudFileMembers &members);
+    bool forceOnline() const;
+    void setForceOnline(bool forceOnline);
 
     bool isValid() const override;
     QString toString() const override;
@@ -74,6 +76,7 @@ private:
     QString m_name;
     PostFunction m_postFunction;
     CloudFileMembers m_members;
+    bool m_forceOnline = false;
 };
 } // namespace vm
 
@@ -61,7 +61,8 @@ public:
     void addCloudFileListener(CloudFilesQueueListenerPtr listener);
 
 signals:
-    void pushListFolder(const CloudFileHandler &parentFolder);
+    void pushListFolder(const CloudFileHandler &parentFolder, bool forceOnline);
+    void pushPrefetchFolders(const CloudFiles &folders);
     void pushCreateFolder(const QString &name, const CloudFileHandler &parentFolder, const CloudFileMembers &members);
     void pushUploadFile(const QString &filePath, const CloudFileHandler &parentFolder);
     void pushDownloadFile(const CloudFileHandler &file, const CloudFileHandler &parentFolder, const PostFunction &func);
@@ -81,8 +82,10 @@ private:
     Operation *createOperation(OperationSourcePtr source) override;
     void invalidateOperation(OperationSourcePtr source) override;
     qsizetype maxAttemptCount() const override;
+    std::chrono::milliseconds operationDeadline(const QString &operationType) const override;
 
-    void onPushListFolder(const CloudFileHandler &parentFolder);
+    void onPushListFolder(const CloudFileHandler &parentFolder, bool forceOnline);
+    void onPrefetchRequested(const CloudFileHandler &folder);
     void onPushCreateFolder(const QString &name, const CloudFileHandler &parentFolder, const CloudFileMembers &members);
     void onPushUploadFile(const QString &filePath, const CloudFileHandler &parentFolder);
     void onPushDownloadFile(const CloudFileHandler &file, const CloudFileHandler &parentFolder,
@@ -97,6 +100,7 @@ private:
     QPointer<Messenger> m_messenger;
     QPointer<UserDatabase> m_userDatabase;
     QPointer<CloudFolderUpdateWatcher> m_watcher;
+    QPointer<CloudFolderPrefetcher> m_prefetcher;
     std::vector<CloudFilesQueueListenerPtr> m_cloudFileListeners;
 };
 } // namespace vm
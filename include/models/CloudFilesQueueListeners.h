@@ -42,6 +42,8 @@
 #include <QLoggingCategory>
 #include <QMutex>
 
+#include <deque>
+
 Q_DECLARE_LOGGING_CATEGORY(lcCloudFilesQueueListener);
 
 namespace vm {
@@ -146,6 +148,35 @@ private:
     std::vector<Item> m_items;
     QMutex m_mutex;
 };
+
+//
+// Listener that prefetches listings of child folders in background.
+// Only listings of the last listed folder are pending, at most two of them run at once.
+//
+class CloudFolderPrefetcher : public CloudFilesQueueListener
+{
+    Q_OBJECT
+
+public:
+    explicit CloudFolderPrefetcher(QObject *parent);
+
+    void prefetch(const CloudFiles &folders);
+
+signals:
+    void prefetchRequested(const CloudFileHandler &folder);
+
+    void prefetchFinished(QPrivateSignal);
+
+private:
+    void postRunCloudFile(CloudFileOperationSource *source) override;
+    void clear() override;
+
+    void onPrefetchFinished();
+    void submitPending();
+
+    std::deque<CloudFileHandler> m_pending;
+    int m_runningCount = 0;
+};
 } // namespace vm
 
 #endif // VM_CLOUD_FILES_QUEUE_LISTENER_H
@@ -0,0 +1,103 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_MESSAGES_DECRYPTION_WORKER_H
+#define VM_MESSAGES_DECRYPTION_WORKER_H
+
+#include "Messenger.h"
+#include "MessageUpdate.h"
+
+#include <QFuture>
+#include <QObject>
+#include <QPointer>
+
+#include <map>
+#include <set>
+#include <vector>
+
+Q_DECLARE_LOGGING_CATEGORY(lcMessagesDecryptionWorker);
+
+namespace vm {
+class UserDatabase;
+
+//
+//  Keeps track of stored messages that were received while sender keys were unavailable.
+//  Pending messages are grouped by a sender and are decrypted in a background batch
+//  as soon as the sender is found.
+//
+//  Each message is tried once per session. Group messages that stay encrypted are deferred
+//  until their group is loaded, other messages that stay encrypted are not tried again until the next session.
+//
+class MessagesDecryptionWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    MessagesDecryptionWorker(Messenger *messenger, UserDatabase *userDatabase, QObject *parent);
+    ~MessagesDecryptionWorker() override;
+
+signals:
+    //
+    //  Emitted when a batch of messages from a single sender was processed.
+    //
+    void messagesDecrypted(const MessageUpdates &messageUpdates);
+
+private:
+    void onDatabaseOpened();
+    void onEncryptedMessagesFetched(const ModifiableMessages &messages);
+    void onMessageReceived(const ModifiableMessageHandler &message);
+    void onUserWasFound(const UserHandler &user);
+    void onOnlineStatusChanged(bool isOnline);
+    void onGroupChatLoaded(const GroupHandler &group);
+    void onSignedOut();
+    void onSenderMessagesProcessed(const UserId &senderId, const ModifiableMessages &messages, bool isSenderFound,
+                                   const MessageUpdates &messageUpdates);
+
+    void addPendingMessage(const ModifiableMessageHandler &message);
+    void deferMessage(const ModifiableMessageHandler &message);
+    void decryptSenderMessages(const UserId &senderId);
+    void decryptAllMessages();
+
+    QPointer<Messenger> m_messenger;
+    QPointer<UserDatabase> m_userDatabase;
+    std::map<UserId, ModifiableMessages> m_pendingMessages;
+    std::set<MessageId> m_pendingMessageIds;
+    std::map<GroupId, ModifiableMessages> m_deferredGroupMessages;
+    std::set<MessageId> m_triedMessageIds;
+    std::set<UserId> m_processingSenders;
+    std::vector<QFuture<void>> m_decryptionFutures;
+};
+} // namespace vm
+
+#endif // VM_MESSAGES_DECRYPTION_WORKER_H
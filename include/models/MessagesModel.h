@@ -140,10 +140,19 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
     Q_INVOKABLE QString lastMessageSenderId() const; // TODO(fpohtmeh): remove
+
+    //
+    //  Set range of proxy rows that are shown by the view. Picture messages within and near
+    //  this range are reported to drive attachment prefetching.
+    //
+    Q_INVOKABLE void setVisibleRange(int firstProxyRow, int lastProxyRow);
     MessageHandler findIncomingInvitationMessage() const;
 
 signals:
     void pictureIconNotFound(const MessageId &messageId) const;
+    void viewportChanged(const ChatId &chatId, const ModifiableMessages &visibleMessages,
+                         const ModifiableMessages &nearbyMessages);
+    void viewportClosed();
     void messageAdding(); // TODO(fpohtmeh): remove
     void messagesReset();
     void groupInvitationReceived(const QString &ownerUsername, const MessageHandler &message);
@@ -42,6 +42,7 @@
 Q_DECLARE_LOGGING_CATEGORY(lcMessagesQueue);
 
 namespace vm {
+class AttachmentPrefetcher;
 class MessageOperation;
 class MessageOperationFactory;
 class UserDatabase;
@@ -59,6 +60,9 @@ signals:
     void pushMessageDownload(const ModifiableMessageHandler &message, const QString &filePath,
                              const PostFunction &func);
     void pushMessagePreload(const ModifiableMessageHandler &message);
+    void pushViewport(const ChatId &chatId, const ModifiableMessages &visibleMessages,
+                      const ModifiableMessages &nearbyMessages);
+    void closeViewport();
 
     void updateMessage(const MessageUpdate &messagesUpdate);
 
@@ -66,11 +70,13 @@ private:
     Operation *createOperation(OperationSourcePtr source) override;
     void invalidateOperation(OperationSourcePtr source) override;
     qsizetype maxAttemptCount() const override;
+    std::chrono::milliseconds operationDeadline(const QString &operationType) const override;
 
     void onPushMessage(const ModifiableMessageHandler &message);
     void onPushMessageDownload(const ModifiableMessageHandler &message, const QString &filePath,
                                const PostFunction &postFunction);
     void onPushMessagePreload(const ModifiableMessageHandler &message);
+    void onPrefetchRequested(const ModifiableMessageHandler &message);
 
     void onDatabaseOpened();
     void onOnlineStatusChanged(const bool isOnline);
@@ -79,6 +85,7 @@ private:
     QPointer<Messenger> m_messenger;
     QPointer<UserDatabase> m_userDatabase;
     QPointer<MessageOperationFactory> m_factory;
+    QPointer<AttachmentPrefetcher> m_prefetcher;
 };
 } // namespace vm
 
@@ -47,6 +47,7 @@ class CloudFilesTransfersModel;
 class CloudFilesQueue;
 class DiscoveredContactsModel;
 class FileLoader;
+class MessagesDecryptionWorker;
 class MessagesModel;
 class MessagesQueue;
 class Messenger;
@@ -85,6 +86,8 @@ public:
     MessagesModel *messages();
     const MessagesQueue *messagesQueue() const;
     MessagesQueue *messagesQueue();
+    const MessagesDecryptionWorker *messagesDecryptionWorker() const;
+    MessagesDecryptionWorker *messagesDecryptionWorker();
 
 signals:
     void notificationCreated(const QString &notification, const bool error);
@@ -99,6 +102,7 @@ private:
     QPointer<CloudFilesQueue> m_cloudFilesQueue;
     QPointer<FileLoader> m_fileLoader;
     QPointer<MessagesQueue> m_messagesQueue;
+    QPointer<MessagesDecryptionWorker> m_messagesDecryptionWorker;
 };
 } // namespace vm
 
@@ -42,10 +42,18 @@
 #include "OperationQueueListener.h"
 #include "OperationSource.h"
 
+#include <chrono>
+#include <memory>
+
 class QThreadPool;
+class QTimer;
 
 namespace vm {
+class MetricCounter;
+class MetricGauge;
+class MetricHistogram;
 class Operation;
+class OperationMonitor;
 
 class OperationQueue : public QObject
 {
@@ -64,22 +72,30 @@ public:
     void addSource(OperationSourcePtr source);
     void addListener(OperationQueueListenerPtr listener);
 
+    // Stop operations flagged by the watchdog, otherwise they are only logged and counted
+    void setStuckOperationsCancelEnabled(bool enabled);
+
 signals:
     void notificationCreated(const QString &notification, const bool error);
 
     void stopRequested(QPrivateSignal);
-    void operationFailed(OperationSourcePtr source, QPrivateSignal);
+    void operationFailed(OperationSourcePtr source, const QString &operationType, const QString &reasonCode,
+                         const QString &reason, QPrivateSignal);
 
 protected:
     virtual Operation *createOperation(OperationSourcePtr source) = 0;
     virtual void invalidateOperation(OperationSourcePtr source) = 0;
     virtual qsizetype maxAttemptCount() const = 0;
+    // How long operation of the type may stay started before the watchdog flags it, zero disables the check
+    virtual std::chrono::milliseconds operationDeadline(const QString &operationType) const;
 
 private:
     void addSourceImpl(OperationSourcePtr source, const bool run);
     void runSource(OperationSourcePtr source);
 
-    void onOperationFailed(OperationSourcePtr source);
+    void onOperationFailed(OperationSourcePtr source, const QString &operationType, const QString &reasonCode,
+                           const QString &reason);
+    void onWatchdogTimeout();
 
     const QLoggingCategory &m_category;
 
@@ -87,6 +103,20 @@ private:
     std::atomic_bool m_isStopped = false;
     OperationSources m_sources;
     OperationQueueListeners m_listeners;
+
+    std::unique_ptr<OperationMonitor> m_monitor;
+    QTimer *m_watchdogTimer;
+    bool m_isStuckCancelEnabled = false;
+    std::atomic<qint64> m_runningCount = 0;
+
+    MetricGauge *m_depthGauge;
+    MetricCounter *m_retryCounter;
+    MetricCounter *m_exhaustedCounter;
+    MetricHistogram *m_runLatency;
+    MetricHistogram *m_waitLatency;
+    MetricHistogram *m_attempts;
+    MetricGauge *m_runningGauge;
+    MetricGauge *m_runningMaxGauge;
 };
 } // namespace vm
 
@@ -35,8 +35,10 @@
 #ifndef VM_OPERATIONSOURCE_H
 #define VM_OPERATIONSOURCE_H
 
+#include <chrono>
 #include <memory>
 
+#include <QElapsedTimer>
 #include <QString>
 
 namespace vm {
@@ -58,9 +60,17 @@ public:
     void setPriority(Priority priority) { m_priority = priority; }
     Priority priority() const { return m_priority; }
 
+    // Time since the source was (re)enqueued, retried sources wait from the failure of the previous attempt
+    void markEnqueued() { m_enqueueTimer.start(); }
+    std::chrono::microseconds queueWait() const
+    {
+        return std::chrono::microseconds(m_enqueueTimer.isValid() ? m_enqueueTimer.nsecsElapsed() / 1000 : 0);
+    }
+
 private:
     qsizetype m_attemptCount = 0;
     Priority m_priority = Priority::Default;
+    QElapsedTimer m_enqueueTimer;
 };
 
 using OperationSourcePtr = std::shared_ptr<OperationSource>;
@@ -35,6 +35,7 @@
 #ifndef VM_LIST_CLOUD_FOLDER_OPERATION_H
 #define VM_LIST_CLOUD_FOLDER_OPERATION_H
 
+#include <QHash>
 #include <QPointer>
 
 #include "CloudFile.h"
@@ -51,13 +52,21 @@ class ListCloudFolderOperation : public Operation
     Q_OBJECT
 
 public:
-    ListCloudFolderOperation(CloudFileOperation *parent, const CloudFileHandler &parentFolder,
+    //
+    //  Navigate - show cached listing, list online if folder was changed or cached listing is old.
+    //  Refresh - show cached listing, always list online.
+    //  Prefetch - list online in background if folder was changed.
+    //
+    enum class Mode { Navigate, Refresh, Prefetch };
+
+    ListCloudFolderOperation(CloudFileOperation *parent, const CloudFileHandler &parentFolder, Mode mode,
                              UserDatabase *userDatabase);
 
     void run() override;
 
 signals:
     void onlineListingFailed();
+    void childFoldersOutdated(const CloudFiles &folders);
 
 private:
     void onDatabaseListFetched(const CloudFileHandler &parentFolder, const ModifiableCloudFiles &cloudFiles);
@@ -65,18 +74,25 @@ private:
                             const ModifiableCloudFiles &files);
     void onCloudListFetchErrorOccurred(CloudFileRequestId requestId, const QString &errorText);
 
+    bool isCachedListingActual(const CloudFileHandler &listedFolder) const;
+    CloudFiles findOutdatedChildFolders(const ModifiableCloudFiles &files) const;
     CloudListCloudFolderUpdate buildDifference(const CloudFileHandler &parentFolder,
                                                const ModifiableCloudFiles &files) const;
     void deleteObsoleteLocalFiles(const ModifiableCloudFiles &files);
+    void deleteObsoleteLocalFiles(const CloudListCloudFolderUpdate &update);
 
-    static bool fileIdLess(const ModifiableCloudFileHandler &lhs, const ModifiableCloudFileHandler &rhs);
+    static bool isListingChanged(const CloudFileHandler &listedFolder, const QDateTime &updatedAt);
     static bool fileUpdated(const ModifiableCloudFileHandler &lhs, const ModifiableCloudFileHandler &rhs);
+    static void removeLocalFile(const CloudFileHandler &file);
 
     CloudFileOperation *m_parent;
     CloudFileHandler m_parentFolder;
+    Mode m_mode;
     QPointer<UserDatabase> m_userDatabase;
 
     ModifiableCloudFiles m_cachedFiles;
+    QHash<QString, ModifiableCloudFileHandler> m_cachedFilesById;
+    bool m_wasListed = false;
     CloudFileRequestId m_requestId = 0;
 };
 } // namespace vm
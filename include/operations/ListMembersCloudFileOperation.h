@@ -50,6 +50,8 @@ class UserDatabase;
 
 class ListMembersCloudFileOperation : public Operation
 {
+    Q_OBJECT
+
 public:
     ListMembersCloudFileOperation(CloudFileOperation *parent, CloudFileHandler file, CloudFileHandler parentFolder,
                                   UserDatabase *userDatabase);
@@ -36,6 +36,9 @@
 #define VM_NETWORKOPERATION_H
 
 #include "Operation.h"
+#include "TransferScheduler.h"
+
+#include <optional>
 
 namespace vm {
 class NetworkOperation : public Operation
@@ -49,11 +52,18 @@ public:
     bool isOnline() const noexcept;
     void setIsOnline(bool isOnline);
 
+    //
+    //  Priority of file transfers within this operation, inherited from the parent operation if not set.
+    //
+    TransferPriority transferPriority() const;
+    void setTransferPriority(TransferPriority priority);
+
 protected:
     bool preRun() override;
 
 private:
     bool m_isOnline = false;
+    std::optional<TransferPriority> m_transferPriority;
 };
 } // namespace vm
 
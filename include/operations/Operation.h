@@ -43,6 +43,7 @@
 Q_DECLARE_LOGGING_CATEGORY(lcOperation)
 
 namespace vm {
+class OperationMonitor;
 class TimeProfiler;
 
 class Operation : public QObject
@@ -68,6 +69,16 @@ public:
     QString fullName() const;
     Status status() const;
 
+    // Class name without namespace, operations without own meta-object fall back to the name
+    QString type() const;
+    // Notification of the failed or invalidated operation, failed parents are prefixed with the failed child type
+    QString failureReason() const;
+    // Type of the innermost failed operation, it is this operation if it failed by itself
+    QString failedOperationType() const;
+
+    // Monitor is propagated to all children, including the ones appended later
+    void setMonitor(OperationMonitor *monitor);
+
     void appendChild(Operation *child);
     bool hasChildren() const;
 
@@ -99,6 +110,12 @@ protected:
 
 private:
     bool setStatus(const Status &status);
+    void reportStatus(const Status &status);
+    void traceStatus(const Status &status);
+
+    void onChildFailed(Operation *child);
+    void onChildInvalidated(Operation *child);
+    void setChildFailureReason(Operation *child);
 
     void startNextChild();
 
@@ -109,6 +126,11 @@ private:
     bool m_cleanedUp = false;
 
     TimeProfiler *m_timeProfiler = nullptr;
+    QString m_traceName;
+
+    OperationMonitor *m_monitor = nullptr;
+    QString m_failureReason;
+    QString m_failedOperationType;
 };
 } // namespace vm
 
@@ -0,0 +1,120 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+
+#ifndef VM_OPERATION_MONITOR_H
+#define VM_OPERATION_MONITOR_H
+
+#include "Operation.h"
+
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QString>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+Q_DECLARE_LOGGING_CATEGORY(lcOperationMonitor)
+
+namespace vm {
+class MetricCounter;
+class MetricHistogram;
+
+//
+//  Collect execution statistics of operation trees run by a queue: run time and outcome of every operation
+//  by its type, failure reasons, retries and operations that stay started longer than their deadline.
+//
+//  Operations report status changes from their own threads, stuck operations are checked by the queue
+//  from its thread, so all state is guarded by a mutex.
+//
+class OperationMonitor
+{
+public:
+    using DeadlineFunction = std::function<std::chrono::milliseconds(const QString &operationType)>;
+
+    explicit OperationMonitor(const QString &queueName);
+
+    void onStatusChanged(Operation *operation, Operation::Status status);
+    void onDestroyed(Operation *operation);
+
+    // Count retry of the failed root operation by the reason code and log the full reason
+    void recordRetry(const QString &operationType, const QString &reasonCode, const QString &reason);
+
+    //
+    //  Return bounded reason code of the failed operation to be used as a metric label:
+    //  "stopped" or type of the innermost failed operation. Full reasons hold notifications and server errors.
+    //
+    static QString failureReasonCode(const Operation *operation);
+
+    //
+    //  Log operations that are started longer than their deadline, each operation is flagged once.
+    //  Stuck operations are stopped within their threads if cancellation is enabled, zero deadline disables the check.
+    //
+    void checkStuckOperations(const DeadlineFunction &deadline, bool cancel);
+
+private:
+    struct TypeMetrics
+    {
+        MetricHistogram *runTime = nullptr;
+        MetricCounter *finished = nullptr;
+        MetricCounter *failed = nullptr;
+        MetricCounter *invalid = nullptr;
+        MetricCounter *stuck = nullptr;
+        MetricCounter *cancelled = nullptr;
+    };
+
+    struct RunningOperation
+    {
+        QString type;
+        QString fullName;
+        QElapsedTimer timer;
+        bool isStuck = false;
+        bool isCancelled = false;
+    };
+
+    TypeMetrics &typeMetrics(const QString &type);
+    void recordFailureReason(const QString &type, const QString &reasonCode, const QString &reason);
+
+    const QString m_queueName;
+
+    QMutex m_mutex;
+    std::map<QString, TypeMetrics> m_typeMetrics;
+    std::unordered_map<Operation *, RunningOperation> m_running;
+};
+} // namespace vm
+
+#endif // VM_OPERATION_MONITOR_H
@@ -45,6 +45,8 @@ class CloudFileOperation;
 
 class SetMembersCloudFileOperation : public Operation
 {
+    Q_OBJECT
+
 public:
     SetMembersCloudFileOperation(CloudFileOperation *parent, const CloudFileMembers &members,
                                  const CloudFileHandler &file, const CloudFileHandler &parentFolder);
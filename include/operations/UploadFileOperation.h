@@ -50,6 +50,11 @@ public:
 
     void run() override;
 
+    //
+    //  Request upload slot in advance, while the file is being prepared from the source of the given size.
+    //
+    void prefetchUploadSlot(qint64 sourceFileSize);
+
 signals:
     void uploadSlotReceived();
     void uploaded(const QUrl &getUrl);
@@ -59,6 +64,7 @@ protected:
 
 private:
     void connectReply(QNetworkReply *reply) override;
+    void cleanup() override;
 
     void startUpload();
 
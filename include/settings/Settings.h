@@ -96,6 +96,34 @@ public:
     bool devMode() const;
     bool autoSendCrashReport() const;
     bool timeProfilerEnabled() const;
+    // Record trace events and export them in Chrome trace-event format to the logs directory on quit
+    bool tracingEnabled() const;
+    // Interval of metrics snapshot dumps to the logs directory, 0 disables dumps
+    std::chrono::seconds metricsDumpInterval() const;
+    // Localhost port to serve metrics in Prometheus text format, 0 disables the endpoint
+    quint16 metricsPort() const;
+    // Time prepare, exec and row iteration of every SQL statement, dump stats to the logs directory on quit
+    bool databaseProfilingEnabled() const;
+    // Statements that take longer are logged while database profiling is enabled
+    std::chrono::milliseconds slowQueryThreshold() const;
+    // Cold start time from process start to the shown chat list, startup report warns when it is exceeded
+    std::chrono::milliseconds timeToChatListTarget() const;
+    // Stop queued operations that stay started longer than their deadline, otherwise they are only logged
+    bool cancelStuckOperationsEnabled() const;
+    // Send v4 envelopes to peers that advertised them, push notifications service still expects v3 JSON body
+    bool compactMessageEnvelopeEnabled() const;
+    // Minimal message content size in bytes to be compressed within compact envelope, 0 disables compression
+    int messageCompressionThreshold() const;
+    // Maximum number of concurrent file transfers to a single host, the rest are queued
+    int maxTransfersPerHost() const;
+    // Allow HTTP/2 for file transfers, so transfers to the same host are multiplexed over one connection
+    bool http2TransfersEnabled() const;
+    // File transfer rate limits in bytes per second by priority class, 0 means unlimited
+    qint64 interactiveTransferRateLimit() const;
+    qint64 preloadTransferRateLimit() const;
+    qint64 backgroundTransferRateLimit() const;
+    // Total file transfer rate limit in bytes per second, e.g. for metered networks, 0 means unlimited
+    qint64 globalTransferRateLimit() const;
 
     // Window
     QRect windowGeometry() const;
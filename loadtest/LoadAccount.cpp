@@ -0,0 +1,408 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "LoadAccount.h"
+
+#include "Chat.h"
+#include "FileLoader.h"
+#include "IncomingMessage.h"
+#include "LoadMessenger.h"
+#include "MessageContentFile.h"
+#include "MessageContentText.h"
+#include "MessagePacking.h"
+#include "OutgoingMessage.h"
+#include "database/UserDatabase.h"
+#include "models/MessagesQueue.h"
+
+#include <qxmpp/QXmppClient.h>
+#include <qxmpp/QXmppConfiguration.h>
+#include <qxmpp/QXmppHttpUploadIq.h>
+#include <qxmpp/QXmppMessage.h>
+#include <qxmpp/QXmppUploadRequestManager.h>
+#include <qxmpp/QXmppUtils.h>
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QMimeType>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QRandomGenerator>
+
+Q_LOGGING_CATEGORY(lcLoadAccount, "load-account");
+
+using namespace vm;
+using Self = LoadAccount;
+
+namespace {
+bool writeRandomFile(const QString &filePath, qint64 size)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QByteArray chunk(64 * 1024, Qt::Uninitialized);
+    for (qint64 written = 0; written < size; written += chunk.size()) {
+        QRandomGenerator::global()->fillRange(reinterpret_cast<quint32 *>(chunk.data()), chunk.size() / 4);
+        if (file.write(chunk.constData(), std::min<qint64>(chunk.size(), size - written)) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+Self::LoadAccount(Config config, Settings *settings, UserDatabase *database, FileLoader *fileLoader,
+                  QObject *parent)
+    : QObject(parent),
+      m_config(std::move(config)),
+      m_fileLoader(fileLoader),
+      m_database(database),
+      m_xmpp(new QXmppClient(this)),
+      m_messenger(new LoadMessenger(settings, fileLoader, m_xmpp, m_config.domain, this)),
+      m_messagesQueue(new MessagesQueue(m_messenger, database, this)),
+      m_uploadManager(new QXmppUploadRequestManager()),
+      m_networkAccessManager(new QNetworkAccessManager(this))
+{
+    m_config.dataDir.mkpath(QLatin1String("."));
+    m_xmpp->addExtension(m_uploadManager);
+
+    connect(m_database, &UserDatabase::opened, this, [this]() {
+        m_isDatabaseOpened = true;
+        checkReady();
+    });
+    connect(m_xmpp, &QXmppClient::connected, this, [this]() {
+        m_isXmppConnected = true;
+        checkReady();
+    });
+    connect(m_xmpp, &QXmppClient::error, this, [this](QXmppClient::Error error) {
+        emit errorOccurred(QString("XMPP error %1 for %2").arg(error).arg(m_config.username));
+    });
+    connect(m_xmpp, &QXmppClient::messageReceived, this, &Self::onXmppMessageReceived);
+    connect(m_uploadManager, &QXmppUploadRequestManager::slotReceived, this, &Self::onUploadSlotReceived);
+    connect(m_uploadManager, &QXmppUploadRequestManager::requestFailed, this, &Self::onUploadRequestFailed);
+    connect(m_messagesQueue, &MessagesQueue::updateMessage, this, &Self::onMessageUpdated);
+}
+
+Self::~LoadAccount() = default;
+
+QString Self::username() const
+{
+    return m_config.username;
+}
+
+void Self::start()
+{
+    lookupIdentity(m_config.username, [this](const QString &identity) {
+        m_identity = identity;
+        emit m_database->openUser(m_config.username);
+        connectXmpp();
+    });
+}
+
+void Self::stop()
+{
+    m_messagesQueue->stop();
+    m_xmpp->disconnectFromServer();
+    emit m_database->closeUser();
+}
+
+QString Self::sendText(const QString &recipientUsername, const QString &text)
+{
+    auto message = std::make_shared<OutgoingMessage>();
+    message->setId(MessageId::generate());
+    message->setContent(MessageContentText(text));
+    sendMessage(recipientUsername, message);
+    return message->id();
+}
+
+QString Self::sendAttachment(const QString &recipientUsername, qint64 size)
+{
+    auto message = std::make_shared<OutgoingMessage>();
+    message->setId(MessageId::generate());
+
+    MessageContentFile file;
+    file.setId(AttachmentId::generate());
+    file.setFileName(QString("attachment-%1.bin").arg(file.id()));
+    file.setSize(size);
+    file.setEncryptedSize(size);
+    const auto filePath = m_config.dataDir.filePath(file.fileName());
+    file.setLocalPath(filePath);
+    message->setContent(std::move(file));
+
+    if (!writeRandomFile(filePath, size)) {
+        qCWarning(lcLoadAccount) << "Can not write attachment:" << filePath;
+        emit messageFailed(message->id());
+        return message->id();
+    }
+
+    //
+    //  Message is sent when the attachment is uploaded.
+    //
+    message->setRecipientUsername(recipientUsername);
+    const auto requestId = m_uploadManager->requestUploadSlot(QFileInfo(filePath).fileName(), size, QMimeType(),
+                                                              m_config.uploadService);
+    m_pendingUploads.insert(requestId, { message, filePath });
+    return message->id();
+}
+
+void Self::checkReady()
+{
+    if (m_isDatabaseOpened && m_isXmppConnected) {
+        emit ready();
+    }
+}
+
+void Self::lookupIdentity(const QString &username, std::function<void(const QString &identity)> callback)
+{
+    const auto identityIt = m_identities.constFind(username);
+    if (identityIt != m_identities.constEnd()) {
+        callback(*identityIt);
+        return;
+    }
+
+    QUrl url(m_config.keyDirectoryUrl);
+    url.setPath(QLatin1String("/users/") + username);
+    auto reply = m_networkAccessManager->get(QNetworkRequest(url));
+    connect(reply, &QNetworkReply::finished, this, [this, reply, username, callback = std::move(callback)]() {
+        reply->deleteLater();
+        const auto identity = QJsonDocument::fromJson(reply->readAll())[QLatin1String("identity")].toString();
+        if (reply->error() != QNetworkReply::NoError || identity.isEmpty()) {
+            emit errorOccurred(QString("User %1 was not found: %2").arg(username, reply->errorString()));
+            return;
+        }
+        m_identities.insert(username, identity);
+        callback(identity);
+    });
+}
+
+void Self::connectXmpp()
+{
+    QXmppConfiguration config;
+    config.setHost(QLatin1String("127.0.0.1"));
+    config.setPort(m_config.xmppPort);
+    config.setDomain(m_config.domain);
+    config.setUser(m_identity);
+    config.setPassword(QLatin1String("load"));
+    config.setResource(QLatin1String("load"));
+    config.setStreamSecurityMode(QXmppConfiguration::TLSDisabled);
+    config.setSaslAuthMechanism(QLatin1String("PLAIN"));
+    config.setAutoReconnectionEnabled(false);
+    m_xmpp->connectToServer(config);
+}
+
+void Self::sendMessage(const QString &recipientUsername, ModifiableMessageHandler message)
+{
+    lookupIdentity(recipientUsername, [this, message, recipientUsername](const QString &recipientIdentity) {
+        message->setSenderId(UserId(m_identity));
+        message->setSenderUsername(m_config.username);
+        message->setRecipientId(UserId(recipientIdentity));
+        message->setRecipientUsername(recipientUsername);
+        message->setCreatedNow();
+        std::static_pointer_cast<OutgoingMessage>(message)->setStage(OutgoingMessage::Stage::Created);
+        writeMessage(message);
+        if (message->contentIsAttachment()) {
+            sendAttachmentMessage(message);
+        } else {
+            emit m_messagesQueue->pushMessage(message);
+        }
+    });
+}
+
+void Self::sendAttachmentMessage(const MessageHandler &message)
+{
+    //
+    //  Attachment is uploaded already, so the message is sent without the upload operations of the queue.
+    //
+    OutgoingMessageStageUpdate update;
+    update.messageId = message->id();
+    update.stage = m_messenger->sendMessage(message) ? OutgoingMessageStage::Sent : OutgoingMessageStage::Broken;
+    onMessageUpdated(update);
+}
+
+void Self::writeMessage(const MessageHandler &message)
+{
+    //
+    //  The first message creates chat as the application does.
+    //
+    const auto chatId = message->chatId();
+    if (m_knownChats.contains(chatId)) {
+        emit m_database->writeMessage(message);
+        return;
+    }
+
+    m_knownChats.insert(chatId);
+    auto chat = std::make_shared<Chat>();
+    chat->setId(chatId);
+    chat->setCreatedAt(message->createdAt());
+    chat->setType(Chat::Type::Personal);
+    chat->setTitle(message->isIncoming() ? message->senderUsername() : message->recipientUsername());
+    chat->setLastMessage(message);
+    emit m_database->writeChatAndLastMessage(chat);
+}
+
+void Self::onMessageUpdated(const MessageUpdate &messageUpdate)
+{
+    emit m_database->updateMessage(messageUpdate);
+
+    const auto stageUpdate = std::get_if<OutgoingMessageStageUpdate>(&messageUpdate);
+    if (!stageUpdate) {
+        return;
+    }
+
+    if (stageUpdate->stage == OutgoingMessageStage::Sent) {
+        emit messageSent(stageUpdate->messageId);
+    } else if (stageUpdate->stage == OutgoingMessageStage::Broken) {
+        emit messageFailed(stageUpdate->messageId);
+    }
+}
+
+void Self::onXmppMessageReceived(const QXmppMessage &xmppMessage)
+{
+    if (xmppMessage.marker() == QXmppMessage::Marker::Received) {
+        emit messageDelivered(xmppMessage.markerId());
+        return;
+    }
+
+    if (xmppMessage.body().isEmpty()) {
+        return;
+    }
+
+    const auto ciphertext = MessagePacking::unpackXmppMessageBody(xmppMessage.body());
+    const auto messageData = std::get_if<QByteArray>(&ciphertext);
+
+    auto message = std::make_shared<IncomingMessage>();
+    message->setId(MessageId(xmppMessage.id()));
+    message->setSenderId(UserId(QXmppUtils::jidToUser(xmppMessage.from())));
+    message->setRecipientId(UserId(m_identity));
+    message->setRecipientUsername(m_config.username);
+    message->setCreatedAt(xmppMessage.stamp());
+    if (!messageData || MessagePacking::unpackMessage(*messageData, *message) != CoreMessengerStatus::Success) {
+        qCWarning(lcLoadAccount) << "Got malformed message:" << xmppMessage.id();
+        return;
+    }
+    message->setStage(IncomingMessage::Stage::Decrypted);
+
+    QXmppMessage mark;
+    mark.setTo(xmppMessage.from());
+    mark.setFrom(xmppMessage.to());
+    mark.setMarkerId(xmppMessage.id());
+    mark.setMarker(QXmppMessage::Marker::Received);
+    m_xmpp->sendPacket(mark);
+
+    if (std::holds_alternative<MessageContentFile>(message->content())) {
+        downloadAttachment(message);
+    } else {
+        writeMessage(message);
+        emit messageReceived(message->id());
+    }
+}
+
+void Self::onUploadSlotReceived(const QXmppHttpUploadSlotIq &slot)
+{
+    const auto pendingUpload = m_pendingUploads.take(slot.id());
+    const auto message = pendingUpload.message;
+    if (!message) {
+        return;
+    }
+
+    auto file = new QFile(pendingUpload.filePath, this);
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        emit messageFailed(message->id());
+        return;
+    }
+
+    const auto getUrl = slot.getUrl();
+    emit m_fileLoader->startUpload(
+            slot.putUrl(), file, TransferPriority::Interactive, [this, message, file, getUrl](QNetworkReply *reply) {
+                connect(reply, &QNetworkReply::finished, this, [this, message, file, getUrl, reply]() {
+                    reply->deleteLater();
+                    file->deleteLater();
+                    if (reply->error() != QNetworkReply::NoError) {
+                        qCWarning(lcLoadAccount) << "Upload failed:" << reply->errorString();
+                        emit messageFailed(message->id());
+                        return;
+                    }
+
+                    auto &attachment = std::get<MessageContentFile>(message->content());
+                    attachment.setRemoteUrl(getUrl);
+                    attachment.setUploadStage(MessageContentUploadStage::Uploaded);
+                    sendMessage(message->recipientUsername(), message);
+                });
+            });
+}
+
+void Self::onUploadRequestFailed(const QXmppHttpUploadRequestIq &request)
+{
+    const auto pendingUpload = m_pendingUploads.take(request.id());
+    if (pendingUpload.message) {
+        emit messageFailed(pendingUpload.message->id());
+    }
+}
+
+void Self::downloadAttachment(ModifiableMessageHandler message)
+{
+    auto &attachment = std::get<MessageContentFile>(message->content());
+    const auto filePath = m_config.dataDir.filePath(QLatin1String("received-") + attachment.fileName());
+
+    auto file = new QFile(filePath, this);
+    if (!file->open(QIODevice::WriteOnly)) {
+        delete file;
+        qCWarning(lcLoadAccount) << "Can not open download file:" << filePath;
+        return;
+    }
+
+    emit m_fileLoader->startDownload(
+            attachment.remoteUrl(), file, TransferPriority::Interactive, [this, message, file](QNetworkReply *reply) {
+                connect(reply, &QNetworkReply::finished, this, [this, message, file, reply]() {
+                    reply->deleteLater();
+                    file->deleteLater();
+                    if (reply->error() != QNetworkReply::NoError) {
+                        qCWarning(lcLoadAccount) << "Download failed:" << reply->errorString();
+                        return;
+                    }
+
+                    auto &attachment = std::get<MessageContentFile>(message->content());
+                    attachment.setLocalPath(file->fileName());
+                    attachment.setDownloadStage(MessageContentDownloadStage::Downloaded);
+                    writeMessage(message);
+                    emit messageReceived(message->id());
+                });
+            });
+}
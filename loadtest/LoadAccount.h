@@ -0,0 +1,155 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_LOAD_ACCOUNT_H
+#define VM_LOAD_ACCOUNT_H
+
+#include "Message.h"
+#include "MessageUpdate.h"
+
+#include <QDir>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QUrl>
+
+#include <functional>
+
+class QNetworkAccessManager;
+class QXmppClient;
+class QXmppHttpUploadRequestIq;
+class QXmppHttpUploadSlotIq;
+class QXmppMessage;
+class QXmppUploadRequestManager;
+
+namespace vm {
+class FileLoader;
+class LoadMessenger;
+class MessagesQueue;
+class Settings;
+class UserDatabase;
+
+//
+//  Simulated messenger account without UI.
+//  Text messages go through the same MessagesQueue and database as the application does,
+//  the queue sends them with the LoadMessenger that omits encryption, since Comm Kit needs real Virgil services.
+//  Attachments are uploaded with the FileLoader directly, since upload slots are requested via Comm Kit.
+//
+class LoadAccount : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Self = LoadAccount;
+
+    struct Config
+    {
+        QString username;
+        QString domain;
+        quint16 xmppPort = 0;
+        QString uploadService;
+        QUrl keyDirectoryUrl;
+        QDir dataDir;
+    };
+
+    LoadAccount(Config config, Settings *settings, UserDatabase *database, FileLoader *fileLoader, QObject *parent);
+    ~LoadAccount() override;
+
+    QString username() const;
+
+    //
+    //  Resolve own identity within the key directory, open database and connect to the XMPP server.
+    //
+    void start();
+    void stop();
+
+    //
+    //  Send text or attachment of the given size and return message id.
+    //
+    QString sendText(const QString &recipientUsername, const QString &text);
+    QString sendAttachment(const QString &recipientUsername, qint64 size);
+
+signals:
+    //
+    //  Emitted when both database is opened and XMPP is connected.
+    //
+    void ready();
+    void errorOccurred(const QString &errorText);
+
+    void messageSent(const QString &messageId);
+    void messageFailed(const QString &messageId);
+    void messageReceived(const QString &messageId);
+    void messageDelivered(const QString &messageId);
+
+private:
+    struct PendingUpload
+    {
+        ModifiableMessageHandler message;
+        QString filePath;
+    };
+
+    void lookupIdentity(const QString &username, std::function<void(const QString &identity)> callback);
+    void connectXmpp();
+    void checkReady();
+
+    void sendMessage(const QString &recipientUsername, ModifiableMessageHandler message);
+    void sendAttachmentMessage(const MessageHandler &message);
+    void writeMessage(const MessageHandler &message);
+
+    void onMessageUpdated(const MessageUpdate &messageUpdate);
+
+    void onXmppMessageReceived(const QXmppMessage &xmppMessage);
+    void onUploadSlotReceived(const QXmppHttpUploadSlotIq &slot);
+    void onUploadRequestFailed(const QXmppHttpUploadRequestIq &request);
+    void downloadAttachment(ModifiableMessageHandler message);
+
+    const Config m_config;
+    QPointer<FileLoader> m_fileLoader;
+    QPointer<UserDatabase> m_database;
+    QXmppClient *m_xmpp = nullptr;
+    LoadMessenger *m_messenger = nullptr;
+    MessagesQueue *m_messagesQueue = nullptr;
+    QXmppUploadRequestManager *m_uploadManager = nullptr;
+    QNetworkAccessManager *m_networkAccessManager = nullptr;
+    QString m_identity;
+    bool m_isDatabaseOpened = false;
+    bool m_isXmppConnected = false;
+    QHash<QString, QString> m_identities;
+    QSet<QString> m_knownChats;
+    QHash<QString, PendingUpload> m_pendingUploads;
+};
+} // namespace vm
+
+#endif // VM_LOAD_ACCOUNT_H
@@ -0,0 +1,376 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "LoadHarness.h"
+
+#include "CoreMessenger.h"
+#include "FileLoader.h"
+#include "LoadAccount.h"
+#include "LocalHttpServer.h"
+#include "LocalXmppServer.h"
+#include "Metrics.h"
+#include "Settings.h"
+#include "database/MessagesTable.h"
+#include "database/UserDatabase.h"
+
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QThread>
+
+#if defined(Q_OS_UNIX)
+#    include <sys/resource.h>
+#endif
+
+Q_LOGGING_CATEGORY(lcLoadHarness, "load-harness");
+
+using namespace vm;
+using Self = LoadHarness;
+
+namespace {
+const auto kDomain = QLatin1String("loadtest.localhost");
+
+bool writeFile(const QString &filePath, const QByteArray &data)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(data);
+    return file.commit();
+}
+} // namespace
+
+Self::LoadHarness(Options options, QObject *parent)
+    : QObject(parent),
+      m_options(std::move(options)),
+      m_settings(new Settings(this)),
+      m_coreMessenger(new CoreMessenger(m_settings, this)),
+      m_fileLoader(new FileLoader(m_settings, m_coreMessenger, this)),
+      m_httpServer(new LocalHttpServer(this))
+{
+    auto metrics = Metrics::instance();
+    m_textLatency = metrics->histogram("loadtest_send_to_receive_microseconds", { { "kind", "text" } });
+    m_attachmentLatency = metrics->histogram("loadtest_send_to_receive_microseconds", { { "kind", "attachment" } });
+    m_deliveryLatency = metrics->histogram("loadtest_delivery_ack_microseconds");
+    m_databaseWrites = metrics->counter("loadtest_database_writes_total");
+
+    m_sendTimer.setInterval(std::max(1, qRound(1000.0 / m_options.sendRate)));
+    connect(&m_sendTimer, &QTimer::timeout, this, &Self::onSendTick);
+
+    m_timeoutTimer.setSingleShot(true);
+    m_timeoutTimer.setInterval(m_options.timeout);
+    connect(&m_timeoutTimer, &QTimer::timeout, this, [this]() { finish(true); });
+
+    //
+    //  All databases share the thread, so probing one of them measures the whole backlog.
+    //
+    m_databaseProbeTimer.setInterval(100);
+    connect(&m_databaseProbeTimer, &QTimer::timeout, this, [this]() { m_databases.front()->probeQueue(); });
+
+    m_clock.start();
+}
+
+Self::~LoadHarness()
+{
+    if (m_databaseThread) {
+        m_databaseThread->quit();
+        m_databaseThread->wait();
+    }
+    qDeleteAll(m_databases);
+    delete m_databaseThread;
+}
+
+void Self::start()
+{
+    if (!m_dataDir.isValid() || !m_httpServer->listen()) {
+        qCCritical(lcLoadHarness) << "Can not prepare local services";
+        emit finished(false);
+        return;
+    }
+
+    m_xmppServer = new LocalXmppServer(kDomain, m_httpServer->baseUrl(), this);
+    if (!m_xmppServer->listen()) {
+        emit finished(false);
+        return;
+    }
+
+    qCInfo(lcLoadHarness).nospace() << "Start " << m_options.accountCount << " accounts, XMPP port "
+                                    << m_xmppServer->port() << ", HTTP " << m_httpServer->baseUrl().toString()
+                                    << ", data " << m_dataDir.path();
+
+    m_databaseThread = new QThread();
+    m_databaseThread->setObjectName("DatabaseThread");
+    m_databaseThread->start();
+
+    const QDir dataDir(m_dataDir.path());
+    for (int index = 0; index < m_options.accountCount; ++index) {
+        LoadAccount::Config config;
+        config.username = QString("load-user-%1").arg(index);
+        config.domain = m_xmppServer->domain();
+        config.xmppPort = m_xmppServer->port();
+        config.uploadService = m_xmppServer->uploadService();
+        config.keyDirectoryUrl = m_httpServer->baseUrl();
+        config.dataDir.setPath(dataDir.filePath(config.username));
+
+        auto database = new UserDatabase(config.dataDir, nullptr);
+        m_databases.push_back(database);
+
+        //
+        //  Tables are created when the database is opened, and it happens before the account is ready.
+        //
+        connect(database, &UserDatabase::opened, this, [this, database]() {
+            connect(
+                    database->messagesTable(), &MessagesTable::messageAdded, database,
+                    [counter = m_databaseWrites]() { counter->increment(); }, Qt::DirectConnection);
+        });
+        connect(database, &UserDatabase::errorOccurred, this,
+                [](const QString &errorText) { qCWarning(lcLoadHarness) << "Database error:" << errorText; });
+        database->moveToThread(m_databaseThread);
+
+        auto account = new LoadAccount(std::move(config), m_settings, database, m_fileLoader, this);
+        connect(account, &LoadAccount::ready, this, &Self::onAccountReady);
+        connect(account, &LoadAccount::messageSent, this, [this]() { ++m_sentCount; });
+        connect(account, &LoadAccount::messageReceived, this, &Self::onMessageReceived);
+        connect(account, &LoadAccount::messageDelivered, this, &Self::onMessageDelivered);
+        connect(account, &LoadAccount::messageFailed, this, &Self::onMessageFailed);
+        connect(account, &LoadAccount::errorOccurred, this,
+                [](const QString &errorText) { qCWarning(lcLoadHarness) << errorText; });
+        m_accounts.push_back(account);
+    }
+
+    m_timeoutTimer.start();
+    m_databaseProbeTimer.start();
+    for (auto account : m_accounts) {
+        account->start();
+    }
+}
+
+void Self::onAccountReady()
+{
+    if (++m_readyAccountCount < m_options.accountCount) {
+        return;
+    }
+
+    qCInfo(lcLoadHarness) << "All accounts are ready in" << m_clock.elapsed() << "ms, start sending";
+    m_sendStartedAt = m_clock.nsecsElapsed() / 1000;
+    m_sendTimer.start();
+}
+
+void Self::onSendTick()
+{
+    const int roundCount = m_options.messagesPerAccount + m_options.attachmentsPerAccount;
+    if (m_sendRound >= roundCount) {
+        m_sendTimer.stop();
+        return;
+    }
+
+    //
+    //  Attachments are spread evenly between text messages, recipients are rotated.
+    //
+    const qint64 attachmentCount = m_options.attachmentsPerAccount;
+    const bool isAttachment = (m_sendRound * attachmentCount) / roundCount
+            != ((m_sendRound + 1) * attachmentCount) / roundCount;
+    const auto accountCount = static_cast<int>(m_accounts.size());
+
+    for (int index = 0; index < accountCount; ++index) {
+        auto account = m_accounts[index];
+        const auto recipient = m_accounts[(index + 1 + m_sendRound % (accountCount - 1)) % accountCount]->username();
+        const auto startedAt = m_clock.nsecsElapsed() / 1000;
+        const auto text = QString("Message #%1 from %2").arg(m_sendRound).arg(account->username());
+        const auto messageId = isAttachment ? account->sendAttachment(recipient, m_options.attachmentSize)
+                                            : account->sendText(recipient, text);
+
+        m_pendingMessages.insert(messageId, { isAttachment, startedAt });
+        if (!isAttachment) {
+            m_undeliveredMessages.insert(messageId, startedAt);
+        }
+    }
+
+    if (++m_sendRound >= roundCount) {
+        m_sendTimer.stop();
+    }
+}
+
+void Self::onMessageReceived(const QString &messageId)
+{
+    const auto it = m_pendingMessages.find(messageId);
+    if (it == m_pendingMessages.end()) {
+        return;
+    }
+
+    m_lastReceivedAt = m_clock.nsecsElapsed() / 1000;
+    const auto latency = static_cast<quint64>(m_lastReceivedAt - it->startedAt);
+    (it->isAttachment ? m_attachmentLatency : m_textLatency)->record(latency);
+    m_pendingMessages.erase(it);
+    ++m_receivedCount;
+
+    checkCompletion();
+}
+
+void Self::onMessageDelivered(const QString &messageId)
+{
+    const auto startedAt = m_undeliveredMessages.take(messageId);
+    if (startedAt > 0) {
+        m_deliveryLatency->record(static_cast<quint64>(m_clock.nsecsElapsed() / 1000 - startedAt));
+    }
+}
+
+void Self::onMessageFailed(const QString &messageId)
+{
+    qCWarning(lcLoadHarness) << "Message failed:" << messageId;
+    m_pendingMessages.remove(messageId);
+    m_undeliveredMessages.remove(messageId);
+    ++m_failedCount;
+
+    checkCompletion();
+}
+
+void Self::checkCompletion()
+{
+    const int roundCount = m_options.messagesPerAccount + m_options.attachmentsPerAccount;
+    if (m_isFinished || m_sendRound < roundCount || !m_pendingMessages.isEmpty()) {
+        return;
+    }
+
+    //
+    //  Every delivered message is written by both sender and recipient, wait for the database thread.
+    //
+    if (m_databaseWrites->value() < 2 * m_receivedCount) {
+        QTimer::singleShot(100, this, &Self::checkCompletion);
+        return;
+    }
+
+    finish(false);
+}
+
+void Self::finish(bool isTimedOut)
+{
+    if (m_isFinished) {
+        return;
+    }
+    m_isFinished = true;
+    m_sendTimer.stop();
+    m_timeoutTimer.stop();
+    m_databaseProbeTimer.stop();
+
+    const auto report = createReport(isTimedOut);
+    QTextStream(stdout) << QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if (!m_options.reportPath.isEmpty() && !writeFile(m_options.reportPath, QJsonDocument(report).toJson())) {
+        qCWarning(lcLoadHarness) << "Can not write report:" << m_options.reportPath;
+    }
+    if (!m_options.metricsPath.isEmpty()
+        && !writeFile(m_options.metricsPath, Metrics::instance()->toPrometheusText())) {
+        qCWarning(lcLoadHarness) << "Can not write metrics:" << m_options.metricsPath;
+    }
+
+    for (auto account : m_accounts) {
+        account->stop();
+    }
+
+    emit finished(!isTimedOut && m_failedCount == 0 && m_pendingMessages.isEmpty());
+}
+
+QJsonObject Self::createReport(bool isTimedOut) const
+{
+    const auto durationUs = std::max<qint64>(1, m_lastReceivedAt - m_sendStartedAt);
+    const auto durationSeconds = static_cast<double>(durationUs) / 1e6;
+    const auto databaseWrites = m_databaseWrites->value();
+
+    QJsonObject options;
+    options[QLatin1String("accounts")] = m_options.accountCount;
+    options[QLatin1String("messagesPerAccount")] = m_options.messagesPerAccount;
+    options[QLatin1String("attachmentsPerAccount")] = m_options.attachmentsPerAccount;
+    options[QLatin1String("attachmentSize")] = m_options.attachmentSize;
+    options[QLatin1String("sendRate")] = m_options.sendRate;
+
+    QJsonObject latency;
+    latency[QLatin1String("text")] = latencyReport(m_textLatency);
+    latency[QLatin1String("attachment")] = latencyReport(m_attachmentLatency);
+    latency[QLatin1String("deliveryAck")] = latencyReport(m_deliveryLatency);
+
+    QJsonObject report;
+    report[QLatin1String("options")] = options;
+    report[QLatin1String("timedOut")] = isTimedOut;
+    report[QLatin1String("sent")] = static_cast<qint64>(m_sentCount);
+    report[QLatin1String("received")] = static_cast<qint64>(m_receivedCount);
+    report[QLatin1String("failed")] = static_cast<qint64>(m_failedCount);
+    report[QLatin1String("lost")] = m_pendingMessages.size();
+    report[QLatin1String("durationSeconds")] = durationSeconds;
+    report[QLatin1String("messagesPerSecond")] = static_cast<double>(m_receivedCount) / durationSeconds;
+    report[QLatin1String("latencyMicroseconds")] = latency;
+    report[QLatin1String("databaseWrites")] = static_cast<qint64>(databaseWrites);
+    report[QLatin1String("databaseWritesPerSecond")] = static_cast<double>(databaseWrites) / durationSeconds;
+    if (m_xmppServer) {
+        report[QLatin1String("xmppRoutedStanzas")] = static_cast<qint64>(m_xmppServer->routedStanzaCount());
+    }
+    report[QLatin1String("httpRequests")] = static_cast<qint64>(m_httpServer->requestCount());
+    report[QLatin1String("httpStoredBytes")] = m_httpServer->storedBytes();
+    report[QLatin1String("peakMemoryBytes")] = peakMemoryUsage();
+    return report;
+}
+
+QJsonObject Self::latencyReport(const MetricHistogram *histogram)
+{
+    const auto snapshot = histogram->snapshot();
+
+    QJsonObject report;
+    report[QLatin1String("count")] = static_cast<qint64>(snapshot.count);
+    if (snapshot.count > 0) {
+        report[QLatin1String("p50")] = static_cast<qint64>(snapshot.valueAtQuantile(0.5));
+        report[QLatin1String("p99")] = static_cast<qint64>(snapshot.valueAtQuantile(0.99));
+        report[QLatin1String("max")] = static_cast<qint64>(snapshot.max);
+        report[QLatin1String("mean")] = static_cast<qint64>(snapshot.sum / snapshot.count);
+    }
+    return report;
+}
+
+qint64 Self::peakMemoryUsage()
+{
+#if defined(Q_OS_UNIX)
+    struct rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#    if defined(Q_OS_MACOS)
+    return usage.ru_maxrss;
+#    else
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#    endif
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,145 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_LOAD_HARNESS_H
+#define VM_LOAD_HARNESS_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include <chrono>
+#include <vector>
+
+class QThread;
+
+namespace vm {
+class CoreMessenger;
+class FileLoader;
+class LoadAccount;
+class LocalHttpServer;
+class LocalXmppServer;
+class MetricCounter;
+class MetricHistogram;
+class Settings;
+class UserDatabase;
+
+//
+//  Drive simulated accounts against the local XMPP and HTTP services,
+//  then report send-to-receive latency, throughput, database write rate and memory usage.
+//
+class LoadHarness : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Self = LoadHarness;
+
+    struct Options
+    {
+        int accountCount = 10;
+        int messagesPerAccount = 100;
+        int attachmentsPerAccount = 0;
+        qint64 attachmentSize = 64 * 1024;
+        double sendRate = 10.0; // messages per second for every account
+        std::chrono::seconds timeout { 120 };
+        QString reportPath;
+        QString metricsPath;
+    };
+
+    LoadHarness(Options options, QObject *parent);
+    ~LoadHarness() override;
+
+    void start();
+
+signals:
+    void finished(bool isSucceeded);
+
+private:
+    struct PendingMessage
+    {
+        bool isAttachment = false;
+        qint64 startedAt = 0;
+    };
+
+    void onAccountReady();
+    void onSendTick();
+    void onMessageReceived(const QString &messageId);
+    void onMessageDelivered(const QString &messageId);
+    void onMessageFailed(const QString &messageId);
+    void checkCompletion();
+    void finish(bool isTimedOut);
+
+    QJsonObject createReport(bool isTimedOut) const;
+    static QJsonObject latencyReport(const MetricHistogram *histogram);
+    static qint64 peakMemoryUsage();
+
+    const Options m_options;
+    QTemporaryDir m_dataDir;
+    QThread *m_databaseThread = nullptr;
+    Settings *m_settings = nullptr;
+    CoreMessenger *m_coreMessenger = nullptr;
+    FileLoader *m_fileLoader = nullptr;
+    LocalHttpServer *m_httpServer = nullptr;
+    LocalXmppServer *m_xmppServer = nullptr;
+    std::vector<UserDatabase *> m_databases;
+    std::vector<LoadAccount *> m_accounts;
+
+    QTimer m_sendTimer;
+    QTimer m_timeoutTimer;
+    QTimer m_databaseProbeTimer;
+    QElapsedTimer m_clock;
+    qint64 m_sendStartedAt = 0;
+    qint64 m_lastReceivedAt = 0;
+    int m_readyAccountCount = 0;
+    int m_sendRound = 0;
+    bool m_isFinished = false;
+
+    QHash<QString, PendingMessage> m_pendingMessages;
+    QHash<QString, qint64> m_undeliveredMessages;
+    quint64 m_sentCount = 0;
+    quint64 m_receivedCount = 0;
+    quint64 m_failedCount = 0;
+
+    MetricHistogram *m_textLatency = nullptr;
+    MetricHistogram *m_attachmentLatency = nullptr;
+    MetricHistogram *m_deliveryLatency = nullptr;
+    MetricCounter *m_databaseWrites = nullptr;
+};
+} // namespace vm
+
+#endif // VM_LOAD_HARNESS_H
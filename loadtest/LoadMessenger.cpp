@@ -0,0 +1,119 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "LoadMessenger.h"
+
+#include "MessagePacking.h"
+
+#include <qxmpp/QXmppClient.h>
+#include <qxmpp/QXmppMessage.h>
+
+#include <QFile>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcLoadMessenger, "load-messenger");
+
+using namespace vm;
+using Self = LoadMessenger;
+
+namespace {
+//
+//  Same threshold the application uses for the envelope compression.
+//
+constexpr int kCompressionThreshold = 1024;
+
+bool copyFile(const QString &sourceFilePath, const QString &destFilePath)
+{
+    QFile::remove(destFilePath);
+    return QFile::copy(sourceFilePath, destFilePath);
+}
+} // namespace
+
+Self::LoadMessenger(Settings *settings, FileLoader *fileLoader, QXmppClient *xmpp, QString domain,
+                    QObject *parent)
+    : Messenger(settings, fileLoader, parent), m_xmpp(xmpp), m_domain(std::move(domain))
+{
+    connect(m_xmpp, &QXmppClient::connected, this, [this]() { emit onlineStatusChanged(true); });
+    connect(m_xmpp, &QXmppClient::disconnected, this, [this]() { emit onlineStatusChanged(false); });
+}
+
+bool Self::isOnline() const noexcept
+{
+    return m_xmpp && m_xmpp->isConnected();
+}
+
+bool Self::sendMessage(MessageHandler message)
+{
+    if (!isOnline()) {
+        qCWarning(lcLoadMessenger) << "Can not send message while offline:" << message->id();
+        return false;
+    }
+
+    const auto ciphertext = MessagePacking::packMessage(*message, true, kCompressionThreshold);
+    const auto body = MessagePacking::packXmppMessageBody(ciphertext, MessagePacking::PushType::Alert, true);
+
+    QXmppMessage xmppMessage(jid(message->senderId()), jid(message->recipientId()), QString::fromLatin1(body));
+    xmppMessage.setId(message->id());
+    xmppMessage.setStamp(message->createdAt());
+    xmppMessage.setType(QXmppMessage::Type::Chat);
+    xmppMessage.setMarkable(true);
+
+    if (!m_xmpp->sendPacket(xmppMessage)) {
+        qCWarning(lcLoadMessenger) << "Failed to send message:" << message->id();
+        return false;
+    }
+
+    emit messageSent(message);
+    return true;
+}
+
+std::tuple<bool, QByteArray, QByteArray> Self::encryptFile(const QString &sourceFilePath,
+                                                           const QString &destFilePath)
+{
+    return std::make_tuple(copyFile(sourceFilePath, destFilePath), QByteArray(), QByteArray());
+}
+
+bool Self::decryptFile(const QString &sourceFilePath, const QString &destFilePath, const QByteArray &decryptionKey,
+                       const QByteArray &signature, const UserId senderId)
+{
+    Q_UNUSED(decryptionKey)
+    Q_UNUSED(signature)
+    Q_UNUSED(senderId)
+    return copyFile(sourceFilePath, destFilePath);
+}
+
+QString Self::jid(const QString &identity) const
+{
+    return identity + QLatin1Char('@') + m_domain;
+}
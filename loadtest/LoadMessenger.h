@@ -0,0 +1,75 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_LOAD_MESSENGER_H
+#define VM_LOAD_MESSENGER_H
+
+#include "Messenger.h"
+
+#include <QPointer>
+
+class QXmppClient;
+
+namespace vm {
+//
+//  Messenger that sends messages through the given XMPP client without Comm Kit.
+//  Messages are packed to the same envelope as the application does, but they are not encrypted,
+//  and files are copied as is, since Comm Kit needs real Virgil services.
+//
+class LoadMessenger : public Messenger
+{
+    Q_OBJECT
+
+public:
+    LoadMessenger(Settings *settings, FileLoader *fileLoader, QXmppClient *xmpp, QString domain, QObject *parent);
+
+    bool isOnline() const noexcept override;
+
+    bool sendMessage(MessageHandler message) override;
+
+    std::tuple<bool, QByteArray, QByteArray> encryptFile(const QString &sourceFilePath,
+                                                         const QString &destFilePath) override;
+
+    bool decryptFile(const QString &sourceFilePath, const QString &destFilePath, const QByteArray &decryptionKey,
+                     const QByteArray &signature, const UserId senderId) override;
+
+private:
+    QString jid(const QString &identity) const;
+
+    QPointer<QXmppClient> m_xmpp;
+    const QString m_domain;
+};
+} // namespace vm
+
+#endif // VM_LOAD_MESSENGER_H
@@ -0,0 +1,245 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "LocalHttpServer.h"
+
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+Q_LOGGING_CATEGORY(lcLocalHttpServer, "local-http-server");
+
+using namespace vm;
+using Self = LocalHttpServer;
+
+namespace {
+constexpr qint64 kMaxHeaderSize = 16 * 1024;
+
+const auto kUploadPathPrefix = QLatin1String("/upload/");
+const auto kUsersPathPrefix = QLatin1String("/users/");
+
+QByteArray statusText(int statusCode)
+{
+    switch (statusCode) {
+    case 200:
+        return "OK";
+    case 201:
+        return "Created";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    default:
+        return "Method Not Allowed";
+    }
+}
+} // namespace
+
+Self::LocalHttpServer(QObject *parent) : QObject(parent), m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &Self::onNewConnection);
+}
+
+Self::~LocalHttpServer() = default;
+
+bool Self::listen(quint16 port)
+{
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qCWarning(lcLocalHttpServer) << "Can not listen port:" << port << m_server->errorString();
+        return false;
+    }
+    qCDebug(lcLocalHttpServer) << "Listen on port:" << m_server->serverPort();
+    return true;
+}
+
+QUrl Self::baseUrl() const
+{
+    return QUrl(QString("http://127.0.0.1:%1").arg(m_server->serverPort()));
+}
+
+QString Self::userIdentity(const QString &username)
+{
+    const auto hash = QCryptographicHash::hash(username.toUtf8(), QCryptographicHash::Sha256);
+    return QString::fromLatin1(hash.toHex().left(32));
+}
+
+quint64 Self::requestCount() const noexcept
+{
+    return m_requestCount;
+}
+
+qint64 Self::storedBytes() const noexcept
+{
+    return m_storedBytes;
+}
+
+void Self::onNewConnection()
+{
+    while (auto socket = m_server->nextPendingConnection()) {
+        m_requests[socket] = Request();
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(
+                socket, &QTcpSocket::disconnected, this,
+                [this, socket]() {
+                    m_requests.erase(socket);
+                    socket->deleteLater();
+                },
+                Qt::QueuedConnection);
+    }
+}
+
+void Self::onReadyRead(QTcpSocket *socket)
+{
+    const auto it = m_requests.find(socket);
+    if (it == m_requests.end()) {
+        return;
+    }
+
+    auto &request = it->second;
+    request.buffer += socket->readAll();
+
+    //
+    //  Connections are persistent, so a few requests can be parsed from the single buffer.
+    //
+    for (;;) {
+        if (!request.isHeaderParsed) {
+            const auto headerEnd = request.buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0) {
+                if (request.buffer.size() > kMaxHeaderSize) {
+                    sendResponse(socket, 400, "text/plain", {});
+                    socket->disconnectFromHost();
+                }
+                return;
+            }
+
+            const auto lines = request.buffer.left(headerEnd).split('\n');
+            const auto requestLine = lines.first().trimmed().split(' ');
+            if (requestLine.size() != 3) {
+                sendResponse(socket, 400, "text/plain", {});
+                socket->disconnectFromHost();
+                return;
+            }
+
+            request.method = requestLine.at(0);
+            request.path = QUrl::fromPercentEncoding(requestLine.at(1));
+            request.contentLength = 0;
+            request.isKeepAlive = requestLine.at(2) != "HTTP/1.0";
+            for (auto lineIt = lines.cbegin() + 1; lineIt != lines.cend(); ++lineIt) {
+                const auto separator = lineIt->indexOf(':');
+                const auto name = lineIt->left(separator).trimmed().toLower();
+                const auto value = lineIt->mid(separator + 1).trimmed();
+                if (name == "content-length") {
+                    request.contentLength = value.toLongLong();
+                } else if (name == "connection") {
+                    request.isKeepAlive = value.toLower() != "close";
+                }
+            }
+
+            request.buffer.remove(0, headerEnd + 4);
+            request.isHeaderParsed = true;
+        }
+
+        if (request.buffer.size() < request.contentLength) {
+            return;
+        }
+
+        const auto isKeepAlive = processRequest(socket, request) && request.isKeepAlive;
+        request.buffer.remove(0, request.contentLength);
+        request.isHeaderParsed = false;
+
+        if (!isKeepAlive) {
+            socket->disconnectFromHost();
+            return;
+        }
+    }
+}
+
+bool Self::processRequest(QTcpSocket *socket, const Request &request)
+{
+    ++m_requestCount;
+
+    const auto &path = request.path;
+    const bool isHead = request.method == "HEAD";
+
+    if (request.method == "PUT" && path.startsWith(kUploadPathPrefix)) {
+        const auto body = request.buffer.left(request.contentLength);
+        m_storedBytes += body.size() - m_files.value(path).size();
+        m_files.insert(path, body);
+        sendResponse(socket, 201, "text/plain", {});
+        return true;
+    }
+
+    if ((request.method == "GET" || isHead) && path.startsWith(kUploadPathPrefix)) {
+        const auto fileIt = m_files.constFind(path);
+        if (fileIt == m_files.constEnd()) {
+            sendResponse(socket, 404, "text/plain", {}, !isHead);
+        } else {
+            sendResponse(socket, 200, "application/octet-stream", *fileIt, !isHead);
+        }
+        return true;
+    }
+
+    if ((request.method == "GET" || isHead) && path.startsWith(kUsersPathPrefix)) {
+        const auto username = path.mid(kUsersPathPrefix.size());
+        if (username.isEmpty()) {
+            sendResponse(socket, 404, "text/plain", {}, !isHead);
+            return true;
+        }
+
+        QJsonObject user;
+        user[QLatin1String("username")] = username;
+        user[QLatin1String("identity")] = userIdentity(username);
+        sendResponse(socket, 200, "application/json", QJsonDocument(user).toJson(QJsonDocument::Compact), !isHead);
+        return true;
+    }
+
+    qCDebug(lcLocalHttpServer) << "Unexpected request:" << request.method << path;
+    sendResponse(socket, request.method == "GET" ? 404 : 405, "text/plain", {}, !isHead);
+    return false;
+}
+
+void Self::sendResponse(QTcpSocket *socket, int statusCode, const QByteArray &contentType, const QByteArray &body,
+                        bool withBody)
+{
+    QByteArray header = "HTTP/1.1 " + QByteArray::number(statusCode) + ' ' + statusText(statusCode) + "\r\n";
+    header += "Content-Type: " + contentType + "\r\n";
+    header += "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n";
+    socket->write(header);
+    if (withBody) {
+        socket->write(body);
+    }
+}
@@ -0,0 +1,101 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_LOCAL_HTTP_SERVER_H
+#define VM_LOCAL_HTTP_SERVER_H
+
+#include <QHash>
+#include <QObject>
+#include <QUrl>
+
+#include <map>
+
+class QTcpServer;
+class QTcpSocket;
+
+namespace vm {
+//
+//  Minimal HTTP/1.1 server on the loopback interface that stands in for the file upload service
+//  and the key directory:
+//      PUT /upload/<slot>/<name> - store file in memory;
+//      GET /upload/<slot>/<name> - return stored file;
+//      GET /users/<username>     - return user identity that is derived from the username.
+//
+class LocalHttpServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Self = LocalHttpServer;
+
+    explicit LocalHttpServer(QObject *parent);
+    ~LocalHttpServer() override;
+
+    bool listen(quint16 port = 0);
+    QUrl baseUrl() const;
+
+    //
+    //  Return user identity the key directory responds with.
+    //
+    static QString userIdentity(const QString &username);
+
+    quint64 requestCount() const noexcept;
+    qint64 storedBytes() const noexcept;
+
+private:
+    struct Request
+    {
+        QByteArray buffer;
+        bool isHeaderParsed = false;
+        QByteArray method;
+        QString path;
+        qint64 contentLength = 0;
+        bool isKeepAlive = true;
+    };
+
+    void onNewConnection();
+    void onReadyRead(QTcpSocket *socket);
+    bool processRequest(QTcpSocket *socket, const Request &request);
+    void sendResponse(QTcpSocket *socket, int statusCode, const QByteArray &contentType, const QByteArray &body,
+                      bool withBody = true);
+
+    QTcpServer *m_server = nullptr;
+    std::map<QTcpSocket *, Request> m_requests;
+    QHash<QString, QByteArray> m_files;
+    quint64 m_requestCount = 0;
+    qint64 m_storedBytes = 0;
+};
+} // namespace vm
+
+#endif // VM_LOCAL_HTTP_SERVER_H
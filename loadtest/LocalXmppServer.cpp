@@ -0,0 +1,411 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "LocalXmppServer.h"
+
+#include <QDomDocument>
+#include <QLoggingCategory>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUuid>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
+
+Q_LOGGING_CATEGORY(lcLocalXmppServer, "local-xmpp-server");
+
+using namespace vm;
+using Self = LocalXmppServer;
+
+namespace {
+const auto kNsSasl = QLatin1String("urn:ietf:params:xml:ns:xmpp-sasl");
+const auto kNsBind = QLatin1String("urn:ietf:params:xml:ns:xmpp-bind");
+const auto kNsUpload = QLatin1String("urn:xmpp:http:upload:0");
+const auto kNsDiscoInfo = QLatin1String("http://jabber.org/protocol/disco#info");
+const auto kNsDiscoItems = QLatin1String("http://jabber.org/protocol/disco#items");
+
+QString xmlEscaped(const QString &value)
+{
+    return value.toHtmlEscaped();
+}
+
+QString bareJid(const QString &jid)
+{
+    return jid.section(QLatin1Char('/'), 0, 0);
+}
+} // namespace
+
+struct Self::Session
+{
+    QTcpSocket *socket = nullptr;
+    std::unique_ptr<QXmlStreamReader> reader = std::make_unique<QXmlStreamReader>();
+    int depth = 0;
+    QByteArray stanza;
+    std::unique_ptr<QXmlStreamWriter> stanzaWriter;
+    bool isStreamRestarted = false;
+    QString username;
+    QString fullJid;
+};
+
+Self::LocalXmppServer(const QString &domain, const QUrl &uploadBaseUrl, QObject *parent)
+    : QObject(parent), m_domain(domain), m_uploadBaseUrl(uploadBaseUrl), m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &Self::onNewConnection);
+}
+
+Self::~LocalXmppServer() = default;
+
+bool Self::listen(quint16 port)
+{
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qCWarning(lcLocalXmppServer) << "Can not listen port:" << port << m_server->errorString();
+        return false;
+    }
+    qCDebug(lcLocalXmppServer) << "Listen on port:" << m_server->serverPort();
+    return true;
+}
+
+quint16 Self::port() const
+{
+    return m_server->serverPort();
+}
+
+QString Self::domain() const
+{
+    return m_domain;
+}
+
+QString Self::uploadService() const
+{
+    return QLatin1String("upload.") + m_domain;
+}
+
+quint64 Self::routedStanzaCount() const noexcept
+{
+    return m_routedStanzaCount;
+}
+
+void Self::onNewConnection()
+{
+    while (auto socket = m_server->nextPendingConnection()) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        auto session = std::make_unique<Session>();
+        session->socket = socket;
+        connect(socket, &QTcpSocket::readyRead, this, [this, session = session.get()]() { onReadyRead(session); });
+        //
+        //  Socket can be disconnected while its data is processed, so the session is removed later.
+        //
+        connect(
+                socket, &QTcpSocket::disconnected, this, [this, session = session.get()]() { onDisconnected(session); },
+                Qt::QueuedConnection);
+        m_sessions.push_back(std::move(session));
+    }
+}
+
+void Self::onReadyRead(Session *session)
+{
+    session->reader->addData(session->socket->readAll());
+
+    while (!session->reader->atEnd()) {
+        auto &reader = *session->reader;
+        const auto token = reader.readNext();
+
+        if (token == QXmlStreamReader::Invalid) {
+            if (reader.error() != QXmlStreamReader::PrematureEndOfDocumentError) {
+                qCWarning(lcLocalXmppServer) << "Malformed stream:" << reader.errorString();
+                session->socket->disconnectFromHost();
+            }
+            return;
+        }
+
+        if (token == QXmlStreamReader::StartElement) {
+            if (session->depth == 0) {
+                session->depth = 1;
+                processStreamStart(session);
+                continue;
+            }
+
+            if (session->depth == 1) {
+                session->stanza.clear();
+                session->stanzaWriter = std::make_unique<QXmlStreamWriter>(&session->stanza);
+            }
+            ++session->depth;
+
+            auto &writer = *session->stanzaWriter;
+            writer.writeStartElement(reader.qualifiedName().toString());
+            for (const auto &declaration : reader.namespaceDeclarations()) {
+                const auto prefix = declaration.prefix().toString();
+                writer.writeAttribute(prefix.isEmpty() ? QLatin1String("xmlns") : QLatin1String("xmlns:") + prefix,
+                                      declaration.namespaceUri().toString());
+            }
+            for (const auto &attribute : reader.attributes()) {
+                writer.writeAttribute(attribute.qualifiedName().toString(), attribute.value().toString());
+            }
+
+        } else if (token == QXmlStreamReader::EndElement) {
+            --session->depth;
+            if (session->depth == 0) {
+                send(session, "</stream:stream>");
+                session->socket->disconnectFromHost();
+                return;
+            }
+
+            session->stanzaWriter->writeEndElement();
+            if (session->depth == 1) {
+                session->stanzaWriter.reset();
+                processStanza(session, session->stanza);
+
+                //
+                //  Stream was restarted after authentication, the rest is parsed by the new reader.
+                //
+                if (session->isStreamRestarted) {
+                    session->isStreamRestarted = false;
+                    return;
+                }
+                if (session->socket->state() != QAbstractSocket::ConnectedState) {
+                    return;
+                }
+            }
+
+        } else if (token == QXmlStreamReader::Characters && session->depth > 1) {
+            session->stanzaWriter->writeCharacters(reader.text().toString());
+        }
+    }
+}
+
+void Self::onDisconnected(Session *session)
+{
+    qCDebug(lcLocalXmppServer) << "Session closed:" << session->fullJid;
+
+    const auto jid = bareJid(session->fullJid);
+    if (m_boundSessions.value(jid) == session) {
+        m_boundSessions.remove(jid);
+    }
+
+    session->socket->deleteLater();
+    const auto it = std::find_if(m_sessions.begin(), m_sessions.end(),
+                                 [session](const auto &candidate) { return candidate.get() == session; });
+    if (it != m_sessions.end()) {
+        m_sessions.erase(it);
+    }
+}
+
+void Self::processStreamStart(Session *session)
+{
+    QString response = QString("<?xml version='1.0'?>"
+                               "<stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams'"
+                               " id='%1' from='%2' version='1.0'>")
+                               .arg(++m_nextStreamId)
+                               .arg(m_domain);
+
+    if (session->username.isEmpty()) {
+        response += QString("<stream:features><mechanisms xmlns='%1'><mechanism>PLAIN</mechanism></mechanisms>"
+                            "</stream:features>")
+                            .arg(kNsSasl);
+    } else {
+        response += QString("<stream:features><bind xmlns='%1'/>"
+                            "<session xmlns='urn:ietf:params:xml:ns:xmpp-session'/></stream:features>")
+                            .arg(kNsBind);
+    }
+    send(session, response.toUtf8());
+}
+
+void Self::processStanza(Session *session, const QByteArray &stanzaData)
+{
+    QDomDocument document;
+    if (!document.setContent(stanzaData)) {
+        qCWarning(lcLocalXmppServer) << "Can not parse stanza:" << stanzaData;
+        return;
+    }
+
+    auto element = document.documentElement();
+    const auto tagName = element.tagName();
+    if (tagName == QLatin1String("auth")) {
+        processAuth(session, element);
+        return;
+    }
+
+    if (session->username.isEmpty()) {
+        qCWarning(lcLocalXmppServer) << "Stanza before authentication:" << tagName;
+        session->socket->disconnectFromHost();
+        return;
+    }
+
+    if (tagName == QLatin1String("iq")) {
+        processIq(session, element);
+    } else if (tagName == QLatin1String("message")) {
+        routeStanza(session, element);
+    } else if (tagName == QLatin1String("presence") && element.attribute(QLatin1String("to")).contains('@')) {
+        routeStanza(session, element);
+    }
+}
+
+void Self::processAuth(Session *session, const QDomElement &element)
+{
+    //
+    //  PLAIN credentials are: authzid NUL authcid NUL password, any password is accepted.
+    //
+    const auto credentials = QByteArray::fromBase64(element.text().toLatin1()).split('\0');
+    const auto username = credentials.size() == 3 ? QString::fromUtf8(credentials.at(1)) : QString();
+    if (element.attribute(QLatin1String("mechanism")) != QLatin1String("PLAIN") || username.isEmpty()) {
+        send(session, QString("<failure xmlns='%1'><not-authorized/></failure>").arg(kNsSasl).toUtf8());
+        return;
+    }
+
+    session->username = username;
+    session->reader = std::make_unique<QXmlStreamReader>();
+    session->depth = 0;
+    session->isStreamRestarted = true;
+    send(session, QString("<success xmlns='%1'/>").arg(kNsSasl).toUtf8());
+}
+
+void Self::processIq(Session *session, QDomElement &element)
+{
+    const auto type = element.attribute(QLatin1String("type"));
+    if (type != QLatin1String("get") && type != QLatin1String("set")) {
+        if (element.attribute(QLatin1String("to")).contains('@')) {
+            routeStanza(session, element);
+        }
+        return;
+    }
+
+    const auto to = element.attribute(QLatin1String("to"));
+    if (to.contains('@') && bareJid(to) != bareJid(session->fullJid)) {
+        routeStanza(session, element);
+        return;
+    }
+
+    const auto payload = element.firstChildElement();
+    const auto payloadName = payload.tagName();
+    const auto payloadNs = payload.attribute(QLatin1String("xmlns"));
+
+    if (payloadName == QLatin1String("bind")) {
+        auto resource = payload.firstChildElement(QLatin1String("resource")).text();
+        if (resource.isEmpty()) {
+            resource = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        }
+        session->fullJid = QString("%1@%2/%3").arg(session->username, m_domain, resource);
+        sendIqResult(session, element,
+                     QString("<bind xmlns='%1'><jid>%2</jid></bind>").arg(kNsBind, xmlEscaped(session->fullJid)));
+
+        const auto jid = bareJid(session->fullJid);
+        m_boundSessions.insert(jid, session);
+        for (const auto &stanza : m_offlineStanzas.take(jid)) {
+            send(session, stanza);
+        }
+        return;
+    }
+
+    if (payloadName == QLatin1String("request") && payloadNs == kNsUpload) {
+        processUploadRequest(session, element, payload);
+        return;
+    }
+
+    if (payloadName == QLatin1String("query") && payloadNs == kNsDiscoItems && to == m_domain) {
+        sendIqResult(session, element,
+                     QString("<query xmlns='%1'><item jid='%2'/></query>").arg(kNsDiscoItems, uploadService()));
+        return;
+    }
+
+    if (payloadName == QLatin1String("query") && payloadNs == kNsDiscoInfo && to == uploadService()) {
+        sendIqResult(session, element,
+                     QString("<query xmlns='%1'><identity category='store' type='file' name='HTTP File Upload'/>"
+                             "<feature var='%2'/></query>")
+                             .arg(kNsDiscoInfo, kNsUpload));
+        return;
+    }
+
+    if (payloadName == QLatin1String("query")) {
+        sendIqResult(session, element, QString("<query xmlns='%1'/>").arg(xmlEscaped(payloadNs)));
+    } else {
+        sendIqResult(session, element);
+    }
+}
+
+void Self::processUploadRequest(Session *session, const QDomElement &iq, const QDomElement &request)
+{
+    const auto fileName = request.attribute(QLatin1String("filename"));
+    if (fileName.isEmpty()) {
+        sendIqError(session, iq, QLatin1String("bad-request"));
+        return;
+    }
+
+    QUrl url(m_uploadBaseUrl);
+    url.setPath(QString("/upload/%1/%2").arg(QUuid::createUuid().toString(QUuid::WithoutBraces), fileName));
+    const auto slotUrl = xmlEscaped(url.toString(QUrl::FullyEncoded));
+    sendIqResult(session, iq,
+                 QString("<slot xmlns='%1'><put url=\"%2\"/><get url=\"%2\"/></slot>").arg(kNsUpload, slotUrl));
+}
+
+void Self::routeStanza(Session *session, QDomElement &element)
+{
+    const auto to = bareJid(element.attribute(QLatin1String("to")));
+    element.setAttribute(QLatin1String("from"), session->fullJid);
+    const auto stanza = element.ownerDocument().toByteArray(-1);
+
+    if (auto recipient = m_boundSessions.value(to)) {
+        ++m_routedStanzaCount;
+        send(recipient, stanza);
+    } else if (element.tagName() == QLatin1String("message")) {
+        m_offlineStanzas[to].append(stanza);
+    } else if (element.tagName() == QLatin1String("iq")) {
+        sendIqError(session, element, QLatin1String("service-unavailable"));
+    }
+}
+
+void Self::sendIqResult(Session *session, const QDomElement &iq, const QString &payload)
+{
+    const auto from = iq.attribute(QLatin1String("to"), m_domain);
+    const auto to = session->fullJid.isEmpty() ? QString() : QString(" to=\"%1\"").arg(xmlEscaped(session->fullJid));
+    send(session,
+         QString("<iq type='result' id=\"%1\" from=\"%2\"%3>%4</iq>")
+                 .arg(xmlEscaped(iq.attribute(QLatin1String("id"))), xmlEscaped(from), to, payload)
+                 .toUtf8());
+}
+
+void Self::sendIqError(Session *session, const QDomElement &iq, const QString &condition)
+{
+    send(session,
+         QString("<iq type='error' id=\"%1\" from=\"%2\"><error type='cancel'>"
+                 "<%3 xmlns='urn:ietf:params:xml:ns:xmpp-stanzas'/></error></iq>")
+                 .arg(xmlEscaped(iq.attribute(QLatin1String("id"))),
+                      xmlEscaped(iq.attribute(QLatin1String("to"), m_domain)), condition)
+                 .toUtf8());
+}
+
+void Self::send(Session *session, const QByteArray &data)
+{
+    session->socket->write(data);
+}
@@ -0,0 +1,104 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#ifndef VM_LOCAL_XMPP_SERVER_H
+#define VM_LOCAL_XMPP_SERVER_H
+
+#include <QDomElement>
+#include <QHash>
+#include <QObject>
+#include <QUrl>
+#include <QXmlStreamReader>
+
+#include <memory>
+#include <vector>
+
+class QTcpServer;
+class QTcpSocket;
+
+namespace vm {
+//
+//  Minimal XMPP server on the loopback interface that is enough to run QXmppClient:
+//  plain stream, SASL PLAIN that accepts any password, resource binding, messages routing
+//  with offline storage, and XEP-0363 upload slots that point to the local HTTP service.
+//  Unknown requests get an empty result, so client extensions do not stall.
+//
+class LocalXmppServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Self = LocalXmppServer;
+
+    LocalXmppServer(const QString &domain, const QUrl &uploadBaseUrl, QObject *parent);
+    ~LocalXmppServer() override;
+
+    bool listen(quint16 port = 0);
+    quint16 port() const;
+
+    QString domain() const;
+    QString uploadService() const;
+
+    quint64 routedStanzaCount() const noexcept;
+
+private:
+    struct Session;
+
+    void onNewConnection();
+    void onReadyRead(Session *session);
+    void onDisconnected(Session *session);
+
+    void processStreamStart(Session *session);
+    void processStanza(Session *session, const QByteArray &stanzaData);
+    void processAuth(Session *session, const QDomElement &element);
+    void processIq(Session *session, QDomElement &element);
+    void processUploadRequest(Session *session, const QDomElement &iq, const QDomElement &request);
+    void routeStanza(Session *session, QDomElement &element);
+
+    void sendIqResult(Session *session, const QDomElement &iq, const QString &payload = {});
+    void sendIqError(Session *session, const QDomElement &iq, const QString &condition);
+    void send(Session *session, const QByteArray &data);
+
+    QString m_domain;
+    QUrl m_uploadBaseUrl;
+    QTcpServer *m_server = nullptr;
+    std::vector<std::unique_ptr<Session>> m_sessions;
+    QHash<QString, Session *> m_boundSessions;
+    QHash<QString, QByteArrayList> m_offlineStanzas;
+    quint64 m_routedStanzaCount = 0;
+    quint64 m_nextStreamId = 0;
+};
+} // namespace vm
+
+#endif // VM_LOCAL_XMPP_SERVER_H
@@ -0,0 +1,95 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "LoadHarness.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QTimer>
+
+using namespace vm;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QLatin1String("messenger-loadtest"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QLatin1String("Run simulated messenger accounts against local XMPP and HTTP "
+                                                   "services and report latency, throughput, database writes "
+                                                   "and memory."));
+    parser.addHelpOption();
+
+    const QCommandLineOption accountsOption("accounts", "Number of simulated accounts, at least 2.", "count", "10");
+    const QCommandLineOption messagesOption("messages", "Text messages sent by every account.", "count", "100");
+    const QCommandLineOption attachmentsOption("attachments", "Attachments sent by every account.", "count", "0");
+    const QCommandLineOption attachmentSizeOption("attachment-size", "Attachment size in bytes.", "bytes", "65536");
+    const QCommandLineOption rateOption("rate", "Messages per second sent by every account.", "rate", "10");
+    const QCommandLineOption timeoutOption("timeout", "Time limit of the whole run in seconds.", "seconds", "120");
+    const QCommandLineOption reportOption("report", "Write JSON report to the file.", "path");
+    const QCommandLineOption metricsOption("metrics", "Write metrics in Prometheus text format to the file.", "path");
+    const QCommandLineOption verboseOption("verbose", "Do not suppress debug logs.");
+    parser.addOptions({ accountsOption, messagesOption, attachmentsOption, attachmentSizeOption, rateOption,
+                        timeoutOption, reportOption, metricsOption, verboseOption });
+    parser.process(app);
+
+    LoadHarness::Options options;
+    options.accountCount = parser.value(accountsOption).toInt();
+    options.messagesPerAccount = parser.value(messagesOption).toInt();
+    options.attachmentsPerAccount = parser.value(attachmentsOption).toInt();
+    options.attachmentSize = parser.value(attachmentSizeOption).toLongLong();
+    options.sendRate = parser.value(rateOption).toDouble();
+    options.timeout = std::chrono::seconds(parser.value(timeoutOption).toInt());
+    options.reportPath = parser.value(reportOption);
+    options.metricsPath = parser.value(metricsOption);
+
+    if (options.accountCount < 2 || options.messagesPerAccount < 0 || options.attachmentsPerAccount < 0
+        || options.attachmentSize <= 0 || options.sendRate <= 0 || options.timeout.count() <= 0) {
+        parser.showHelp(1);
+    }
+
+    //
+    //  Debug logs of every message would dominate the measurements.
+    //
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules(QLatin1String("*.debug=false"));
+    }
+
+    LoadHarness harness(std::move(options), nullptr);
+    QObject::connect(&harness, &LoadHarness::finished, &app,
+                     [&app](bool isSucceeded) { app.exit(isSucceeded ? 0 : 1); }, Qt::QueuedConnection);
+    QTimer::singleShot(0, &harness, &LoadHarness::start);
+    return app.exec();
+}
@@ -180,6 +180,26 @@ void CloudFile::setSharedGroupId(const CloudFsSharedGroupId &sharedGroupId)
     m_sharedGroupId = sharedGroupId;
 }
 
+QDateTime CloudFile::listedUpdatedAt() const noexcept
+{
+    return m_listedUpdatedAt;
+}
+
+void CloudFile::setListedUpdatedAt(const QDateTime &dateTime)
+{
+    m_listedUpdatedAt = dateTime;
+}
+
+QDateTime CloudFile::listedAt() const noexcept
+{
+    return m_listedAt;
+}
+
+void CloudFile::setListedAt(const QDateTime &dateTime)
+{
+    m_listedAt = dateTime;
+}
+
 bool CloudFile::isRoot() const
 {
     return m_isFolder && m_id == CloudFileId::root();
@@ -37,23 +37,105 @@
 #include "Settings.h"
 #include "CustomerEnv.h"
 #include "LogConfig.h"
+#include "LogStore.h"
 
 #include <QDirIterator>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QStandardPaths>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 using namespace vm;
 using Self = CrashReporter;
 
 Q_LOGGING_CATEGORY(lcCrashReporter, "crash-reporter")
 
+namespace {
+//
+//  Read-only device that streams compressed log segments one by one and then the compressed active segment.
+//  Files are opened beforehand, so they can be rotated out while the report is being sent.
+//
+class LogUploadDevice : public QIODevice
+{
+public:
+    LogUploadDevice(const QStringList &filePaths, QByteArray tail, QObject *parent)
+        : QIODevice(parent), m_tail(std::move(tail))
+    {
+        for (auto &filePath : filePaths) {
+            auto file = std::make_unique<QFile>(filePath);
+            if (file->open(QIODevice::ReadOnly)) {
+                m_totalSize += file->size();
+                m_files.push_back(std::move(file));
+            } else {
+                qCDebug(lcCrashReporter) << "Can't open " << filePath << file->errorString();
+            }
+        }
+        m_totalSize += m_tail.size();
+        open(QIODevice::ReadOnly);
+    }
+
+    bool isSequential() const override { return true; }
+
+    qint64 size() const override { return m_totalSize; }
+
+    qint64 bytesAvailable() const override { return m_totalSize - m_readSize + QIODevice::bytesAvailable(); }
+
+    bool atEnd() const override { return (m_readSize == m_totalSize) && QIODevice::atEnd(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        while (m_fileIndex < m_files.size()) {
+            const auto readSize = m_files[m_fileIndex]->read(data, maxSize);
+            if (readSize > 0) {
+                m_readSize += readSize;
+                return readSize;
+            }
+            m_files[m_fileIndex]->close();
+            ++m_fileIndex;
+        }
+
+        const auto readSize = std::min(maxSize, static_cast<qint64>(m_tail.size()) - m_tailPos);
+        if (readSize <= 0) {
+            return -1;
+        }
+        std::copy_n(m_tail.constData() + m_tailPos, readSize, data);
+        m_tailPos += readSize;
+        m_readSize += readSize;
+        return readSize;
+    }
+
+    qint64 writeData(const char *data, qint64 maxSize) override
+    {
+        Q_UNUSED(data)
+        Q_UNUSED(maxSize)
+        return -1;
+    }
+
+private:
+    std::vector<std::unique_ptr<QFile>> m_files;
+    size_t m_fileIndex = 0;
+    QByteArray m_tail;
+    qint64 m_tailPos = 0;
+    qint64 m_totalSize = 0;
+    qint64 m_readSize = 0;
+};
+} // namespace
+
 Self::CrashReporter(Settings *settings, vm::CoreMessenger *commKitMessenger, QObject *parent)
     : QObject(parent),
       m_settings(settings),
       m_coreMessenger(commKitMessenger),
       m_networkManager(new QNetworkAccessManager(this))
 {
+    // Log segments are compressed one by one
+    m_compressionPool.setMaxThreadCount(1);
+
+    connect(this, &Self::logFilesCompressed, this, &Self::postLogFiles);
 }
 
 void Self::checkAppCrash()
@@ -88,38 +170,46 @@ bool Self::sendLogFiles(const QString &details)
 
     qCDebug(lcCrashReporter) << "Lookup logs within directory: " << logsDir.absolutePath();
 
-    QByteArray fileData;
-    const auto fileInfos =
-            logsDir.entryInfoList(QStringList() << "VirgilMessenger*.log", QDir::NoFilter, QDir::Name | QDir::Reversed);
-    for (auto &fileInfo : fileInfos) {
-        QFile readFile(fileInfo.filePath());
-        if (readFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            qCDebug(lcCrashReporter) << "Read file:" << readFile.fileName();
-            fileData.append(readFile.readAll());
+    // Closed segments are compressed on disk, the active one is small enough to be compressed in memory
+    QtConcurrent::run(&m_compressionPool, [this]() {
+        LogStore::compressClosedSegments();
+        QByteArray activeSegmentData;
+        QFile activeSegment(LogStore::activeSegmentPath());
+        if (activeSegment.open(QIODevice::ReadOnly)) {
+            activeSegmentData = LogStore::gzip(activeSegment.readAll());
         } else {
-            qCDebug(lcCrashReporter) << "Can't open " << readFile.fileName() << readFile.errorString();
+            qCDebug(lcCrashReporter) << "Can't open " << activeSegment.fileName() << activeSegment.errorString();
         }
-    }
+        emit logFilesCompressed(activeSegmentData, QPrivateSignal());
+    });
+
+    return true;
+}
+
+void Self::postLogFiles(const QByteArray &activeSegmentData)
+{
+    auto logData = new LogUploadDevice(LogStore::compressedSegmentPaths(), activeSegmentData, this);
 
     auto endpointUrl = m_coreMessenger->getCrashReportEndpointUrl();
     auto authHeaderValue = m_coreMessenger->getAuthHeaderVaue();
 
-    qCDebug(lcCrashReporter) << "Send crash report to the endpoint: " << endpointUrl << "size:" << fileData.size();
+    qCDebug(lcCrashReporter) << "Send crash report to the endpoint: " << endpointUrl << "size:" << logData->size();
     qCDebug(lcCrashReporter) << "Messenger Backend auth header value: " << authHeaderValue;
 
     QNetworkRequest request(endpointUrl);
     request.setHeader(QNetworkRequest::ContentTypeHeader, QString("application/json"));
+    request.setHeader(QNetworkRequest::ContentLengthHeader, logData->size());
+    request.setRawHeader("Content-Encoding", "gzip");
     request.setRawHeader(QString("Authorization").toUtf8(), authHeaderValue.toUtf8());
     request.setRawHeader(QString("Virgil-Agent").toUtf8(),
                          qPrintable(CustomerEnv::version() + ";" + QSysInfo::kernelType()));
-    auto reply = m_networkManager->post(request, fileData);
+    auto reply = m_networkManager->post(request, logData);
+    logData->setParent(reply);
     connect(reply, &QNetworkReply::finished, this, std::bind(&CrashReporter::sendSendCrashReportReply, this, reply));
     for (auto name : request.rawHeaderList()) {
         qCDebug(lcCrashReporter) << "Request header" << name << ':' << request.rawHeader(name);
     }
-    qCDebug(lcCrashReporter) << "Crash log is empty: " << fileData.isEmpty();
-
-    return true;
+    qCDebug(lcCrashReporter) << "Crash log is empty: " << (logData->size() == 0);
 }
 
 void Self::sendSendCrashReportReply(QNetworkReply *reply)
@@ -34,29 +34,120 @@
 
 #include "FileLoader.h"
 
+#include "Settings.h"
+
 #include <QFileInfo>
+#include <QIODevice>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QSslConfiguration>
+
+#include <algorithm>
 
 Q_LOGGING_CATEGORY(lcFileLoader, "fileLoader");
 
 using namespace vm;
 using Self = FileLoader;
 
-Self::FileLoader(CoreMessenger *commKitMessenger, QObject *parent)
-    : QObject(parent), m_coreMessenger(commKitMessenger), m_networkAccessManager(new QNetworkAccessManager(this))
+//
+//  Secure connection to a transfer host is re-established in advance if it was not used within this interval.
+//
+static constexpr qint64 kConnectionWarmUpIntervalMs = 60 * 1000;
+
+//
+//  Size of the network buffer of a download. When a download is throttled, the network stack stops
+//  reading from the socket once the buffer is full.
+//
+static constexpr qint64 kDownloadReadBufferSize = 256 * 1024;
+
+namespace {
+//
+//  Read uploaded file as fast as the transfer scheduler allows.
+//
+class ThrottledUploadDevice : public QIODevice
+{
+public:
+    ThrottledUploadDevice(QFile *file, TransferScheduler *scheduler, TransferScheduler::ChannelId channelId,
+                          QObject *parent)
+        : QIODevice(parent), m_file(file), m_scheduler(scheduler), m_channelId(channelId)
+    {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    void resume()
+    {
+        emit readyRead();
+    }
+
+    bool isSequential() const override
+    {
+        return false;
+    }
+
+    qint64 size() const override
+    {
+        return m_file ? m_file->size() : 0;
+    }
+
+    bool seek(qint64 pos) override
+    {
+        return m_file && m_file->seek(pos) && QIODevice::seek(pos);
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        if (!m_file || !m_scheduler) {
+            return -1;
+        }
+
+        const auto grantedSize = m_scheduler->acquire(m_channelId, maxSize);
+        if (grantedSize == 0) {
+            return 0;
+        }
+
+        return m_file->read(data, grantedSize);
+    }
+
+    qint64 writeData(const char *, qint64) override
+    {
+        return -1;
+    }
+
+private:
+    QPointer<QFile> m_file;
+    QPointer<TransferScheduler> m_scheduler;
+    TransferScheduler::ChannelId m_channelId;
+};
+} // namespace
+
+Self::FileLoader(Settings *settings, CoreMessenger *coreMessenger, QObject *parent)
+    : QObject(parent),
+      m_settings(settings),
+      m_coreMessenger(coreMessenger),
+      m_networkAccessManager(new QNetworkAccessManager(this)),
+      m_uploadSlotBroker(new UploadSlotBroker(coreMessenger, this)),
+      m_transferScheduler(new TransferScheduler(settings, this))
 {
 
     qRegisterMetaType<Self::ConnectionSetup>("ConnectionSetup");
+    qRegisterMetaType<Self::TransferTiming>("TransferTiming");
+    qRegisterMetaType<vm::TransferPriority>("TransferPriority");
 
     connect(m_coreMessenger, &CoreMessenger::uploadServiceFound, this, &Self::uploadServiceFound);
-    connect(m_coreMessenger, &CoreMessenger::uploadSlotReceived, this, &Self::uploadSlotReceived);
-    connect(m_coreMessenger, &CoreMessenger::uploadSlotErrorOccurred, this, &Self::uploadSlotErrorOccurred);
+    connect(m_coreMessenger, &CoreMessenger::uploadSlotReceived, this, &Self::onUploadSlotReceived);
+    connect(m_coreMessenger, &CoreMessenger::connectionStateChanged, this, &Self::onConnectionStateChanged);
+    connect(m_uploadSlotBroker, &UploadSlotBroker::slotRequestFinished, this, &Self::uploadSlotRequestFinished);
+    connect(m_uploadSlotBroker, &UploadSlotBroker::slotRequestFailed, this, &Self::uploadSlotRequestFailed);
+    connect(m_uploadSlotBroker, &UploadSlotBroker::slotReceived, this, &Self::uploadSlotReceived);
+    connect(m_uploadSlotBroker, &UploadSlotBroker::slotErrorOccurred, this, &Self::uploadSlotErrorOccurred);
 
     connect(this, &Self::startDownload, this, &Self::onStartDownload);
     connect(this, &Self::startUpload, this, &Self::onStartUpload);
     connect(this, &Self::requestUploadSlot, this, &Self::onRequestUploadSlot);
+    connect(this, &Self::prefetchUploadSlot, m_uploadSlotBroker, &UploadSlotBroker::prefetch);
+    connect(this, &Self::releaseUploadSlot, m_uploadSlotBroker, &UploadSlotBroker::release);
 }
 
 bool Self::isServiceFound() const
@@ -64,35 +155,274 @@ bool Self::isServiceFound() const
     return m_coreMessenger->isUploadServiceFound();
 }
 
+UploadSlotBroker::Stats Self::uploadSlotStats() const
+{
+    return m_uploadSlotBroker->stats();
+}
+
 void Self::onRequestUploadSlot(const QString &requestId, const QString &filePath)
 {
-    const auto slotId = m_coreMessenger->requestUploadSlot(filePath);
+    m_uploadSlotBroker->acquire(requestId, filePath);
+}
 
-    if (slotId.isEmpty()) {
-        emit uploadSlotRequestFailed(requestId);
-    } else {
-        emit uploadSlotRequestFinished(requestId, slotId);
+void Self::onUploadSlotReceived(const QString &slotId, const QUrl &putUrl, const QUrl &getUrl)
+{
+    Q_UNUSED(slotId)
+    Q_UNUSED(getUrl)
+
+    //
+    //  Slot may be prefetched, so the upload host is known before the upload starts.
+    //
+    warmUpConnection(putUrl, false);
+}
+
+void Self::onConnectionStateChanged(CoreMessenger::ConnectionState state)
+{
+    if (state != CoreMessenger::ConnectionState::Connected) {
+        return;
+    }
+
+    //
+    //  Network could be changed, so connections to the known hosts are stale.
+    //
+    for (auto &[key, hostPool] : m_hostPools) {
+        if (hostPool.warmedUpTimer.isValid()) {
+            warmUpConnection(QUrl(key), true);
+        }
     }
 }
 
-void Self::onStartUpload(const QUrl &url, QFile *file, const ConnectionSetup &connectionSetup)
+void Self::onStartUpload(const QUrl &url, QFile *file, TransferPriority priority,
+                         const ConnectionSetup &connectionSetup)
 {
+    Transfer transfer;
+    transfer.direction = TransferDirection::Upload;
+    transfer.priority = priority;
+    transfer.url = url;
+    transfer.file = file;
+    transfer.connectionSetup = connectionSetup;
+    enqueueTransfer(std::move(transfer));
+}
 
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentLengthHeader, file->size());
-    auto reply = m_networkAccessManager->put(request, file);
-    connectionSetup(reply);
+void Self::onStartDownload(const QUrl &url, QFile *file, TransferPriority priority,
+                           const ConnectionSetup &connectionSetup)
+{
+    Transfer transfer;
+    transfer.direction = TransferDirection::Download;
+    transfer.priority = priority;
+    transfer.url = url;
+    transfer.file = file;
+    transfer.connectionSetup = connectionSetup;
+    enqueueTransfer(std::move(transfer));
 }
 
-void Self::onStartDownload(const QUrl &url, QFile *file, const ConnectionSetup &connectionSetup)
+void Self::enqueueTransfer(Transfer transfer)
 {
+    const auto key = hostKey(transfer.url);
+    transfer.queuedTimer.start();
+    m_hostPools[key].pending.push_back(std::move(transfer));
+    dispatchTransfers(key);
+}
 
-    QNetworkRequest request(url);
-    auto reply = m_networkAccessManager->get(request);
-    connect(reply, &QNetworkReply::readyRead, [file, reply]() {
-        const auto bytes = reply->readAll();
-        file->write(bytes);
-        file->flush();
+void Self::dispatchTransfers(const QString &hostKey)
+{
+    auto &hostPool = m_hostPools[hostKey];
+    const auto maxActiveCount = m_settings->maxTransfersPerHost();
+
+    while (!hostPool.pending.empty()) {
+        //
+        //  The oldest transfer of the highest priority goes first.
+        //
+        const auto transferIt =
+                std::min_element(hostPool.pending.begin(), hostPool.pending.end(),
+                                 [](const auto &lhs, const auto &rhs) { return lhs.priority < rhs.priority; });
+
+        if (!transferIt->file) {
+            qCDebug(lcFileLoader) << "Skip transfer of removed file:" << transferIt->url;
+            hostPool.pending.erase(transferIt);
+            continue;
+        }
+
+        //
+        //  Transfers of lower classes are paused by the scheduler while this one is active,
+        //  so their slots are borrowed.
+        //
+        if (occupiedSlotCount(hostPool, transferIt->priority) >= maxActiveCount) {
+            break;
+        }
+
+        auto transfer = std::move(*transferIt);
+        hostPool.pending.erase(transferIt);
+
+        ++hostPool.activeCounts[static_cast<size_t>(transfer.priority)];
+        startTransfer(hostKey, std::move(transfer));
+    }
+}
+
+int Self::occupiedSlotCount(const HostPool &hostPool, TransferPriority priority)
+{
+    int count = 0;
+    for (size_t index = 0; index <= static_cast<size_t>(priority); ++index) {
+        count += hostPool.activeCounts[index];
+    }
+    return count;
+}
+
+void Self::startTransfer(const QString &hostKey, Transfer transfer)
+{
+    auto request = createRequest(transfer.url);
+    auto resume = std::make_shared<TransferScheduler::ResumeFunc>();
+    const auto channelId = m_transferScheduler->openChannel(transfer.priority, [resume]() {
+        if (*resume) {
+            (*resume)();
+        }
+    });
+
+    QNetworkReply *reply = nullptr;
+    if (transfer.direction == TransferDirection::Upload) {
+        request.setHeader(QNetworkRequest::ContentLengthHeader, transfer.file->size());
+        auto device = new ThrottledUploadDevice(transfer.file, m_transferScheduler, channelId, nullptr);
+        reply = m_networkAccessManager->put(request, device);
+        device->setParent(reply);
+        *resume = [device = QPointer<ThrottledUploadDevice>(device)]() {
+            if (device) {
+                device->resume();
+            }
+        };
+    } else {
+        reply = m_networkAccessManager->get(request);
+        reply->setReadBufferSize(kDownloadReadBufferSize);
+
+        auto readAvailable = [this, file = transfer.file, reply = QPointer<QNetworkReply>(reply), channelId]() {
+            while (reply && reply->bytesAvailable() > 0) {
+                const auto grantedSize = m_transferScheduler->acquire(channelId, reply->bytesAvailable());
+                if (grantedSize == 0) {
+                    break;
+                }
+                const auto bytes = reply->read(grantedSize);
+                if (file) {
+                    file->write(bytes);
+                }
+            }
+            if (file) {
+                file->flush();
+            }
+        };
+        *resume = readAvailable;
+        connect(reply, &QNetworkReply::readyRead, this, readAvailable);
+    }
+
+    m_hostPools[hostKey].warmedUpTimer.start();
+
+    auto timing = std::make_shared<TransferTiming>();
+    timing->url = transfer.url;
+    timing->direction = transfer.direction;
+    timing->priority = transfer.priority;
+    timing->queuedMs = transfer.queuedTimer.elapsed();
+    if (transfer.direction == TransferDirection::Upload) {
+        timing->bytes = transfer.file->size();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    connect(reply, &QNetworkReply::encrypted, this, [timing, timer]() { timing->encryptedMs = timer.elapsed(); });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [timing, timer]() {
+        if (timing->firstByteMs < 0) {
+            timing->firstByteMs = timer.elapsed();
+        }
+    });
+    connect(reply, &QNetworkReply::downloadProgress, this, [timing](qint64 bytesReceived, qint64) {
+        if (timing->direction == TransferDirection::Download) {
+            timing->bytes = bytesReceived;
+        }
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, hostKey, timing, timer, reply, channelId, resume,
+                                                    file = transfer.file]() {
+        //
+        //  Whole response is buffered at this moment, so write the rest regardless of throttling.
+        //
+        if (timing->direction == TransferDirection::Download && file) {
+            file->write(reply->readAll());
+            file->flush();
+        }
+        *resume = nullptr;
+        m_transferScheduler->closeChannel(channelId);
+
+        timing->finishedMs = timer.elapsed();
+        timing->isHttp2 = reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+        timing->isSucceeded = reply->error() == QNetworkReply::NoError;
+
+        qCDebug(lcFileLoader).nospace()
+                << (timing->direction == TransferDirection::Upload ? "Upload" : "Download") << " of "
+                << timing->bytes << " bytes to " << timing->url.host() << " (http2: " << timing->isHttp2
+                << "): queued " << timing->queuedMs << " ms, connected " << timing->encryptedMs
+                << " ms, first byte " << timing->firstByteMs << " ms, finished " << timing->finishedMs << " ms";
+
+        emit transferFinished(*timing);
+
+        auto &hostPool = m_hostPools[hostKey];
+        --hostPool.activeCounts[static_cast<size_t>(timing->priority)];
+        dispatchTransfers(hostKey);
     });
-    connectionSetup(reply);
+
+    transfer.connectionSetup(reply);
+}
+
+void Self::warmUpConnection(const QUrl &url, bool force)
+{
+    if (!url.isValid() || url.host().isEmpty()) {
+        return;
+    }
+
+    auto &hostPool = m_hostPools[hostKey(url)];
+    if (!force && hostPool.warmedUpTimer.isValid() && !hostPool.warmedUpTimer.hasExpired(kConnectionWarmUpIntervalMs)) {
+        return;
+    }
+
+    qCDebug(lcFileLoader) << "Warm up connection to:" << url.host();
+    hostPool.warmedUpTimer.start();
+
+    if (url.scheme() == QLatin1String("https")) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+        //
+        //  Negotiate HTTP/2 in advance, so the following transfers are multiplexed over this connection.
+        //
+        auto sslConfiguration = createRequest(url).sslConfiguration();
+        m_networkAccessManager->connectToHostEncrypted(url.host(), url.port(443), sslConfiguration);
+#else
+        m_networkAccessManager->connectToHostEncrypted(url.host(), url.port(443));
+#endif
+    } else {
+        m_networkAccessManager->connectToHost(url.host(), url.port(80));
+    }
+}
+
+QNetworkRequest Self::createRequest(const QUrl &url) const
+{
+    QNetworkRequest request(url);
+
+    const auto isHttp2Enabled = m_settings->http2TransfersEnabled();
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, isHttp2Enabled);
+
+    if (url.scheme() == QLatin1String("https")) {
+        auto sslConfiguration = request.sslConfiguration();
+        //
+        //  Keep TLS session to resume it when a new connection is needed.
+        //
+        sslConfiguration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        if (isHttp2Enabled) {
+            sslConfiguration.setAllowedNextProtocols(
+                    { QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1 });
+        }
+        request.setSslConfiguration(sslConfiguration);
+    }
+
+    return request;
+}
+
+QString Self::hostKey(const QUrl &url)
+{
+    return url.adjusted(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment | QUrl::RemoveUserInfo)
+            .toString();
 }
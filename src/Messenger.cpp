@@ -53,7 +53,7 @@ Self::Messenger(Settings *settings, Validator *validator)
       m_coreMessenger(new CoreMessenger(settings, this)),
       m_cloudFileSystem(new CloudFileSystem(m_coreMessenger, this)),
       m_crashReporter(new CrashReporter(settings, m_coreMessenger, this)),
-      m_fileLoader(new FileLoader(m_coreMessenger, this))
+      m_fileLoader(new FileLoader(settings, m_coreMessenger, this))
 {
     //
     //  Proxy messenger signals.
@@ -93,6 +93,11 @@ Self::Messenger(Settings *settings, Validator *validator)
     connect(m_coreMessenger, &CoreMessenger::newGroupChatLoaded, this, &Self::newGroupChatLoaded);
 }
 
+Self::Messenger(Settings *settings, FileLoader *fileLoader, QObject *parent)
+    : MessageSender(parent), m_settings(settings), m_fileLoader(fileLoader)
+{
+}
+
 bool Self::isNetworkOnline() const noexcept
 {
     return m_coreMessenger->isNetworkOnline();
@@ -229,6 +234,11 @@ bool Self::sendMessage(MessageHandler message)
     return false;
 }
 
+std::optional<MessageUpdates> Self::decryptStoredMessages(const UserId &senderId, const ModifiableMessages &messages)
+{
+    return m_coreMessenger->decryptStoredMessages(senderId, messages);
+}
+
 std::tuple<bool, QByteArray, QByteArray> Self::encryptFile(const QString &sourceFilePath, const QString &destFilePath)
 {
     auto [result, decryptionKey, signature] = m_coreMessenger->encryptFile(sourceFilePath, destFilePath);
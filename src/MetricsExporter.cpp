@@ -0,0 +1,141 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "MetricsExporter.h"
+
+#include "LogConfig.h"
+#include "Metrics.h"
+#include "Settings.h"
+#include "database/core/StatementProfiler.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+Q_LOGGING_CATEGORY(lcMetricsExporter, "metrics-exporter");
+
+using namespace vm;
+using Self = MetricsExporter;
+
+namespace {
+//
+//  Request is ignored after this size, only the header terminator matters.
+//
+constexpr qint64 kMaxRequestSize = 8 * 1024;
+} // namespace
+
+Self::MetricsExporter(Settings *settings, QObject *parent) : QObject(parent)
+{
+    const auto dumpFileName = QCoreApplication::applicationName() + QLatin1String("_metrics.prom");
+    m_dumpFilePath = LogConfig::instance().logsDir().filePath(dumpFileName);
+
+    const auto dumpInterval = settings->metricsDumpInterval();
+    if (dumpInterval.count() > 0) {
+        m_dumpTimer.setInterval(dumpInterval);
+        connect(&m_dumpTimer, &QTimer::timeout, this, &Self::dump);
+        m_dumpTimer.start();
+    }
+
+    const auto port = settings->metricsPort();
+    if (port > 0) {
+        startServer(port);
+    }
+}
+
+bool Self::dump()
+{
+    QSaveFile file(m_dumpFilePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcMetricsExporter) << "Can not open metrics dump file:" << m_dumpFilePath;
+        return false;
+    }
+
+    file.write(Metrics::instance()->toPrometheusText());
+    if (!file.commit()) {
+        qCWarning(lcMetricsExporter) << "Can not write metrics dump file:" << m_dumpFilePath;
+        return false;
+    }
+    return true;
+}
+
+void Self::startServer(quint16 port)
+{
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &Self::onNewConnection);
+
+    //
+    //  Metrics reveal usage patterns, so they are never exposed outside of the device.
+    //
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qCWarning(lcMetricsExporter) << "Can not listen metrics port:" << port << m_server->errorString();
+        return;
+    }
+    qCInfo(lcMetricsExporter) << "Serving metrics on http://127.0.0.1:" << port;
+}
+
+void Self::onNewConnection()
+{
+    while (auto socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, socket, [socket]() {
+            //
+            //  Only the path of the request matters, so wait for the end of the request header.
+            //
+            if (socket->property("isAnswered").toBool()) {
+                socket->readAll();
+                return;
+            }
+            if (!socket->peek(kMaxRequestSize).contains("\r\n\r\n") && socket->bytesAvailable() < kMaxRequestSize) {
+                return;
+            }
+            const auto request = socket->readAll();
+            socket->setProperty("isAnswered", true);
+
+            const bool isStatementsRequest = request.startsWith("GET /statements");
+            const auto body = isStatementsRequest ? StatementProfiler::instance()->report().toUtf8()
+                                                  : Metrics::instance()->toPrometheusText();
+            QByteArray response("HTTP/1.0 200 OK\r\n");
+            response += isStatementsRequest ? "Content-Type: text/plain; charset=utf-8\r\n"
+                                            : "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+            response += "Connection: close\r\n";
+            response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n";
+            response += body;
+
+            socket->write(response);
+            socket->disconnectFromHost();
+        });
+    }
+}
@@ -40,7 +40,10 @@ using namespace vm;
 using Self = TimeProfilerSection;
 
 TimeProfilerSection::TimeProfilerSection(const QString &name, TimeProfiler *profiler)
-    : m_preffix(QString("[%1] ").arg(name)), m_profiler(profiler), m_initialElapsed(profiler ? profiler->elapsed() : 0)
+    : m_preffix(QString("[%1] ").arg(name)),
+      m_profiler(profiler),
+      m_initialElapsed(profiler ? profiler->elapsed() : 0),
+      m_traceSpan("profiler", name)
 {
     if (profiler) {
         profiler->printMessageWithOptions(m_preffix + QLatin1String("Section started"), 0);
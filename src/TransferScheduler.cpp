@@ -0,0 +1,225 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+
+#include "TransferScheduler.h"
+
+#include "Metrics.h"
+#include "Settings.h"
+
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+Q_LOGGING_CATEGORY(lcTransferScheduler, "transfer-scheduler");
+
+using namespace vm;
+using Self = TransferScheduler;
+
+//
+//  Interval of token refill and resumption of throttled transfers.
+//
+static constexpr std::chrono::milliseconds kTickInterval(50);
+
+//
+//  Bucket holds tokens for this time, so a transfer may burst after a pause.
+//
+static constexpr qint64 kBurstIntervalMs = 250;
+
+//
+//  Minimal bucket capacity, so a slow rate still allows to process reasonable chunks.
+//
+static constexpr qint64 kMinBucketCapacity = 16 * 1024;
+
+bool Self::TokenBucket::isLimited() const noexcept
+{
+    return rate > 0;
+}
+
+qint64 Self::TokenBucket::capacity() const noexcept
+{
+    return std::max(rate * kBurstIntervalMs / 1000, kMinBucketCapacity);
+}
+
+void Self::TokenBucket::refill(qint64 elapsedMs) noexcept
+{
+    if (isLimited()) {
+        tokens = std::min(tokens + rate * elapsedMs / 1000, capacity());
+    }
+}
+
+Self::TransferScheduler(Settings *settings, QObject *parent) : QObject(parent)
+{
+    auto &interactiveBucket = m_buckets[static_cast<size_t>(TransferPriority::Interactive)];
+    auto &preloadBucket = m_buckets[static_cast<size_t>(TransferPriority::Preload)];
+    auto &backgroundBucket = m_buckets[static_cast<size_t>(TransferPriority::Background)];
+
+    interactiveBucket.rate = settings->interactiveTransferRateLimit();
+    preloadBucket.rate = settings->preloadTransferRateLimit();
+    backgroundBucket.rate = settings->backgroundTransferRateLimit();
+    m_globalBucket.rate = settings->globalTransferRateLimit();
+
+    for (auto &bucket : m_buckets) {
+        bucket.tokens = bucket.capacity();
+    }
+    m_globalBucket.tokens = m_globalBucket.capacity();
+
+    const std::array<QString, kPriorityCount> priorityNames = { "interactive", "preload", "background" };
+    for (size_t priorityIndex = 0; priorityIndex < kPriorityCount; ++priorityIndex) {
+        const Metrics::Labels labels { { "priority", priorityNames[priorityIndex] } };
+        m_transferredBytes[priorityIndex] = Metrics::instance()->counter("transfer_bytes_total", labels);
+        m_activeChannels[priorityIndex] = Metrics::instance()->gauge("transfer_active_channels", labels);
+    }
+
+    qCDebug(lcTransferScheduler) << "Rate limits (interactive, preload, background, global):"
+                                 << interactiveBucket.rate << preloadBucket.rate << backgroundBucket.rate
+                                 << m_globalBucket.rate;
+
+    m_tickTimer.setInterval(kTickInterval);
+    connect(&m_tickTimer, &QTimer::timeout, this, &Self::onTick);
+}
+
+Self::ChannelId Self::openChannel(TransferPriority priority, ResumeFunc resume)
+{
+    const auto channelId = m_nextChannelId++;
+    const auto priorityIndex = static_cast<size_t>(priority);
+
+    if (m_channelCounts[priorityIndex] == 0
+        && std::any_of(m_channelCounts.cbegin() + priorityIndex + 1, m_channelCounts.cend(),
+                       [](int count) { return count > 0; })) {
+        qCDebug(lcTransferScheduler) << "Pause transfers with priority lower than" << priorityIndex;
+    }
+
+    m_channels[channelId] = Channel { priority, std::move(resume), false };
+    ++m_channelCounts[priorityIndex];
+    m_activeChannels[priorityIndex]->add(1);
+
+    if (!m_tickTimer.isActive()) {
+        m_refillTimer.start();
+        m_tickTimer.start();
+    }
+
+    return channelId;
+}
+
+void Self::closeChannel(ChannelId channelId)
+{
+    auto channelIt = m_channels.find(channelId);
+    if (channelIt == m_channels.end()) {
+        return;
+    }
+
+    const auto priorityIndex = static_cast<size_t>(channelIt->second.priority);
+    --m_channelCounts[priorityIndex];
+    m_activeChannels[priorityIndex]->add(-1);
+    m_channels.erase(channelIt);
+
+    if (m_channels.empty()) {
+        m_tickTimer.stop();
+    }
+}
+
+qint64 Self::acquire(ChannelId channelId, qint64 maxBytes)
+{
+    auto channelIt = m_channels.find(channelId);
+    if (channelIt == m_channels.end()) {
+        return maxBytes;
+    }
+
+    auto &channel = channelIt->second;
+    auto &bucket = m_buckets[static_cast<size_t>(channel.priority)];
+
+    qint64 grantedBytes = maxBytes;
+    if (isPreempted(channel.priority)) {
+        grantedBytes = 0;
+    }
+    if (bucket.isLimited()) {
+        grantedBytes = std::min(grantedBytes, bucket.tokens);
+    }
+    if (m_globalBucket.isLimited()) {
+        grantedBytes = std::min(grantedBytes, m_globalBucket.tokens);
+    }
+
+    if (grantedBytes <= 0) {
+        channel.isStarved = true;
+        return 0;
+    }
+
+    if (bucket.isLimited()) {
+        bucket.tokens -= grantedBytes;
+    }
+    if (m_globalBucket.isLimited()) {
+        m_globalBucket.tokens -= grantedBytes;
+    }
+
+    //
+    //  Granted bytes are processed right away, so they approximate the throughput.
+    //
+    m_transferredBytes[static_cast<size_t>(channel.priority)]->increment(grantedBytes);
+
+    return grantedBytes;
+}
+
+bool Self::isPreempted(TransferPriority priority) const
+{
+    const auto priorityIndex = static_cast<size_t>(priority);
+    return std::any_of(m_channelCounts.cbegin(), m_channelCounts.cbegin() + priorityIndex,
+                       [](int count) { return count > 0; });
+}
+
+void Self::onTick()
+{
+    const auto elapsedMs = m_refillTimer.restart();
+    for (auto &bucket : m_buckets) {
+        bucket.refill(elapsedMs);
+    }
+    m_globalBucket.refill(elapsedMs);
+
+    //
+    //  Resume function may close the channel, so collect them first.
+    //
+    std::vector<ResumeFunc> resumes;
+    for (auto &[channelId, channel] : m_channels) {
+        if (channel.isStarved && !isPreempted(channel.priority)) {
+            channel.isStarved = false;
+            resumes.push_back(channel.resume);
+        }
+    }
+
+    for (const auto &resume : resumes) {
+        resume();
+    }
+}
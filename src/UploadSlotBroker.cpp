@@ -0,0 +1,285 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+
+#include "UploadSlotBroker.h"
+
+#include "UidUtils.h"
+
+#include <QFileInfo>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcUploadSlotBroker, "upload-slot-broker");
+
+using namespace vm;
+using Self = UploadSlotBroker;
+
+//
+//  Slots are valid on the server for a limited time, so unclaimed slots are dropped before that.
+//
+static constexpr qint64 kSlotLifetimeMs = 4 * 60 * 1000;
+static constexpr int kSlotExpirationCheckIntervalMs = 30 * 1000;
+
+//
+//  Prefetched slot sizes are rounded up, so a slot fits files which encryption overhead differs a bit.
+//  A file takes the slot only if the slot exceeds it by less than two granules to not waste big slots.
+//
+static constexpr qint64 kSlotSizeGranularity = 64 * 1024;
+static constexpr qint64 kMaxSlotSizeSlack = 2 * kSlotSizeGranularity;
+
+Self::UploadSlotBroker(CoreMessenger *coreMessenger, QObject *parent)
+    : QObject(parent), m_coreMessenger(coreMessenger)
+{
+    connect(m_coreMessenger, &CoreMessenger::uploadSlotReceived, this, &Self::onSlotReceived);
+    connect(m_coreMessenger, &CoreMessenger::uploadSlotErrorOccurred, this, &Self::onSlotErrorOccurred);
+
+    m_expirationTimer.setInterval(kSlotExpirationCheckIntervalMs);
+    connect(&m_expirationTimer, &QTimer::timeout, this, &Self::removeExpiredSlots);
+}
+
+void Self::prefetch(const QString &requestId, qint64 sourceFileSize)
+{
+    auto &pendingUpload = m_pendingUploads[requestId];
+    pendingUpload.sourceFileSize = sourceFileSize;
+
+    if (m_encryptionOverhead < 0 || pendingUpload.isSlotRequested) {
+        //
+        //  Expected size is unknown until the first file is encrypted.
+        //
+        return;
+    }
+
+    const auto slotFileSize = slotSizeCeiling(sourceFileSize + m_encryptionOverhead);
+    const auto slotId = m_coreMessenger->requestUploadSlot(UidUtils::createUuid(), slotFileSize);
+    if (slotId.isEmpty()) {
+        qCWarning(lcUploadSlotBroker) << "Failed to prefetch upload slot";
+        return;
+    }
+
+    pendingUpload.isSlotRequested = true;
+
+    auto &slot = m_slots[slotId];
+    slot.fileSize = slotFileSize;
+    slot.age.start();
+    if (!m_expirationTimer.isActive()) {
+        m_expirationTimer.start();
+    }
+
+    std::scoped_lock<std::mutex> _(m_statsMutex);
+    ++m_stats.prefetchedCount;
+}
+
+void Self::acquire(const QString &requestId, const QString &filePath)
+{
+    removeExpiredSlots();
+
+    const auto fileSize = QFileInfo(filePath).size();
+
+    //
+    //  Learn encryption overhead and prefetch slots for the uploads queued so far.
+    //
+    if (auto pendingUploadIt = m_pendingUploads.find(requestId); pendingUploadIt != m_pendingUploads.end()) {
+        const auto encryptionOverhead = fileSize - pendingUploadIt->second.sourceFileSize;
+        m_pendingUploads.erase(pendingUploadIt);
+
+        if (encryptionOverhead >= 0 && encryptionOverhead != m_encryptionOverhead) {
+            qCDebug(lcUploadSlotBroker) << "Encryption overhead:" << encryptionOverhead;
+            m_encryptionOverhead = encryptionOverhead;
+
+            for (const auto &[pendingRequestId, pendingUpload] : m_pendingUploads) {
+                prefetch(pendingRequestId, pendingUpload.sourceFileSize);
+            }
+        }
+    }
+
+    if (auto slotIt = findFreeSlot(fileSize); slotIt != m_slots.end()) {
+        const auto &slotId = slotIt->first;
+        auto &slot = slotIt->second;
+
+        qCDebug(lcUploadSlotBroker) << "Use prefetched upload slot:" << slotId;
+
+        slot.requestId = requestId;
+        slot.waitTimer.start();
+        {
+            std::scoped_lock<std::mutex> _(m_statsMutex);
+            ++m_stats.prefetchHitCount;
+        }
+
+        emit slotRequestFinished(requestId, slotId);
+
+        if (slot.isReceived) {
+            reportWaitTime(slotId, slot);
+            const auto putUrl = slot.putUrl;
+            const auto getUrl = slot.getUrl;
+            m_slots.erase(slotIt);
+            emit slotReceived(slotId, putUrl, getUrl);
+        }
+        return;
+    }
+
+    const auto slotId = m_coreMessenger->requestUploadSlot(filePath);
+    if (slotId.isEmpty()) {
+        emit slotRequestFailed(requestId);
+        return;
+    }
+
+    auto &slot = m_slots[slotId];
+    slot.fileSize = fileSize;
+    slot.requestId = requestId;
+    slot.age.start();
+    slot.waitTimer.start();
+    {
+        std::scoped_lock<std::mutex> _(m_statsMutex);
+        ++m_stats.requestedCount;
+    }
+
+    emit slotRequestFinished(requestId, slotId);
+}
+
+void Self::release(const QString &requestId)
+{
+    m_pendingUploads.erase(requestId);
+}
+
+Self::Stats Self::stats() const
+{
+    std::scoped_lock<std::mutex> _(m_statsMutex);
+    return m_stats;
+}
+
+void Self::onSlotReceived(const QString &slotId, const QUrl &putUrl, const QUrl &getUrl)
+{
+    auto slotIt = m_slots.find(slotId);
+    if (slotIt == m_slots.end()) {
+        //
+        //  Slot was requested bypassing the broker.
+        //
+        emit slotReceived(slotId, putUrl, getUrl);
+        return;
+    }
+
+    auto &slot = slotIt->second;
+    if (slot.requestId.isEmpty()) {
+        slot.putUrl = putUrl;
+        slot.getUrl = getUrl;
+        slot.isReceived = true;
+        return;
+    }
+
+    reportWaitTime(slotId, slot);
+    m_slots.erase(slotIt);
+    emit slotReceived(slotId, putUrl, getUrl);
+}
+
+void Self::onSlotErrorOccurred(const QString &slotId, const QString &errorText)
+{
+    auto slotIt = m_slots.find(slotId);
+    if (slotIt == m_slots.end()) {
+        emit slotErrorOccurred(slotId, errorText);
+        return;
+    }
+
+    const auto isClaimed = !slotIt->second.requestId.isEmpty();
+    m_slots.erase(slotIt);
+
+    if (isClaimed) {
+        emit slotErrorOccurred(slotId, errorText);
+    } else {
+        qCWarning(lcUploadSlotBroker) << "Failed to prefetch upload slot:" << errorText;
+    }
+}
+
+void Self::removeExpiredSlots()
+{
+    for (auto slotIt = m_slots.begin(); slotIt != m_slots.end();) {
+        const auto &slot = slotIt->second;
+        if (slot.requestId.isEmpty() && slot.age.hasExpired(kSlotLifetimeMs)) {
+            qCDebug(lcUploadSlotBroker) << "Upload slot expired:" << slotIt->first;
+            slotIt = m_slots.erase(slotIt);
+
+            std::scoped_lock<std::mutex> _(m_statsMutex);
+            ++m_stats.expiredCount;
+        } else {
+            ++slotIt;
+        }
+    }
+
+    if (m_slots.empty()) {
+        m_expirationTimer.stop();
+    }
+}
+
+Self::Slots::iterator Self::findFreeSlot(qint64 fileSize)
+{
+    //
+    //  Prefer received slots, then the smallest ones.
+    //
+    auto foundIt = m_slots.end();
+    for (auto slotIt = m_slots.begin(); slotIt != m_slots.end(); ++slotIt) {
+        const auto &slot = slotIt->second;
+        if (!slot.requestId.isEmpty() || slot.fileSize < fileSize || slot.fileSize - fileSize >= kMaxSlotSizeSlack) {
+            continue;
+        }
+
+        if (foundIt == m_slots.end()) {
+            foundIt = slotIt;
+            continue;
+        }
+
+        const auto &foundSlot = foundIt->second;
+        if (slot.isReceived != foundSlot.isReceived) {
+            if (slot.isReceived) {
+                foundIt = slotIt;
+            }
+        } else if (slot.fileSize < foundSlot.fileSize) {
+            foundIt = slotIt;
+        }
+    }
+    return foundIt;
+}
+
+qint64 Self::slotSizeCeiling(qint64 fileSize)
+{
+    return (fileSize + kSlotSizeGranularity - 1) / kSlotSizeGranularity * kSlotSizeGranularity;
+}
+
+void Self::reportWaitTime(const QString &slotId, const Slot &slot)
+{
+    const auto waitTime = std::chrono::milliseconds(slot.waitTimer.elapsed());
+    qCDebug(lcUploadSlotBroker) << "Upload slot" << slotId << "was ready in" << waitTime.count() << "ms";
+
+    std::scoped_lock<std::mutex> _(m_statsMutex);
+    m_stats.lastWaitTime = waitTime;
+    m_stats.totalWaitTime += waitTime;
+}
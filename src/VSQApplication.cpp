@@ -40,7 +40,14 @@
 #include "VSQClipboardProxy.h"
 #include "VSQCustomer.h"
 #include "Logging.h"
+#include "LogConfig.h"
+#include "Metrics.h"
+#include "StartupTimeline.h"
+#include "Tracer.h"
+#include "database/core/StatementProfiler.h"
 #include "VSQUiHelper.h"
+#include "controllers/ChatsController.h"
+#include "controllers/UsersController.h"
 
 #include <QDesktopServices>
 #include <QFont>
@@ -66,18 +73,36 @@ Self::VSQApplication()
       m_keyboardEventFilter(new KeyboardEventFilter(this)),
       m_applicationStateManager(&m_messenger, &m_controllers, &m_models, m_validator, this)
 {
+    StartupTimeline::instance()->mark(QLatin1String("application-constructed"));
     m_settings.print();
 
+    Tracer::instance()->setEnabled(m_settings.tracingEnabled());
+    StatementProfiler::instance()->setSlowThreshold(m_settings.slowQueryThreshold());
+    StatementProfiler::instance()->setEnabled(m_settings.databaseProfilingEnabled());
+    m_metricsExporter = new MetricsExporter(&m_settings, this);
+
     qRegisterMetaType<qsizetype>("qsizetype");
     qRegisterMetaType<KeyboardEventFilter *>("KeyboardEventFilter*");
 
     connect(&m_models, &Models::notificationCreated, this, &Self::notificationCreated);
     connect(&m_controllers, &Controllers::notificationCreated, this, &Self::notificationCreated);
 
+    connect(m_controllers.users(), &UsersController::userLoaded, this, &Self::onStartupUserLoaded);
+    connect(m_controllers.users(), &UsersController::userNotLoaded, this,
+            [this]() { finishStartup(QLatin1String("account-selection")); });
+    connect(m_controllers.chats(), &ChatsController::chatsLoaded, this, &Self::onStartupChatsLoaded);
+
     QThread::currentThread()->setObjectName("MainThread");
     m_userDatabase->moveToThread(m_databaseThread);
     m_databaseThread->setObjectName("DatabaseThread");
     m_databaseThread->start();
+
+    //
+    //  Probe backlog of the database thread, its wait time goes to the statements report and metrics.
+    //
+    auto databaseProbeTimer = new QTimer(this);
+    connect(databaseProbeTimer, &QTimer::timeout, this, [this]() { m_userDatabase->probeQueue(); });
+    databaseProbeTimer->start(std::chrono::seconds(1));
 }
 
 Self::~VSQApplication()
@@ -146,12 +171,24 @@ int Self::run(const QString &basePath, Logging *logging)
     connect(qApp, &QGuiApplication::applicationStateChanged, this, &Self::onApplicationStateChanged);
     connect(qApp, &QGuiApplication::aboutToQuit, this, &Self::onAboutToQuit);
 
-    reloadQml();
+    //
+    //  Sign-in with XMPP connection setup and opening of the user database with chat list prefetch
+    //  run within their threads, while QML is loaded within the main thread.
+    //
+    m_controllers.users()->startInitialSignIn();
 
-    if (!Platform::instance().init()) {
-        // TODO: Improve - show error and then quit.
-        qCritical("Unable to prepare platform");
-        return -1;
+    {
+        StartupPhase startupPhase(QLatin1String("qml-load"));
+        reloadQml();
+    }
+
+    {
+        StartupPhase startupPhase(QLatin1String("platform-init"));
+        if (!Platform::instance().init()) {
+            // TODO: Improve - show error and then quit.
+            qCritical("Unable to prepare platform");
+            return -1;
+        }
     }
 
     PlatformUpdates::instance().startChecking();
@@ -227,6 +264,66 @@ void Self::onAboutToQuit()
     qDebug() << "Application about to quit";
     m_messenger.setApplicationActive(false);
     m_settings.setRunFlag(false);
+
+    auto tracer = Tracer::instance();
+    if (tracer->isEnabled()) {
+        const auto traceFileName = QCoreApplication::applicationName() + QLatin1String("_trace.json");
+        tracer->exportChromeTrace(LogConfig::instance().logsDir().filePath(traceFileName));
+    }
+
+    auto statementProfiler = StatementProfiler::instance();
+    if (statementProfiler->isEnabled()) {
+        const auto reportFileName = QCoreApplication::applicationName() + QLatin1String("_statements.txt");
+        statementProfiler->writeReport(LogConfig::instance().logsDir().filePath(reportFileName));
+    }
+}
+
+void Self::onStartupUserLoaded()
+{
+    StartupTimeline::instance()->mark(QLatin1String("user-loaded"));
+    updateStartupTimeline();
+}
+
+void Self::onStartupChatsLoaded()
+{
+    StartupTimeline::instance()->mark(QLatin1String("chats-loaded"));
+    updateStartupTimeline();
+}
+
+void Self::updateStartupTimeline()
+{
+    //
+    //  Chat list is shown when the user is loaded and its chats are in the model, whatever comes last.
+    //
+    const auto timeline = StartupTimeline::instance();
+    if (timeline->milestoneTime(QLatin1String("user-loaded")) >= 0
+        && timeline->milestoneTime(QLatin1String("chats-loaded")) >= 0) {
+        finishStartup(QLatin1String("chat-list"));
+    }
+}
+
+void Self::finishStartup(const QString &milestone)
+{
+    const auto timeline = StartupTimeline::instance();
+    if (timeline->isFinished()) {
+        return;
+    }
+    timeline->finish(milestone);
+
+    QJsonObject extras;
+    if (milestone == QLatin1String("chat-list")) {
+        const auto timeToChatList = timeline->milestoneTime(milestone);
+        const auto target = m_settings.timeToChatListTarget().count();
+        Metrics::instance()->gauge("startup_time_to_chat_list_milliseconds")->set(timeToChatList);
+        extras.insert(QLatin1String("timeToChatListMs"), timeToChatList);
+        extras.insert(QLatin1String("timeToChatListTargetMs"), static_cast<qint64>(target));
+        if (target > 0 && timeToChatList > target) {
+            qWarning() << "Time to chat list" << timeToChatList << "ms exceeds target" << target << "ms";
+        }
+    }
+
+    const auto reportFileName = QCoreApplication::applicationName() + QLatin1String("_startup.json");
+    timeline->writeReport(LogConfig::instance().logsDir().filePath(reportFileName), extras);
 }
 
 ApplicationStateManager *Self::stateManager()
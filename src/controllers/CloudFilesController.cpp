@@ -179,7 +179,7 @@ void Self::switchToParentFolder()
 
 void Self::refresh()
 {
-    switchToHierarchy(m_hierarchy);
+    switchToHierarchy(m_hierarchy, true);
 }
 
 void Self::addFiles(const QVariant &fileUrls)
@@ -233,11 +233,11 @@ void Self::removeSelectedMembers()
     m_models->cloudFilesQueue()->pushSetMembers(newMembers, file, parentFolder());
 }
 
-void Self::switchToHierarchy(const FoldersHierarchy &hierarchy)
+void Self::switchToHierarchy(const FoldersHierarchy &hierarchy, bool forceOnline)
 {
     m_requestedHierarchy = hierarchy;
     m_onlineRefreshNeeded = false;
-    m_models->cloudFilesQueue()->pushListFolder(hierarchy.back());
+    m_models->cloudFilesQueue()->pushListFolder(hierarchy.back(), forceOnline);
 }
 
 void Self::refreshIfOnline(bool isOnline)
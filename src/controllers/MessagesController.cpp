@@ -48,6 +48,7 @@
 #include "database/MessagesTable.h"
 #include "database/UserDatabase.h"
 #include "models/ChatsModel.h"
+#include "models/MessagesDecryptionWorker.h"
 #include "models/MessagesModel.h"
 #include "models/MessagesQueue.h"
 #include "models/Models.h"
@@ -57,9 +58,19 @@
 using namespace vm;
 using Self = MessagesController;
 
+//
+//  Interval within which read state updates are coalesced to a single DB update per chat.
+//
+static constexpr std::chrono::milliseconds kReadMarkersFlushInterval(500);
+
 Self::MessagesController(Messenger *messenger, const Settings *settings, Models *models, UserDatabase *userDatabase,
                          QObject *parent)
-    : QObject(parent), m_settings(settings), m_messenger(messenger), m_models(models), m_userDatabase(userDatabase)
+    : QObject(parent),
+      m_settings(settings),
+      m_messenger(messenger),
+      m_models(models),
+      m_userDatabase(userDatabase),
+      m_readMarkers(kReadMarkersFlushInterval)
 {
     auto messagesQueue = m_models->messagesQueue();
     // User database
@@ -67,11 +78,17 @@ Self::MessagesController(Messenger *messenger, const Settings *settings, Models
     // Queue
     connect(this, &Self::messageCreated, messagesQueue, &MessagesQueue::pushMessage);
     connect(messagesQueue, &MessagesQueue::updateMessage, this, &Self::onUpdateMessage);
+    connect(m_models->messagesDecryptionWorker(), &MessagesDecryptionWorker::messagesDecrypted, this,
+            &Self::onMessagesDecrypted);
     // Models
     connect(m_models->messages(), &MessagesModel::pictureIconNotFound, this, &Self::onPictureIconNotFound);
+    connect(m_models->messages(), &MessagesModel::viewportChanged, messagesQueue, &MessagesQueue::pushViewport);
+    connect(m_models->messages(), &MessagesModel::viewportClosed, messagesQueue, &MessagesQueue::closeViewport);
     // Messages
     connect(m_messenger, &Messenger::messageReceived, this, &Self::onMessageReceived);
     connect(m_messenger, &Messenger::updateMessage, this, &Self::onUpdateMessage);
+    // Read markers
+    connect(&m_readMarkers, &MessageMarkerAggregator::markerReady, this, &Self::onReadMarkerReady);
 }
 
 void Self::loadChat(const ChatHandler &chat)
@@ -88,6 +105,8 @@ void Self::loadNewChat(const ChatHandler &chat)
 
 void Self::closeChat()
 {
+    m_readMarkers.flush();
+
     auto messages = m_models->messages();
     messages->clearChat();
     messages->clearMessages();
@@ -213,6 +232,11 @@ void Self::setupTableConnections()
     connect(table, &MessagesTable::chatMessagesFetched, m_models->messages(), &MessagesModel::setMessages);
 }
 
+void Self::onReadMarkerReady(const MessageHandler &message)
+{
+    m_userDatabase->messagesTable()->markIncomingMessagesAsReadBeforeMessage(message->id());
+}
+
 void Self::onUpdateMessage(const MessageUpdate &messageUpdate)
 {
     //
@@ -226,6 +250,21 @@ void Self::onUpdateMessage(const MessageUpdate &messageUpdate)
     m_userDatabase->updateMessage(messageUpdate);
 }
 
+void Self::onMessagesDecrypted(const MessageUpdates &messageUpdates)
+{
+    //
+    //  Update UI for the current chat.
+    //
+    for (const auto &messageUpdate : messageUpdates) {
+        m_models->messages()->updateMessage(messageUpdate);
+    }
+
+    //
+    //  Update DB within a single transaction.
+    //
+    m_userDatabase->updateMessages(messageUpdates);
+}
+
 void Self::onPictureIconNotFound(const MessageId &messageId)
 {
     const auto message = m_models->messages()->findById(messageId);
@@ -286,7 +325,11 @@ void Self::onMessageReceived(ModifiableMessageHandler message)
             IncomingMessageStageUpdate update;
             update.messageId = message->id();
             update.stage = IncomingMessageStage::Read;
-            onUpdateMessage(update);
+            messages->updateMessage(update);
+            //
+            //  DB is updated once per burst with a range update.
+            //
+            m_readMarkers.push(message);
         }
     }
 }
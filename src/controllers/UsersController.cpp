@@ -40,6 +40,7 @@
 #include "models/Models.h"
 #include "models/ChatsModel.h"
 #include "models/MessagesModel.h"
+#include "StartupTimeline.h"
 
 #if VS_ANDROID
 #    include "VSQAndroid.h"
@@ -69,6 +70,23 @@ Self::UsersController(Messenger *messenger, Models *models, UserDatabase *userDa
     connect(this, &Self::userLoaded, this, &Self::hideSplashScreen);
     connect(this, &Self::userNotLoaded, this, &Self::hideSplashScreen);
 
+    //
+    //  Remember result of the early sign-in, since it can come before QML asks for it.
+    //
+    connect(this, &Self::userLoaded, this, [this]() {
+        if (m_initialSignInState == InitialSignInState::Started) {
+            m_initialSignInState = InitialSignInState::UserLoaded;
+        }
+    });
+    connect(this, &Self::userNotLoaded, this, [this]() {
+        if (m_initialSignInState == InitialSignInState::Started) {
+            m_initialSignInState = InitialSignInState::UserNotLoaded;
+        }
+    });
+    connect(messenger, &Messenger::signedIn, this, []() { StartupTimeline::instance()->endPhase("sign-in"); });
+    connect(messenger, &Messenger::signInErrorOccured, this,
+            []() { StartupTimeline::instance()->endPhase("sign-in"); });
+
     // Notifications
     auto notifyAboutError = [this](const QString &text) { emit notificationCreated(text, true); };
     connect(messenger, &Messenger::signInErrorOccured, notifyAboutError);
@@ -77,15 +95,57 @@ Self::UsersController(Messenger *messenger, Models *models, UserDatabase *userDa
     connect(userDatabase, &UserDatabase::errorOccurred, notifyAboutError);
 }
 
+void Self::startInitialSignIn()
+{
+    const auto username = initialUsername();
+    if (username.isEmpty()) {
+        return;
+    }
+
+    m_initialSignInState = InitialSignInState::Started;
+    emit m_userDatabase->prepareUser(username);
+    StartupTimeline::instance()->beginPhase("sign-in");
+    m_messenger->signIn(username);
+}
+
 void Self::initialSignIn()
+{
+    switch (m_initialSignInState) {
+    case InitialSignInState::Started:
+        //
+        //  Result comes later.
+        //
+        break;
+
+    case InitialSignInState::UserLoaded:
+        emit userLoaded();
+        break;
+
+    case InitialSignInState::UserNotLoaded:
+        emit userNotLoaded();
+        break;
+
+    case InitialSignInState::NotStarted: {
+        const auto username = initialUsername();
+        if (username.isEmpty()) {
+            emit userNotLoaded();
+        } else {
+            StartupTimeline::instance()->beginPhase("sign-in");
+            m_messenger->signIn(username);
+        }
+        break;
+    }
+    }
+}
+
+QString Self::initialUsername() const
 {
     const auto settings = m_messenger->settings();
     const auto username = settings->lastSignedInUser();
     if (username.isEmpty() || settings->userCredential(username).isEmpty()) {
-        emit userNotLoaded();
-    } else {
-        m_messenger->signIn(username);
+        return QString();
     }
+    return username;
 }
 
 QString Self::currentUserId() const
@@ -38,6 +38,7 @@
 #include "database/core/Database.h"
 #include "database/core/DatabaseUtils.h"
 #include "MessageContentType.h"
+#include "Tracer.h"
 
 using namespace vm;
 using Self = AttachmentsTable;
@@ -60,6 +61,7 @@ bool Self::create()
 
 void Self::onAddAttachment(MessageHandler message)
 {
+    TraceSpan traceSpan("database", QStringLiteral("AttachmentsTable::onAddAttachment"));
     const auto attachment = message->contentAsAttachment();
 
     ScopedConnection connection(*database());
@@ -134,6 +136,7 @@ static std::tuple<QString, DatabaseUtils::BindValues> createDatabaseBindings(con
 
 void Self::onUpdateAttachment(const MessageUpdate &attachmentUpdate)
 {
+    TraceSpan traceSpan("database", QStringLiteral("AttachmentsTable::onUpdateAttachment"));
     auto [queryId, bindValues] = createDatabaseBindings(attachmentUpdate);
     if (queryId.isEmpty()) {
         // Nothing to update.
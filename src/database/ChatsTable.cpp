@@ -38,12 +38,14 @@
 #include "Utils.h"
 #include "database/core/Database.h"
 #include "database/core/DatabaseUtils.h"
+#include "Tracer.h"
 
 using namespace vm;
 
 ChatsTable::ChatsTable(Database *database) : DatabaseTable(QLatin1String("chats"), database)
 {
     connect(this, &ChatsTable::fetch, this, &ChatsTable::onFetch);
+    connect(this, &ChatsTable::prefetch, this, &ChatsTable::onPrefetch);
     connect(this, &ChatsTable::addChat, this, &ChatsTable::onAddChat);
     connect(this, &ChatsTable::deleteChat, this, &ChatsTable::onDeleteChat);
     connect(this, &ChatsTable::updateLastMessage, this, &ChatsTable::onUpdateLastMessage);
@@ -62,44 +64,75 @@ bool ChatsTable::create()
     return false;
 }
 
-void ChatsTable::onFetch()
+std::optional<ModifiableChats> ChatsTable::readChats()
 {
-    qCDebug(lcDatabase) << "Fetching chats...";
     ScopedConnection connection(*database());
     auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("selectChats"));
     if (!query) {
+        return std::nullopt;
+    }
+
+    ModifiableChats chats;
+    while (query->next()) {
+        auto id = query->value("id").toString();
+        auto title = query->value("title").toString();
+        auto type = query->value("type").toString();
+        auto createdAt = query->value("createdAt").toULongLong();
+        auto lastMessage = DatabaseUtils::readMessage(*query, QLatin1String("lastMessageId"));
+        auto unreadMessageCount = query->value("unreadMessageCount").value<qsizetype>();
+
+        auto chat = std::make_unique<Chat>();
+
+        chat->setId(ChatId(id));
+        chat->setTitle(title);
+        chat->setType(ChatTypeFromString(type));
+        chat->setCreatedAt(QDateTime::fromTime_t(createdAt));
+        chat->setLastMessage(lastMessage);
+        chat->setUnreadMessageCount(unreadMessageCount);
+
+        chat->setGroup(GroupsTable::readGroup(*query, QLatin1String("group")));
+
+        chats.emplace_back(std::move(chat));
+    }
+    return chats;
+}
+
+void ChatsTable::onFetch()
+{
+    TraceSpan traceSpan("database", QStringLiteral("ChatsTable::onFetch"));
+    qCDebug(lcDatabase) << "Fetching chats...";
+    auto chats = std::move(m_prefetchedChats);
+    m_prefetchedChats.reset();
+    if (chats && database()->writeCount() != m_prefetchWriteCount) {
+        qCDebug(lcDatabase) << "Prefetched chats are outdated";
+        chats.reset();
+    }
+    if (!chats) {
+        chats = readChats();
+    }
+
+    if (!chats) {
         qCCritical(lcDatabase) << "ChatsTable::onFetch error";
         emit errorOccurred(tr("Failed to fetch chats"));
     } else {
-        ModifiableChats chats;
-        while (query->next()) {
-            auto id = query->value("id").toString();
-            auto title = query->value("title").toString();
-            auto type = query->value("type").toString();
-            auto createdAt = query->value("createdAt").toULongLong();
-            auto lastMessage = DatabaseUtils::readMessage(*query, QLatin1String("lastMessageId"));
-            auto unreadMessageCount = query->value("unreadMessageCount").value<qsizetype>();
-
-            auto chat = std::make_unique<Chat>();
-
-            chat->setId(ChatId(id));
-            chat->setTitle(title);
-            chat->setType(ChatTypeFromString(type));
-            chat->setCreatedAt(QDateTime::fromTime_t(createdAt));
-            chat->setLastMessage(lastMessage);
-            chat->setUnreadMessageCount(unreadMessageCount);
-
-            chat->setGroup(GroupsTable::readGroup(*query, QLatin1String("group")));
-
-            chats.emplace_back(std::move(chat));
-        }
-        qCDebug(lcDatabase) << "Fetched chats count:" << chats.size();
-        emit fetched(std::move(chats));
+        qCDebug(lcDatabase) << "Fetched chats count:" << chats->size();
+        emit fetched(std::move(*chats));
+    }
+}
+
+void ChatsTable::onPrefetch()
+{
+    TraceSpan traceSpan("database", QStringLiteral("ChatsTable::onPrefetch"));
+    m_prefetchedChats = readChats();
+    m_prefetchWriteCount = database()->writeCount();
+    if (m_prefetchedChats) {
+        qCDebug(lcDatabase) << "Prefetched chats count:" << m_prefetchedChats->size();
     }
 }
 
 void ChatsTable::onAddChat(const ChatHandler &chat)
 {
+    TraceSpan traceSpan("database", QStringLiteral("ChatsTable::onAddChat"));
     qCDebug(lcDatabase) << "Trying to insert chat:" << chat->id();
 
     ScopedConnection connection(*database());
@@ -120,6 +153,7 @@ void ChatsTable::onAddChat(const ChatHandler &chat)
 
 void ChatsTable::onDeleteChat(const ChatId &chatId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("ChatsTable::onDeleteChat"));
     const DatabaseUtils::BindValues values { { ":id", QString(chatId) } };
     const auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("deleteChatById"), values);
     if (query) {
@@ -132,6 +166,7 @@ void ChatsTable::onDeleteChat(const ChatId &chatId)
 
 void ChatsTable::onUpdateLastMessage(const MessageHandler &message)
 {
+    TraceSpan traceSpan("database", QStringLiteral("ChatsTable::onUpdateLastMessage"));
     ScopedConnection connection(*database());
     const DatabaseUtils::BindValues values { { ":id", QString(message->chatId()) },
                                              { ":lastMessageId", QString(message->id()) } };
@@ -146,6 +181,7 @@ void ChatsTable::onUpdateLastMessage(const MessageHandler &message)
 
 void ChatsTable::onResetLastMessage(const ChatId &chatId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("ChatsTable::onResetLastMessage"));
     ScopedConnection connection(*database());
     const DatabaseUtils::BindValues values { { ":id", QString(chatId) }, { ":lastMessageId", QString() } };
     const auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("updateLastMessage"), values);
@@ -161,6 +197,7 @@ void ChatsTable::onResetLastMessage(const ChatId &chatId)
 
 void ChatsTable::onRequestChatUnreadMessageCount(const ChatId &chatId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("ChatsTable::onRequestChatUnreadMessageCount"));
     ScopedConnection connection(*database());
     const DatabaseUtils::BindValues values { { ":id", QString(chatId) } };
     auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("selectUnreadMessageCount"), values);
@@ -177,6 +214,7 @@ void ChatsTable::onRequestChatUnreadMessageCount(const ChatId &chatId)
 
 void ChatsTable::onMarkMessagesAsRead(const ChatHandler &chat)
 {
+    TraceSpan traceSpan("database", QStringLiteral("ChatsTable::onMarkMessagesAsRead"));
     ScopedConnection connection(*database());
 
     //
@@ -36,6 +36,7 @@
 
 #include "core/Database.h"
 #include "core/DatabaseUtils.h"
+#include "Tracer.h"
 
 using namespace vm;
 
@@ -119,6 +120,47 @@ bool CloudFilesTable::updateFile(const CloudFileHandler &cloudFile, const CloudF
     }
 }
 
+bool CloudFilesTable::updateFolderListing(const CloudFileHandler &cloudFolder)
+{
+    if (cloudFolder->isRoot()) {
+        return true;
+    }
+
+    const auto bindValues = DatabaseUtils::createCloudFolderListingBindings(cloudFolder);
+    const auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("updateCloudFolderListing"), bindValues);
+    if (query) {
+        qCDebug(lcDatabase) << "Cloud folder listing was updated" << bindValues.front().second;
+        return true;
+    } else {
+        qCCritical(lcDatabase) << "CloudFilesTable::updateFolderListing error";
+        emit errorOccurred(tr("Failed to update cloud folder listing"));
+        return false;
+    }
+}
+
+CloudFileHandler CloudFilesTable::readFolderListing(const CloudFileHandler &cloudFolder)
+{
+    if (cloudFolder->isRoot()) {
+        return cloudFolder;
+    }
+
+    const DatabaseUtils::BindValues values { { ":folderId", QString(cloudFolder->id()) } };
+    auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("selectCloudFolderListing"), values);
+    if (!query) {
+        qCCritical(lcDatabase) << "CloudFilesTable::readFolderListing error";
+        return cloudFolder;
+    }
+
+    auto listedFolder = std::make_shared<CloudFile>(*cloudFolder);
+    if (query->next()) {
+        DatabaseUtils::readCloudFolderListing(*query, *listedFolder);
+    } else {
+        listedFolder->setListedUpdatedAt(QDateTime());
+        listedFolder->setListedAt(QDateTime());
+    }
+    return listedFolder;
+}
+
 bool CloudFilesTable::updateDownloadedFile(const DownloadCloudFileUpdate &update)
 {
     const auto bindValues = DatabaseUtils::createDownloadedCloudFileBindings(update.file, update.fingerprint);
@@ -196,6 +238,7 @@ QStringList CloudFilesTable::getSubFoldersIds(const QString &folderId)
 
 void CloudFilesTable::onFetch(const CloudFileHandler &folder)
 {
+    TraceSpan traceSpan("database", QStringLiteral("CloudFilesTable::onFetch"));
     qCDebug(lcDatabase) << "Fetching cloud files...";
     ScopedConnection connection(*database());
     const DatabaseUtils::BindValues values { { ":folderId", QString(folder->id()) } };
@@ -209,12 +252,13 @@ void CloudFilesTable::onFetch(const CloudFileHandler &folder)
             cloudFiles.push_back(DatabaseUtils::readCloudFile(*query));
         }
         qCDebug(lcDatabase) << "Fetched cloud files count: " << cloudFiles.size();
-        emit fetched(folder, std::move(cloudFiles));
+        emit fetched(readFolderListing(folder), std::move(cloudFiles));
     }
 }
 
 void CloudFilesTable::onUpdateCloudFiles(const CloudFilesUpdate &update)
 {
+    TraceSpan traceSpan("database", QStringLiteral("CloudFilesTable::onUpdateCloudFiles"));
     if (std::holds_alternative<CachedListCloudFolderUpdate>(update)
         || std::holds_alternative<TransferCloudFileUpdate>(update)
         || std::holds_alternative<ListMembersCloudFileUpdate>(update)) {
@@ -226,6 +270,7 @@ void CloudFilesTable::onUpdateCloudFiles(const CloudFilesUpdate &update)
     bool success = false;
     if (auto upd = std::get_if<CloudListCloudFolderUpdate>(&update)) {
         success = deleteFiles(upd->deleted) && updateFile(upd->parentFolder, CloudFileUpdateSource::ListedParent)
+                && updateFolderListing(upd->parentFolder)
                 && updateFiles(upd->updated, CloudFileUpdateSource::ListedChild) && createFiles(upd->added);
     } else if (auto upd = std::get_if<CreateCloudFilesUpdate>(&update)) {
         success = createFiles(upd->files);
@@ -36,6 +36,7 @@
 
 #include "database/core/Database.h"
 #include "database/core/DatabaseUtils.h"
+#include "Tracer.h"
 
 using namespace vm;
 using Self = ContactsTable;
@@ -59,6 +60,7 @@ bool Self::create()
 
 void Self::onAddContact(const Contact &contact)
 {
+    TraceSpan traceSpan("database", QStringLiteral("ContactsTable::onAddContact"));
 
     DatabaseUtils::BindValues bindValues { { ":userId", QString(contact.userId()) },
                                            { ":username", contact.username() },
@@ -80,6 +82,7 @@ void Self::onAddContact(const Contact &contact)
 
 void Self::onFetch(quint64 requestId, const QStringList &userIds)
 {
+    TraceSpan traceSpan("database", QStringLiteral("ContactsTable::onFetch"));
     DatabaseUtils::BindValues bindValues { { ":userIds", userIds } };
 
     ScopedConnection connection(*database());
@@ -99,6 +102,7 @@ void Self::onFetch(quint64 requestId, const QStringList &userIds)
 
 void Self::onUpdateContact(const ContactUpdate &contactUpdate)
 {
+    TraceSpan traceSpan("database", QStringLiteral("ContactsTable::onUpdateContact"));
 
     DatabaseUtils::BindValues bindValues;
     QLatin1String queryId;
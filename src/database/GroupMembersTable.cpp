@@ -37,6 +37,7 @@
 #include "core/Database.h"
 #include "core/DatabaseUtils.h"
 #include "Utils.h"
+#include "Tracer.h"
 
 using namespace vm;
 using Self = GroupMembersTable;
@@ -63,6 +64,7 @@ bool Self::create()
 
 void Self::onAdd(const GroupMembers &groupMembers)
 {
+    TraceSpan traceSpan("database", QStringLiteral("GroupMembersTable::onAdd"));
     qCDebug(lcDatabase) << "Start adding group members";
 
     ScopedConnection connection(*database());
@@ -84,6 +86,7 @@ void Self::onAdd(const GroupMembers &groupMembers)
 
 void Self::onFetch(const GroupId &groupId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("GroupMembersTable::onFetch"));
     qCDebug(lcDatabase) << "Start fetching group members by for group:" << groupId;
 
     ScopedConnection connection(*database());
@@ -107,6 +110,7 @@ void Self::onFetch(const GroupId &groupId)
 
 void Self::onUpdateGroup(const GroupUpdate &groupUpdate)
 {
+    TraceSpan traceSpan("database", QStringLiteral("GroupMembersTable::onUpdateGroup"));
     std::list<DatabaseUtils::BindValues> bindValuesCollection;
     QLatin1String queryId;
 
@@ -142,6 +146,7 @@ void Self::onUpdateGroup(const GroupUpdate &groupUpdate)
 
 void Self::onDeleteGroupMembers(const GroupId &groupId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("GroupMembersTable::onDeleteGroupMembers"));
     const DatabaseUtils::BindValues values { { ":id", QString(groupId) } };
     const auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("deleteGroupMembersByGroupId"), values);
     if (query) {
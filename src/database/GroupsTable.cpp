@@ -36,6 +36,7 @@
 
 #include "core/Database.h"
 #include "core/DatabaseUtils.h"
+#include "Tracer.h"
 
 using namespace vm;
 using Self = GroupsTable;
@@ -86,6 +87,7 @@ GroupHandler Self::readGroup(const QSqlQuery &query, const QString &preffix)
 
 void Self::onAdd(const GroupHandler &group)
 {
+    TraceSpan traceSpan("database", QStringLiteral("GroupsTable::onAdd"));
     ScopedConnection connection(*database());
 
     const QVariant groupCache = !group->cache().isEmpty() ? group->cache() : QVariant("");
@@ -109,6 +111,7 @@ void Self::onAdd(const GroupHandler &group)
 
 void Self::onFetch()
 {
+    TraceSpan traceSpan("database", QStringLiteral("GroupsTable::onFetch"));
     ScopedConnection connection(*database());
     auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("selectGroups"));
     if (query) {
@@ -129,6 +132,7 @@ void Self::onFetch()
 
 void Self::onUpdateGroup(const GroupUpdate &groupUpdate)
 {
+    TraceSpan traceSpan("database", QStringLiteral("GroupsTable::onUpdateGroup"));
     if (auto update = std::get_if<GroupNameUpdate>(&groupUpdate)) {
         updateGroupName(update->groupId, update->name);
 
@@ -141,6 +145,7 @@ void Self::onUpdateGroup(const GroupUpdate &groupUpdate)
 
 void Self::onDeleteGroup(const GroupId &groupId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("GroupsTable::onDeleteGroup"));
     ScopedConnection connection(*database());
     const DatabaseUtils::BindValues values { { ":id", QString(groupId) } };
     const auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("deleteGroupById"), values);
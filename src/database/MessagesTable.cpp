@@ -40,6 +40,7 @@
 #include "IncomingMessage.h"
 #include "OutgoingMessage.h"
 #include "MessageContentJsonUtils.h"
+#include "Tracer.h"
 
 using namespace vm;
 
@@ -47,6 +48,7 @@ MessagesTable::MessagesTable(Database *database) : DatabaseTable(QLatin1String("
 {
     connect(this, &MessagesTable::fetchChatMessages, this, &MessagesTable::onFetchChatMessages);
     connect(this, &MessagesTable::fetchNotSentMessages, this, &MessagesTable::onFetchNotSentMessages);
+    connect(this, &MessagesTable::fetchEncryptedMessages, this, &MessagesTable::onFetchEncryptedMessages);
     connect(this, &MessagesTable::addMessage, this, &MessagesTable::onAddMessage);
     connect(this, &MessagesTable::deleteChatMessages, this, &MessagesTable::onDeleteChatMessages);
     connect(this, &MessagesTable::updateMessage, this, &MessagesTable::onUpdateMessage);
@@ -68,6 +70,7 @@ bool MessagesTable::create()
 
 void MessagesTable::onFetchChatMessages(const ChatId &chatId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("MessagesTable::onFetchChatMessages"));
     ScopedConnection connection(*database());
     const DatabaseUtils::BindValues values { { ":chatId", QString(chatId) } };
     auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("selectChatMessages"), values);
@@ -85,6 +88,7 @@ void MessagesTable::onFetchChatMessages(const ChatId &chatId)
 
 void MessagesTable::onFetchNotSentMessages()
 {
+    TraceSpan traceSpan("database", QStringLiteral("MessagesTable::onFetchNotSentMessages"));
     ScopedConnection connection(*database());
     auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("selectNotSentMessages"));
     if (!query) {
@@ -99,8 +103,28 @@ void MessagesTable::onFetchNotSentMessages()
     }
 }
 
+void MessagesTable::onFetchEncryptedMessages()
+{
+    TraceSpan traceSpan("database", QStringLiteral("MessagesTable::onFetchEncryptedMessages"));
+    ScopedConnection connection(*database());
+    auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("selectEncryptedMessages"));
+    if (!query) {
+        qCCritical(lcDatabase) << "MessagesTable::onFetchEncryptedMessages error";
+        emit errorOccurred(tr("Failed to fetch encrypted messages"));
+    } else {
+        ModifiableMessages messages;
+        while (query->next()) {
+            if (auto message = DatabaseUtils::readMessage(*query)) {
+                messages.push_back(std::move(message));
+            }
+        }
+        emit encryptedMessagesFetched(std::move(messages));
+    }
+}
+
 void MessagesTable::onAddMessage(const MessageHandler &message)
 {
+    TraceSpan traceSpan("database", QStringLiteral("MessagesTable::onAddMessage"));
     auto messageStage = message->stageString();
 
     ScopedConnection connection(*database());
@@ -141,6 +165,7 @@ void MessagesTable::onAddMessage(const MessageHandler &message)
 
 void MessagesTable::onDeleteChatMessages(const ChatId &chatId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("MessagesTable::onDeleteChatMessages"));
     const DatabaseUtils::BindValues values { { ":id", QString(chatId) } };
     const auto query = DatabaseUtils::readExecQuery(database(), QLatin1String("deleteMessagesByChatId"), values);
     if (query) {
@@ -153,6 +178,7 @@ void MessagesTable::onDeleteChatMessages(const ChatId &chatId)
 
 void MessagesTable::onUpdateMessage(const MessageUpdate &messageUpdate)
 {
+    TraceSpan traceSpan("database", QStringLiteral("MessagesTable::onUpdateMessage"));
     QString queryId;
     DatabaseUtils::BindValues bindValues;
 
@@ -165,6 +191,23 @@ void MessagesTable::onUpdateMessage(const MessageUpdate &messageUpdate)
             markIncomingMessagesAsReadBeforeMessage(update->messageId);
         }
 
+    } else if (auto update = std::get_if<IncomingMessageDecryptedUpdate>(&messageUpdate)) {
+        const auto &content = update->decryptedMessage->content();
+
+        QString body;
+        if (auto text = std::get_if<MessageContentText>(&content)) {
+            body = text->text();
+
+        } else if (auto invitation = std::get_if<MessageContentGroupInvitation>(&content)) {
+            body = MessageContentJsonUtils::toString(*invitation);
+        }
+
+        queryId = QLatin1String("updateDecryptedMessage");
+        bindValues.push_back({ ":id", QString(update->messageId) });
+        bindValues.push_back({ ":contentType", MessageContentTypeToString(content) });
+        bindValues.push_back({ ":body", body });
+        bindValues.push_back({ ":stage", IncomingMessageStageToString(IncomingMessageStage::Decrypted) });
+
     } else if (auto update = std::get_if<OutgoingMessageStageUpdate>(&messageUpdate)) {
         queryId = QLatin1String("updateOutgoingMessageStage");
         bindValues.push_back({ ":id", QString(update->messageId) });
@@ -190,6 +233,7 @@ void MessagesTable::onUpdateMessage(const MessageUpdate &messageUpdate)
 
 void MessagesTable::onMarkIncomingMessagesAsReadBeforeMessage(const MessageId &messageId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("MessagesTable::onMarkIncomingMessagesAsReadBeforeMessage"));
     ScopedConnection connection(*database());
 
     qCDebug(lcDatabase) << "Start mark all messages as read before message:" << messageId;
@@ -229,6 +273,7 @@ void MessagesTable::onMarkIncomingMessagesAsReadBeforeMessage(const MessageId &m
 
 void MessagesTable::onMarkOutgoingMessagesAsReadBeforeMessage(const MessageId &messageId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("MessagesTable::onMarkOutgoingMessagesAsReadBeforeMessage"));
     ScopedConnection connection(*database());
 
     qCDebug(lcDatabase) << "Start mark all outgoing messages as read before message:" << messageId;
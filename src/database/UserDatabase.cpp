@@ -37,6 +37,7 @@
 #include "Settings.h"
 #include "Utils.h"
 #include "database/core/DatabaseUtils.h"
+#include "database/core/StatementProfiler.h"
 #include "database/AttachmentsTable.h"
 #include "database/ChatsTable.h"
 #include "database/CloudFilesTable.h"
@@ -47,6 +48,10 @@
 #include "database/UserDatabaseMigration.h"
 
 #include "MessageContentGroupInvitation.h"
+#include "StartupTimeline.h"
+#include "Tracer.h"
+
+#include <chrono>
 
 using namespace vm;
 using Self = UserDatabase;
@@ -59,20 +64,31 @@ constexpr const int k_groupMembersTableIndex = 4;
 constexpr const int k_groupsTableIndex = 5;
 constexpr const int k_messagesTableIndex = 6;
 
+static const QString k_queueName = QLatin1String("UserDatabase");
+
+static qint64 steadyClockMicroseconds()
+{
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
 Self::UserDatabase(const QDir &databaseDir, QObject *parent)
     : Database(VERSION_DATABASE_SCHEME, parent), m_databaseDir(databaseDir)
 {
     setMigration(std::make_unique<UserDatabaseMigration>());
 
     connect(this, &Self::openUser, this, &Self::onOpenUser);
+    connect(this, &Self::prepareUser, this, &Self::onPrepareUser);
     connect(this, &Self::closeUser, this, &Self::onCloseUser);
     connect(this, &Self::closed, this, &Self::userClosed);
     connect(this, &Self::writeMessage, this, &Self::onWriteMessage);
     connect(this, &Self::updateMessage, this, &Self::onUpdateMessage);
+    connect(this, &Self::updateMessages, this, &Self::onUpdateMessages);
     connect(this, &Self::writeChatAndLastMessage, this, &Self::onWriteChatAndLastMessage);
     connect(this, &Self::writeGroupChat, this, &Self::onWriteGroupChat);
     connect(this, &Self::deleteNewGroupChat, this, &Self::onDeleteNewGroupChat);
     connect(this, &Self::updateGroup, this, &Self::onUpdateGroup);
+    connect(this, &Self::queueProbePosted, this, &Self::onQueueProbePosted, Qt::QueuedConnection);
 }
 
 const AttachmentsTable *Self::attachmentsTable() const
@@ -190,12 +206,29 @@ bool Self::create()
     return true;
 }
 
+void Self::probeQueue()
+{
+    emit queueProbePosted(steadyClockMicroseconds(), QPrivateSignal());
+}
+
+void Self::onQueueProbePosted(qint64 postedAtMicroseconds)
+{
+    const auto wait = std::chrono::microseconds(steadyClockMicroseconds() - postedAtMicroseconds);
+    StatementProfiler::instance()->setQueueWait(k_queueName, wait);
+}
+
 void Self::onOpenUser(const QString &username)
 {
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onOpenUser"));
     if (!DatabaseUtils::isValidName(username)) {
         qCCritical(lcDatabase) << "Invalid database id:" << username;
         emit errorOccurred(tr("Invalid database id"));
+    } else if (username == m_preparedUsername) {
+        m_preparedUsername.clear();
+        emit opened();
+        emit userOpened(username);
     } else {
+        StartupPhase startupPhase(QLatin1String("database-open"));
         const QString fileName = QString("user-%1.sqlite3").arg(username);
         const QString filePath(m_databaseDir.filePath(fileName));
 
@@ -207,13 +240,42 @@ void Self::onOpenUser(const QString &username)
     }
 }
 
+void Self::onPrepareUser(const QString &username)
+{
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onPrepareUser"));
+    m_preparedUsername.clear();
+    if (!DatabaseUtils::isValidName(username)) {
+        qCCritical(lcDatabase) << "Invalid database id:" << username;
+        return;
+    }
+
+    {
+        StartupPhase startupPhase(QLatin1String("database-prepare"));
+        const QString fileName = QString("user-%1.sqlite3").arg(username);
+        const QString filePath(m_databaseDir.filePath(fileName));
+        //
+        //  Database is opened once again by the following openUser(), if preparation failed.
+        //
+        if (!Database::prepare(filePath, username + QLatin1String("-messenger"))) {
+            return;
+        }
+    }
+
+    StartupPhase startupPhase(QLatin1String("chat-list-prefetch"));
+    chatsTable()->prefetch();
+    m_preparedUsername = username;
+}
+
 void Self::onCloseUser()
 {
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onCloseUser"));
+    m_preparedUsername.clear();
     Database::close();
 }
 
 void Self::onWriteMessage(const MessageHandler &message)
 {
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onWriteMessage"));
     ScopedConnection connection(*this);
     ScopedTransaction transaction(*this);
     messagesTable()->addMessage(message);
@@ -233,6 +295,7 @@ void Self::onWriteMessage(const MessageHandler &message)
 
 void UserDatabase::onUpdateMessage(const MessageUpdate &messageUpdate)
 {
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onUpdateMessage"));
     // Early ignore of updates that doesn't write to DB
     if (std::holds_alternative<MessageAttachmentProcessedSizeUpdate>(messageUpdate)) {
         return;
@@ -246,8 +309,35 @@ void UserDatabase::onUpdateMessage(const MessageUpdate &messageUpdate)
     }
 }
 
+void Self::onUpdateMessages(const MessageUpdates &messageUpdates)
+{
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onUpdateMessages"));
+    ScopedConnection connection(*this);
+    ScopedTransaction transaction(*this);
+    for (const auto &messageUpdate : messageUpdates) {
+        if (std::holds_alternative<MessageAttachmentProcessedSizeUpdate>(messageUpdate)) {
+            continue;
+        }
+
+        messagesTable()->updateMessage(messageUpdate);
+        attachmentsTable()->updateAttachment(messageUpdate);
+
+        //
+        //  Decrypted message can bring an attachment and the sender username.
+        //
+        if (auto decryptedUpdate = std::get_if<IncomingMessageDecryptedUpdate>(&messageUpdate)) {
+            const auto &message = decryptedUpdate->decryptedMessage;
+            if (rowsChangedCount() > 0 && message->contentIsAttachment()) {
+                attachmentsTable()->addAttachment(message);
+            }
+            contactsTable()->updateContact(UsernameContactUpdate { message->senderId(), message->senderUsername() });
+        }
+    }
+}
+
 void Self::onWriteChatAndLastMessage(const ChatHandler &chat)
 {
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onWriteChatAndLastMessage"));
     ScopedConnection connection(*this);
     ScopedTransaction transaction(*this);
     //
@@ -306,6 +396,7 @@ void Self::onWriteChatAndLastMessage(const ChatHandler &chat)
 
 void Self::onWriteGroupChat(const ChatHandler &chat, const GroupHandler &group, const GroupMembers &groupMembers)
 {
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onWriteGroupChat"));
     ScopedConnection connection(*this);
     ScopedTransaction transaction(*this);
     chatsTable()->addChat(chat);
@@ -317,6 +408,7 @@ void Self::onWriteGroupChat(const ChatHandler &chat, const GroupHandler &group,
 
 void Self::onDeleteNewGroupChat(const ChatId &chatId)
 {
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onDeleteNewGroupChat"));
     ScopedConnection connection(*this);
     ScopedTransaction transaction(*this);
     // NOTE(fpohtmeh): new group chat has no attachments
@@ -329,6 +421,7 @@ void Self::onDeleteNewGroupChat(const ChatId &chatId)
 
 void Self::onUpdateGroup(const GroupUpdate &groupUpdate)
 {
+    TraceSpan traceSpan("database", QStringLiteral("UserDatabase::onUpdateGroup"));
     ScopedConnection connection(*this);
     ScopedTransaction transaction(*this);
     groupsTable()->updateGroup(groupUpdate);
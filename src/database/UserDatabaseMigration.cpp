@@ -38,6 +38,8 @@
 #include "database/patches/version2/PatchCloudFiles.h"
 #include "database/patches/version3/PatchChats.h"
 #include "database/patches/version3/PatchGroups.h"
+#include "database/patches/version4/PatchCloudFiles.h"
+#include "database/patches/version5/PatchMessages.h"
 
 using namespace vm;
 
@@ -48,4 +50,6 @@ UserDatabaseMigration::UserDatabaseMigration() : Migration()
     addPatch(std::make_unique<version2::PatchCloudFiles>());
     addPatch(std::make_unique<version3::PatchChats>());
     addPatch(std::make_unique<version3::PatchGroups>());
+    addPatch(std::make_unique<version4::PatchCloudFiles>());
+    addPatch(std::make_unique<version5::PatchMessages>());
 }
@@ -53,8 +53,18 @@ Self::~Database()
 }
 
 bool Self::open(const QString &databaseFileName, const QString &connectionName)
+{
+    if (!prepare(databaseFileName, connectionName)) {
+        return false;
+    }
+    emit opened();
+    return true;
+}
+
+bool Self::prepare(const QString &databaseFileName, const QString &connectionName)
 {
     close();
+    m_writeCount = 0;
 
     qCDebug(lcDatabase) << "Opening of database:" << databaseFileName;
     m_qtDatabase = QSqlDatabase::addDatabase(m_type, connectionName);
@@ -92,7 +102,6 @@ bool Self::open(const QString &databaseFileName, const QString &connectionName)
         }
     }
     qCDebug(lcDatabase) << "Database was opened";
-    emit opened();
     return true;
 }
 
@@ -203,3 +212,13 @@ qsizetype Self::rowsChangedCount() const
 
     return 0;
 }
+
+quint64 Self::writeCount() const
+{
+    return m_writeCount;
+}
+
+void Self::incrementWriteCount()
+{
+    ++m_writeCount;
+}
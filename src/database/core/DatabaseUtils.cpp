@@ -37,12 +37,16 @@
 #include "FileUtils.h"
 #include "JsonUtils.h"
 #include "database/core/Database.h"
+#include "database/core/StatementProfiler.h"
 #include "AttachmentId.h"
 #include "OutgoingMessage.h"
 #include "IncomingMessage.h"
+#include "Metrics.h"
+#include "Tracer.h"
 #include "MessageContentJsonUtils.h"
 #include "MessageContentType.h"
 
+#include <QElapsedTimer>
 #include <QSqlError>
 #include <QSqlField>
 #include <QSqlQuery>
@@ -73,6 +77,21 @@ std::optional<QStringList> readQueryTexts(const QString &queryId)
     }
     return queries;
 }
+
+MetricHistogram *queryLatencyHistogram(const QString &queryId)
+{
+    return Metrics::instance()->histogram("database_query_microseconds", { { "query", queryId } });
+}
+
+//
+//  Return microseconds elapsed since the previous lap.
+//
+std::chrono::microseconds lapDuration(QElapsedTimer &timer)
+{
+    const auto duration = std::chrono::microseconds(timer.nsecsElapsed() / 1000);
+    timer.restart();
+    return duration;
+}
 } // namespace
 
 bool Self::isValidName(const QString &id)
@@ -83,22 +102,42 @@ bool Self::isValidName(const QString &id)
 
 bool Self::readExecQueries(Database *database, const QString &queryId)
 {
+    TraceSpan traceSpan("database", queryId);
+    MetricLatencyTimer latencyTimer(queryLatencyHistogram(queryId));
     const auto texts = readQueryTexts(queryId);
     if (!texts) {
         return false;
     }
+    auto profiler = StatementProfiler::instance();
+    const bool isProfiled = profiler->isEnabled();
+    QElapsedTimer profileTimer;
+    if (isProfiled) {
+        profileTimer.start();
+    }
+
     for (auto text : *texts) {
         auto query = database->createQuery();
         if (!query.exec(text)) {
             qCCritical(lcDatabase) << "Failed to run query:" << text;
             return false;
         }
+        if (!query.isSelect()) {
+            database->incrementWriteCount();
+        }
+    }
+
+    if (isProfiled) {
+        StatementProfiler::Sample sample;
+        sample.execDuration = lapDuration(profileTimer);
+        profiler->record(queryId, sample);
     }
     return true;
 }
 
 std::optional<QSqlQuery> Self::readExecQuery(Database *database, const QString &queryId, const BindValues &values)
 {
+    TraceSpan traceSpan("database", queryId);
+    MetricLatencyTimer latencyTimer(queryLatencyHistogram(queryId));
     auto maybeText = FileUtils::readTextFile(queryPath(queryId));
     if (!maybeText) {
         return std::nullopt;
@@ -112,12 +151,24 @@ std::optional<QSqlQuery> Self::readExecQuery(Database *database, const QString &
         }
     }
 
+    auto profiler = StatementProfiler::instance();
+    const bool isProfiled = profiler->isEnabled();
+    StatementProfiler::Sample sample;
+    QElapsedTimer profileTimer;
+    if (isProfiled) {
+        profileTimer.start();
+    }
+
     auto query = database->createQuery();
     if (!query.prepare(text)) {
         qCCritical(lcDatabase) << "Failed to prepare query:" << query.lastError().databaseText();
         return std::nullopt;
     }
 
+    if (isProfiled) {
+        sample.prepareDuration = lapDuration(profileTimer);
+    }
+
     for (auto &v : values) {
         if (hasListType(v)) {
             // bindValue was processed earlier
@@ -132,6 +183,26 @@ std::optional<QSqlQuery> Self::readExecQuery(Database *database, const QString &
         qCCritical(lcDatabase) << "Failed to exec query:" << query.lastError().databaseText();
         return std::nullopt;
     }
+    if (!query.isSelect()) {
+        database->incrementWriteCount();
+    }
+
+    if (isProfiled) {
+        sample.execDuration = lapDuration(profileTimer);
+        //
+        //  Fetch rows ahead of callers, so iteration is measured apart from processing of rows.
+        //  Fetched rows are cached by the query, so callers read them again from the first one.
+        //
+        if (query.isSelect() && !query.isForwardOnly()) {
+            sample.rowCount = 0;
+            while (query.next()) {
+                ++sample.rowCount;
+            }
+            query.seek(QSql::BeforeFirstRow);
+            sample.fetchDuration = lapDuration(profileTimer);
+        }
+        profiler->record(queryId, sample, values);
+    }
     return query;
 }
 
@@ -352,10 +423,22 @@ ModifiableCloudFileHandler Self::readCloudFile(const QSqlQuery &query)
     cloudFile->setLocalPath(localPath);
     cloudFile->setFingerprint(fingerprint);
     cloudFile->setSharedGroupId(CloudFsSharedGroupId(sharedGroupId));
+    if (isFolder) {
+        readCloudFolderListing(query, *cloudFile);
+    }
 
     return cloudFile;
 }
 
+void Self::readCloudFolderListing(const QSqlQuery &query, CloudFile &cloudFolder)
+{
+    // NULL means that folder was never listed
+    const auto listedUpdatedAt = query.value("cloudFileListedUpdatedAt").toULongLong();
+    const auto listedAt = query.value("cloudFileListedAt").toULongLong();
+    cloudFolder.setListedUpdatedAt(listedUpdatedAt ? QDateTime::fromTime_t(listedUpdatedAt) : QDateTime());
+    cloudFolder.setListedAt(listedAt ? QDateTime::fromTime_t(listedAt) : QDateTime());
+}
+
 DatabaseUtils::BindValues DatabaseUtils::createNewCloudFileBindings(const CloudFileHandler &cloudFile)
 {
     return { { ":id", QString(cloudFile->id()) },
@@ -416,6 +499,13 @@ DatabaseUtils::BindValues DatabaseUtils::createDownloadedCloudFileBindings(const
     return { { ":id", QString(cloudFile->id()) }, { ":fingerprint", fingerprint } };
 }
 
+DatabaseUtils::BindValues DatabaseUtils::createCloudFolderListingBindings(const CloudFileHandler &cloudFolder)
+{
+    return { { ":id", QString(cloudFolder->id()) },
+             { ":listedUpdatedAt", cloudFolder->listedUpdatedAt().toTime_t() },
+             { ":listedAt", cloudFolder->listedAt().toTime_t() } };
+}
+
 bool DatabaseUtils::hasListType(const BindValue &bindValue)
 {
     switch (bindValue.second.type()) {
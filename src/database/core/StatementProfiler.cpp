@@ -0,0 +1,229 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "database/core/StatementProfiler.h"
+
+#include <QLoggingCategory>
+#include <QSaveFile>
+
+#include <algorithm>
+
+Q_LOGGING_CATEGORY(lcStatementProfiler, "statement-profiler");
+
+using namespace vm;
+using Self = StatementProfiler;
+
+namespace {
+QString formatMilliseconds(quint64 microseconds)
+{
+    return QString::number(static_cast<double>(microseconds) / 1000.0, 'f', 3);
+}
+
+QString redactBindValue(const QVariant &value)
+{
+    if (value.isNull()) {
+        return QLatin1String("null");
+    }
+    switch (value.type()) {
+    case QVariant::String:
+        return QString("<string:%1>").arg(value.toString().size());
+    case QVariant::ByteArray:
+        return QString("<bytes:%1>").arg(value.toByteArray().size());
+    case QVariant::StringList:
+    case QVariant::List:
+        return QString("<list:%1>").arg(value.toList().size());
+    default:
+        return QString("<%1>").arg(QLatin1String(value.typeName()));
+    }
+}
+} // namespace
+
+Self *Self::instance()
+{
+    //
+    //  Never destroyed, so statements may be recorded during static destruction.
+    //
+    static auto *profiler = new StatementProfiler();
+    return profiler;
+}
+
+void Self::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Self::setSlowThreshold(std::chrono::milliseconds threshold)
+{
+    m_slowThresholdMilliseconds.store(threshold.count(), std::memory_order_relaxed);
+}
+
+std::chrono::milliseconds Self::slowThreshold() const
+{
+    return std::chrono::milliseconds(m_slowThresholdMilliseconds.load(std::memory_order_relaxed));
+}
+
+void Self::record(const QString &queryId, const Sample &sample, const BindValues &values)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    const auto totalDuration = sample.totalDuration();
+    const bool isSlow = totalDuration >= slowThreshold();
+    if (isSlow) {
+        qCWarning(lcStatementProfiler).noquote().nospace()
+                << "Slow query " << queryId << ": " << formatMilliseconds(totalDuration.count()) << " ms"
+                << " (prepare " << formatMilliseconds(sample.prepareDuration.count()) << ", exec "
+                << formatMilliseconds(sample.execDuration.count()) << ", fetch "
+                << formatMilliseconds(sample.fetchDuration.count()) << "), rows " << sample.rowCount << ", binds "
+                << redactBindValues(values);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto &stats = m_statements[queryId];
+    if (!stats) {
+        stats = std::make_unique<StatementStats>();
+    }
+    ++stats->count;
+    stats->slowCount += isSlow ? 1 : 0;
+    stats->prepareMicroseconds += sample.prepareDuration.count();
+    stats->execMicroseconds += sample.execDuration.count();
+    stats->fetchMicroseconds += sample.fetchDuration.count();
+    stats->rowCount += static_cast<quint64>(std::max<qint64>(0, sample.rowCount));
+    stats->totalHistogram.record(totalDuration.count());
+}
+
+void Self::setQueueWait(const QString &queueName, std::chrono::microseconds wait)
+{
+    QMutexLocker locker(&m_mutex);
+    auto &queue = m_queues[queueName];
+    if (!queue.gauge) {
+        const Metrics::Labels labels = { { "queue", queueName } };
+        queue.gauge = Metrics::instance()->gauge("database_queue_wait_microseconds", labels);
+        queue.maxGauge = Metrics::instance()->gauge("database_queue_wait_microseconds_max", labels);
+    }
+    queue.currentMicroseconds = std::max<qint64>(0, wait.count());
+    queue.maxMicroseconds = std::max(queue.maxMicroseconds, queue.currentMicroseconds);
+    queue.gauge->set(queue.currentMicroseconds);
+    queue.maxGauge->set(queue.maxMicroseconds);
+}
+
+QString Self::report() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    using StatementEntry = std::pair<QString, const StatementStats *>;
+    std::vector<StatementEntry> statements;
+    for (auto &[queryId, stats] : m_statements) {
+        statements.emplace_back(queryId, stats.get());
+    }
+    auto totalMicroseconds = [](const StatementStats *stats) {
+        return stats->prepareMicroseconds + stats->execMicroseconds + stats->fetchMicroseconds;
+    };
+    std::sort(statements.begin(), statements.end(), [&totalMicroseconds](auto &lhs, auto &rhs) {
+        return totalMicroseconds(lhs.second) > totalMicroseconds(rhs.second);
+    });
+
+    QString text;
+    text += QString("Statements, slow threshold %1 ms%2\n")
+                    .arg(slowThreshold().count())
+                    .arg(isEnabled() ? QString() : QLatin1String(", profiling is disabled"));
+    text += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+                    .arg(QLatin1String("query"), -40)
+                    .arg(QLatin1String("count"), 8)
+                    .arg(QLatin1String("slow"), 6)
+                    .arg(QLatin1String("total ms"), 12)
+                    .arg(QLatin1String("p99 ms"), 10)
+                    .arg(QLatin1String("prepare ms"), 12)
+                    .arg(QLatin1String("exec ms"), 12)
+                    .arg(QLatin1String("fetch ms"), 12)
+                    .arg(QLatin1String("rows"), 10);
+    for (auto &[queryId, stats] : statements) {
+        const auto snapshot = stats->totalHistogram.snapshot();
+        text += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+                        .arg(queryId, -40)
+                        .arg(stats->count, 8)
+                        .arg(stats->slowCount, 6)
+                        .arg(formatMilliseconds(totalMicroseconds(stats)), 12)
+                        .arg(formatMilliseconds(snapshot.valueAtQuantile(0.99)), 10)
+                        .arg(formatMilliseconds(stats->prepareMicroseconds), 12)
+                        .arg(formatMilliseconds(stats->execMicroseconds), 12)
+                        .arg(formatMilliseconds(stats->fetchMicroseconds), 12)
+                        .arg(stats->rowCount, 10);
+    }
+
+    text += QLatin1String("\nQueues\n");
+    text += QString("%1 %2 %3\n")
+                    .arg(QLatin1String("queue"), -40)
+                    .arg(QLatin1String("wait ms"), 12)
+                    .arg(QLatin1String("max ms"), 12);
+    for (auto &[queueName, queue] : m_queues) {
+        text += QString("%1 %2 %3\n")
+                        .arg(queueName, -40)
+                        .arg(formatMilliseconds(queue.currentMicroseconds), 12)
+                        .arg(formatMilliseconds(queue.maxMicroseconds), 12);
+    }
+    return text;
+}
+
+bool Self::writeReport(const QString &filePath) const
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qCWarning(lcStatementProfiler) << "Can not open statements report file:" << filePath;
+        return false;
+    }
+
+    file.write(report().toUtf8());
+    if (!file.commit()) {
+        qCWarning(lcStatementProfiler) << "Can not write statements report file:" << filePath;
+        return false;
+    }
+    return true;
+}
+
+void Self::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_statements.clear();
+}
+
+QString Self::redactBindValues(const BindValues &values)
+{
+    QStringList binds;
+    for (auto &[name, value] : values) {
+        binds << QString("%1=%2").arg(name, redactBindValue(value));
+    }
+    return binds.join(QLatin1String(", "));
+}
@@ -0,0 +1,500 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "EncodingUtils.h"
+
+#include <QLoggingCategory>
+
+#include <array>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#    define VM_ENCODING_UTILS_X86 1
+#    include <immintrin.h>
+#endif
+
+using namespace vm;
+using Self = EncodingUtils;
+
+Q_LOGGING_CATEGORY(lcEncodingUtils, "encoding-utils");
+
+namespace {
+constexpr char kBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char kHexAlphabet[] = "0123456789abcdef";
+constexpr uint8_t kInvalidBase64Value = 0xFF;
+
+constexpr auto kBase64DecodeTable = []() {
+    std::array<uint8_t, 256> table {};
+    for (auto &value : table) {
+        value = kInvalidBase64Value;
+    }
+    for (uint8_t index = 0; index < 64; ++index) {
+        table[static_cast<uint8_t>(kBase64Alphabet[index])] = index;
+    }
+    return table;
+}();
+
+// --------------------------------------------------------------------------
+//  Scalar implementation.
+//  Processes the whole input and handles tails left by vectorized implementations.
+// --------------------------------------------------------------------------
+void base64EncodeScalar(const uint8_t *src, size_t srcLen, char *dst)
+{
+    size_t i = 0;
+    for (; i + 3 <= srcLen; i += 3) {
+        const uint32_t triple = (uint32_t(src[i]) << 16) | (uint32_t(src[i + 1]) << 8) | uint32_t(src[i + 2]);
+        *dst++ = kBase64Alphabet[(triple >> 18) & 0x3F];
+        *dst++ = kBase64Alphabet[(triple >> 12) & 0x3F];
+        *dst++ = kBase64Alphabet[(triple >> 6) & 0x3F];
+        *dst++ = kBase64Alphabet[triple & 0x3F];
+    }
+
+    const auto tailLen = srcLen - i;
+    if (tailLen == 1) {
+        const uint32_t triple = uint32_t(src[i]) << 16;
+        *dst++ = kBase64Alphabet[(triple >> 18) & 0x3F];
+        *dst++ = kBase64Alphabet[(triple >> 12) & 0x3F];
+        *dst++ = '=';
+        *dst++ = '=';
+    } else if (tailLen == 2) {
+        const uint32_t triple = (uint32_t(src[i]) << 16) | (uint32_t(src[i + 1]) << 8);
+        *dst++ = kBase64Alphabet[(triple >> 18) & 0x3F];
+        *dst++ = kBase64Alphabet[(triple >> 12) & 0x3F];
+        *dst++ = kBase64Alphabet[(triple >> 6) & 0x3F];
+        *dst++ = '=';
+    }
+}
+
+//
+//  Decode Base64 without padding, the output buffer must fit the decoded size exactly.
+//
+bool base64DecodeScalar(const char *src, size_t srcLen, uint8_t *dst)
+{
+    size_t i = 0;
+    for (; i + 4 <= srcLen; i += 4) {
+        const auto a = kBase64DecodeTable[static_cast<uint8_t>(src[i])];
+        const auto b = kBase64DecodeTable[static_cast<uint8_t>(src[i + 1])];
+        const auto c = kBase64DecodeTable[static_cast<uint8_t>(src[i + 2])];
+        const auto d = kBase64DecodeTable[static_cast<uint8_t>(src[i + 3])];
+        if ((a | b | c | d) & 0x80) {
+            return false;
+        }
+        const uint32_t triple = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | uint32_t(d);
+        *dst++ = static_cast<uint8_t>(triple >> 16);
+        *dst++ = static_cast<uint8_t>(triple >> 8);
+        *dst++ = static_cast<uint8_t>(triple);
+    }
+
+    const auto tailLen = srcLen - i;
+    if (tailLen == 0) {
+        return true;
+    }
+
+    uint32_t triple = 0;
+    for (size_t j = 0; j < tailLen; ++j) {
+        const auto value = kBase64DecodeTable[static_cast<uint8_t>(src[i + j])];
+        if (value & 0x80) {
+            return false;
+        }
+        triple |= uint32_t(value) << (18 - 6 * j);
+    }
+
+    if (tailLen >= 2) {
+        *dst++ = static_cast<uint8_t>(triple >> 16);
+    }
+    if (tailLen == 3) {
+        *dst++ = static_cast<uint8_t>(triple >> 8);
+    }
+    return tailLen != 1;
+}
+
+void hexEncodeScalar(const uint8_t *src, size_t srcLen, char *dst)
+{
+    for (size_t i = 0; i < srcLen; ++i) {
+        *dst++ = kHexAlphabet[src[i] >> 4];
+        *dst++ = kHexAlphabet[src[i] & 0x0F];
+    }
+}
+
+#if VM_ENCODING_UTILS_X86
+// --------------------------------------------------------------------------
+//  SSE4.1 implementation.
+//  Based on "Faster Base64 Encoding and Decoding Using AVX2 Instructions" by W. Mula and D. Lemire.
+//  Functions return the number of processed input bytes.
+// --------------------------------------------------------------------------
+__attribute__((target("ssse3,sse4.1"))) inline __m128i base64EncodeLookupSse(__m128i indices)
+{
+    const __m128i shiftLut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    result = _mm_shuffle_epi8(shiftLut, result);
+    return _mm_add_epi8(result, indices);
+}
+
+__attribute__((target("ssse3,sse4.1"))) size_t base64EncodeSse(const uint8_t *src, size_t srcLen, char *dst)
+{
+    const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+
+    size_t i = 0;
+    for (; i + 16 <= srcLen; i += 12, dst += 16) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        in = _mm_shuffle_epi8(in, shuffle);
+
+        const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t1, t3);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), base64EncodeLookupSse(indices));
+    }
+    return i;
+}
+
+//
+//  Return std::nullopt if invalid character was found.
+//  Every iteration writes 16 bytes where 12 are valid, so 6 characters are kept for the scalar tail.
+//
+__attribute__((target("ssse3,sse4.1"))) std::optional<size_t> base64DecodeSse(const char *src, size_t srcLen,
+                                                                               uint8_t *dst)
+{
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B,
+                                        0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                        0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    size_t i = 0;
+    for (; i + 16 + 6 <= srcLen; i += 16, dst += 12) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+
+        const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+        const __m128i loNibbles = _mm_and_si128(in, mask2F);
+        const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        if (!_mm_testz_si128(lo, hi)) {
+            return std::nullopt;
+        }
+
+        const __m128i eq2F = _mm_cmpeq_epi8(in, mask2F);
+        const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+        in = _mm_add_epi8(in, roll);
+
+        const __m128i merged = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+        const __m128i out = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_shuffle_epi8(out, pack));
+    }
+    return i;
+}
+
+__attribute__((target("ssse3,sse4.1"))) size_t hexEncodeSse(const uint8_t *src, size_t srcLen, char *dst)
+{
+    const __m128i alphabet = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kHexAlphabet));
+    const __m128i mask0F = _mm_set1_epi8(0x0F);
+
+    size_t i = 0;
+    for (; i + 16 <= srcLen; i += 16, dst += 32) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i hi = _mm_shuffle_epi8(alphabet, _mm_and_si128(_mm_srli_epi16(in, 4), mask0F));
+        const __m128i lo = _mm_shuffle_epi8(alphabet, _mm_and_si128(in, mask0F));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+// --------------------------------------------------------------------------
+//  AVX2 implementation, the same algorithms within two 128-bit lanes.
+// --------------------------------------------------------------------------
+__attribute__((target("avx2"))) size_t base64EncodeAvx2(const uint8_t *src, size_t srcLen, char *dst)
+{
+    const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1, 10, 11, 9, 10, 7, 8, 6,
+                                            7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i shiftLut = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                                              'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    size_t i = 0;
+    for (; i + 28 <= srcLen; i += 24, dst += 32) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 12));
+        __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        in = _mm256_shuffle_epi8(in, shuffle);
+
+        const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        result = _mm256_shuffle_epi8(shiftLut, result);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_add_epi8(result, indices));
+    }
+    return i;
+}
+
+//
+//  Return std::nullopt if invalid character was found.
+//  Every iteration writes 32 bytes where 24 are valid, so 11 characters are kept for the tail.
+//
+__attribute__((target("avx2"))) std::optional<size_t> base64DecodeAvx2(const char *src, size_t srcLen, uint8_t *dst)
+{
+    const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A,
+                                           0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4,
+                                             -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4,
+                                          10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+    size_t i = 0;
+    for (; i + 32 + 11 <= srcLen; i += 32, dst += 24) {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+
+        const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask2F);
+        const __m256i loNibbles = _mm256_and_si256(in, mask2F);
+        const __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+        const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        if (!_mm256_testz_si256(lo, hi)) {
+            return std::nullopt;
+        }
+
+        const __m256i eq2F = _mm256_cmpeq_epi8(in, mask2F);
+        const __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles));
+        in = _mm256_add_epi8(in, roll);
+
+        const __m256i merged = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+        __m256i out = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        out = _mm256_shuffle_epi8(out, pack);
+        out = _mm256_permutevar8x32_epi32(out, permute);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), out);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t hexEncodeAvx2(const uint8_t *src, size_t srcLen, char *dst)
+{
+    const __m256i alphabet =
+            _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(kHexAlphabet)));
+    const __m256i mask0F = _mm256_set1_epi8(0x0F);
+
+    size_t i = 0;
+    for (; i + 32 <= srcLen; i += 32, dst += 64) {
+        const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        const __m256i hi = _mm256_shuffle_epi8(alphabet, _mm256_and_si256(_mm256_srli_epi16(in, 4), mask0F));
+        const __m256i lo = _mm256_shuffle_epi8(alphabet, _mm256_and_si256(in, mask0F));
+        const __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        const __m256i second = _mm256_unpackhi_epi8(hi, lo);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return i;
+}
+#endif // VM_ENCODING_UTILS_X86
+
+enum class SimdLevel { None, Sse41, Avx2 };
+
+SimdLevel simdLevel()
+{
+    static const SimdLevel level = []() {
+#if VM_ENCODING_UTILS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::Avx2;
+        }
+        if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1")) {
+            return SimdLevel::Sse41;
+        }
+#endif
+        return SimdLevel::None;
+    }();
+    return level;
+}
+
+size_t base64EncodedSize(size_t srcLen)
+{
+    return 4 * ((srcLen + 2) / 3);
+}
+
+size_t base64DecodedSize(size_t srcLen)
+{
+    return 3 * (srcLen / 4) + (srcLen % 4 == 0 ? 0 : srcLen % 4 - 1);
+}
+
+void base64Encode(const uint8_t *src, size_t srcLen, char *dst)
+{
+    size_t processed = 0;
+#if VM_ENCODING_UTILS_X86
+    switch (simdLevel()) {
+    case SimdLevel::Avx2:
+        processed = base64EncodeAvx2(src, srcLen, dst);
+        break;
+    case SimdLevel::Sse41:
+        processed = base64EncodeSse(src, srcLen, dst);
+        break;
+    case SimdLevel::None:
+        break;
+    }
+#endif
+    base64EncodeScalar(src + processed, srcLen - processed, dst + 4 * (processed / 3));
+}
+
+bool base64Decode(const char *src, size_t srcLen, uint8_t *dst)
+{
+    std::optional<size_t> processed = 0;
+#if VM_ENCODING_UTILS_X86
+    switch (simdLevel()) {
+    case SimdLevel::Avx2:
+        processed = base64DecodeAvx2(src, srcLen, dst);
+        break;
+    case SimdLevel::Sse41:
+        processed = base64DecodeSse(src, srcLen, dst);
+        break;
+    case SimdLevel::None:
+        break;
+    }
+#endif
+    if (!processed) {
+        return false;
+    }
+    return base64DecodeScalar(src + *processed, srcLen - *processed, dst + 3 * (*processed / 4));
+}
+
+void hexEncode(const uint8_t *src, size_t srcLen, char *dst)
+{
+    size_t processed = 0;
+#if VM_ENCODING_UTILS_X86
+    switch (simdLevel()) {
+    case SimdLevel::Avx2:
+        processed = hexEncodeAvx2(src, srcLen, dst);
+        break;
+    case SimdLevel::Sse41:
+        processed = hexEncodeSse(src, srcLen, dst);
+        break;
+    case SimdLevel::None:
+        break;
+    }
+#endif
+    hexEncodeScalar(src + processed, srcLen - processed, dst + 2 * processed);
+}
+} // namespace
+
+QByteArray Self::toBase64(const QByteArray &data)
+{
+    QByteArray base64(static_cast<int>(base64EncodedSize(data.size())), Qt::Uninitialized);
+    base64Encode(reinterpret_cast<const uint8_t *>(data.constData()), data.size(), base64.data());
+    return base64;
+}
+
+std::optional<QByteArray> Self::fromBase64(const QByteArray &base64, Base64Mode mode)
+{
+    QByteArray data(base64DecodedMaxSize(base64.size()), Qt::Uninitialized);
+    if (auto size = fromBase64(base64.constData(), base64.size(), data.data(), data.size())) {
+        data.truncate(*size);
+        return data;
+    }
+
+    if (mode == Base64Mode::Strict) {
+        return std::nullopt;
+    }
+
+    //
+    //  Other clients may wrap lines or leave garbage that Qt decoder skips, so keep accepting it.
+    //
+    qCWarning(lcEncodingUtils) << "Base64 input of size" << base64.size() << "is not canonical, decoded leniently";
+    return QByteArray::fromBase64(base64);
+}
+
+std::optional<QByteArray> Self::fromBase64(const QString &base64, Base64Mode mode)
+{
+    return fromBase64(base64.toLatin1(), mode);
+}
+
+std::optional<int> Self::fromBase64(const char *base64, int base64Size, char *buffer, int bufferSize)
+{
+    size_t srcLen = base64Size > 0 ? static_cast<size_t>(base64Size) : 0;
+    if (srcLen > 0 && base64[srcLen - 1] == '=') {
+        if (srcLen % 4 != 0) {
+            return std::nullopt;
+        }
+        --srcLen;
+        if (base64[srcLen - 1] == '=') {
+            --srcLen;
+        }
+    }
+
+    if (srcLen % 4 == 1) {
+        return std::nullopt;
+    }
+
+    const auto decodedSize = base64DecodedSize(srcLen);
+    if (decodedSize > static_cast<size_t>(qMax(bufferSize, 0))) {
+        return std::nullopt;
+    }
+    if (!base64Decode(base64, srcLen, reinterpret_cast<uint8_t *>(buffer))) {
+        return std::nullopt;
+    }
+    return static_cast<int>(decodedSize);
+}
+
+int Self::base64DecodedMaxSize(int base64Size)
+{
+    return base64Size > 0 ? static_cast<int>(base64DecodedSize(static_cast<size_t>(base64Size))) : 0;
+}
+
+QByteArray Self::toHex(const QByteArray &data)
+{
+    QByteArray hex(2 * data.size(), Qt::Uninitialized);
+    hexEncode(reinterpret_cast<const uint8_t *>(data.constData()), data.size(), hex.data());
+    return hex;
+}
@@ -34,6 +34,7 @@
 
 #include "FileUtils.h"
 
+#include "EncodingUtils.h"
 #include "UidUtils.h"
 #include "PlatformFs.h"
 
@@ -61,7 +62,7 @@ QString Self::calculateFingerprint(const QString &path)
     }
     QCryptographicHash hash(QCryptographicHash::Sha256);
     hash.addData(&file);
-    const QString fingerpint = hash.result().toHex().left(8);
+    const QString fingerpint = EncodingUtils::toHex(hash.result()).left(8);
     qCDebug(lcFileUtils) << "File fingerprint:" << path << "=>" << fingerpint;
     return fingerpint;
 }
@@ -0,0 +1,237 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "Metrics.h"
+
+#include <QReadLocker>
+#include <QStringList>
+#include <QTextStream>
+#include <QWriteLocker>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace vm;
+using Self = Metrics;
+
+namespace {
+constexpr std::array<double, 3> kExportedQuantiles = { 0.5, 0.9, 0.99 };
+} // namespace
+
+int MetricHistogram::bucketIndex(quint64 value) noexcept
+{
+    if (value < kSubBucketCount) {
+        return static_cast<int>(value);
+    }
+
+    //
+    //  Value within [2^e, 2^(e+1)) is mapped to one of sub-buckets by its top bits after the leading one.
+    //
+    const int exponent = 63 - static_cast<int>(qCountLeadingZeroBits(value));
+    const int shift = exponent - kSubBucketBits;
+    const int subBucket = static_cast<int>((value >> shift) & (kSubBucketCount - 1));
+    return kSubBucketCount + shift * kSubBucketCount + subBucket;
+}
+
+quint64 MetricHistogram::bucketUpperBound(int index) noexcept
+{
+    if (index < kSubBucketCount) {
+        return static_cast<quint64>(index);
+    }
+
+    const int shift = (index - kSubBucketCount) / kSubBucketCount;
+    const quint64 subBucket = (index - kSubBucketCount) % kSubBucketCount;
+    const quint64 lowerBound = (kSubBucketCount + subBucket) << shift;
+    return lowerBound + ((quint64(1) << shift) - 1);
+}
+
+void MetricHistogram::record(quint64 value) noexcept
+{
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    auto max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+MetricHistogram::Snapshot MetricHistogram::snapshot() const
+{
+    //
+    //  Fields are read independently, so a snapshot taken during recording may be slightly inconsistent.
+    //
+    Snapshot snapshot;
+    for (int index = 0; index < kBucketCount; ++index) {
+        snapshot.buckets[index] = m_buckets[index].load(std::memory_order_relaxed);
+    }
+    snapshot.count = m_count.load(std::memory_order_relaxed);
+    snapshot.sum = m_sum.load(std::memory_order_relaxed);
+    snapshot.max = m_max.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+quint64 MetricHistogram::Snapshot::valueAtQuantile(double quantile) const
+{
+    quint64 total = 0;
+    for (auto bucketCount : buckets) {
+        total += bucketCount;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    const auto rank = std::max<quint64>(1, static_cast<quint64>(std::ceil(quantile * total)));
+    quint64 accumulated = 0;
+    for (int index = 0; index < kBucketCount; ++index) {
+        accumulated += buckets[index];
+        if (accumulated >= rank) {
+            return std::min(bucketUpperBound(index), max);
+        }
+    }
+    return max;
+}
+
+MetricLatencyTimer::MetricLatencyTimer(MetricHistogram *histogram) : m_histogram(histogram)
+{
+    m_timer.start();
+}
+
+MetricLatencyTimer::~MetricLatencyTimer()
+{
+    m_histogram->record(static_cast<quint64>(m_timer.nsecsElapsed() / 1000));
+}
+
+Self *Self::instance()
+{
+    //
+    //  Never destroyed, so metrics may be updated during static destruction.
+    //
+    static auto *metrics = new Metrics();
+    return metrics;
+}
+
+MetricCounter *Self::counter(const QString &name, const Labels &labels)
+{
+    return findOrCreate(m_counters, name, labels);
+}
+
+MetricGauge *Self::gauge(const QString &name, const Labels &labels)
+{
+    return findOrCreate(m_gauges, name, labels);
+}
+
+MetricHistogram *Self::histogram(const QString &name, const Labels &labels)
+{
+    return findOrCreate(m_histograms, name, labels);
+}
+
+template<typename Metric>
+Metric *Self::findOrCreate(Families<Metric> &families, const QString &name, const Labels &labels)
+{
+    const auto formattedLabels = formatLabels(labels);
+    {
+        QReadLocker locker(&m_lock);
+        auto familyIt = families.find(name);
+        if (familyIt != families.end()) {
+            auto metricIt = familyIt->second.find(formattedLabels);
+            if (metricIt != familyIt->second.end()) {
+                return metricIt->second.get();
+            }
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    auto &metric = families[name][formattedLabels];
+    if (!metric) {
+        metric = std::make_unique<Metric>();
+    }
+    return metric.get();
+}
+
+QString Self::formatLabels(const Labels &labels)
+{
+    QStringList pairs;
+    for (auto it = labels.cbegin(); it != labels.cend(); ++it) {
+        auto value = it.value();
+        value.replace(QLatin1Char('\\'), QLatin1String("\\\\")).replace(QLatin1Char('"'), QLatin1String("\\\""));
+        pairs << QString("%1=\"%2\"").arg(it.key(), value);
+    }
+    return pairs.join(QLatin1Char(','));
+}
+
+QByteArray Self::toPrometheusText() const
+{
+    auto series = [](const QString &name, const QString &labels) {
+        return labels.isEmpty() ? name : QString("%1{%2}").arg(name, labels);
+    };
+
+    QString text;
+    QTextStream stream(&text);
+
+    QReadLocker locker(&m_lock);
+    for (const auto &[name, family] : m_counters) {
+        stream << "# TYPE " << name << " counter\n";
+        for (const auto &[labels, counter] : family) {
+            stream << series(name, labels) << ' ' << counter->value() << '\n';
+        }
+    }
+
+    for (const auto &[name, family] : m_gauges) {
+        stream << "# TYPE " << name << " gauge\n";
+        for (const auto &[labels, gauge] : family) {
+            stream << series(name, labels) << ' ' << gauge->value() << '\n';
+        }
+    }
+
+    for (const auto &[name, family] : m_histograms) {
+        stream << "# TYPE " << name << " summary\n";
+        for (const auto &[labels, histogram] : family) {
+            const auto snapshot = histogram->snapshot();
+            const auto separator = labels.isEmpty() ? QString() : QString(QLatin1Char(','));
+            for (auto quantile : kExportedQuantiles) {
+                stream << name << '{' << labels << separator << "quantile=\"" << quantile << "\"} "
+                       << snapshot.valueAtQuantile(quantile) << '\n';
+            }
+            stream << name << '{' << labels << separator << "quantile=\"1\"} " << snapshot.max << '\n';
+            stream << series(name + QLatin1String("_sum"), labels) << ' ' << snapshot.sum << '\n';
+            stream << series(name + QLatin1String("_count"), labels) << ' ' << snapshot.count << '\n';
+        }
+    }
+    locker.unlock();
+
+    stream.flush();
+    return text.toUtf8();
+}
@@ -0,0 +1,200 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "StartupTimeline.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QThread>
+
+Q_LOGGING_CATEGORY(lcStartupTimeline, "startup-timeline");
+
+using namespace vm;
+using Self = StartupTimeline;
+
+Self::StartupTimeline()
+{
+    m_timer.start();
+}
+
+Self *Self::instance()
+{
+    //
+    //  Never destroyed, so phases may be reported during static destruction.
+    //
+    static auto *timeline = new StartupTimeline();
+    return timeline;
+}
+
+qint64 Self::elapsed() const
+{
+    return m_timer.elapsed();
+}
+
+void Self::beginPhase(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_isFinished) {
+        return;
+    }
+    m_phases.push_back({ name, currentThreadName(), elapsed(), -1 });
+}
+
+void Self::endPhase(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_isFinished) {
+        return;
+    }
+    //
+    //  Phase with the same name may run again (e.g. sign-in after an error), so the latest one is ended.
+    //
+    for (auto it = m_phases.rbegin(); it != m_phases.rend(); ++it) {
+        if (it->name == name && it->endedAt < 0) {
+            it->endedAt = elapsed();
+            return;
+        }
+    }
+    qCWarning(lcStartupTimeline) << "Phase was not started:" << name;
+}
+
+void Self::mark(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_isFinished) {
+        return;
+    }
+    m_marks.push_back({ name, currentThreadName(), elapsed() });
+}
+
+void Self::finish(const QString &milestone)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_isFinished) {
+        return;
+    }
+    m_marks.push_back({ milestone, currentThreadName(), elapsed() });
+    m_isFinished = true;
+    qCInfo(lcStartupTimeline).noquote() << "Startup finished by" << milestone << "in" << m_marks.back().at << "ms";
+}
+
+bool Self::isFinished() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isFinished;
+}
+
+qint64 Self::milestoneTime(const QString &name) const
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_marks.rbegin(); it != m_marks.rend(); ++it) {
+        if (it->name == name) {
+            return it->at;
+        }
+    }
+    return -1;
+}
+
+QJsonObject Self::toJson() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QJsonArray phases;
+    for (auto &phase : m_phases) {
+        QJsonObject phaseObject;
+        phaseObject.insert(QLatin1String("name"), phase.name);
+        phaseObject.insert(QLatin1String("thread"), phase.threadName);
+        phaseObject.insert(QLatin1String("beganAtMs"), phase.beganAt);
+        if (phase.endedAt >= 0) {
+            phaseObject.insert(QLatin1String("endedAtMs"), phase.endedAt);
+            phaseObject.insert(QLatin1String("durationMs"), phase.endedAt - phase.beganAt);
+        }
+        phases.append(phaseObject);
+    }
+
+    QJsonArray marks;
+    for (auto &mark : m_marks) {
+        QJsonObject markObject;
+        markObject.insert(QLatin1String("name"), mark.name);
+        markObject.insert(QLatin1String("thread"), mark.threadName);
+        markObject.insert(QLatin1String("atMs"), mark.at);
+        marks.append(markObject);
+    }
+
+    QJsonObject timeline;
+    timeline.insert(QLatin1String("phases"), phases);
+    timeline.insert(QLatin1String("marks"), marks);
+    timeline.insert(QLatin1String("isFinished"), m_isFinished);
+    return timeline;
+}
+
+bool Self::writeReport(const QString &filePath, const QJsonObject &extras) const
+{
+    auto report = toJson();
+    for (auto it = extras.constBegin(); it != extras.constEnd(); ++it) {
+        report.insert(it.key(), it.value());
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcStartupTimeline) << "Can not open startup report file:" << filePath;
+        return false;
+    }
+
+    file.write(QJsonDocument(report).toJson());
+    if (!file.commit()) {
+        qCWarning(lcStartupTimeline) << "Can not write startup report file:" << filePath;
+        return false;
+    }
+    return true;
+}
+
+QString Self::currentThreadName()
+{
+    const auto thread = QThread::currentThread();
+    const auto name = thread->objectName();
+    return name.isEmpty() ? QString("Thread-%1").arg(reinterpret_cast<quintptr>(thread), 0, 16) : name;
+}
+
+StartupPhase::StartupPhase(QString name) : m_name(std::move(name)), m_traceSpan("startup", m_name)
+{
+    StartupTimeline::instance()->beginPhase(m_name);
+}
+
+StartupPhase::~StartupPhase()
+{
+    StartupTimeline::instance()->endPhase(m_name);
+}
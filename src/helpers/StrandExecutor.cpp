@@ -0,0 +1,149 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "StrandExecutor.h"
+
+#include <QLoggingCategory>
+#include <QRunnable>
+
+#include <exception>
+
+using namespace vm;
+using Self = StrandExecutor;
+
+Q_LOGGING_CATEGORY(lcStrandExecutor, "strand-executor");
+
+namespace {
+class FunctionRunnable : public QRunnable
+{
+public:
+    explicit FunctionRunnable(std::function<void()> function) : m_function(std::move(function))
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override { m_function(); }
+
+private:
+    std::function<void()> m_function;
+};
+} // namespace
+
+Self::StrandExecutor(int maxThreadCount, int maxPendingTasks) : m_maxPendingTasks(maxPendingTasks)
+{
+    m_pool.setMaxThreadCount(maxThreadCount);
+}
+
+Self::~StrandExecutor() noexcept
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_pendingTaskCount > 0) {
+            m_pendingTasksDecreased.wait(&m_mutex);
+        }
+    }
+
+    //
+    //  Let the last runnable leave runNext() before members are destroyed.
+    //
+    m_pool.waitForDone();
+}
+
+void Self::post(const QString &strandKey, Task task)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto &strand = m_strands[strandKey];
+    strand.push_back(std::move(task));
+    ++m_pendingTaskCount;
+
+    //
+    //  Strand is idle, so start it. Otherwise the task will be run after the previous ones.
+    //
+    if (strand.size() == 1) {
+        schedule(strandKey);
+    }
+}
+
+int Self::pendingTaskCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pendingTaskCount;
+}
+
+bool Self::isSaturated() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pendingTaskCount >= m_maxPendingTasks;
+}
+
+void Self::schedule(const QString &strandKey)
+{
+    m_pool.start(new FunctionRunnable([this, strandKey]() { runNext(strandKey); }));
+}
+
+void Self::runNext(const QString &strandKey)
+{
+    Task task;
+    {
+        QMutexLocker locker(&m_mutex);
+        task = m_strands[strandKey].front();
+    }
+
+    //
+    //  A throwing task must not stall its strand, so the queue is advanced anyway.
+    //
+    try {
+        task();
+    } catch (const std::exception &exception) {
+        qCCritical(lcStrandExecutor) << "Task of strand" << strandKey << "failed with exception:" << exception.what();
+    } catch (...) {
+        qCCritical(lcStrandExecutor) << "Task of strand" << strandKey << "failed with unknown exception";
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto strandIt = m_strands.find(strandKey);
+    strandIt->second.pop_front();
+    --m_pendingTaskCount;
+    m_pendingTasksDecreased.wakeAll();
+
+    //
+    //  Give other strands a chance to run before the next task of this strand.
+    //
+    if (strandIt->second.empty()) {
+        m_strands.erase(strandIt);
+    } else {
+        schedule(strandKey);
+    }
+}
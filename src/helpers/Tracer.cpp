@@ -0,0 +1,274 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "Tracer.h"
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QThread>
+
+#include <algorithm>
+
+Q_LOGGING_CATEGORY(lcTracer, "tracer");
+
+using namespace vm;
+using Self = Tracer;
+
+namespace {
+//
+//  Finished threads keep their events until the limit of retired buffers is reached.
+//
+constexpr int kMaxRetiredBuffers = 16;
+} // namespace
+
+namespace vm {
+//
+//  Detach thread buffer from the tracer when thread finishes.
+//
+struct ThreadBufferHolder
+{
+    Tracer::ThreadBuffer *buffer = nullptr;
+
+    ~ThreadBufferHolder()
+    {
+        if (buffer) {
+            Tracer::instance()->retireThreadBuffer(buffer);
+        }
+    }
+};
+} // namespace vm
+
+Self::Tracer()
+{
+    m_clock.start();
+}
+
+Self *Self::instance()
+{
+    //
+    //  Never destroyed, so threads that finish after static destruction can retire buffers.
+    //
+    static auto *tracer = new Tracer();
+    return tracer;
+}
+
+void Self::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+    qCDebug(lcTracer) << "Tracing enabled:" << enabled;
+}
+
+qint64 Self::now() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+void Self::addSpan(const char *category, const QString &name, qint64 startedAt, qint64 duration, Args args)
+{
+    if (isEnabled()) {
+        record({ 'X', category, name, startedAt, duration, 0, std::move(args) });
+    }
+}
+
+void Self::addInstant(const char *category, const QString &name, Args args)
+{
+    if (isEnabled()) {
+        record({ 'i', category, name, now(), 0, 0, std::move(args) });
+    }
+}
+
+void Self::beginAsyncSpan(const char *category, const QString &name, quint64 id, Args args)
+{
+    if (isEnabled()) {
+        record({ 'b', category, name, now(), 0, id, std::move(args) });
+    }
+}
+
+void Self::endAsyncSpan(const char *category, const QString &name, quint64 id, Args args)
+{
+    if (isEnabled()) {
+        record({ 'e', category, name, now(), 0, id, std::move(args) });
+    }
+}
+
+bool Self::exportChromeTrace(const QString &filePath)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcTracer) << "Can not open trace file:" << filePath;
+        return false;
+    }
+
+    const auto pid = QCoreApplication::applicationPid();
+    bool isFirstEvent = true;
+    auto writeEvent = [&file, &isFirstEvent](const QJsonObject &event) {
+        file.write(isFirstEvent ? "\n" : ",\n");
+        file.write(QJsonDocument(event).toJson(QJsonDocument::Compact));
+        isFirstEvent = false;
+    };
+
+    file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    QMutexLocker buffersLocker(&m_buffersMutex);
+    int eventCount = 0;
+    for (const auto &buffer : m_buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+
+        writeEvent({ { "ph", "M" },
+                     { "name", "thread_name" },
+                     { "pid", pid },
+                     { "tid", buffer->threadId },
+                     { "args", QJsonObject { { "name", buffer->threadName } } } });
+
+        for (const auto &event : buffer->events) {
+            QJsonObject jsonEvent { { "ph", QString(QChar::fromLatin1(event.phase)) },
+                                    { "cat", QLatin1String(event.category) },
+                                    { "name", event.name },
+                                    { "pid", pid },
+                                    { "tid", buffer->threadId },
+                                    { "ts", event.timestamp } };
+
+            if (event.phase == 'X') {
+                jsonEvent.insert("dur", event.duration);
+            } else if (event.phase == 'i') {
+                jsonEvent.insert("s", "t");
+            } else {
+                jsonEvent.insert("id", QString::number(event.id, 16).prepend(QLatin1String("0x")));
+            }
+
+            if (!event.args.isEmpty()) {
+                jsonEvent.insert("args", QJsonObject::fromVariantMap(event.args));
+            }
+
+            writeEvent(jsonEvent);
+            ++eventCount;
+        }
+    }
+    buffersLocker.unlock();
+
+    file.write("\n]}\n");
+
+    if (!file.commit()) {
+        qCWarning(lcTracer) << "Can not write trace file:" << filePath;
+        return false;
+    }
+
+    qCInfo(lcTracer) << "Exported" << eventCount << "trace events to:" << filePath;
+    return true;
+}
+
+void Self::clear()
+{
+    QMutexLocker buffersLocker(&m_buffersMutex);
+    for (const auto &buffer : m_buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->events.clear();
+    }
+}
+
+Self::ThreadBuffer *Self::currentThreadBuffer()
+{
+    thread_local ThreadBufferHolder holder;
+    if (holder.buffer) {
+        return holder.buffer;
+    }
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    auto thread = QThread::currentThread();
+    buffer->threadName = thread->objectName();
+    if (buffer->threadName.isEmpty()) {
+        buffer->threadName = QString::fromLatin1(thread->metaObject()->className());
+    }
+
+    QMutexLocker locker(&m_buffersMutex);
+    buffer->threadId = m_nextThreadId++;
+    holder.buffer = buffer.get();
+    m_buffers.push_back(std::move(buffer));
+    return holder.buffer;
+}
+
+void Self::retireThreadBuffer(ThreadBuffer *buffer)
+{
+    QMutexLocker locker(&m_buffersMutex);
+    buffer->isRetired = true;
+
+    const auto retiredCount = std::count_if(m_buffers.cbegin(), m_buffers.cend(),
+                                            [](const auto &item) { return item->isRetired; });
+    if (retiredCount > kMaxRetiredBuffers) {
+        auto oldestRetired = std::find_if(m_buffers.begin(), m_buffers.end(),
+                                          [](const auto &item) { return item->isRetired; });
+        m_buffers.erase(oldestRetired);
+    }
+}
+
+void Self::record(Event event)
+{
+    auto buffer = currentThreadBuffer();
+
+    //
+    //  Buffer mutex is contended only during export, so locking is cheap.
+    //
+    QMutexLocker locker(&buffer->mutex);
+    if (buffer->events.size() >= kMaxThreadEvents) {
+        buffer->events.pop_front();
+    }
+    buffer->events.push_back(std::move(event));
+}
+
+TraceSpan::TraceSpan(const char *category, QString name, Tracer::Args args)
+    : m_category(category), m_name(std::move(name)), m_args(std::move(args))
+{
+    auto tracer = Tracer::instance();
+    if (tracer->isEnabled()) {
+        m_startedAt = tracer->now();
+    }
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_startedAt >= 0) {
+        auto tracer = Tracer::instance();
+        tracer->addSpan(m_category, m_name, m_startedAt, tracer->now() - m_startedAt, std::move(m_args));
+    }
+}
+
+void TraceSpan::addArg(const QString &key, const QVariant &value)
+{
+    if (m_startedAt >= 0) {
+        m_args.insert(key, value);
+    }
+}
@@ -35,7 +35,6 @@
 #include "LogConfig.h"
 
 #include "Platform.h"
-#include "LogContext.h"
 
 using namespace vm;
 using namespace vm::platform;
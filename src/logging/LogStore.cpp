@@ -0,0 +1,171 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "LogStore.h"
+
+#include "LogConfig.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
+
+#include <array>
+
+using namespace vm;
+using Self = LogStore;
+
+namespace {
+QMutex compressionMutex;
+
+QString segmentPrefix()
+{
+    return QCoreApplication::applicationName() + QLatin1Char('_');
+}
+
+quint32 crc32(const QByteArray &data)
+{
+    static const auto table = []() {
+        std::array<quint32, 256> t {};
+        for (quint32 i = 0; i < 256; ++i) {
+            auto c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    quint32 crc = 0xFFFFFFFFU;
+    for (const auto byte : data) {
+        crc = table[(crc ^ static_cast<quint8>(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFU;
+}
+
+void appendLittleEndian(QByteArray &data, quint32 value)
+{
+    for (int i = 0; i < 4; ++i) {
+        data.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+} // namespace
+
+QString Self::activeSegmentPath()
+{
+    return LogConfig::instance().logsDir().filePath(segmentPrefix() + QLatin1String("0.log"));
+}
+
+bool Self::closeActiveSegment()
+{
+    const auto activePath = activeSegmentPath();
+    if (!QFile::exists(activePath)) {
+        return false;
+    }
+    const auto closedName = segmentPrefix() + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz") + ".log";
+    return QFile::rename(activePath, LogConfig::instance().logsDir().filePath(closedName));
+}
+
+void Self::compressClosedSegments()
+{
+    QMutexLocker locker(&compressionMutex);
+
+    const auto logsDir = LogConfig::instance().logsDir();
+    const auto activeName = QFileInfo(activeSegmentPath()).fileName();
+
+    // Compress closed segments, including segments that were left after crash
+    const auto closedInfos = logsDir.entryInfoList({ segmentPrefix() + "*.log" }, QDir::Files, QDir::Name);
+    for (auto &info : closedInfos) {
+        if (info.fileName() == activeName) {
+            continue;
+        }
+        QFile file(info.filePath());
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        const auto compressed = gzip(file.readAll());
+        file.close();
+
+        QSaveFile compressedFile(info.filePath() + QLatin1String(".gz"));
+        if (compressedFile.open(QIODevice::WriteOnly) && (compressedFile.write(compressed) == compressed.size())
+            && compressedFile.commit()) {
+            QFile::remove(info.filePath());
+        }
+    }
+
+    // Remove the oldest segments that exceed the budget
+    const auto compressedInfos =
+            logsDir.entryInfoList({ segmentPrefix() + "*.log.gz" }, QDir::Files, QDir::Name | QDir::Reversed);
+    qint64 totalSize = 0;
+    int count = 0;
+    for (auto &info : compressedInfos) {
+        totalSize += info.size();
+        ++count;
+        if ((count > kMaxSegmentCount) || (totalSize > kMaxTotalSize)) {
+            QFile::remove(info.filePath());
+        }
+    }
+}
+
+QStringList Self::compressedSegmentPaths()
+{
+    const auto logsDir = LogConfig::instance().logsDir();
+    QStringList paths;
+    for (auto &info : logsDir.entryInfoList({ segmentPrefix() + "*.log.gz" }, QDir::Files, QDir::Name)) {
+        paths << info.filePath();
+    }
+    return paths;
+}
+
+QByteArray Self::gzip(const QByteArray &data)
+{
+    // qCompress returns 4 bytes of size, 2 bytes of zlib header, deflate stream and 4 bytes of adler32
+    const auto zlibData = qCompress(data);
+    if (zlibData.size() < 10) {
+        return {};
+    }
+
+    QByteArray result;
+    result.reserve(zlibData.size() + 12);
+    const char header[] = { '\x1f', '\x8b', '\x08', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\xff' };
+    result.append(header, sizeof(header));
+    result.append(zlibData.constData() + 6, zlibData.size() - 10);
+    appendLittleEndian(result, crc32(data));
+    appendLittleEndian(result, static_cast<quint32>(data.size()));
+    return result;
+}
@@ -34,51 +34,210 @@
 
 #include "LogWorker.h"
 
-#include "LogConfig.h"
+#include "LogStore.h"
 
 #include <QTextStream>
 #include <QStandardPaths>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDir>
+#include <QRunnable>
+#include <QThread>
 
 #include <cstdio>
+#include <functional>
 
-constexpr const qint64 LOG_MAX_FILESIZE = 1024 * 1024 / 2; // 0.5 Mb
+constexpr const std::size_t LOG_RECORDS_CAPACITY = 8192; // must be a power of two
+constexpr const int LOG_OVERFLOW_RETRY_COUNT = 256; // how many times warnings retry to get into full buffer
 
 using namespace vm;
 using Self = LogWorker;
 
-Self::LogWorker(QObject *parent) : QObject(parent), m_logFile() { }
+namespace {
+class FunctionRunnable : public QRunnable
+{
+public:
+    explicit FunctionRunnable(std::function<void()> function) : m_function(std::move(function))
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override { m_function(); }
+
+private:
+    std::function<void()> m_function;
+};
+} // namespace
+
+Self::LogWorker(QObject *parent) : QObject(parent), m_records(LOG_RECORDS_CAPACITY), m_logFile()
+{
+    // Closed segments are compressed one by one
+    m_compressionPool.setMaxThreadCount(1);
+}
+
+void Self::enqueue(LogRecord &&record)
+{
+    const auto type = record.type;
+    auto isPushed = m_records.tryPush(std::move(record));
+    if (!isPushed && (type != QtDebugMsg) && (type != QtInfoMsg)) {
+        // Make sure that worker is going to free the buffer
+        if (!m_isDrainScheduled.exchange(true)) {
+            QMetaObject::invokeMethod(this, &Self::drain, Qt::QueuedConnection);
+        }
+        const auto isWorkerThread = QThread::currentThread() == thread();
+        for (int i = 0; !isPushed && ((type == QtFatalMsg) || (i < LOG_OVERFLOW_RETRY_COUNT)); ++i) {
+            if (isWorkerThread) {
+                drain();
+            } else {
+                QThread::yieldCurrentThread();
+            }
+            isPushed = m_records.tryPush(std::move(record));
+        }
+    }
+
+    if (!isPushed) {
+        ++m_droppedCount;
+        return;
+    }
+
+    if (!m_isDrainScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(this, &Self::drain, Qt::QueuedConnection);
+    }
+}
+
+void Self::drain()
+{
+    // Reset flag before reading, so records enqueued after the last read schedule a new drain
+    m_isDrainScheduled = false;
+
+    QString htmlMessages;
+    LogRecord record;
+    std::size_t count = 0;
+    while ((count < m_records.capacity()) && m_records.tryPop(record)) {
+        processRecord(record, htmlMessages);
+        ++count;
+    }
+    reportDroppedRecords();
+
+    if (m_logFile.isOpen()) {
+        m_logFile.flush();
+    }
+    if (!htmlMessages.isEmpty()) {
+        emit formattedMessageCreated(htmlMessages);
+    }
+
+    // Give a chance to other events if producers are faster than worker
+    if ((count == m_records.capacity()) && !m_isDrainScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(this, &Self::drain, Qt::QueuedConnection);
+    }
+}
 
-void Self::processMessage(QtMsgType type, const LogContext &context, const QString &message)
+void Self::setHtmlFormattingEnabled(bool enabled)
 {
+    m_isHtmlFormattingEnabled = enabled;
+}
+
+QString Self::categoryName(const char *category)
+{
+    auto it = m_categoryNames.find(category);
+    if (it == m_categoryNames.end()) {
+        it = m_categoryNames.insert(category, category ? QString::fromLatin1(category) : QLatin1String("default"));
+    }
+    return *it;
+}
+
+void Self::processRecord(const LogRecord &record, QString &htmlMessages)
+{
+    const auto category = categoryName(record.category);
 #ifdef QT_DEBUG
-    consoleMessageHandler(type, context, message);
+    consoleMessageHandler(record, category);
 #endif
-    fileMessageHandler(type, context, message);
+    fileMessageHandler(record, category);
+    if (m_isHtmlFormattingEnabled) {
+        htmlMessageHandler(record, category, htmlMessages);
+    }
 }
 
-void Self::fileMessageHandler(QtMsgType type, const LogContext &context, const QString &message)
+void Self::reportDroppedRecords()
 {
+    const auto droppedCount = m_droppedCount.exchange(0);
+    if (droppedCount == 0) {
+        return;
+    }
 
-    auto formattedMessage = QString("%1 [%2] [%3:%4] %5")
-                                    .arg(formatLogType(type))
-                                    .arg(context.category)
-                                    .arg(context.fileName)
-                                    .arg(context.line)
-                                    .arg(message);
-    logToFile(formattedMessage);
+    LogRecord record;
+    record.type = QtWarningMsg;
+    record.category = "logging";
+    record.timestamp = QDateTime::currentMSecsSinceEpoch();
+    record.threadId = QThread::currentThreadId();
+    record.message = QString("Log buffer is full, dropped records: %1").arg(droppedCount);
+    fileMessageHandler(record, categoryName(record.category));
 }
 
-void Self::consoleMessageHandler(QtMsgType type, const LogContext &context, const QString &message)
+void Self::fileMessageHandler(const LogRecord &record, const QString &category)
 {
-    auto formattedMessage = QString("%1 [%2] %3").arg(formatLogType(type)).arg(context.category).arg(message);
+    QString formattedMessage;
+    formattedMessage.reserve(96 + category.size() + record.message.size());
+    formattedMessage += QDateTime::fromMSecsSinceEpoch(record.timestamp).toString(Qt::ISODateWithMs);
+    formattedMessage += QLatin1String(" [0x");
+    formattedMessage += QString::number(reinterpret_cast<quintptr>(record.threadId), 16);
+    formattedMessage += QLatin1String("] ");
+    formattedMessage += formatLogType(record.type);
+    formattedMessage += QLatin1String(" [");
+    formattedMessage += category;
+    formattedMessage += QLatin1String("] [");
+    formattedMessage += QLatin1String(record.fileName);
+    formattedMessage += QLatin1Char(':');
+    formattedMessage += QString::number(record.line);
+    formattedMessage += QLatin1String("] ");
+    formattedMessage += record.message;
+    formattedMessage += QLatin1Char('\n');
+    logToFile(formattedMessage.toUtf8());
+}
+
+void Self::consoleMessageHandler(const LogRecord &record, const QString &category)
+{
+    auto formattedMessage = QString("%1 [%2] %3").arg(QString(formatLogType(record.type)), category, record.message);
     logToConsole(formattedMessage);
 }
 
+void Self::htmlMessageHandler(const LogRecord &record, const QString &category, QString &htmlMessages)
+{
+    QChar preffix;
+    QString color;
+    switch (record.type) {
+    case QtDebugMsg:
+        preffix = QLatin1Char('D');
+        break;
+    case QtInfoMsg:
+        preffix = QLatin1Char('I');
+        color = QLatin1String("#00aa00");
+        break;
+    case QtWarningMsg:
+        preffix = QLatin1Char('W');
+        color = QLatin1String("#ff8800");
+        break;
+    case QtCriticalMsg:
+        preffix = QLatin1Char('C');
+        color = QLatin1String("#aa0000");
+        break;
+    case QtFatalMsg:
+        preffix = QLatin1Char('F');
+        color = QLatin1String("#aa0000");
+        break;
+    }
+    const auto message = QString("%1: [%2] %3").arg(preffix, category, record.message).toHtmlEscaped();
+    if (color.isEmpty()) {
+        htmlMessages += message;
+    } else {
+        htmlMessages += QString("<span style='color:%1;'>%2</span>").arg(color, message);
+    }
+    htmlMessages += QLatin1String("<br/>");
+}
+
 bool Self::prepareLogFile(qint64 messageLen)
 {
-    if (messageLen > LOG_MAX_FILESIZE) {
+    if (messageLen > LogStore::kMaxSegmentSize) {
         // Skip very long messages where size exceeds file size limit.
         // This situation is almost not possible, so don't complicate the logic
         return false;
@@ -90,13 +249,13 @@ bool Self::prepareLogFile(qint64 messageLen)
         rotateLogFiles();
     }
 
-    if (m_logFile.isOpen() && (m_logFile.size() + messageLen > LOG_MAX_FILESIZE)) {
+    if (m_logFile.isOpen() && (m_logFile.size() + messageLen > LogStore::kMaxSegmentSize)) {
         m_logFile.close();
         rotateLogFiles();
     }
 
     if (!m_logFile.isOpen()) {
-        m_logFile.setFileName(getLogFileName(0));
+        m_logFile.setFileName(LogStore::activeSegmentPath());
         if (!m_logFile.open(QIODevice::WriteOnly)) {
             return false;
         }
@@ -107,19 +266,18 @@ bool Self::prepareLogFile(qint64 messageLen)
 
 void Self::rotateLogFiles()
 {
-    const auto currentFileName = getLogFileName(0);
-    if (QFile::exists(currentFileName)) {
-        QFile::rename(currentFileName, getLogFileName(1));
-    }
+    LogStore::closeActiveSegment();
+    // Segments of the previous run are compressed too
+    m_compressionPool.start(new FunctionRunnable(&LogStore::compressClosedSegments));
 }
 
-void Self::logToFile(const QString &formattedMessage)
+void Self::logToFile(const QByteArray &formattedMessage)
 {
     if (!prepareLogFile(formattedMessage.size())) {
         return;
     }
 
-    QTextStream { &m_logFile } << formattedMessage << "\n";
+    m_logFile.write(formattedMessage);
 }
 
 void Self::logToConsole(const QString &formattedMessage)
@@ -131,31 +289,25 @@ void Self::logToConsole(const QString &formattedMessage)
     }
 }
 
-QString Self::formatLogType(QtMsgType type)
+QLatin1String Self::formatLogType(QtMsgType type)
 {
     switch (type) {
     case QtDebugMsg:
-        return "D:";
+        return QLatin1String("D:");
 
     case QtInfoMsg:
-        return "I:";
+        return QLatin1String("I:");
 
     case QtWarningMsg:
-        return "W:";
+        return QLatin1String("W:");
 
     case QtCriticalMsg:
-        return "C:";
+        return QLatin1String("C:");
 
     case QtFatalMsg:
-        return "F:";
+        return QLatin1String("F:");
 
     default:
         throw std::logic_error("Invalid Qt message type");
     }
 }
-
-QString Self::getLogFileName(int logIndex)
-{
-    const auto fileName = QCoreApplication::applicationName() + "_" + QString::number(logIndex) + ".log";
-    return LogConfig::instance().logsDir().filePath(fileName);
-}
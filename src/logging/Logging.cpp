@@ -36,6 +36,8 @@
 
 #include "LogWorker.h"
 
+#include <QDateTime>
+#include <QMetaMethod>
 #include <QThread>
 
 using namespace vm;
@@ -52,19 +54,12 @@ Self::Logging(QObject *parent) : QObject(parent)
         m_instance = this;
     }
 
-    // Register
-    qRegisterMetaType<QtMsgType>();
-    qRegisterMetaType<LogContext>();
-
-    // Internal connections
-    connect(this, &Self::messageCreated, this, &Self::formatMessage);
-
     // Setup thread, worker and connections
     m_workerThread = std::make_unique<QThread>();
-    auto worker = new LogWorker();
-    worker->moveToThread(m_workerThread.get());
-    connect(this, &Self::messageCreated, worker, &LogWorker::processMessage);
-    connect(m_workerThread.get(), &QThread::finished, worker, &LogWorker::deleteLater);
+    m_worker = new LogWorker();
+    m_worker->moveToThread(m_workerThread.get());
+    connect(m_worker, &LogWorker::formattedMessageCreated, this, &Self::formattedMessageCreated);
+    connect(m_workerThread.get(), &QThread::finished, m_worker, &LogWorker::deleteLater);
     m_workerThread->start();
 
     // Install handler
@@ -76,48 +71,52 @@ Self::~Logging()
     // Unset handler
     qInstallMessageHandler(0);
 
-    // Cleanup thread
+    // Write remaining records and cleanup thread
+    QMetaObject::invokeMethod(m_worker, &LogWorker::drain, Qt::BlockingQueuedConnection);
     m_workerThread->quit();
     m_workerThread->wait();
+    m_worker = nullptr;
 
     // Unset instance
     m_instance = nullptr;
 }
 
-void Self::formatMessage(QtMsgType type, const LogContext &context, const QString &message)
+void Self::connectNotify(const QMetaMethod &signal)
 {
-    QChar preffix;
-    QString color;
-    switch (type) {
-    case QtDebugMsg:
-        preffix = QLatin1Char('D');
-        break;
-    case QtInfoMsg:
-        preffix = QLatin1Char('I');
-        color = QLatin1String("#00aa00");
-        break;
-    case QtWarningMsg:
-        preffix = QLatin1Char('W');
-        color = QLatin1String("#ff8800");
-        break;
-    case QtCriticalMsg:
-        preffix = QLatin1Char('C');
-        color = QLatin1String("#aa0000");
-        break;
-    case QtFatalMsg:
-        preffix = QLatin1Char('F');
-        color = QLatin1String("#aa0000");
-        break;
+    if (m_worker && (signal == QMetaMethod::fromSignal(&Self::formattedMessageCreated))) {
+        m_worker->setHtmlFormattingEnabled(isSignalConnected(signal));
     }
-    auto formattedMessage = QString("%1: [%2] %3").arg(preffix, context.category, message);
-    if (!color.isEmpty()) {
-        formattedMessage = QString("<span style='color:%1;'>%2</span>").arg(color, formattedMessage.toHtmlEscaped());
+}
+
+void Self::disconnectNotify(const QMetaMethod &signal)
+{
+    // Signal is invalid when all connections were removed
+    if (m_worker && (!signal.isValid() || (signal == QMetaMethod::fromSignal(&Self::formattedMessageCreated)))) {
+        const auto formattedSignal = QMetaMethod::fromSignal(&Self::formattedMessageCreated);
+        m_worker->setHtmlFormattingEnabled(isSignalConnected(formattedSignal));
     }
-    emit formattedMessageCreated(formattedMessage + QLatin1String("<br/>"));
 }
 
 void Self::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
 {
-    LogContext logContext { context.category, context.file, context.line };
-    emit m_instance->messageCreated(type, logContext, message);
+    LogRecord record;
+    record.type = type;
+    record.category = context.category;
+    record.fileName = context.file;
+    record.line = context.line;
+    record.timestamp = QDateTime::currentMSecsSinceEpoch();
+    record.threadId = QThread::currentThreadId();
+    record.message = message;
+
+    auto worker = m_instance->m_worker;
+    worker->enqueue(std::move(record));
+
+    // Application is aborted after fatal message, so write it right now
+    if (type == QtFatalMsg) {
+        if (QThread::currentThread() == worker->thread()) {
+            worker->drain();
+        } else {
+            QMetaObject::invokeMethod(worker, &LogWorker::drain, Qt::BlockingQueuedConnection);
+        }
+    }
 }
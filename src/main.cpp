@@ -33,6 +33,7 @@
 //  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
 
 #include "Logging.h"
+#include "StartupTimeline.h"
 #include "VSQApplication.h"
 
 #if VS_MOBILE
@@ -49,12 +50,17 @@ using namespace vm;
 
 int main(int argc, char *argv[])
 {
+    //
+    //  Startup time is counted from here.
+    //
+    StartupTimeline::instance()->mark(QLatin1String("main"));
     VSQApplication::initialize();
 #if VS_MOBILE
     QGuiApplication a(argc, argv);
 #else
     QApplication a(argc, argv);
 #endif
+    StartupTimeline::instance()->mark(QLatin1String("gui-application-created"));
     Logging logging;
 
     QString baseUrl;
@@ -36,9 +36,16 @@
 
 #include "CommKitBridge.h"
 #include "CustomerEnv.h"
+#include "EncodingUtils.h"
+#include "StrandExecutor.h"
+#include "Metrics.h"
+#include "Tracer.h"
 #include "IncomingMessage.h"
 #include "MessageContentJsonUtils.h"
+#include "MessageEnvelope.h"
+#include "MessageMarkerAggregator.h"
 #include "OutgoingMessage.h"
+#include "ReconnectScheduler.h"
 #include "UserImpl.h"
 #include "Platform.h"
 
@@ -67,18 +74,27 @@
 #include <qxmpp/QXmppMamManager.h>
 #include <qxmpp/QXmppUtils.h>
 #include <qxmpp/QXmppMamIq.h>
+#include <qxmpp/QXmppGlobal.h>
 
 #include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFutureInterface>
 #include <QMap>
+#include <QMimeDatabase>
 #include <QXmlStreamWriter>
 #include <QtConcurrent>
 #include <QJsonDocument>
 #include <QLoggingCategory>
 #include <QPointer>
+#include <QSslSocket>
+#include <QTimer>
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <set>
 
 using namespace vm;
 using namespace vm::platform;
@@ -89,6 +105,62 @@ using Self = vm::CoreMessenger;
 Q_LOGGING_CATEGORY(lcCoreMessenger, "core-messenger");
 Q_LOGGING_CATEGORY(lcCoreMessengerXMPP, "core-messenger-xmpp");
 
+//
+//  Interval within which "displayed" markers are coalesced to a single marker per chat.
+//
+static constexpr std::chrono::milliseconds kDisplayedMarkersFlushInterval(500);
+
+//
+//  XMPP keep-alive ping interval and timeout in seconds.
+//  Short values allow to detect a dead socket quickly and resume the session.
+//
+static constexpr int kXmppKeepAliveInterval = 30;
+static constexpr int kXmppKeepAliveTimeout = 10;
+
+//
+//  XMPP credentials token is refreshed when it expires within this interval.
+//
+static constexpr qint64 kXmppCredentialsExpirationMarginSec = 60;
+
+//
+//  Maximum number of received XMPP messages that are queued for processing.
+//
+static constexpr int kMaxPendingReceivedXmppMessages = 256;
+
+//
+//  Maximum number of conversations with messages waiting to be sent.
+//
+static constexpr int kMaxPendingSendBatches = 256;
+
+//
+//  Number of threads that send messages, the rest of conversations wait for their turn.
+//
+static constexpr int kMaxSendMessagesThreads = 2;
+
+//
+//  How often the next page of the message history is checked while received messages are queued.
+//
+static constexpr std::chrono::milliseconds kArchivedMessagesBacklogPollInterval(200);
+
+//
+//  Maximum number of personal messages sent to one recipient without a delivery receipt.
+//  A message without a receipt releases its slot after the timeout, because an offline
+//  recipient acknowledges it much later. The window is kept per recipient, so a silent
+//  recipient throttles only its own conversation.
+//
+static constexpr size_t kMaxInFlightSentMessages = 64;
+static constexpr std::chrono::seconds kInFlightSentMessageTimeout(10);
+
+//
+//  Stream management (XEP-0198) state is exposed by QXmppClient since QXmpp 1.4.
+//  Older versions build without session resumption, this is reported by CMake and logged at startup.
+//
+#if defined(QXMPP_VERSION) && QXMPP_VERSION >= QT_VERSION_CHECK(1, 4, 0)
+#    define VM_XMPP_STREAM_MANAGEMENT_STATE 1
+#else
+#    define VM_XMPP_STREAM_MANAGEMENT_STATE 0
+#endif
+
 // --------------------------------------------------------------------------
 // XMPP Helpers.
 // --------------------------------------------------------------------------
@@ -102,6 +174,36 @@ static QString toXmlString(const T &obj)
     return xmlStr;
 }
 
+// --------------------------------------------------------------------------
+// Metrics Helpers.
+// --------------------------------------------------------------------------
+struct CryptoMetrics
+{
+    MetricHistogram *latency;
+    MetricCounter *bytes;
+};
+
+//
+//  Return latency and processed bytes metrics of the crypto operation.
+//
+static CryptoMetrics cryptoMetrics(const QString &operation)
+{
+    auto metrics = Metrics::instance();
+    const Metrics::Labels labels { { "operation", operation } };
+    return { metrics->histogram("crypto_microseconds", labels), metrics->counter("crypto_bytes_total", labels) };
+}
+
+//
+//  Count XMPP connections by kind: resumed session or full reconnect.
+//
+static void recordXmppConnectMetrics(const QString &kind, std::chrono::milliseconds latency)
+{
+    auto metrics = Metrics::instance();
+    const Metrics::Labels labels { { "kind", kind } };
+    metrics->counter("xmpp_connections_total", labels)->increment();
+    metrics->histogram("xmpp_connect_microseconds", labels)->record(std::chrono::microseconds(latency).count());
+}
+
 // --------------------------------------------------------------------------
 // C Helpers.
 // --------------------------------------------------------------------------
@@ -274,6 +376,11 @@ public:
 
     QPointer<NetworkAnalyzer> networkAnalyzer;
     QPointer<Settings> settings;
+    QPointer<MessageMarkerAggregator> displayedMarkers;
+    QPointer<ReconnectScheduler> reconnectScheduler;
+
+    QString xmppPassword;
+    QDateTime xmppPasswordExpiresAt;
 
     std::unique_ptr<QXmppClient> xmpp;
     std::unique_ptr<XmppDiscoveryManager> discoveryManager;
@@ -291,12 +398,58 @@ public:
     std::map<QString, std::shared_ptr<User>> usernameToUser;
     std::mutex findUserMutex;
 
+    //
+    //  Compact envelope capability of every known device (resource) of a peer.
+    //
+    std::map<UserId, std::map<QString, bool>> compactEnvelopePeerDevices;
+    mutable std::mutex compactEnvelopePeersMutex;
+
     ConnectionState connectionState = ConnectionState::Disconnected;
 
+    QElapsedTimer xmppConnectTimer;
+    XmppSessionStats xmppSessionStats;
+    mutable std::mutex xmppSessionStatsMutex;
+
     QDateTime startDisconnectAt;
 
     bool suspended = false;
     bool shouldDisconnectWhenSuspended = true;
+
+    bool receivedMessagesBacklogSaturated = false;
+
+    //
+    //  Set when the connection was aborted to keep the session, so the next connection is expected to resume it.
+    //
+    bool isXmppResumeExpected = false;
+
+    struct PendingSend
+    {
+        MessageHandler message;
+        std::shared_ptr<QFutureInterface<Result>> futureInterface;
+    };
+
+    std::map<QString, std::vector<PendingSend>> pendingSends;
+    std::mutex pendingSendsMutex;
+
+    struct SendWindow
+    {
+        std::map<QString, std::chrono::steady_clock::time_point> inFlight;
+        bool hasWaiter = false;
+    };
+
+    std::map<QString, SendWindow> sendWindows;
+    std::map<QString, QString> sendWindowPipelineKeys;
+    std::mutex sendWindowMutex;
+
+    //
+    //  Process received messages in order within a conversation. Declared last to be destroyed first.
+    //
+    std::unique_ptr<StrandExecutor> receivedMessagesExecutor;
+
+    //
+    //  Send pending messages in order within a conversation. Declared last to be destroyed first.
+    //
+    std::unique_ptr<StrandExecutor> sendMessagesExecutor;
 };
 
 // --------------------------------------------------------------------------
@@ -339,6 +492,7 @@ struct RegisterMetaTypesOnce
         qRegisterMetaType<vm::Contacts>("Contacts");
         qRegisterMetaType<vm::MutableContacts>("MutableContacts");
         qRegisterMetaType<vm::MessageUpdate>("MessageUpdate");
+        qRegisterMetaType<vm::MessageUpdates>("MessageUpdates");
         qRegisterMetaType<vm::ContactUpdate>("ContactUpdate");
 
         qRegisterMetaType<vm::ChatId>("ChatId");
@@ -384,6 +538,8 @@ Self::CoreMessenger(Settings *settings, QObject *parent) : QObject(parent), m_im
     connect(this, &Self::xmppFetchRoomsFromServer, this, &Self::xmppOnFetchRoomsFromServer);
     connect(this, &Self::xmppJoinRoom, this, &Self::xmppOnJoinRoom);
     connect(this, &Self::xmppMessageDelivered, this, &Self::xmppOnMessageDelivered);
+    connect(this, &Self::scheduleSendPipelineResume, this, &Self::onScheduleSendPipelineResume,
+            Qt::QueuedConnection);
 
     connect(this, &Self::syncPrivateChatsHistory, this, &Self::onSyncPrivateChatsHistory, Qt::QueuedConnection);
     connect(this, &Self::syncGroupChatHistory, this, &Self::onSyncGroupChatHistory, Qt::QueuedConnection);
@@ -397,13 +553,43 @@ Self::CoreMessenger(Settings *settings, QObject *parent) : QObject(parent), m_im
 
     connect(m_impl->networkAnalyzer, &NetworkAnalyzer::connectedChanged, this, &Self::onProcessNetworkState);
 
+    //
+    //  Configure received messages processing.
+    //
+    m_impl->receivedMessagesExecutor =
+            std::make_unique<StrandExecutor>(QThread::idealThreadCount(), kMaxPendingReceivedXmppMessages);
+    m_impl->sendMessagesExecutor = std::make_unique<StrandExecutor>(kMaxSendMessagesThreads, kMaxPendingSendBatches);
+
+    //
+    //  Configure reconnection.
+    //
+#if !VM_XMPP_STREAM_MANAGEMENT_STATE
+    qCWarning(lcCoreMessenger) << "QXmpp is older than 1.4, XMPP session resumption is disabled";
+#endif
+    m_impl->reconnectScheduler = new ReconnectScheduler(this);
+    connect(m_impl->reconnectScheduler, &ReconnectScheduler::reconnectRequested, this,
+            &Self::reconnectXmppServerIfNeeded);
+
+    //
+    //  Configure "displayed" markers aggregation.
+    //
+    m_impl->displayedMarkers = new MessageMarkerAggregator(kDisplayedMarkersFlushInterval, this);
+    connect(m_impl->displayedMarkers, &MessageMarkerAggregator::markerReady, this, &Self::onSendDisplayedMarker);
+
     //
     //  Configure Push Notifications
     //
     connect(&Platform::instance(), &Platform::pushTokenUpdated, this, &Self::onRegisterPushNotifications);
 }
 
-Self::~CoreMessenger() noexcept = default;
+Self::~CoreMessenger() noexcept
+{
+    //
+    //  Wait for running sends, then finish postponed ones, so callers waiting for their results are released.
+    //
+    m_impl->sendMessagesExecutor.reset();
+    failPendingSends(Self::Result::Error_Offline);
+}
 
 Self::Result Self::resetCommKitConfiguration()
 {
@@ -560,7 +746,7 @@ void Self::onResetXmppConfiguration()
     //
     connect(m_impl->xmpp.get(), &QXmppClient::presenceReceived, this, &Self::xmppOnPresenceReceived);
     connect(m_impl->xmpp.get(), &QXmppClient::iqReceived, this, &Self::xmppOnIqReceived);
-    connect(m_impl->xmpp.get(), &QXmppClient::messageReceived, this, &Self::xmppOnMessageReceived);
+    connect(m_impl->xmpp.get(), &QXmppClient::messageReceived, this, &Self::xmppOnClientMessageReceived);
 
     //
     //  Handle carbons (message copies).
@@ -608,6 +794,17 @@ CoreMessenger::ConnectionState Self::connectionState() const
     return m_impl->connectionState;
 }
 
+ReconnectScheduler::Stats Self::reconnectStats() const
+{
+    return m_impl->reconnectScheduler->stats();
+}
+
+Self::XmppSessionStats Self::xmppSessionStats() const
+{
+    std::scoped_lock<std::mutex> _(m_impl->xmppSessionStatsMutex);
+    return m_impl->xmppSessionStats;
+}
+
 bool Self::isNetworkOnline() const noexcept
 {
     return m_impl->networkAnalyzer->isConnected();
@@ -640,6 +837,63 @@ bool Self::isXmppDisconnected() const noexcept
     return true;
 }
 
+bool Self::isXmppStreamResumable() const noexcept
+{
+#if VM_XMPP_STREAM_MANAGEMENT_STATE
+    return m_impl->xmpp && m_impl->xmpp->streamManagementState() != QXmppClient::NoStreamManagement;
+#else
+    return false;
+#endif
+}
+
+bool Self::isXmppStreamResumed() const noexcept
+{
+#if VM_XMPP_STREAM_MANAGEMENT_STATE
+    return m_impl->xmpp && m_impl->xmpp->streamManagementState() == QXmppClient::ResumedStream;
+#else
+    return false;
+#endif
+}
+
+bool Self::abortResumableXmppConnection()
+{
+    if (!isXmppStreamResumable() || m_impl->xmpp->state() == QXmppClient::DisconnectedState) {
+        return false;
+    }
+
+    //
+    //  QXmppClient does not expose its socket and has no public API to drop the connection without
+    //  sending </stream>, which ends the session. The socket is the single QSslSocket child of the client
+    //  stream, verified with QXmpp 1.4 and 1.5. This helper is the only place that touches QXmpp internals.
+    //
+    const auto sockets = m_impl->xmpp->findChildren<QSslSocket *>();
+    if (sockets.size() != 1) {
+        qCWarning(lcCoreMessenger) << "Can not abort XMPP connection - unexpected number of sockets:" << sockets.size();
+        return false;
+    }
+
+    qCDebug(lcCoreMessenger) << "Abort XMPP connection, keep the session for resumption";
+    m_impl->isXmppResumeExpected = true;
+    sockets.front()->abort();
+    return true;
+}
+
+void Self::rejoinXmppRooms()
+{
+    for (auto xmppRoom : m_impl->xmppGroupChatManager->rooms()) {
+        if (xmppRoom->isJoined()) {
+            qCDebug(lcCoreMessenger) << "XMPP room is already joined:" << xmppRoom->jid();
+        } else {
+            qCDebug(lcCoreMessenger) << "Re-join XMPP room:" << xmppRoom->jid();
+            if (xmppRoom->join()) {
+                qCDebug(lcCoreMessenger) << "Sent request to join XMPP room:" << xmppRoom->jid();
+            } else {
+                qCDebug(lcCoreMessenger) << "Failed to sent request to join XMPP room:" << xmppRoom->jid();
+            }
+        }
+    }
+}
+
 // --------------------------------------------------------------------------
 // State controls.
 // --------------------------------------------------------------------------
@@ -915,6 +1169,8 @@ QFuture<Self::Result> Self::signOut()
         emit cleanupXmppMucRooms();
         emit cleanupCommKitMessenger();
 
+        failPendingSends(Self::Result::Error_Offline);
+
         return Self::Result::Success;
     });
 }
@@ -1112,45 +1368,67 @@ void Self::connectXmppServer()
     if (m_impl->startDisconnectAt.isValid()) {
         const auto distance = m_impl->startDisconnectAt.msecsTo(QDateTime::currentDateTime());
         if (distance < 2000) {
-            QTimer::singleShot(2000 - distance, this, &Self::reconnectXmppServerIfNeeded);
+            //
+            //  Reconnect is requested when disconnect is completed, schedule a retry in case it never happens.
+            //  It is not a connection failure, so backoff is not increased.
+            //
             qCDebug(lcCoreMessenger) << "Prevent XMPP start connection, when disconnect was not completed.";
-            qCDebug(lcCoreMessenger) << "Emit reconnect in" << 2000 - distance << "ms from: connectXmppServer()";
+            m_impl->reconnectScheduler->postpone(std::chrono::milliseconds(2000 - distance));
             return;
         }
     }
 
-    vssq_error_t error;
-    vssq_error_reset(&error);
+    m_impl->reconnectScheduler->attemptStarted();
 
-    qCDebug(lcCoreMessenger) << "Obtain XMPP credentials...";
+    //
+    //  Reuse XMPP credentials token until it expires.
+    //
+    const auto now = QDateTime::currentDateTime();
+    if (m_impl->xmppPassword.isEmpty() || !m_impl->xmppPasswordExpiresAt.isValid()
+        || now.secsTo(m_impl->xmppPasswordExpiresAt) < kXmppCredentialsExpirationMarginSec) {
 
-    const vssq_messenger_auth_t *auth = vssq_messenger_auth(m_impl->messenger.get());
-    const vssq_ejabberd_jwt_t *jwt = vssq_messenger_auth_ejabberd_jwt(auth, &error);
+        vssq_error_t error;
+        vssq_error_reset(&error);
 
-    if (vssq_error_has_error(&error)) {
-        qCWarning(lcCoreMessenger) << "Got error status:" << vsc_str_to_qstring(vssq_error_message_from_error(&error));
-        changeConnectionState(Self::ConnectionState::Disconnected);
-        return;
+        qCDebug(lcCoreMessenger) << "Obtain XMPP credentials...";
+
+        const vssq_messenger_auth_t *auth = vssq_messenger_auth(m_impl->messenger.get());
+        const vssq_ejabberd_jwt_t *jwt = vssq_messenger_auth_ejabberd_jwt(auth, &error);
+
+        if (vssq_error_has_error(&error)) {
+            qCWarning(lcCoreMessenger) << "Got error status:"
+                                       << vsc_str_to_qstring(vssq_error_message_from_error(&error));
+            changeConnectionState(Self::ConnectionState::Disconnected);
+            m_impl->reconnectScheduler->scheduleRetry();
+            return;
+        }
+
+        m_impl->xmppPassword = vsc_str_to_qstring(vssq_ejabberd_jwt_as_string(jwt));
+        m_impl->xmppPasswordExpiresAt = QDateTime::fromTime_t(vssq_ejabberd_jwt_expires_at(jwt));
     }
 
-    const auto jwtExpiresAt = vssq_ejabberd_jwt_expires_at(jwt);
     qCDebug(lcCoreMessenger) << "XMPP credentials token will expire at: "
-                             << QDateTime::fromTime_t(jwtExpiresAt).toLocalTime();
-
-    QString xmppPass = vsc_str_to_qstring(vssq_ejabberd_jwt_as_string(jwt));
+                             << m_impl->xmppPasswordExpiresAt.toLocalTime();
 
     qCDebug(lcCoreMessenger) << "Connect user with JID:" << currentUserJid();
 
     QXmppConfiguration config {};
     config.setJid(currentUserJid());
     config.setHost(CustomerEnv::xmppServiceUrl());
-    config.setPassword(xmppPass);
+    config.setPassword(m_impl->xmppPassword);
     config.setAutoReconnectionEnabled(false);
     config.setAutoAcceptSubscriptions(true);
+    config.setKeepAliveInterval(kXmppKeepAliveInterval);
+    config.setKeepAliveTimeout(kXmppKeepAliveTimeout);
 
     resetXmppConfiguration();
 
+    //
+    //  Stream management (XEP-0198) is negotiated by QXmppClient when the server supports it.
+    //  The same client instance is reused, so the previous session is resumed if it was not closed.
+    //
     qCDebug(lcCoreMessenger) << "Connecting to XMPP server...";
+    m_impl->xmppConnectTimer.start();
     m_impl->xmpp->connectToServer(config);
     m_impl->startDisconnectAt = QDateTime();
 }
@@ -1172,9 +1450,12 @@ void Self::onReconnectXmppServerIfNeeded()
 void Self::onDisconnectXmppServer()
 {
     if (m_impl->xmpp != nullptr && (m_impl->xmpp->state() != QXmppClient::DisconnectedState)) {
+        m_impl->displayedMarkers->flush();
+
         qCDebug(lcCoreMessenger) << "Start XMPP disconnect...";
         m_impl->xmpp->disconnectFromServer();
         m_impl->startDisconnectAt = QDateTime::currentDateTime();
+        m_impl->isXmppResumeExpected = false;
     }
 }
 
@@ -1200,6 +1481,10 @@ void Self::onCleanupXmppMucRooms()
 
 void Self::onCleanupCommKitMessenger()
 {
+    m_impl->reconnectScheduler->reset();
+    m_impl->xmppPassword.clear();
+    m_impl->xmppPasswordExpiresAt = QDateTime();
+
     std::scoped_lock<std::mutex> _(m_impl->authMutex);
     m_impl->messenger = nullptr;
     m_impl->creds = nullptr;
@@ -1330,26 +1615,272 @@ std::shared_ptr<User> Self::currentUser() const
 // --------------------------------------------------------------------------
 QFuture<Self::Result> Self::sendMessage(MessageHandler message)
 {
+    qCInfo(lcCoreMessenger) << "Enqueue message to send with id:" << QString(message->id());
+
+    auto futureInterface = std::make_shared<QFutureInterface<Result>>();
+    futureInterface->reportStarted();
+    auto future = futureInterface->future();
+
+    //
+    //  Only the first pending message of a conversation schedules sending,
+    //  the rest join its batch.
+    //
+    const auto pipelineKey = sendPipelineKey(message);
+    bool shouldSchedule = false;
+    {
+        std::scoped_lock<std::mutex> _(m_impl->pendingSendsMutex);
+        auto &pendingSends = m_impl->pendingSends[pipelineKey];
+        shouldSchedule = pendingSends.empty();
+        pendingSends.push_back({ std::move(message), std::move(futureInterface) });
+    }
+
+    if (shouldSchedule) {
+        m_impl->sendMessagesExecutor->post(pipelineKey, [this, pipelineKey]() { sendPendingMessages(pipelineKey); });
+    }
+
+    return future;
+}
+
+QString Self::sendPipelineKey(const MessageHandler &message)
+{
+    switch (message->chatType()) {
+    case ChatType::Personal:
+        return QLatin1String("personal:") + QString(message->recipientId());
+
+    case ChatType::Group:
+        return QLatin1String("group:") + QString(message->groupChatInfo()->groupId());
+
+    default:
+        throw std::logic_error("Invalid chat type");
+    }
+}
+
+void Self::sendPendingMessages(const QString &pipelineKey)
+{
+    std::vector<Impl::PendingSend> batch;
+    {
+        std::scoped_lock<std::mutex> _(m_impl->pendingSendsMutex);
+        auto pendingSendsIt = m_impl->pendingSends.find(pipelineKey);
+        if (pendingSendsIt == m_impl->pendingSends.end()) {
+            return;
+        }
+        batch = std::move(pendingSendsIt->second);
+        m_impl->pendingSends.erase(pendingSendsIt);
+    }
+
+    if (batch.empty()) {
+        return;
+    }
+
+    qCDebug(lcCoreMessenger) << "Will send" << batch.size() << "message(s) to:" << pipelineKey;
+
+    const auto finish = [](Impl::PendingSend &pendingSend, Result result) {
+        pendingSend.futureInterface->reportResult(result);
+        pendingSend.futureInterface->reportFinished();
+    };
+
+    const auto finishAll = [&batch, &finish](Result result) {
+        for (auto &pendingSend : batch) {
+            finish(pendingSend, result);
+        }
+    };
+
+    if (!isOnline()) {
+        qCInfo(lcCoreMessenger) << "Trying to send message when offline";
+        finishAll(Self::Result::Error_Offline);
+        return;
+    }
+
+    //
+    //  Resolve recipient or group once for the whole batch.
+    //
+    const auto &firstMessage = batch.front().message;
+    UserHandler recipient;
+    GroupImplHandler group;
+
+    if (firstMessage->chatType() == ChatType::Personal) {
+        recipient = findUserById(firstMessage->recipientId());
+        if (!recipient) {
+            //
+            //  Got network troubles to find recipient, so cache message and try later.
+            //
+            qCWarning(lcCoreMessenger) << "Can not send message - recipient is not found";
+            finishAll(Self::Result::Error_UserNotFound);
+            return;
+        }
+    } else {
+        group = findGroupInCache(firstMessage->groupChatInfo()->groupId());
+        if (!group || !group->commKitGroup) {
+            qCWarning(lcCoreMessenger) << "Can not send message - group is not loaded";
+            finishAll(Self::Result::Error_GroupNotLoaded);
+            return;
+        }
+    }
+
+    for (auto pendingSendIt = batch.begin(); pendingSendIt != batch.end(); ++pendingSendIt) {
+        const auto &message = pendingSendIt->message;
 
-    return QtConcurrent::run([this, message = std::move(message)]() -> Result {
         qCInfo(lcCoreMessenger) << "Trying to send message with id:" << QString(message->id());
 
         if (!isOnline()) {
             qCInfo(lcCoreMessenger) << "Trying to send message when offline";
-            return Self::Result::Error_Offline;
+            finish(*pendingSendIt, Self::Result::Error_Offline);
+            continue;
         }
 
-        switch (message->chatType()) {
-        case ChatType::Personal:
-            return sendPersonalMessage(message);
+        if (!recipient) {
+            finish(*pendingSendIt, sendGroupMessage(message, group));
+            continue;
+        }
 
-        case ChatType::Group:
-            return sendGroupMessage(message);
+        //
+        //  Stanzas are pipelined until the window of unacknowledged messages is full.
+        //  Then the rest of the batch is returned to the pipeline, which is resumed when a slot is released.
+        //
+        if (!tryAcquireSendWindow(pipelineKey, message->id())) {
+            qCDebug(lcCoreMessenger) << "Send window is full, postpone" << std::distance(pendingSendIt, batch.end())
+                                     << "message(s) to:" << pipelineKey;
+
+            std::scoped_lock<std::mutex> _(m_impl->pendingSendsMutex);
+            auto &pendingSends = m_impl->pendingSends[pipelineKey];
+            pendingSends.insert(pendingSends.begin(), std::make_move_iterator(pendingSendIt),
+                                std::make_move_iterator(batch.end()));
+            return;
+        }
 
-        default:
-            throw std::logic_error("Invalid chat type");
+        const auto result = sendPersonalMessage(message, *recipient);
+        if (result != Self::Result::Success) {
+            releaseSendWindow(message->id());
         }
-    });
+        finish(*pendingSendIt, result);
+    }
+}
+
+void Self::failPendingSends(Result result)
+{
+    std::map<QString, std::vector<Impl::PendingSend>> pendingSends;
+    {
+        std::scoped_lock<std::mutex> _(m_impl->pendingSendsMutex);
+        pendingSends.swap(m_impl->pendingSends);
+    }
+
+    for (auto &[pipelineKey, batch] : pendingSends) {
+        qCInfo(lcCoreMessenger) << "Drop" << batch.size() << "pending message(s) to:" << pipelineKey;
+        for (auto &pendingSend : batch) {
+            pendingSend.futureInterface->reportResult(result);
+            pendingSend.futureInterface->reportFinished();
+        }
+    }
+}
+
+bool Self::tryAcquireSendWindow(const QString &pipelineKey, const QString &messageId)
+{
+    std::scoped_lock<std::mutex> _(m_impl->sendWindowMutex);
+    auto &sendWindow = m_impl->sendWindows[pipelineKey];
+    auto &inFlight = sendWindow.inFlight;
+
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = inFlight.begin(); it != inFlight.end();) {
+        if (now - it->second >= kInFlightSentMessageTimeout) {
+            m_impl->sendWindowPipelineKeys.erase(it->first);
+            it = inFlight.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (inFlight.size() < kMaxInFlightSentMessages) {
+        inFlight[messageId] = now;
+        m_impl->sendWindowPipelineKeys[messageId] = pipelineKey;
+        return true;
+    }
+
+    //
+    //  The waiter schedules resume when the oldest slot expires, a delivery receipt may release it earlier.
+    //
+    if (!sendWindow.hasWaiter) {
+        sendWindow.hasWaiter = true;
+        const auto oldestIt =
+                std::min_element(inFlight.cbegin(), inFlight.cend(),
+                                 [](const auto &lhs, const auto &rhs) { return lhs.second < rhs.second; });
+        const auto expiresIn = std::chrono::duration_cast<std::chrono::milliseconds>(
+                oldestIt->second + kInFlightSentMessageTimeout - now);
+        emit scheduleSendPipelineResume(pipelineKey, static_cast<int>(expiresIn.count()) + 1);
+    }
+
+    return false;
+}
+
+void Self::releaseSendWindow(const QString &messageId)
+{
+    QString pipelineKey;
+    {
+        std::scoped_lock<std::mutex> _(m_impl->sendWindowMutex);
+        auto pipelineKeyIt = m_impl->sendWindowPipelineKeys.find(messageId);
+        if (pipelineKeyIt == m_impl->sendWindowPipelineKeys.end()) {
+            return;
+        }
+        pipelineKey = std::move(pipelineKeyIt->second);
+        m_impl->sendWindowPipelineKeys.erase(pipelineKeyIt);
+
+        auto sendWindowIt = m_impl->sendWindows.find(pipelineKey);
+        if (sendWindowIt == m_impl->sendWindows.end()) {
+            return;
+        }
+        sendWindowIt->second.inFlight.erase(messageId);
+        if (sendWindowIt->second.inFlight.empty() && !sendWindowIt->second.hasWaiter) {
+            m_impl->sendWindows.erase(sendWindowIt);
+            return;
+        }
+    }
+    resumeSendPipeline(pipelineKey);
+}
+
+void Self::resetSendWindow()
+{
+    std::map<QString, Impl::SendWindow> sendWindows;
+    {
+        std::scoped_lock<std::mutex> _(m_impl->sendWindowMutex);
+        sendWindows.swap(m_impl->sendWindows);
+        m_impl->sendWindowPipelineKeys.clear();
+    }
+
+    //
+    //  The executor is gone when the connection drops while the messenger is destroyed.
+    //
+    if (!m_impl->sendMessagesExecutor) {
+        return;
+    }
+
+    for (const auto &[pipelineKey, sendWindow] : sendWindows) {
+        if (sendWindow.hasWaiter) {
+            m_impl->sendMessagesExecutor->post(pipelineKey,
+                                               [this, pipelineKey]() { sendPendingMessages(pipelineKey); });
+        }
+    }
+}
+
+void Self::resumeSendPipeline(const QString &pipelineKey)
+{
+    {
+        std::scoped_lock<std::mutex> _(m_impl->sendWindowMutex);
+        auto sendWindowIt = m_impl->sendWindows.find(pipelineKey);
+        if (sendWindowIt == m_impl->sendWindows.end() || !sendWindowIt->second.hasWaiter) {
+            return;
+        }
+        sendWindowIt->second.hasWaiter = false;
+    }
+
+    if (!m_impl->sendMessagesExecutor) {
+        return;
+    }
+
+    m_impl->sendMessagesExecutor->post(pipelineKey, [this, pipelineKey]() { sendPendingMessages(pipelineKey); });
+}
+
+void Self::onScheduleSendPipelineResume(const QString &pipelineKey, int msec)
+{
+    QTimer::singleShot(msec, this, [this, pipelineKey]() { resumeSendPipeline(pipelineKey); });
 }
 
 std::variant<CoreMessengerStatus, QByteArray> Self::encryptPersonalMessage(const UserId &recipientId,
@@ -1367,11 +1898,22 @@ std::variant<CoreMessengerStatus, QByteArray> Self::encryptPersonalMessage(const
         return Self::Result::Error_UserNotFound;
     }
 
+    return encryptPersonalMessage(*recipient, messageData);
+}
+
+std::variant<CoreMessengerStatus, QByteArray> Self::encryptPersonalMessage(const User &recipient,
+                                                                           const QByteArray &messageData)
+{
+    TraceSpan traceSpan("crypto", QStringLiteral("encryptPersonalMessage"), { { "size", messageData.size() } });
+    static const auto metrics = cryptoMetrics(QStringLiteral("encryptPersonalMessage"));
+    metrics.bytes->increment(messageData.size());
+    MetricLatencyTimer latencyTimer(metrics.latency);
+
     //
     //  Encrypt message.
     //
     auto ciphertextDataMinLen = vssq_messenger_encrypted_message_len(m_impl->messenger.get(), messageData.size(),
-                                                                     recipient->impl()->user.get());
+                                                                     recipient.impl()->user.get());
 
     qCDebug(lcCoreMessenger) << "Message Len   :" << messageData.size();
     qCDebug(lcCoreMessenger) << "ciphertext Len:" << ciphertextDataMinLen;
@@ -1379,7 +1921,7 @@ std::variant<CoreMessengerStatus, QByteArray> Self::encryptPersonalMessage(const
     auto [ciphertextData, ciphertext] = makeMappedBuffer(ciphertextDataMinLen);
 
     const vssq_status_t encryptionStatus = vssq_messenger_encrypt_data(
-            m_impl->messenger.get(), vsc_data_from(messageData), recipient->impl()->user.get(), ciphertext.get());
+            m_impl->messenger.get(), vsc_data_from(messageData), recipient.impl()->user.get(), ciphertext.get());
 
     if (encryptionStatus != vssq_status_SUCCESS) {
         qCWarning(lcCoreMessenger) << "Can not encrypt ciphertext:"
@@ -1395,6 +1937,11 @@ std::variant<CoreMessengerStatus, QByteArray> Self::encryptPersonalMessage(const
 std::variant<CoreMessengerStatus, QByteArray> Self::decryptPersonalMessage(const UserId &senderId,
                                                                            const QByteArray &messageCiphertext)
 {
+    TraceSpan traceSpan("crypto", QStringLiteral("decryptPersonalMessage"), { { "size", messageCiphertext.size() } });
+    static const auto metrics = cryptoMetrics(QStringLiteral("decryptPersonalMessage"));
+    metrics.bytes->increment(messageCiphertext.size());
+    MetricLatencyTimer latencyTimer(metrics.latency);
+
     //
     //  Find sender.
     //
@@ -1430,13 +1977,121 @@ std::variant<CoreMessengerStatus, QByteArray> Self::decryptPersonalMessage(const
     return messageData;
 }
 
-Self::Result Self::sendPersonalMessage(const MessageHandler &message)
+std::optional<MessageUpdates> Self::decryptStoredMessages(const UserId &senderId,
+                                                           const ModifiableMessages &messages)
+{
+    //
+    //  Resolve sender once, so decryption of each message hits the cache.
+    //
+    if (!findUserById(senderId)) {
+        qCDebug(lcCoreMessenger) << "Can not decrypt stored messages for now - sender is not found:" << senderId;
+        return std::nullopt;
+    }
+
+    //
+    //  Caller is a pool task already, so messages are not spread over nested tasks of the same pool.
+    //
+    MessageUpdates updates;
+    for (const auto &message : messages) {
+        if (auto update = decryptStoredMessage(*message)) {
+            updates.push_back(std::move(*update));
+        }
+    }
+
+    qCInfo(lcCoreMessenger) << "Stored messages were processed:" << updates.size() << "of" << messages.size()
+                            << "from:" << senderId;
+
+    return updates;
+}
+
+std::optional<MessageUpdate> Self::decryptStoredMessage(const Message &encryptedMessage)
+{
+    auto encryptedContent = std::get_if<MessageContentEncrypted>(&encryptedMessage.content());
+    if (!encryptedContent) {
+        return std::nullopt;
+    }
+
+    const auto ciphertext = encryptedContent->ciphertext();
+
+    auto messageDataResult = encryptedMessage.isGroupChatMessage()
+            ? decryptGroupMessage(encryptedMessage.groupChatInfo()->groupId(), encryptedMessage.senderId(), ciphertext)
+            : decryptPersonalMessage(encryptedMessage.senderId(), ciphertext);
+
+    auto brokenUpdate = [&encryptedMessage]() {
+        IncomingMessageStageUpdate update;
+        update.messageId = encryptedMessage.id();
+        update.stage = IncomingMessageStage::Broken;
+        return update;
+    };
+
+    if (auto status = std::get_if<CoreMessengerStatus>(&messageDataResult)) {
+        switch (*status) {
+        case Self::Result::Success: // sender is not found
+        case Self::Result::Error_UserNotFound:
+        case Self::Result::Error_GroupNotFound:
+        case Self::Result::Error_GroupNotLoaded:
+        case Self::Result::Error_ProcessGroupMessage_EpochNotFound:
+            //
+            //  Keys are not available yet, so try later.
+            //
+            return std::nullopt;
+
+        case Self::Result::Error_InvalidMessageCiphertext:
+        case Self::Result::Error_InvalidMessageFormat:
+        case Self::Result::Error_InvalidMessageVersion:
+        case Self::Result::Error_ImportGroupEpoch_ParseFailed:
+        case Self::Result::Error_ProcessGroupMessage_WrongKeyType:
+        case Self::Result::Error_ProcessGroupMessage_InvalidSignature:
+        case Self::Result::Error_ProcessGroupMessage_Ed25519Failed:
+        case Self::Result::Error_ProcessGroupMessage_PlainTextTooLong:
+        case Self::Result::Error_ProcessGroupMessage_CryptoFailed:
+            //
+            //  Ciphertext is damaged or was not encrypted for us, so it never can be decrypted.
+            //
+            qCWarning(lcCoreMessenger) << "Stored message can not be decrypted:" << encryptedMessage.id();
+            return brokenUpdate();
+
+        default:
+            //
+            //  Transient failure, so the message stays encrypted and is tried in the next session.
+            //
+            qCWarning(lcCoreMessenger) << "Stored message was not decrypted for now:" << encryptedMessage.id()
+                                       << "status:" << static_cast<int>(*status);
+            return std::nullopt;
+        }
+    }
+
+    auto message = std::make_shared<IncomingMessage>();
+    message->setId(encryptedMessage.id());
+    message->setRecipientId(encryptedMessage.recipientId());
+    message->setSenderId(encryptedMessage.senderId());
+    message->setCreatedAt(encryptedMessage.createdAt());
+    message->setGroupChatInfo(encryptedMessage.groupChatInfo());
+
+    const auto &messageData = *std::get_if<QByteArray>(&messageDataResult);
+    if (auto result = MessagePacking::unpackMessage(messageData, *message); result != Self::Result::Success) {
+        qCWarning(lcCoreMessenger) << "Stored message can not be unpacked:" << encryptedMessage.id();
+        return brokenUpdate();
+    }
+
+    message->setStage(IncomingMessageStage::Decrypted);
+
+    IncomingMessageDecryptedUpdate update;
+    update.messageId = message->id();
+    update.decryptedMessage = std::move(message);
+    return update;
+}
+
+Self::Result Self::sendPersonalMessage(const MessageHandler &message, const User &recipient)
 {
+    TraceSpan traceSpan("xmpp", QStringLiteral("sendPersonalMessage"), { { "messageId", QString(message->id()) } });
+
     //
     //  Encrypt message.
     //
-    auto messageData = packMessage(message);
-    auto ciphertextResult = encryptPersonalMessage(message->recipientId(), messageData);
+    const auto isCompactEnvelope = isCompactEnvelopeSupported(recipient.id());
+    auto messageData = packMessage(message, isCompactEnvelope);
+    auto ciphertextResult = encryptPersonalMessage(recipient, messageData);
     if (auto status = std::get_if<Self::Result>(&ciphertextResult)) {
         return *status;
     }
@@ -1446,7 +2101,7 @@ Self::Result Self::sendPersonalMessage(const MessageHandler &message)
     //
     //  Pack JSON body.
     //
-    auto messageBody = packXmppMessageBody(ciphertextData, PushType::Alert);
+    auto messageBody = MessagePacking::packXmppMessageBody(ciphertextData, PushType::Alert, isCompactEnvelope);
 
     //
     //  Send message.
@@ -1464,12 +2119,12 @@ Self::Result Self::sendPersonalMessage(const MessageHandler &message)
     xmppMessage.setStamp(message->createdAt());
     xmppMessage.setType(QXmppMessage::Type::Chat);
     xmppMessage.setMarkable(true);
+    addCompactEnvelopeCapability(xmppMessage);
 
-    //
-    //  Send.
-    //
     bool isSent = m_impl->xmpp->sendPacket(xmppMessage);
     if (isSent) {
+        static auto sentCounter = Metrics::instance()->counter("xmpp_messages_sent_total", { { "type", "chat" } });
+        sentCounter->increment();
         qCDebug(lcCoreMessenger) << "XMPP message was sent:" << message->id();
         return Self::Result::Success;
     } else {
@@ -1478,8 +2133,9 @@ Self::Result Self::sendPersonalMessage(const MessageHandler &message)
     }
 }
 
-Self::Result Self::sendGroupMessage(const MessageHandler &message)
+Self::Result Self::sendGroupMessage(const MessageHandler &message, const GroupImplHandler &group)
 {
+    TraceSpan traceSpan("xmpp", QStringLiteral("sendGroupMessage"), { { "messageId", QString(message->id()) } });
 
     qCDebug(lcCoreMessenger) << "Will send group message:" << message->id() << ", from user:" << message->senderId()
                              << ", to group:" << message->groupChatInfo()->groupId();
@@ -1490,9 +2146,12 @@ Self::Result Self::sendGroupMessage(const MessageHandler &message)
     //
     auto groupId = message->groupChatInfo()->groupId();
 
-    auto messageData = packMessage(message);
+    //
+    //  Group members may run clients without envelope support, so group messages stay in JSON.
+    //
+    auto messageData = packMessage(message, false);
 
-    auto encryptedMessageDataResult = encryptGroupMessage(groupId, messageData);
+    auto encryptedMessageDataResult = encryptGroupMessage(group, messageData);
 
     if (auto status = std::get_if<Self::Result>(&encryptedMessageDataResult)) {
         qCDebug(lcCoreMessenger) << "Failed to send message with id:" << message->id();
@@ -1504,7 +2163,7 @@ Self::Result Self::sendGroupMessage(const MessageHandler &message)
     //
     //  Pack JSON body.
     //
-    auto messageBody = packXmppMessageBody(encryptedMessageData, PushType::Alert);
+    auto messageBody = MessagePacking::packXmppMessageBody(encryptedMessageData, PushType::Alert, false);
 
     qCDebug(lcCoreMessenger) << "Will send XMPP message with body:" << messageBody;
 
@@ -1525,6 +2184,8 @@ Self::Result Self::sendGroupMessage(const MessageHandler &message)
     //
     bool isSent = m_impl->xmpp->sendPacket(xmppMessage);
     if (isSent) {
+        static auto sentCounter = Metrics::instance()->counter("xmpp_messages_sent_total", { { "type", "groupchat" } });
+        sentCounter->increment();
         qCDebug(lcCoreMessenger) << "XMPP message was sent";
         return Self::Result::Success;
 
@@ -1631,7 +2292,7 @@ std::variant<Self::Result, MessageHandler> Self::decryptStandaloneMessage(const
         return Self::Result::Error_InvalidMessageCiphertext;
     }
 
-    auto ciphertextDecoded = QByteArray::fromBase64Encoding(ciphertext.toLatin1());
+    auto ciphertextDecoded = EncodingUtils::fromBase64(ciphertext);
     if (!ciphertextDecoded) {
         qCWarning(lcCoreMessenger) << "Given ciphertext is not base64 encoded";
         return Self::Result::Error_InvalidMessageCiphertext;
@@ -1659,16 +2320,41 @@ std::variant<Self::Result, MessageHandler> Self::decryptStandaloneMessage(const
     //
     auto message = std::make_unique<IncomingMessage>();
 
-    if (auto result = unpackMessage(messageData, *message); result != Self::Result::Success) {
+    if (auto result = MessagePacking::unpackMessage(messageData, *message); result != Self::Result::Success) {
         return result;
     }
 
     return message;
 }
 
+QString Self::xmppConversationKey(const QXmppMessage &xmppMessage, bool isCarbon)
+{
+    //
+    //  Group chat messages come from the room JID, carbons are sent by the current user to the peer.
+    //
+    if (isCarbon && xmppMessage.type() != QXmppMessage::GroupChat) {
+        return QXmppUtils::jidToBareJid(xmppMessage.to());
+    }
+    return QXmppUtils::jidToBareJid(xmppMessage.from());
+}
+
+void Self::checkReceivedMessagesBacklog()
+{
+    const bool isSaturated = m_impl->receivedMessagesExecutor->isSaturated();
+    if (isSaturated && !m_impl->receivedMessagesBacklogSaturated) {
+        qCWarning(lcCoreMessenger) << "Received messages queue is saturated:"
+                                   << m_impl->receivedMessagesExecutor->pendingTaskCount() << "message(s)";
+    }
+    m_impl->receivedMessagesBacklogSaturated = isSaturated;
+}
+
 QFuture<Self::Result> Self::processReceivedXmppMessage(const QXmppMessage &xmppMessage)
 {
-    return QtConcurrent::run([this, xmppMessage]() -> Result {
+    checkReceivedMessagesBacklog();
+
+    const auto conversationKey = xmppConversationKey(xmppMessage, false);
+    return m_impl->receivedMessagesExecutor->submit(conversationKey, [this, xmppMessage]() -> Result {
+        TraceSpan traceSpan("xmpp", QStringLiteral("processReceivedMessage"), { { "messageId", xmppMessage.id() } });
         qCInfo(lcCoreMessenger) << "Received XMPP message";
         qCDebug(lcCoreMessenger) << "Received XMPP message with id:" << xmppMessage.id()
                                  << "from:" << xmppMessage.from();
@@ -1733,7 +2419,7 @@ Self::Result Self::processChatReceivedXmppMessage(const QXmppMessage &xmppMessag
     //
     //  Decode message body from Base64 and JSON.
     //
-    auto messageCiphertextResult = unpackXmppMessageBody(xmppMessage.body());
+    auto messageCiphertextResult = MessagePacking::unpackXmppMessageBody(xmppMessage.body());
     if (auto status = std::get_if<CoreMessengerStatus>(&messageCiphertextResult)) {
         return *status;
     }
@@ -1758,7 +2444,7 @@ Self::Result Self::processChatReceivedXmppMessage(const QXmppMessage &xmppMessag
     //
     //  Unpack message.
     //
-    if (auto result = unpackMessage(messageData, *message); result != Self::Result::Success) {
+    if (auto result = MessagePacking::unpackMessage(messageData, *message); result != Self::Result::Success) {
         return result;
     }
 
@@ -1795,7 +2481,7 @@ Self::Result Self::processGroupChatReceivedXmppMessage(const QXmppMessage &xmppM
     //
     //  Decode message body from Base64 and JSON.
     //
-    auto ciphertextResult = unpackXmppMessageBody(xmppMessage.body());
+    auto ciphertextResult = MessagePacking::unpackXmppMessageBody(xmppMessage.body());
     if (auto status = std::get_if<CoreMessengerStatus>(&ciphertextResult)) {
         return *status;
     }
@@ -1829,7 +2515,7 @@ Self::Result Self::processGroupChatReceivedXmppMessage(const QXmppMessage &xmppM
     //
     //  Unpack message.
     //
-    if (auto result = unpackMessage(plaintextData, *message); result != Self::Result::Success) {
+    if (auto result = MessagePacking::unpackMessage(plaintextData, *message); result != Self::Result::Success) {
         return result;
     }
 
@@ -1856,8 +2542,10 @@ Self::Result Self::processErrorXmppMessage(const QXmppMessage &xmppMessage)
 
 QFuture<Self::Result> Self::processReceivedXmppCarbonMessage(const QXmppMessage &xmppMessage)
 {
+    checkReceivedMessagesBacklog();
 
-    return QtConcurrent::run([this, xmppMessage]() -> Result {
+    const auto conversationKey = xmppConversationKey(xmppMessage, true);
+    return m_impl->receivedMessagesExecutor->submit(conversationKey, [this, xmppMessage]() -> Result {
         qCInfo(lcCoreMessenger) << "Received Carbon XMPP message:" << xmppMessage.id();
         qCDebug(lcCoreMessenger) << "Received Carbon XMPP message:" << xmppMessage.id()
                                  << "from:" << xmppMessage.from();
@@ -1916,7 +2604,7 @@ Self::Result Self::processChatReceivedXmppCarbonMessage(const QXmppMessage &xmpp
     //
     //  Decode message body from Base64 and JSON.
     //
-    auto ciphertextResult = unpackXmppMessageBody(xmppMessage.body());
+    auto ciphertextResult = MessagePacking::unpackXmppMessageBody(xmppMessage.body());
     if (auto status = std::get_if<CoreMessengerStatus>(&ciphertextResult)) {
         return *status;
     }
@@ -1951,7 +2639,7 @@ Self::Result Self::processChatReceivedXmppCarbonMessage(const QXmppMessage &xmpp
     //
     //  Unpack message.
     //
-    if (auto result = unpackMessage(plaintextData, *message); result != Self::Result::Success) {
+    if (auto result = MessagePacking::unpackMessage(plaintextData, *message); result != Self::Result::Success) {
         return result;
     }
 
@@ -1986,7 +2674,7 @@ Self::Result Self::processGroupChatReceivedXmppCarbonMessage(const QXmppMessage
     //
     //  Decode message body from Base64 and JSON.
     //
-    auto ciphertextResult = unpackXmppMessageBody(xmppMessage.body());
+    auto ciphertextResult = MessagePacking::unpackXmppMessageBody(xmppMessage.body());
     if (auto status = std::get_if<CoreMessengerStatus>(&ciphertextResult)) {
         return *status;
     }
@@ -2018,7 +2706,7 @@ Self::Result Self::processGroupChatReceivedXmppCarbonMessage(const QXmppMessage
     //
     //  Unpack message.
     //
-    if (auto result = unpackMessage(plaintextData, *message); result != Self::Result::Success) {
+    if (auto result = MessagePacking::unpackMessage(plaintextData, *message); result != Self::Result::Success) {
         return result;
     }
 
@@ -2036,6 +2724,11 @@ Self::Result Self::processGroupChatReceivedXmppCarbonMessage(const QXmppMessage
 std::tuple<Self::Result, QByteArray, QByteArray> Self::encryptFile(const QString &sourceFilePath,
                                                                    const QString &destFilePath)
 {
+    TraceSpan traceSpan("crypto", QStringLiteral("encryptFile"), { { "path", sourceFilePath } });
+    static const auto metrics = cryptoMetrics(QStringLiteral("encryptFile"));
+    metrics.bytes->increment(QFileInfo(sourceFilePath).size());
+    MetricLatencyTimer latencyTimer(metrics.latency);
+
     //
     //  Create helpers for error handling.
     //
@@ -2196,6 +2889,11 @@ std::tuple<Self::Result, QByteArray, QByteArray> Self::encryptFile(const QString
 Self::Result Self::decryptFile(const QString &sourceFilePath, const QString &destFilePath,
                                const QByteArray &decryptionKey, const QByteArray &signature, const UserId senderId)
 {
+    TraceSpan traceSpan("crypto", QStringLiteral("decryptFile"), { { "path", sourceFilePath } });
+    static const auto metrics = cryptoMetrics(QStringLiteral("decryptFile"));
+    metrics.bytes->increment(QFileInfo(sourceFilePath).size());
+    MetricLatencyTimer latencyTimer(metrics.latency);
+
     //
     //  Create helpers for error handling.
     //
@@ -2339,23 +3037,57 @@ Self::Result Self::decryptFile(const QString &sourceFilePath, const QString &des
 void Self::xmppOnConnected()
 {
     m_impl->lastActivityManager->setEnabled(true);
+    m_impl->reconnectScheduler->connected();
+
+    const auto connectLatency = std::chrono::milliseconds(
+            m_impl->xmppConnectTimer.isValid() ? m_impl->xmppConnectTimer.elapsed() : 0);
+    m_impl->xmppConnectTimer.invalidate();
+
+    const bool isResumeExpected = std::exchange(m_impl->isXmppResumeExpected, false);
 
     //
-    //  TODO: Extract to a method
+    //  Resumed session keeps presence and push registration on the server,
+    //  and unacknowledged stanzas are replayed by the server, so no resync is required.
+    //  Rooms are left locally when the connection drops, so they are joined again in both cases.
+    //  Pending messages are sent by the queue when the connection state is changed to connected.
     //
-    for (auto xmppRoom : m_impl->xmppGroupChatManager->rooms()) {
-        if (xmppRoom->isJoined()) {
-            qCDebug(lcCoreMessenger) << "XMPP room is already joined:" << xmppRoom->jid();
-        } else {
-            qCDebug(lcCoreMessenger) << "Re-join XMPP room:" << xmppRoom->jid();
-            if (xmppRoom->join()) {
-                qCDebug(lcCoreMessenger) << "Sent request to join XMPP room:" << xmppRoom->jid();
-            } else {
-                qCDebug(lcCoreMessenger) << "Failed to sent request to join XMPP room:" << xmppRoom->jid();
-            }
+    if (isXmppStreamResumed()) {
+        {
+            std::scoped_lock<std::mutex> _(m_impl->xmppSessionStatsMutex);
+            ++m_impl->xmppSessionStats.resumedCount;
+            m_impl->xmppSessionStats.lastResumeLatency = connectLatency;
         }
+        recordXmppConnectMetrics(QStringLiteral("resumed"), connectLatency);
+        qCInfo(lcCoreMessenger) << "XMPP session was resumed in" << connectLatency.count() << "ms";
+
+        rejoinXmppRooms();
+        changeConnectionState(Self::ConnectionState::Connected);
+        return;
+    }
+
+    //
+    //  Server rejected resumption (session expired or unknown), so the client bound a new session
+    //  and everything is synchronized as after a full reconnect.
+    //
+    if (isResumeExpected) {
+        {
+            std::scoped_lock<std::mutex> _(m_impl->xmppSessionStatsMutex);
+            ++m_impl->xmppSessionStats.resumeRejectedCount;
+        }
+        Metrics::instance()->counter("xmpp_resume_rejected_total")->increment();
+        qCWarning(lcCoreMessenger) << "XMPP session resumption was rejected, do full resync";
     }
 
+    {
+        std::scoped_lock<std::mutex> _(m_impl->xmppSessionStatsMutex);
+        ++m_impl->xmppSessionStats.fullReconnectCount;
+        m_impl->xmppSessionStats.lastFullReconnectLatency = connectLatency;
+    }
+    recordXmppConnectMetrics(QStringLiteral("full"), connectLatency);
+    qCInfo(lcCoreMessenger) << "XMPP session was established in" << connectLatency.count() << "ms";
+
+    rejoinXmppRooms();
+
     changeConnectionState(Self::ConnectionState::Connected);
 
     //
@@ -2375,8 +3107,26 @@ void Self::xmppOnConnected()
 void Self::xmppOnDisconnected()
 {
     m_impl->lastActivityManager->setEnabled(false);
+    m_impl->reconnectScheduler->disconnected();
+
+    //
+    //  Receipts of the messages in flight will not come within this stream.
+    //
+    resetSendWindow();
 
     changeConnectionState(Self::ConnectionState::Disconnected);
+
+    //
+    //  Disconnect requested by the app (network change, suspend) is completed, so reconnect without backoff.
+    //  Connection that was lost or dropped due to an error is reconnected by the scheduler with backoff,
+    //  so clients do not reconnect in a tight loop or in lockstep after a server restart.
+    //
+    if (m_impl->startDisconnectAt.isValid()) {
+        m_impl->startDisconnectAt = QDateTime();
+        emit reconnectXmppServerIfNeeded();
+    } else {
+        m_impl->reconnectScheduler->scheduleRetry();
+    }
 }
 
 void Self::xmppOnStateChanged(QXmppClient::State state)
@@ -2393,7 +3143,17 @@ void Self::xmppOnError(QXmppClient::Error error)
     switch (m_impl->connectionState) {
     case Self::ConnectionState::Connecting:
     case Self::ConnectionState::Connected:
-        disconnectXmppServer();
+        //
+        //  Stream error closes the stream anyway, other errors (keep-alive timeout, socket error)
+        //  leave the session on the server, so it is resumed with the next connection.
+        //
+        if (error == QXmppClient::XmppStreamError || !abortResumableXmppConnection()) {
+            disconnectXmppServer();
+        }
+        //
+        //  Disconnect is not requested by the app, so it must not bypass the scheduled retry.
+        //
+        m_impl->startDisconnectAt = QDateTime();
         break;
 
     case Self::ConnectionState::Disconnected:
@@ -2402,9 +3162,15 @@ void Self::xmppOnError(QXmppClient::Error error)
     }
     emit connectionStateChanged(Self::ConnectionState::Error);
 
-    // Wait 10 second and try to reconnect.
-    qCDebug(lcCoreMessenger) << "Emit reconnect in 10s from: xmppOnError()";
-    QTimer::singleShot(10000, this, &Self::reconnectXmppServerIfNeeded);
+    //
+    //  Token might be rejected, so request a new one with the next attempt.
+    //
+    if (error == QXmppClient::XmppStreamError
+        && m_impl->xmpp->xmppStreamError() == QXmppStanza::Error::NotAuthorized) {
+        m_impl->xmppPassword.clear();
+    }
+
+    m_impl->reconnectScheduler->scheduleRetry();
 }
 
 void Self::xmppOnPresenceReceived(const QXmppPresence &presence)
@@ -2422,13 +3188,15 @@ void Self::xmppOnSslErrors(const QList<QSslError> &errors)
     qCWarning(lcCoreMessenger) << "XMPP SSL errors:" << errors;
     emit connectionStateChanged(Self::ConnectionState::Error);
 
-    // Wait 10 second and try to reconnect.
-    qCDebug(lcCoreMessenger) << "Emit reconnect in 10s from: xmppOnSslErrors()";
-    QTimer::singleShot(10000, this, &Self::reconnectXmppServerIfNeeded);
+    m_impl->reconnectScheduler->scheduleRetry();
 }
 
 void Self::xmppOnMessageReceived(const QXmppMessage &xmppMessage)
 {
+    Tracer::instance()->addInstant("xmpp", QStringLiteral("messageReceived"), { { "messageId", xmppMessage.id() } });
+    static auto receivedCounter = Metrics::instance()->counter("xmpp_messages_received_total");
+    receivedCounter->increment();
+
     //
     //  Got non archived message so send 'received' mark.
     //  TODO: Decide if need to filter group chat messages.
@@ -2455,6 +3223,17 @@ void Self::xmppOnMessageReceived(const QXmppMessage &xmppMessage)
     processReceivedXmppMessage(xmppMessage);
 }
 
+void Self::xmppOnClientMessageReceived(const QXmppMessage &xmppMessage)
+{
+    //
+    //  Archived messages and carbons may come from an outdated device or be sent by this account,
+    //  so only live messages update the capability.
+    //
+    rememberCompactEnvelopeCapability(xmppMessage);
+
+    xmppOnMessageReceived(xmppMessage);
+}
+
 void Self::xmppOnCarbonMessageReceived(const QXmppMessage &xmppMessage)
 {
     //
@@ -2466,6 +3245,8 @@ void Self::xmppOnCarbonMessageReceived(const QXmppMessage &xmppMessage)
 void Self::xmppOnMessageDelivered(const QString &jid, const QString &messageId)
 {
     qCDebug(lcCoreMessenger) << "Message delivered to:" << jid;
+    releaseSendWindow(messageId);
+
     OutgoingMessageStageUpdate update;
     update.messageId = MessageId(messageId);
     update.stage = OutgoingMessageStage::Delivered;
@@ -2481,8 +3262,20 @@ void Self::onProcessNetworkState(bool isOnline)
         qCDebug(lcCoreMessenger) << "Network go online.";
         qCDebug(lcCoreMessenger) << "Emit reconnect when network changed";
 
-        emit disconnectXmppServer();
-        emit reconnectXmppServerIfNeeded();
+        //
+        //  Closing the stream drops the session on the server, so the old connection is aborted to resume it.
+        //  Aborted socket is disconnected at once, so the reconnect below does not wait for it.
+        //
+        if (!abortResumableXmppConnection()) {
+            emit disconnectXmppServer();
+        }
+        m_impl->reconnectScheduler->reconnectNow();
+    } else if (isXmppStreamResumable()) {
+        //
+        //  Closing the stream drops the session on the server, so keep it for resumption.
+        //  Dead socket is detected by the keep-alive ping.
+        //
+        qCDebug(lcCoreMessenger) << "Network go offline. Keep XMPP session for resumption.";
     } else {
         qCDebug(lcCoreMessenger) << "Network go offline.";
         emit disconnectXmppServer();
@@ -2510,6 +3303,15 @@ QString Self::requestUploadSlot(const QString &filePath)
     return m_impl->xmppUploadManager->requestUploadSlot(QFileInfo(filePath));
 }
 
+QString Self::requestUploadSlot(const QString &fileName, qint64 fileSize)
+{
+    //
+    //  File is encrypted before the upload, so its content type is never known to the server.
+    //
+    const auto mimeType = QMimeDatabase().mimeTypeForName(QLatin1String("application/octet-stream"));
+    return m_impl->xmppUploadManager->requestUploadSlot(fileName, fileSize, mimeType);
+}
+
 void Self::xmppOnUploadServiceFound()
 {
 
@@ -2565,157 +3367,68 @@ void Self::onLogConnectionStateChanged(CoreMessenger::ConnectionState state)
 // --------------------------------------------------------------------------
 //  Message processing helpers.
 // --------------------------------------------------------------------------
-QByteArray Self::packMessage(const MessageHandler &message)
+QByteArray Self::packMessage(const MessageHandler &message, bool isCompactEnvelope) const
 {
-    //
-    //  Pack message to JSON.
-    //
-    QJsonObject messageJson;
-    messageJson.insert("version", "v3");
-    messageJson.insert("timestamp", static_cast<qint64>(message->createdAt().toTime_t()));
-    messageJson.insert("from", message->senderUsername());
-    messageJson.insert("to", message->recipientUsername());
-    messageJson.insert("content", MessageContentJsonUtils::to(message->content()));
-
-    return MessageContentJsonUtils::toBytes(messageJson);
+    return MessagePacking::packMessage(*message, isCompactEnvelope, m_impl->settings->messageCompressionThreshold());
 }
 
-CoreMessengerStatus Self::unpackMessage(const QByteArray &messageData, Message &message)
+bool Self::isCompactEnvelopeSupported(const UserId &recipientId) const
 {
-    //
-    //  Parse message.
-    //
-    const auto messageJsonDocument = QJsonDocument::fromJson(messageData);
-    if (messageJsonDocument.isNull()) {
-        qCWarning(lcCoreMessenger) << "Got invalid message format - not a JSON";
-        return Self::Result::Error_InvalidMessageFormat;
-    }
-
-    const auto messageJson = messageJsonDocument.object();
-
-    //
-    //  Check version and timestamp.
-    //
-    const auto version = messageJson["version"].toString();
-    if (version != "v3") {
-        qCWarning(lcCoreMessenger) << "Got invalid message - unsupported version, expected v3, got" << version;
-        return Self::Result::Error_InvalidMessageVersion;
-    }
-
-    const auto timestamp = messageJson["timestamp"].toVariant().value<uint>();
-    if (auto xmppStamp = message.createdAt().toTime_t(); timestamp != xmppStamp) {
-        qCWarning(lcCoreMessenger) << "Got invalid message - timestamp mismatch. Expected" << timestamp << ", xmpp"
-                                   << xmppStamp;
-        message.setCreatedAt(QDateTime::fromTime_t(timestamp));
+    if (!m_impl->settings->compactMessageEnvelopeEnabled()) {
+        return false;
     }
 
     //
-    //  Get sender and recipient usernames.
+    //  The message is encrypted once for all devices, so every known device must understand the envelope.
     //
-    auto senderUsername = messageJson["from"].toString();
-    if (senderUsername.isEmpty()) {
-        qCWarning(lcCoreMessenger) << "Got invalid message - missing 'from' username";
-        return Self::Result::Error_InvalidMessageFormat;
-    }
-
-    message.setSenderUsername(std::move(senderUsername));
-
-    auto recipientUsername = messageJson["to"].toString();
-    if (!recipientUsername.isEmpty()) {
-        message.setRecipientUsername(std::move(recipientUsername));
+    std::scoped_lock _(m_impl->compactEnvelopePeersMutex);
+    const auto devicesIt = m_impl->compactEnvelopePeerDevices.find(recipientId);
+    if (devicesIt == m_impl->compactEnvelopePeerDevices.cend()) {
+        return false;
     }
 
-    //
-    //  Parse content.
-    //
-    const auto contentJson = messageJson["content"].toObject();
-    if (contentJson.isEmpty()) {
-        qCWarning(lcCoreMessenger) << "Got invalid message - missing content";
-        return Self::Result::Error_InvalidMessageFormat;
-    }
-
-    QString errorString;
-    auto content = MessageContentJsonUtils::from(contentJson, errorString);
-
-    if (std::get_if<std::monostate>(&content)) {
-        qCWarning(lcCoreMessenger) << "Got invalid message - invalid content:" << errorString;
-        return Self::Result::Error_InvalidMessageFormat;
-    }
-
-    message.setContent(std::move(content));
-
-    qCDebug(lcCoreMessenger) << "Received XMPP message was unpacked:" << message.id();
-
-    return Self::Result::Success;
+    const auto &devices = devicesIt->second;
+    return std::all_of(devices.cbegin(), devices.cend(), [](const auto &device) { return device.second; });
 }
 
-QByteArray Self::packXmppMessageBody(const QByteArray &messageCiphertext, PushType pushType)
+void Self::addCompactEnvelopeCapability(QXmppMessage &xmppMessage) const
 {
     //
-    //  Pack to JSON and return Base64 string.
+    //  Receiving is always supported, so every client advertises it regardless of the sending switch.
     //
-    QJsonObject messageBodyJson;
-
-    switch (pushType) {
-    case PushType::None:
-        messageBodyJson["pushType"] = "none";
-        break;
-
-    case PushType::Alert:
-        messageBodyJson["pushType"] = "alert";
-        break;
-
-    case PushType::Voip:
-        messageBodyJson["pushType"] = "voip";
-        break;
-    }
+    QXmppElement capabilityElement;
+    capabilityElement.setTagName("envelope");
+    capabilityElement.setAttribute("xmlns", MessageEnvelope::kCapabilityNamespace);
 
-    messageBodyJson["ciphertext"] = QString::fromLatin1(messageCiphertext.toBase64());
-
-    return MessageContentJsonUtils::toBytes(messageBodyJson).toBase64();
+    auto extensions = xmppMessage.extensions();
+    extensions << capabilityElement;
+    xmppMessage.setExtensions(extensions);
 }
 
-std::variant<CoreMessengerStatus, QByteArray> Self::unpackXmppMessageBody(const QString &xmppMessageBody)
+void Self::rememberCompactEnvelopeCapability(const QXmppMessage &xmppMessage)
 {
     //
-    //  Decode message body from Base64 and JSON.
+    //  Only chat messages advertise the capability, receipts and other markers do not carry it.
     //
-    auto messageBody = xmppMessageBody.toLatin1();
-    if (messageBody.isEmpty()) {
-        qCWarning(lcCoreMessenger) << "Got invalid XMPP message - body is empty";
-        return Self::Result::Error_InvalidMessageFormat;
-    }
-
-    auto messageBodyJsonString = QByteArray::fromBase64Encoding(messageBody);
-    if (!messageBodyJsonString) {
-        qCWarning(lcCoreMessenger) << "Got invalid XMPP message - body is not Base64";
-        return Self::Result::Error_InvalidMessageFormat;
-    }
-
-    const auto messageBodyJsonDocument = QJsonDocument::fromJson(*messageBodyJsonString);
-    if (messageBodyJsonDocument.isNull()) {
-        qCWarning(lcCoreMessenger) << "Got invalid XMPP message - body is not JSON within Base64";
-        return Self::Result::Error_InvalidMessageFormat;
+    if (xmppMessage.type() != QXmppMessage::Type::Chat || xmppMessage.body().isEmpty()
+        || xmppMessage.marker() != QXmppMessage::Marker::NoMarker) {
+        return;
     }
 
-    const auto messageBodyJson = messageBodyJsonDocument.object();
-
-    //
-    //  Get ciphertext.
-    //
-    const auto ciphertextBase64 = messageBodyJson["ciphertext"].toString();
-    if (ciphertextBase64.isEmpty()) {
-        qCWarning(lcCoreMessenger) << "Got invalid XMPP message - empty ciphertext";
-        return Self::Result::Error_InvalidMessageCiphertext;
+    const auto resource = QXmppUtils::jidToResource(xmppMessage.from());
+    const auto senderId = userIdFromJid(xmppMessage.from());
+    if (resource.isEmpty() || !senderId.isValid()) {
+        return;
     }
 
-    auto ciphertextDecoded = QByteArray::fromBase64Encoding(ciphertextBase64.toLatin1());
-    if (!ciphertextDecoded) {
-        qCWarning(lcCoreMessenger) << "Got invalid XMPP message - ciphertext is not base64 encoded";
-        return Self::Result::Error_InvalidMessageCiphertext;
-    }
+    const auto extensions = xmppMessage.extensions();
+    const auto isSupported = std::any_of(extensions.cbegin(), extensions.cend(), [](const QXmppElement &element) {
+        return element.tagName() == QLatin1String("envelope")
+                && element.attribute("xmlns") == QLatin1String(MessageEnvelope::kCapabilityNamespace);
+    });
 
-    return *ciphertextDecoded;
+    std::scoped_lock _(m_impl->compactEnvelopePeersMutex);
+    m_impl->compactEnvelopePeerDevices[senderId][resource] = isSupported;
 }
 
 // --------------------------------------------------------------------------
@@ -3057,7 +3770,8 @@ void Self::xmppOnCreateGroupChat(const GroupHandler &group, const GroupMembers &
                     invitationMessage->setGroupChatInfo(std::make_unique<MessageGroupChatInfo>(group->id()));
                     invitationMessage->setCreatedNow();
 
-                    auto invitationMessageData = packMessage(invitationMessage);
+                    auto invitationMessageData =
+                            packMessage(invitationMessage, isCompactEnvelopeSupported(memberId));
 
                     auto encryptedInvitationMessageResult = encryptPersonalMessage(memberId, invitationMessageData);
 
@@ -3066,8 +3780,8 @@ void Self::xmppOnCreateGroupChat(const GroupHandler &group, const GroupMembers &
                         continue;
                     }
 
-                    auto encryptedInvitationMessage =
-                            std::get_if<QByteArray>(&encryptedInvitationMessageResult)->toBase64();
+                    auto encryptedInvitationMessage = EncodingUtils::toBase64(
+                            *std::get_if<QByteArray>(&encryptedInvitationMessageResult));
 
                     if (room->sendInvitation(userIdToJid(memberId), encryptedInvitationMessage)) {
                         qCDebug(lcCoreMessenger) << "User was invited:" << memberId;
@@ -3158,7 +3872,7 @@ void Self::xmppOnMucInvitationReceived(const QString &roomJid, const QString &in
         //
         //  Decode from Base64.
         //
-        auto maybeEncryptedInvitationMessage = QByteArray::fromBase64Encoding(reason.toLatin1());
+        auto maybeEncryptedInvitationMessage = EncodingUtils::fromBase64(reason);
         if (!maybeEncryptedInvitationMessage) {
             qCDebug(lcCoreMessenger) << "Received invitation that is not Base64 encoded.";
             return;
@@ -3184,7 +3898,7 @@ void Self::xmppOnMucInvitationReceived(const QString &roomJid, const QString &in
         //
         //  Unpack message.
         //
-        if (auto result = unpackMessage(messageData, *message); result != Self::Result::Success) {
+        if (auto result = MessagePacking::unpackMessage(messageData, *message); result != Self::Result::Success) {
             return;
         }
 
@@ -3469,16 +4183,13 @@ const Self::GroupImplHandler Self::findGroupInCache(const GroupId &groupId) cons
     return nullptr;
 }
 
-std::variant<CoreMessengerStatus, QByteArray> Self::encryptGroupMessage(const GroupId &groupId,
+std::variant<CoreMessengerStatus, QByteArray> Self::encryptGroupMessage(const GroupImplHandler &group,
                                                                         const QByteArray &messageData)
 {
-    //
-    //  Find group.
-    //
-    auto group = findGroupInCache(groupId);
-    if (!group || !group->commKitGroup) {
-        return Self::Result::Error_GroupNotLoaded;
-    }
+    TraceSpan traceSpan("crypto", QStringLiteral("encryptGroupMessage"), { { "size", messageData.size() } });
+    static const auto metrics = cryptoMetrics(QStringLiteral("encryptGroupMessage"));
+    metrics.bytes->increment(messageData.size());
+    MetricLatencyTimer latencyTimer(metrics.latency);
 
     //
     //  Encrypt message.
@@ -3500,6 +4211,10 @@ std::variant<CoreMessengerStatus, QByteArray> Self::encryptGroupMessage(const Gr
 std::variant<CoreMessengerStatus, QByteArray> Self::decryptGroupMessage(const GroupId &groupId, const UserId &senderId,
                                                                         const QByteArray &encryptedMessageData)
 {
+    TraceSpan traceSpan("crypto", QStringLiteral("decryptGroupMessage"), { { "size", encryptedMessageData.size() } });
+    static const auto metrics = cryptoMetrics(QStringLiteral("decryptGroupMessage"));
+    metrics.bytes->increment(encryptedMessageData.size());
+    MetricLatencyTimer latencyTimer(metrics.latency);
 
     //
     //  Find group.
@@ -3596,18 +4311,15 @@ void Self::xmppOnArchivedMessageReceived(const QString &queryId, const QXmppMess
         }
     }();
 
-    auto future = [this, &message, &senderId]() {
-        if (senderId == currentUser()->id()) {
-            return processReceivedXmppCarbonMessage(message);
-        } else {
-            return processReceivedXmppMessage(message);
-        }
-    }();
-
     //
-    //  Archived messages should be processed sequentially to grantee correct order of messages and it's marks.
+    //  Archived messages of a conversation are processed sequentially by its strand,
+    //  so there is no need to wait for them here.
     //
-    future.waitForFinished();
+    if (senderId == currentUser()->id()) {
+        processReceivedXmppCarbonMessage(message);
+    } else {
+        processReceivedXmppMessage(message);
+    }
 }
 
 void Self::xmppOnArchivedResultsRecieved(const QString &queryId, const QXmppResultSetReply &resultSetReply,
@@ -3621,21 +4333,43 @@ void Self::xmppOnArchivedResultsRecieved(const QString &queryId, const QXmppResu
     Q_ASSERT(queryParamIt != m_impl->historySyncQueryParams.cend());
     const auto groupId = queryParamIt->second;
 
-    if (!complete) {
-        QXmppResultSetQuery resultSetQuery;
-        resultSetQuery.setAfter(resultSetReply.last());
-        const auto lastSyncDate = m_impl->settings->chatHistoryLastSyncDate(QString(groupId));
-        const auto toJid = groupId.isValid() ? groupIdToJid(groupId) : QString();
-        const auto syncQueryId =
-                m_impl->xmppMamManager->retrieveArchivedMessages(toJid, {}, {}, lastSyncDate, {}, resultSetQuery);
-        m_impl->historySyncQueryParams[syncQueryId] = groupId;
+    m_impl->historySyncQueryParams.erase(queryParamIt);
 
+    if (!complete) {
+        requestNextArchivedMessages(groupId, resultSetReply.last());
     } else {
-        m_impl->historySyncQueryParams.erase(queryParamIt);
         m_impl->settings->setChatHistoryLastSyncDate(QString(groupId));
     }
 }
 
+void Self::requestNextArchivedMessages(const GroupId &groupId, const QString &after)
+{
+    if (!isXmppConnected()) {
+        //
+        //  Last sync date is not updated, so the history is fetched again after reconnection.
+        //
+        qCDebug(lcCoreMessenger) << "Stop loading history, XMPP is disconnected";
+        return;
+    }
+
+    //
+    //  Pause history fetch until received messages are processed.
+    //
+    if (m_impl->receivedMessagesExecutor->isSaturated()) {
+        QTimer::singleShot(kArchivedMessagesBacklogPollInterval, this,
+                           [this, groupId, after]() { requestNextArchivedMessages(groupId, after); });
+        return;
+    }
+
+    QXmppResultSetQuery resultSetQuery;
+    resultSetQuery.setAfter(after);
+    const auto lastSyncDate = m_impl->settings->chatHistoryLastSyncDate(QString(groupId));
+    const auto toJid = groupId.isValid() ? groupIdToJid(groupId) : QString();
+    const auto syncQueryId =
+            m_impl->xmppMamManager->retrieveArchivedMessages(toJid, {}, {}, lastSyncDate, {}, resultSetQuery);
+    m_impl->historySyncQueryParams[syncQueryId] = groupId;
+}
+
 void Self::onSendMessageStatusDisplayed(const MessageHandler &message)
 {
     Q_ASSERT(message->isIncoming());
@@ -3656,6 +4390,14 @@ void Self::onSendMessageStatusDisplayed(const MessageHandler &message)
         return;
     }
 
+    //
+    //  Only the newest marker within a chat is sent, it marks all previous messages as displayed.
+    //
+    m_impl->displayedMarkers->push(message);
+}
+
+void Self::onSendDisplayedMarker(const MessageHandler &message)
+{
     QXmppMessage mark;
     mark.setType(QXmppMessage::Chat);
     mark.setTo(userIdToJid(message->senderId()));
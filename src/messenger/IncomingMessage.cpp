@@ -83,5 +83,8 @@ bool Self::applyUpdate(const MessageUpdate &update)
         m_stage = stageUpdate->stage;
         return true;
     }
+    if (std::holds_alternative<IncomingMessageDecryptedUpdate>(update)) {
+        m_stage = Stage::Decrypted;
+    }
     return Message::applyUpdate(update);
 }
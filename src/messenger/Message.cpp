@@ -221,6 +221,13 @@ QString Self::statusString() const
 bool Self::applyUpdate(const MessageUpdate &update)
 {
     std::lock_guard<std::mutex> _(m_updateGuardMutex);
+    if (auto decryptedUpdate = std::get_if<IncomingMessageDecryptedUpdate>(&update)) {
+        const auto &decryptedMessage = decryptedUpdate->decryptedMessage;
+        m_senderUsername = decryptedMessage->senderUsername();
+        m_recipientUsername = decryptedMessage->recipientUsername();
+        m_content = decryptedMessage->content();
+        return true;
+    }
     if (contentIsAttachment()) {
         return contentAsAttachment()->applyUpdate(update);
     }
@@ -35,6 +35,7 @@
 #include "MessageContentJsonUtils.h"
 
 #include "MessageContentType.h"
+#include "EncodingUtils.h"
 
 using namespace vm;
 using Self = MessageContentJsonUtils;
@@ -187,10 +188,10 @@ bool Self::readAttachment(const QJsonObject &jsonObject, MessageContentAttachmen
 
 QString MessageContentJsonUtils::toBase64(const QByteArray &bytes)
 {
-    return QString::fromUtf8(bytes.toBase64());
+    return QString::fromLatin1(EncodingUtils::toBase64(bytes));
 }
 
 QByteArray MessageContentJsonUtils::fromBase64(const QVariant &str)
 {
-    return QByteArray::fromBase64(str.toString().toUtf8());
+    return EncodingUtils::fromBase64(str.toString()).value_or(QByteArray());
 }
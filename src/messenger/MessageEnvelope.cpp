@@ -0,0 +1,354 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "MessageEnvelope.h"
+
+#include <QtEndian>
+
+#include <zlib.h>
+
+using namespace vm;
+using Self = MessageEnvelope;
+
+namespace {
+constexpr char kMagic[] = { 'V', 'M' };
+constexpr int kHeaderSize = sizeof(kMagic) + 1;
+
+enum class MessageTag : quint8 { Timestamp = 1, From = 2, To = 3, Content = 4, DeflatedContent = 5 };
+
+constexpr int kCompressionLevel = 6;
+constexpr int kCompressedSizeHeaderSize = sizeof(quint32);
+
+enum class BodyTag : quint8 { PushType = 1, Ciphertext = 2 };
+
+//
+//  Sequential writer of the envelope fields.
+//
+class FieldWriter
+{
+public:
+    explicit FieldWriter(int reserveSize)
+    {
+        m_data.reserve(kHeaderSize + reserveSize);
+        m_data.append(kMagic, sizeof(kMagic));
+        m_data.append(static_cast<char>(Self::kVersion));
+    }
+
+    void write(quint8 tag, const char *value, int size)
+    {
+        m_data.append(static_cast<char>(tag));
+        auto length = static_cast<quint64>(size);
+        do {
+            auto byte = static_cast<quint8>(length & 0x7F);
+            length >>= 7;
+            if (length > 0) {
+                byte |= 0x80;
+            }
+            m_data.append(static_cast<char>(byte));
+        } while (length > 0);
+        m_data.append(value, size);
+    }
+
+    void write(quint8 tag, const QByteArray &value) { write(tag, value.constData(), value.size()); }
+
+    void write(quint8 tag, quint64 value)
+    {
+        const auto bigEndianValue = qToBigEndian(value);
+        write(tag, reinterpret_cast<const char *>(&bigEndianValue), sizeof(bigEndianValue));
+    }
+
+    void write(quint8 tag, quint8 value) { write(tag, reinterpret_cast<const char *>(&value), sizeof(value)); }
+
+    QByteArray data() { return std::move(m_data); }
+
+private:
+    QByteArray m_data;
+};
+
+//
+//  Sequential reader of the envelope fields.
+//  Values point to the source data and are valid while the source data is alive.
+//
+class FieldReader
+{
+public:
+    explicit FieldReader(const QByteArray &data) : m_begin(data.constData()), m_end(data.constData() + data.size())
+    {
+        m_begin += kHeaderSize;
+    }
+
+    //
+    //  Read next field. Return false when there are no more fields or data is malformed.
+    //
+    bool next()
+    {
+        if (m_begin >= m_end) {
+            return false;
+        }
+
+        m_tag = static_cast<quint8>(*m_begin++);
+
+        quint64 length = 0;
+        for (int shift = 0;; shift += 7) {
+            if (m_begin >= m_end || shift > 63) {
+                m_isMalformed = true;
+                return false;
+            }
+            const auto byte = static_cast<quint8>(*m_begin++);
+            length |= static_cast<quint64>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+
+        if (length > static_cast<quint64>(m_end - m_begin)) {
+            m_isMalformed = true;
+            return false;
+        }
+
+        m_value = m_begin;
+        m_valueSize = static_cast<int>(length);
+        m_begin += length;
+        return true;
+    }
+
+    bool isMalformed() const noexcept { return m_isMalformed; }
+
+    quint8 tag() const noexcept { return m_tag; }
+
+    QByteArray bytes() const { return QByteArray(m_value, m_valueSize); }
+
+    QString string() const { return QString::fromUtf8(m_value, m_valueSize); }
+
+    std::optional<quint64> uint64() const
+    {
+        if (m_valueSize != sizeof(quint64)) {
+            return std::nullopt;
+        }
+        return qFromBigEndian<quint64>(m_value);
+    }
+
+    std::optional<quint8> uint8() const
+    {
+        if (m_valueSize != sizeof(quint8)) {
+            return std::nullopt;
+        }
+        return static_cast<quint8>(*m_value);
+    }
+
+private:
+    const char *m_begin;
+    const char *m_end;
+    const char *m_value = nullptr;
+    int m_valueSize = 0;
+    quint8 m_tag = 0;
+    bool m_isMalformed = false;
+};
+
+//
+//  Compress content with Deflate (qCompress format: 4 bytes of the original size followed by zlib stream).
+//  Return std::nullopt if compression does not pay off.
+//
+std::optional<QByteArray> compressContent(const QByteArray &content)
+{
+    auto compressed = qCompress(content, kCompressionLevel);
+    if (compressed.isEmpty() || compressed.size() >= content.size()) {
+        return std::nullopt;
+    }
+    return compressed;
+}
+
+//
+//  Decompress content into a buffer of the declared size, so inflation never allocates more than declared.
+//  Note, qUncompress() is not used because it grows its buffer until the whole stream is inflated.
+//
+std::optional<QByteArray> decompressContent(const QByteArray &compressed)
+{
+    if (compressed.size() <= kCompressedSizeHeaderSize || compressed.size() > Self::kMaxContentSize) {
+        return std::nullopt;
+    }
+
+    const auto declaredSize = qFromBigEndian<quint32>(compressed.constData());
+    if (declaredSize == 0 || declaredSize > static_cast<quint32>(Self::kMaxContentSize)) {
+        return std::nullopt;
+    }
+
+    QByteArray content(static_cast<int>(declaredSize), Qt::Uninitialized);
+
+    z_stream stream {};
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.constData() + kCompressedSizeHeaderSize));
+    stream.avail_in = static_cast<uInt>(compressed.size() - kCompressedSizeHeaderSize);
+    stream.next_out = reinterpret_cast<Bytef *>(content.data());
+    stream.avail_out = static_cast<uInt>(declaredSize);
+    if (inflateInit(&stream) != Z_OK) {
+        return std::nullopt;
+    }
+
+    //
+    //  Stream that does not end within the buffer inflates to more than declared, or it is truncated.
+    //
+    const auto status = inflate(&stream, Z_FINISH);
+    const auto inflatedSize = stream.total_out;
+    inflateEnd(&stream);
+    if (status != Z_STREAM_END || inflatedSize != declaredSize) {
+        return std::nullopt;
+    }
+    return content;
+}
+} // namespace
+
+bool Self::isEnvelope(const QByteArray &data) noexcept
+{
+    return data.size() >= kHeaderSize && data[0] == kMagic[0] && data[1] == kMagic[1]
+            && static_cast<quint8>(data[2]) == kVersion;
+}
+
+QByteArray Self::packMessage(const Message &message, int compressionThreshold)
+{
+    const auto from = message.from.toUtf8();
+    const auto to = message.to.toUtf8();
+
+    FieldWriter writer(32 + from.size() + to.size() + message.content.size());
+    writer.write(static_cast<quint8>(MessageTag::Timestamp), message.timestamp);
+    writer.write(static_cast<quint8>(MessageTag::From), from);
+    if (!to.isEmpty()) {
+        writer.write(static_cast<quint8>(MessageTag::To), to);
+    }
+
+    if (compressionThreshold > 0 && message.content.size() >= compressionThreshold) {
+        if (auto compressedContent = compressContent(message.content)) {
+            writer.write(static_cast<quint8>(MessageTag::DeflatedContent), *compressedContent);
+            return writer.data();
+        }
+    }
+
+    writer.write(static_cast<quint8>(MessageTag::Content), message.content);
+
+    return writer.data();
+}
+
+std::optional<Self::Message> Self::unpackMessage(const QByteArray &data)
+{
+    if (!isEnvelope(data)) {
+        return std::nullopt;
+    }
+
+    Message message;
+    bool hasTimestamp = false;
+
+    FieldReader reader(data);
+    while (reader.next()) {
+        switch (static_cast<MessageTag>(reader.tag())) {
+        case MessageTag::Timestamp:
+            if (auto timestamp = reader.uint64()) {
+                message.timestamp = *timestamp;
+                hasTimestamp = true;
+            }
+            break;
+
+        case MessageTag::From:
+            message.from = reader.string();
+            break;
+
+        case MessageTag::To:
+            message.to = reader.string();
+            break;
+
+        case MessageTag::Content:
+            message.content = reader.bytes();
+            break;
+
+        case MessageTag::DeflatedContent:
+            if (auto content = decompressContent(reader.bytes())) {
+                message.content = std::move(*content);
+            } else {
+                return std::nullopt;
+            }
+            break;
+
+        default:
+            // Unknown field, skip it.
+            break;
+        }
+    }
+
+    if (reader.isMalformed() || !hasTimestamp) {
+        return std::nullopt;
+    }
+
+    return message;
+}
+
+QByteArray Self::packBody(const Body &body)
+{
+    FieldWriter writer(16 + body.ciphertext.size());
+    writer.write(static_cast<quint8>(BodyTag::PushType), body.pushType);
+    writer.write(static_cast<quint8>(BodyTag::Ciphertext), body.ciphertext);
+
+    return writer.data();
+}
+
+std::optional<Self::Body> Self::unpackBody(const QByteArray &data)
+{
+    if (!isEnvelope(data)) {
+        return std::nullopt;
+    }
+
+    Body body;
+
+    FieldReader reader(data);
+    while (reader.next()) {
+        switch (static_cast<BodyTag>(reader.tag())) {
+        case BodyTag::PushType:
+            if (auto pushType = reader.uint8()) {
+                body.pushType = *pushType;
+            }
+            break;
+
+        case BodyTag::Ciphertext:
+            body.ciphertext = reader.bytes();
+            break;
+
+        default:
+            // Unknown field, skip it.
+            break;
+        }
+    }
+
+    if (reader.isMalformed()) {
+        return std::nullopt;
+    }
+
+    return body;
+}
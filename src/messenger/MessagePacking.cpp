@@ -0,0 +1,275 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "MessagePacking.h"
+
+#include "EncodingUtils.h"
+#include "MessageContentJsonUtils.h"
+#include "MessageEnvelope.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcMessagePacking, "message-packing");
+
+using namespace vm;
+using Self = MessagePacking;
+
+QByteArray Self::packMessage(const Message &message, bool isCompactEnvelope, int compressionThreshold)
+{
+    //
+    //  Pack message to the compact binary envelope.
+    //
+    if (isCompactEnvelope) {
+        MessageEnvelope::Message envelope;
+        envelope.timestamp = message.createdAt().toTime_t();
+        envelope.from = message.senderUsername();
+        envelope.to = message.recipientUsername();
+        envelope.content = MessageContentJsonUtils::toBytes(message.content());
+
+        return MessageEnvelope::packMessage(envelope, compressionThreshold);
+    }
+
+    //
+    //  Pack message to JSON.
+    //
+    QJsonObject messageJson;
+    messageJson.insert("version", "v3");
+    messageJson.insert("timestamp", static_cast<qint64>(message.createdAt().toTime_t()));
+    messageJson.insert("from", message.senderUsername());
+    messageJson.insert("to", message.recipientUsername());
+    messageJson.insert("content", MessageContentJsonUtils::to(message.content()));
+
+    return MessageContentJsonUtils::toBytes(messageJson);
+}
+
+CoreMessengerStatus Self::unpackMessage(const QByteArray &messageData, Message &message)
+{
+    uint timestamp = 0;
+    QString senderUsername;
+    QString recipientUsername;
+    MessageContent content;
+    QString errorString;
+
+    if (MessageEnvelope::isEnvelope(messageData)) {
+        //
+        //  Parse compact binary envelope.
+        //
+        auto envelope = MessageEnvelope::unpackMessage(messageData);
+        if (!envelope) {
+            qCWarning(lcMessagePacking) << "Got invalid message format - malformed envelope";
+            return CoreMessengerStatus::Error_InvalidMessageFormat;
+        }
+
+        timestamp = static_cast<uint>(envelope->timestamp);
+        senderUsername = std::move(envelope->from);
+        recipientUsername = std::move(envelope->to);
+
+        if (envelope->content.isEmpty()) {
+            qCWarning(lcMessagePacking) << "Got invalid message - missing content";
+            return CoreMessengerStatus::Error_InvalidMessageFormat;
+        }
+
+        content = MessageContentJsonUtils::fromBytes(envelope->content, errorString);
+
+    } else {
+        //
+        //  Parse message.
+        //
+        const auto messageJsonDocument = QJsonDocument::fromJson(messageData);
+        if (messageJsonDocument.isNull()) {
+            qCWarning(lcMessagePacking) << "Got invalid message format - not a JSON";
+            return CoreMessengerStatus::Error_InvalidMessageFormat;
+        }
+
+        const auto messageJson = messageJsonDocument.object();
+
+        //
+        //  Check version.
+        //
+        const auto version = messageJson["version"].toString();
+        if (version != "v3") {
+            qCWarning(lcMessagePacking) << "Got invalid message - unsupported version, expected v3, got" << version;
+            return CoreMessengerStatus::Error_InvalidMessageVersion;
+        }
+
+        timestamp = messageJson["timestamp"].toVariant().value<uint>();
+        senderUsername = messageJson["from"].toString();
+        recipientUsername = messageJson["to"].toString();
+
+        const auto contentJson = messageJson["content"].toObject();
+        if (contentJson.isEmpty()) {
+            qCWarning(lcMessagePacking) << "Got invalid message - missing content";
+            return CoreMessengerStatus::Error_InvalidMessageFormat;
+        }
+
+        content = MessageContentJsonUtils::from(contentJson, errorString);
+    }
+
+    //
+    //  Check timestamp.
+    //
+    if (auto xmppStamp = message.createdAt().toTime_t(); timestamp != xmppStamp) {
+        qCWarning(lcMessagePacking) << "Got invalid message - timestamp mismatch. Expected" << timestamp << ", xmpp"
+                                   << xmppStamp;
+        message.setCreatedAt(QDateTime::fromTime_t(timestamp));
+    }
+
+    //
+    //  Get sender and recipient usernames.
+    //
+    if (senderUsername.isEmpty()) {
+        qCWarning(lcMessagePacking) << "Got invalid message - missing 'from' username";
+        return CoreMessengerStatus::Error_InvalidMessageFormat;
+    }
+
+    message.setSenderUsername(std::move(senderUsername));
+
+    if (!recipientUsername.isEmpty()) {
+        message.setRecipientUsername(std::move(recipientUsername));
+    }
+
+    //
+    //  Check content.
+    //
+    if (std::get_if<std::monostate>(&content)) {
+        qCWarning(lcMessagePacking) << "Got invalid message - invalid content:" << errorString;
+        return CoreMessengerStatus::Error_InvalidMessageFormat;
+    }
+
+    message.setContent(std::move(content));
+
+    qCDebug(lcMessagePacking) << "Received XMPP message was unpacked:" << message.id();
+
+    return CoreMessengerStatus::Success;
+}
+
+QByteArray Self::packXmppMessageBody(const QByteArray &messageCiphertext, PushType pushType, bool isCompactEnvelope)
+{
+    //
+    //  Pack to the compact binary envelope and return Base64 string.
+    //
+    if (isCompactEnvelope) {
+        MessageEnvelope::Body envelope;
+        envelope.pushType = static_cast<quint8>(pushType);
+        envelope.ciphertext = messageCiphertext;
+
+        return EncodingUtils::toBase64(MessageEnvelope::packBody(envelope));
+    }
+
+    //
+    //  Pack to JSON and return Base64 string.
+    //
+    QJsonObject messageBodyJson;
+
+    switch (pushType) {
+    case PushType::None:
+        messageBodyJson["pushType"] = "none";
+        break;
+
+    case PushType::Alert:
+        messageBodyJson["pushType"] = "alert";
+        break;
+
+    case PushType::Voip:
+        messageBodyJson["pushType"] = "voip";
+        break;
+    }
+
+    messageBodyJson["ciphertext"] = QString::fromLatin1(EncodingUtils::toBase64(messageCiphertext));
+
+    return EncodingUtils::toBase64(MessageContentJsonUtils::toBytes(messageBodyJson));
+}
+
+std::variant<CoreMessengerStatus, QByteArray> Self::unpackXmppMessageBody(const QString &xmppMessageBody)
+{
+    //
+    //  Decode message body from Base64 and JSON.
+    //
+    auto messageBody = xmppMessageBody.toLatin1();
+    if (messageBody.isEmpty()) {
+        qCWarning(lcMessagePacking) << "Got invalid XMPP message - body is empty";
+        return CoreMessengerStatus::Error_InvalidMessageFormat;
+    }
+
+    auto messageBodyJsonString = EncodingUtils::fromBase64(messageBody);
+    if (!messageBodyJsonString) {
+        qCWarning(lcMessagePacking) << "Got invalid XMPP message - body is not Base64";
+        return CoreMessengerStatus::Error_InvalidMessageFormat;
+    }
+
+    //
+    //  Get ciphertext from the compact binary envelope.
+    //
+    if (MessageEnvelope::isEnvelope(*messageBodyJsonString)) {
+        auto envelope = MessageEnvelope::unpackBody(*messageBodyJsonString);
+        if (!envelope) {
+            qCWarning(lcMessagePacking) << "Got invalid XMPP message - malformed envelope";
+            return CoreMessengerStatus::Error_InvalidMessageFormat;
+        }
+
+        if (envelope->ciphertext.isEmpty()) {
+            qCWarning(lcMessagePacking) << "Got invalid XMPP message - empty ciphertext";
+            return CoreMessengerStatus::Error_InvalidMessageCiphertext;
+        }
+
+        return std::move(envelope->ciphertext);
+    }
+
+    const auto messageBodyJsonDocument = QJsonDocument::fromJson(*messageBodyJsonString);
+    if (messageBodyJsonDocument.isNull()) {
+        qCWarning(lcMessagePacking) << "Got invalid XMPP message - body is not JSON within Base64";
+        return CoreMessengerStatus::Error_InvalidMessageFormat;
+    }
+
+    const auto messageBodyJson = messageBodyJsonDocument.object();
+
+    //
+    //  Get ciphertext.
+    //
+    const auto ciphertextBase64 = messageBodyJson["ciphertext"].toString();
+    if (ciphertextBase64.isEmpty()) {
+        qCWarning(lcMessagePacking) << "Got invalid XMPP message - empty ciphertext";
+        return CoreMessengerStatus::Error_InvalidMessageCiphertext;
+    }
+
+    auto ciphertextDecoded = EncodingUtils::fromBase64(ciphertextBase64);
+    if (!ciphertextDecoded) {
+        qCWarning(lcMessagePacking) << "Got invalid XMPP message - ciphertext is not base64 encoded";
+        return CoreMessengerStatus::Error_InvalidMessageCiphertext;
+    }
+
+    return *ciphertextDecoded;
+}
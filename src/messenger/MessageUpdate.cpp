@@ -42,6 +42,8 @@ MessageId vm::MessageUpdateGetMessageId(const MessageUpdate &update)
 {
     if (auto base = std::get_if<IncomingMessageStageUpdate>(&update)) {
         return base->messageId;
+    } else if (auto base = std::get_if<IncomingMessageDecryptedUpdate>(&update)) {
+        return base->messageId;
     } else if (auto base = std::get_if<OutgoingMessageStageUpdate>(&update)) {
         return base->messageId;
     } else if (auto base = std::get_if<MessageAttachmentUploadStageUpdate>(&update)) {
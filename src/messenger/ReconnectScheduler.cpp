@@ -0,0 +1,156 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "ReconnectScheduler.h"
+
+#include "Metrics.h"
+
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+
+#include <algorithm>
+
+Q_LOGGING_CATEGORY(lcReconnectScheduler, "reconnect-scheduler");
+
+using namespace vm;
+using Self = ReconnectScheduler;
+
+Self::ReconnectScheduler(QObject *parent) : QObject(parent)
+{
+    m_retryTimer.setSingleShot(true);
+    connect(&m_retryTimer, &QTimer::timeout, this, &Self::reconnectRequested);
+
+    m_stableTimer.setSingleShot(true);
+    m_stableTimer.setInterval(kStableConnectionInterval);
+    connect(&m_stableTimer, &QTimer::timeout, this, &Self::onConnectionStable);
+}
+
+void Self::scheduleRetry()
+{
+    if (m_retryTimer.isActive()) {
+        return;
+    }
+
+    const auto delay = nextDelay();
+    ++m_failureCount;
+
+    qCDebug(lcReconnectScheduler) << "Reconnect in" << delay.count() << "ms, failures:" << m_failureCount;
+    m_retryTimer.start(delay);
+}
+
+void Self::postpone(std::chrono::milliseconds delay)
+{
+    if (m_retryTimer.isActive()) {
+        return;
+    }
+
+    qCDebug(lcReconnectScheduler) << "Reconnect postponed for" << delay.count() << "ms";
+    m_retryTimer.start(delay);
+}
+
+void Self::reconnectNow()
+{
+    qCDebug(lcReconnectScheduler) << "Reconnect now";
+    reset();
+    emit reconnectRequested();
+}
+
+void Self::reset()
+{
+    m_retryTimer.stop();
+    m_failureCount = 0;
+}
+
+void Self::attemptStarted()
+{
+    if (!m_disconnectedTimer.isValid()) {
+        m_disconnectedTimer.start();
+    }
+
+    static auto attemptCounter = Metrics::instance()->counter("xmpp_reconnect_attempts_total");
+    attemptCounter->increment();
+
+    std::scoped_lock<std::mutex> _(m_statsMutex);
+    ++m_stats.attemptCount;
+}
+
+void Self::connected()
+{
+    m_retryTimer.stop();
+    m_stableTimer.start();
+
+    const auto timeToConnected =
+            std::chrono::milliseconds(m_disconnectedTimer.isValid() ? m_disconnectedTimer.elapsed() : 0);
+    m_disconnectedTimer.invalidate();
+
+    qCDebug(lcReconnectScheduler) << "Connected in" << timeToConnected.count() << "ms";
+
+    std::scoped_lock<std::mutex> _(m_statsMutex);
+    ++m_stats.connectedCount;
+    m_stats.lastTimeToConnected = timeToConnected;
+}
+
+void Self::disconnected()
+{
+    m_stableTimer.stop();
+
+    if (!m_disconnectedTimer.isValid()) {
+        m_disconnectedTimer.start();
+    }
+}
+
+Self::Stats Self::stats() const
+{
+    std::scoped_lock<std::mutex> _(m_statsMutex);
+    return m_stats;
+}
+
+std::chrono::milliseconds Self::nextDelay() const
+{
+    //
+    //  Full jitter: random delay within [0, min(max, base * 2^failures)].
+    //
+    const auto exponent = std::min(m_failureCount, kMaxBackoffExponent);
+    const auto ceiling = std::min<qint64>(kMaxDelay.count(), kBaseDelay.count() * (qint64(1) << exponent));
+    //
+    //  Ceiling does not exceed the max delay, so it fits the 32-bit bound.
+    //
+    return std::chrono::milliseconds(QRandomGenerator::global()->bounded(static_cast<quint32>(ceiling + 1)));
+}
+
+void Self::onConnectionStable()
+{
+    qCDebug(lcReconnectScheduler) << "Connection is stable, reset backoff";
+    m_failureCount = 0;
+}
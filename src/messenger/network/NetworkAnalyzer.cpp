@@ -36,6 +36,7 @@
 
 #include <QDateTime>
 #include <QDebug>
+#include <QNetworkInterface>
 #include <QNetworkSession>
 #include <QThread>
 #include <QTimer>
@@ -43,6 +44,19 @@
 #include <QNetworkSession>
 #include <QLoggingCategory>
 
+#include <algorithm>
+
+#if VS_LINUX
+#    include <QSocketNotifier>
+
+#    include <cerrno>
+
+#    include <linux/netlink.h>
+#    include <linux/rtnetlink.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+#endif
+
 using namespace vm;
 using Self = NetworkAnalyzer;
 
@@ -52,6 +66,41 @@ using Self = NetworkAnalyzer;
 
 Q_LOGGING_CATEGORY(lcNetwork, "network");
 
+//
+//  Return true for IPv4 addresses that can reach other hosts.
+//
+static bool isRoutableIpV4Address(const QHostAddress &address)
+{
+    return address.protocol() == QAbstractSocket::IPv4Protocol && !address.isLoopback() && !address.isBroadcast()
+            && !address.isLinkLocal();
+}
+
+//
+//  Return true for IPv6 addresses of global scope, so IPv6-only networks are reported online.
+//
+static bool isRoutableIpV6Address(const QHostAddress &address)
+{
+    return address.protocol() == QAbstractSocket::IPv6Protocol && address.isGlobal() && !address.isMulticast();
+}
+
+//
+//  Return the first routable IPv4 address, or the first global IPv6 address when there is no IPv4 one.
+//
+static QString selectRoutableAddress(const QList<QHostAddress> &addresses)
+{
+    const auto ipV4It = std::find_if(addresses.cbegin(), addresses.cend(), isRoutableIpV4Address);
+    if (ipV4It != addresses.cend()) {
+        return ipV4It->toString();
+    }
+
+    const auto ipV6It = std::find_if(addresses.cbegin(), addresses.cend(), isRoutableIpV6Address);
+    if (ipV6It != addresses.cend()) {
+        return ipV6It->toString();
+    }
+
+    return {};
+}
+
 #if VS_MACOS || VS_LINUX
 #    pragma GCC diagnostic push
 #    pragma GCC diagnostic ignored "-Wdeprecated-declarations"
@@ -65,6 +114,9 @@ Self::NetworkAnalyzer(QObject *parent) : QObject(parent), m_nwManager(this), m_i
     m_thread = new QThread(this);
     moveToThread(m_thread);
     m_timer.moveToThread(m_thread);
+#if VS_LINUX
+    m_debounceTimer.moveToThread(m_thread);
+#endif
 
     connect(&m_nwManager, SIGNAL(updateCompleted()), this, SLOT(onUpdateCompleted()));
     connect(m_thread, SIGNAL(started()), this, SLOT(onStart()));
@@ -87,10 +139,37 @@ Self::~NetworkAnalyzer()
     if (m_thread->isRunning()) {
         m_thread->quit();
     }
+
+#if VS_LINUX
+    if (m_netlinkSocket >= 0) {
+        ::close(m_netlinkSocket);
+    }
+#endif
 }
 
 void Self::onStart()
 {
+#if VS_LINUX
+    if (startNetlinkMonitor()) {
+        //
+        //  Analyze network when kernel reports changes, and rarely for the heart beat.
+        //
+        m_debounceTimer.setInterval(kDebounceIntervalMs);
+        m_debounceTimer.setSingleShot(true);
+        connect(&m_debounceTimer, &QTimer::timeout, this, &Self::onAnalyzeNetwork);
+
+        m_timer.setInterval(kEventDrivenTimerInterval);
+        m_timer.setSingleShot(false);
+        connect(&m_timer, &QTimer::timeout, this, &Self::onAnalyzeNetwork);
+
+        onAnalyzeNetwork();
+        m_timer.start();
+        return;
+    }
+
+    qCWarning(lcNetwork) << "NetworkAnalyzer: rtnetlink is not available, fallback to polling";
+#endif
+
     m_timer.setInterval(kTimerInterval);
     m_timer.setSingleShot(false);
     connect(&m_timer, SIGNAL(timeout()), &m_nwManager, SLOT(updateConfigurations()));
@@ -115,10 +194,116 @@ bool Self::checkIsNeedStop()
     bool needStop = QThread::currentThread()->isInterruptionRequested();
     if (needStop) {
         m_timer.stop();
+#if VS_LINUX
+        m_debounceTimer.stop();
+        if (m_netlinkNotifier) {
+            m_netlinkNotifier->setEnabled(false);
+        }
+#endif
     }
     return needStop;
 }
 
+#if VS_LINUX
+bool Self::startNetlinkMonitor()
+{
+    m_netlinkSocket = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (m_netlinkSocket < 0) {
+        return false;
+    }
+
+    sockaddr_nl address {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (::bind(m_netlinkSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        ::close(m_netlinkSocket);
+        m_netlinkSocket = -1;
+        return false;
+    }
+
+    m_netlinkNotifier = new QSocketNotifier(m_netlinkSocket, QSocketNotifier::Read, this);
+    connect(m_netlinkNotifier, SIGNAL(activated(int)), this, SLOT(onNetlinkEvent()));
+
+    qCDebug(lcNetwork) << "NetworkAnalyzer: Listen for rtnetlink events";
+    return true;
+}
+
+void Self::onNetlinkEvent()
+{
+    bool hasChanges = false;
+
+    //
+    //  Drain all pending messages, only the fact of the change is important.
+    //
+    alignas(nlmsghdr) char buffer[8192];
+    for (;;) {
+        const auto receivedSize = ::recv(m_netlinkSocket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (receivedSize < 0 && errno == ENOBUFS) {
+            //
+            //  The socket buffer overflowed and events were lost, so a full re-scan is required.
+            //
+            qCDebug(lcNetwork) << "NetworkAnalyzer: rtnetlink events were lost, re-scan interfaces";
+            hasChanges = true;
+            continue;
+        }
+
+        if (receivedSize <= 0) {
+            break;
+        }
+
+        auto remainingSize = static_cast<int>(receivedSize);
+        for (auto header = reinterpret_cast<nlmsghdr *>(buffer); NLMSG_OK(header, remainingSize);
+             header = NLMSG_NEXT(header, remainingSize)) {
+            switch (header->nlmsg_type) {
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+                hasChanges = true;
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+    //
+    //  Restart debounce timer, so interface flaps result in a single analysis.
+    //
+    if (hasChanges) {
+        m_debounceTimer.start();
+    }
+}
+#endif
+
+Self::VSQNetworkInterfaceData Self::collectInterfaceAddresses() const
+{
+    VSQNetworkInterfaceData networkInterfaceData;
+
+    const auto requiredFlags = QNetworkInterface::IsUp | QNetworkInterface::IsRunning;
+    for (const auto &networkInterface : QNetworkInterface::allInterfaces()) {
+        if ((networkInterface.flags() & requiredFlags) != requiredFlags
+            || networkInterface.flags().testFlag(QNetworkInterface::IsLoopBack)) {
+            continue;
+        }
+
+        printNetworkInterface(networkInterface);
+
+        QList<QHostAddress> addresses;
+        for (const auto &entry : networkInterface.addressEntries()) {
+            addresses.append(entry.ip());
+        }
+
+        const auto address = selectRoutableAddress(addresses);
+        if (!address.isEmpty()) {
+            networkInterfaceData.insert(networkInterface.index(), address);
+        }
+    }
+
+    return networkInterfaceData;
+}
+
 void Self::onAnalyzeNetwork()
 {
     bool currentState = false;
@@ -127,58 +312,62 @@ void Self::onAnalyzeNetwork()
 
     VSQNetworkInterfaceData currenNetworkInterfaceData;
 
+#if VS_LINUX
+    const bool isEventDriven = m_netlinkNotifier != nullptr;
+#else
+    const bool isEventDriven = false;
+#endif
+
+    if (isEventDriven) {
+        currenNetworkInterfaceData = collectInterfaceAddresses();
+        currentState = !currenNetworkInterfaceData.isEmpty();
+    }
 #if !VS_ANDROID
-    QList<QNetworkConfiguration> networkConfigurations = m_nwManager.allConfigurations();
-    for (const QNetworkConfiguration &configuration : networkConfigurations) {
+    else {
+        QList<QNetworkConfiguration> networkConfigurations = m_nwManager.allConfigurations();
+        for (const QNetworkConfiguration &configuration : networkConfigurations) {
 
-        if (checkIsNeedStop()) {
-            return;
-        }
+            if (checkIsNeedStop()) {
+                return;
+            }
 
-        QNetworkSession session(configuration, this);
-        session.open();
-        session.waitForOpened(kSessionTimeoutMs);
+            QNetworkSession session(configuration, this);
+            session.open();
+            session.waitForOpened(kSessionTimeoutMs);
 
-        if (!session.isOpen()) {
-            continue;
-        }
+            if (!session.isOpen()) {
+                continue;
+            }
 
-        if (!configuration.isValid()) {
-            qCDebug(lcNetwork).noquote() << "NetworkAnalyzer: Network configuration is not valid, skipped...";
-            continue;
-        }
+            if (!configuration.isValid()) {
+                qCDebug(lcNetwork).noquote() << "NetworkAnalyzer: Network configuration is not valid, skipped...";
+                continue;
+            }
 
-        printConfiguration(configuration);
-        printSession(session);
+            printConfiguration(configuration);
+            printSession(session);
 
-        if (session.state() == QNetworkSession::Connected) {
-            QNetworkInterface networkInterface = session.interface();
+            if (session.state() == QNetworkSession::Connected) {
+                QNetworkInterface networkInterface = session.interface();
 
-            if (networkInterface.isValid()) {
-                printNetworkInterface(networkInterface);
+                if (networkInterface.isValid()) {
+                    printNetworkInterface(networkInterface);
 
-                QString ipV4Address;
-                auto networkAddresses = networkInterface.allAddresses();
-                for (const auto &entry : networkAddresses) {
-                    if (entry.isLoopback() || entry.isBroadcast() || entry.isLinkLocal()
-                        || entry.protocol() != QAbstractSocket::IPv4Protocol) {
-                        continue;
-                    }
-                    ipV4Address = entry.toString();
-                    break;
-                }
+                    const auto ipAddress = selectRoutableAddress(networkInterface.allAddresses());
 
 #    if DEBUG_NETWORK
-                qCDebug(lcNetwork).noquote().nospace() << "NetworkAnalyzer: QNetworkAddressEntry, Ip: " << ipV4Address;
+                    qCDebug(lcNetwork).noquote().nospace()
+                            << "NetworkAnalyzer: QNetworkAddressEntry, Ip: " << ipAddress;
 #    endif
-                if (!ipV4Address.isEmpty()) {
-                    currenNetworkInterfaceData.insert(networkInterface.index(), ipV4Address);
+                    if (!ipAddress.isEmpty()) {
+                        currenNetworkInterfaceData.insert(networkInterface.index(), ipAddress);
+                    }
                 }
             }
-        }
 
-        if (session.isOpen() && (session.state() == QNetworkSession::Connected)) {
-            currentState = true;
+            if (session.isOpen() && (session.state() == QNetworkSession::Connected)) {
+                currentState = true;
+            }
         }
     }
 
@@ -187,16 +376,15 @@ void Self::onAnalyzeNetwork()
     currentState = true;
     int i = 0;
     for (const auto &entry : networkAddresses) {
-        if (entry.isLoopback() || entry.isBroadcast() || entry.isLinkLocal()
-            || entry.protocol() != QAbstractSocket::IPv4Protocol) {
+        if (!isRoutableIpV4Address(entry) && !isRoutableIpV6Address(entry)) {
             continue;
         }
-        QString ipV4Address = entry.toString();
+        QString ipAddress = entry.toString();
 #    if DEBUG_NETWORK
-        qCDebug(lcNetwork).noquote().nospace() << "NetworkAnalyzer: QNetworkAddressEntry, Ip: " << ipV4Address;
+        qCDebug(lcNetwork).noquote().nospace() << "NetworkAnalyzer: QNetworkAddressEntry, Ip: " << ipAddress;
 #    endif
-        if (!ipV4Address.isEmpty()) {
-            currenNetworkInterfaceData.insert(i++, ipV4Address);
+        if (!ipAddress.isEmpty()) {
+            currenNetworkInterfaceData.insert(i++, ipAddress);
         }
     }
 
@@ -0,0 +1,348 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+
+#include "models/AttachmentPrefetcher.h"
+
+#include "MessageOperationSource.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+#include <vector>
+
+Q_LOGGING_CATEGORY(lcAttachmentPrefetcher, "attachment-prefetcher");
+
+using namespace vm;
+using Self = AttachmentPrefetcher;
+
+//
+//  Maximum number of prefetches that run within the messages queue at once.
+//
+static constexpr size_t kMaxRunningPrefetches = 2;
+
+//
+//  Pictures received earlier than this number of days are not prefetched until they become visible.
+//
+static constexpr int kMaxArrivedPrefetchAgeDays = 6;
+
+//
+//  Number of pictures received in a closed chat that are prefetched before the chat is opened.
+//
+static constexpr int kInitialChatBudget = 8;
+static constexpr int kMinChatBudget = 2;
+static constexpr int kMaxChatBudget = 64;
+static constexpr int kChatBudgetStep = 4;
+
+Self::AttachmentPrefetcher(QObject *parent) : OperationQueueListener(parent)
+{
+    connect(this, &Self::prefetchFinished, this, &Self::onPrefetchFinished);
+}
+
+void Self::pushArrived(const ModifiableMessageHandler &message)
+{
+    if (!needsPrefetch(message)) {
+        return;
+    }
+
+    if (message->createdAt().addDays(kMaxArrivedPrefetchAgeDays) <= QDateTime::currentDateTime()) {
+        qCDebug(lcAttachmentPrefetcher) << "Message prefetch is outdated. Id:" << message->id()
+                                        << "Date:" << message->createdAt();
+        return;
+    }
+
+    const auto chatId = message->chatId();
+    if (chatId == m_currentChatId) {
+        //
+        //  Chat is opened, so the message is prefetched when it is near the viewport.
+        //
+        return;
+    }
+
+    auto &unseenArrivals = m_unseenArrivals[chatId];
+    if (static_cast<int>(unseenArrivals.size()) >= chatBudget(chatId)) {
+        qCDebug(lcAttachmentPrefetcher) << "Chat prefetch budget is exhausted, skip message:" << message->id();
+        return;
+    }
+
+    unseenArrivals.insert(message->id());
+    enqueue(message, Urgency::Arrived);
+    submitPending();
+}
+
+void Self::pushVisible(const ModifiableMessageHandler &message)
+{
+    if (!needsPrefetch(message)) {
+        return;
+    }
+
+    enqueue(message, Urgency::Visible);
+    submitPending();
+}
+
+void Self::setViewport(const ChatId &chatId, const ModifiableMessages &visibleMessages,
+                       const ModifiableMessages &nearbyMessages)
+{
+    if (chatId != m_currentChatId) {
+        finishChatVisit();
+        m_currentChatId = chatId;
+    }
+
+    //
+    //  Count pictures prefetched on arrival that were actually seen.
+    //
+    if (auto unseenIt = m_unseenArrivals.find(chatId); unseenIt != m_unseenArrivals.end()) {
+        for (const auto &message : visibleMessages) {
+            m_currentChatHits += static_cast<int>(unseenIt->second.erase(message->id()));
+        }
+    }
+
+    //
+    //  Cancel prefetches of messages that are far from the viewport.
+    //
+    std::set<MessageId> inRangeIds;
+    for (const auto &message : visibleMessages) {
+        inRangeIds.insert(message->id());
+    }
+    for (const auto &message : nearbyMessages) {
+        inRangeIds.insert(message->id());
+    }
+    cancelOutOfRange(inRangeIds);
+
+    for (const auto &message : visibleMessages) {
+        if (needsPrefetch(message)) {
+            enqueue(message, Urgency::Visible);
+        }
+    }
+    for (const auto &message : nearbyMessages) {
+        if (needsPrefetch(message)) {
+            enqueue(message, Urgency::Nearby);
+        }
+    }
+
+    submitPending();
+}
+
+void Self::closeViewport()
+{
+    finishChatVisit();
+    m_currentChatId = ChatId();
+    cancelOutOfRange({});
+    submitPending();
+}
+
+void Self::cancelOutOfRange(const std::set<MessageId> &inRangeIds)
+{
+    const auto isOutOfRange = [&inRangeIds](const MessageId &messageId, Urgency urgency) {
+        return urgency != Urgency::Arrived && inRangeIds.count(messageId) == 0;
+    };
+
+    for (auto pendingIt = m_pending.begin(); pendingIt != m_pending.end();) {
+        if (isOutOfRange(pendingIt->first, pendingIt->second.urgency)) {
+            pendingIt = m_pending.erase(pendingIt);
+        } else {
+            ++pendingIt;
+        }
+    }
+
+    {
+        QMutexLocker locker(&m_runningMutex);
+        for (auto &[messageId, runningRequest] : m_running) {
+            if (isOutOfRange(messageId, runningRequest.urgency) && !runningRequest.isCanceled) {
+                qCDebug(lcAttachmentPrefetcher) << "Cancel prefetch of message:" << messageId;
+                runningRequest.isCanceled = true;
+            }
+        }
+    }
+}
+
+bool Self::preRun(OperationSourcePtr source)
+{
+    const auto messageId = prefetchId(source);
+    if (!messageId) {
+        return true;
+    }
+
+    {
+        QMutexLocker locker(&m_runningMutex);
+        const auto runningIt = m_running.find(*messageId);
+        if (runningIt == m_running.end() || !runningIt->second.isCanceled) {
+            return true;
+        }
+    }
+
+    qCDebug(lcAttachmentPrefetcher) << "Skipped canceled prefetch of message:" << *messageId;
+    emit prefetchFinished(*messageId, QPrivateSignal());
+    return false;
+}
+
+void Self::postRun(OperationSourcePtr source)
+{
+    if (const auto messageId = prefetchId(source)) {
+        emit prefetchFinished(*messageId, QPrivateSignal());
+    }
+}
+
+void Self::clear()
+{
+    m_pending.clear();
+    {
+        QMutexLocker locker(&m_runningMutex);
+        m_running.clear();
+    }
+    m_currentChatId = ChatId();
+    m_currentChatHits = 0;
+    m_unseenArrivals.clear();
+}
+
+void Self::onPrefetchFinished(const MessageId &messageId)
+{
+    {
+        QMutexLocker locker(&m_runningMutex);
+        m_running.erase(messageId);
+    }
+    submitPending();
+}
+
+void Self::enqueue(const ModifiableMessageHandler &message, Urgency urgency)
+{
+    {
+        QMutexLocker locker(&m_runningMutex);
+        if (auto runningIt = m_running.find(message->id()); runningIt != m_running.end()) {
+            //
+            //  Message came back to the viewport before its canceled prefetch was skipped.
+            //
+            runningIt->second.isCanceled = false;
+            runningIt->second.urgency = std::min(runningIt->second.urgency, urgency);
+            return;
+        }
+    }
+
+    auto [pendingIt, isInserted] = m_pending.try_emplace(message->id());
+    auto &request = pendingIt->second;
+    if (isInserted || urgency < request.urgency) {
+        request.message = message;
+        request.urgency = urgency;
+        request.order = m_nextOrder++;
+    }
+}
+
+void Self::submitPending()
+{
+    while (!m_pending.empty()) {
+        {
+            QMutexLocker locker(&m_runningMutex);
+            if (m_running.size() >= kMaxRunningPrefetches) {
+                return;
+            }
+        }
+
+        const auto nextIt =
+                std::min_element(m_pending.cbegin(), m_pending.cend(), [](const auto &lhs, const auto &rhs) {
+                    const auto &lhsRequest = lhs.second;
+                    const auto &rhsRequest = rhs.second;
+                    return std::tie(lhsRequest.urgency, lhsRequest.order)
+                            < std::tie(rhsRequest.urgency, rhsRequest.order);
+                });
+
+        const auto request = nextIt->second;
+        m_pending.erase(nextIt);
+
+        {
+            QMutexLocker locker(&m_runningMutex);
+            m_running[request.message->id()] = RunningRequest { request.urgency, false };
+        }
+
+        emit prefetchRequested(request.message);
+    }
+}
+
+void Self::finishChatVisit()
+{
+    if (!m_currentChatId.isValid()) {
+        return;
+    }
+
+    auto &unseenArrivals = m_unseenArrivals[m_currentChatId];
+    const auto wastedCount = static_cast<int>(unseenArrivals.size());
+    const auto hitCount = m_currentChatHits;
+
+    if (hitCount + wastedCount > 0) {
+        auto budget = chatBudget(m_currentChatId);
+        if (wastedCount == 0) {
+            budget = std::min(budget + kChatBudgetStep, kMaxChatBudget);
+        } else if (wastedCount > hitCount) {
+            budget = std::max(budget / 2, kMinChatBudget);
+        }
+        m_chatBudgets[m_currentChatId] = budget;
+
+        qCDebug(lcAttachmentPrefetcher) << "Chat" << QString(m_currentChatId) << "prefetch hits:" << hitCount
+                                        << "wasted:" << wastedCount << "new budget:" << budget;
+    }
+
+    unseenArrivals.clear();
+    m_currentChatHits = 0;
+}
+
+int Self::chatBudget(const ChatId &chatId) const
+{
+    const auto budgetIt = m_chatBudgets.find(chatId);
+    return budgetIt == m_chatBudgets.end() ? kInitialChatBudget : budgetIt->second;
+}
+
+bool Self::needsPrefetch(const MessageHandler &message)
+{
+    if (message->isOutgoing()
+        && (message->status() == MessageStatus::New || message->status() == MessageStatus::Processing)) {
+        return false;
+    }
+
+    const auto picture = std::get_if<MessageContentPicture>(&message->content());
+    return picture && picture->previewOrThumbnailPath().isEmpty();
+}
+
+std::optional<MessageId> Self::prefetchId(const OperationSourcePtr &source)
+{
+    const auto messageSource = dynamic_cast<const MessageOperationSource *>(source.get());
+    if (!messageSource) {
+        return std::nullopt;
+    }
+
+    const auto download = messageSource->download();
+    if (!download || download->type != MessageOperationSource::DownloadParameter::Type::Preload) {
+        return std::nullopt;
+    }
+
+    return messageSource->message()->id();
+}
@@ -110,6 +110,16 @@ void CloudFileOperationSource::setMembers(const CloudFileMembers &members)
     m_members = members;
 }
 
+bool CloudFileOperationSource::forceOnline() const
+{
+    return m_forceOnline;
+}
+
+void CloudFileOperationSource::setForceOnline(bool forceOnline)
+{
+    m_forceOnline = forceOnline;
+}
+
 bool CloudFileOperationSource::isValid() const
 {
     return true;
@@ -121,6 +131,8 @@ QString CloudFileOperationSource::toString() const
     switch (m_type) {
     case Type::ListFolder:
         return str.arg(QLatin1String("ListFolder"));
+    case Type::PrefetchFolder:
+        return str.arg(QLatin1String("PrefetchFolder"));
     case Type::CreateFolder:
         return str.arg(QLatin1String("CreateFolder"));
     case Type::Upload:
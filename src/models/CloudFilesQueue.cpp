@@ -54,11 +54,14 @@ Self::CloudFilesQueue(Messenger *messenger, UserDatabase *userDatabase, QObject
     : OperationQueue(lcCloudFilesQueue(), parent),
       m_messenger(messenger),
       m_userDatabase(userDatabase),
-      m_watcher(new CloudFolderUpdateWatcher(this))
+      m_watcher(new CloudFolderUpdateWatcher(this)),
+      m_prefetcher(new CloudFolderPrefetcher(this))
 {
     connect(m_messenger, &Messenger::signedOut, this, &CloudFilesQueue::stop);
     connect(m_userDatabase, &UserDatabase::opened, this, &Self::start);
     connect(this, &Self::pushListFolder, this, &Self::onPushListFolder);
+    connect(this, &Self::pushPrefetchFolders, m_prefetcher, &CloudFolderPrefetcher::prefetch);
+    connect(m_prefetcher, &CloudFolderPrefetcher::prefetchRequested, this, &Self::onPrefetchRequested);
     connect(this, &Self::pushCreateFolder, this, &Self::onPushCreateFolder);
     connect(this, &Self::pushUploadFile, this, &Self::onPushUploadFile);
     connect(this, &Self::pushDownloadFile, this, &Self::onPushDownloadFile);
@@ -68,6 +71,7 @@ Self::CloudFilesQueue(Messenger *messenger, UserDatabase *userDatabase, QObject
     connect(this, &Self::updateCloudFiles, this, &Self::onUpdateCloudFiles);
 
     addCloudFileListener(m_watcher.data());
+    addCloudFileListener(m_prefetcher.data());
     addCloudFileListener(new UniqueCloudFileFilter(this));
 }
 
@@ -89,11 +93,18 @@ Operation *Self::createOperation(OperationSourcePtr source)
 
     switch (cloudFileSource->type()) {
     case SourceType::ListFolder: {
-        auto listOp = new ListCloudFolderOperation(op, cloudFileSource->folder(), m_userDatabase);
+        const auto mode = cloudFileSource->forceOnline() ? ListCloudFolderOperation::Mode::Refresh
+                                                         : ListCloudFolderOperation::Mode::Navigate;
+        auto listOp = new ListCloudFolderOperation(op, cloudFileSource->folder(), mode, m_userDatabase);
         connect(listOp, &ListCloudFolderOperation::onlineListingFailed, this, &CloudFilesQueue::onlineListingFailed);
+        connect(listOp, &ListCloudFolderOperation::childFoldersOutdated, this, &CloudFilesQueue::pushPrefetchFolders);
         op->appendChild(listOp);
         break;
     }
+    case SourceType::PrefetchFolder:
+        op->appendChild(new ListCloudFolderOperation(op, cloudFileSource->folder(),
+                                                     ListCloudFolderOperation::Mode::Prefetch, m_userDatabase));
+        break;
     case SourceType::CreateFolder:
         op->appendChild(new CreateCloudFolderOperation(op, cloudFileSource->name(), cloudFileSource->folder(),
                                                        cloudFileSource->members()));
@@ -147,11 +158,31 @@ qsizetype Self::maxAttemptCount() const
     return 0;
 }
 
-void Self::onPushListFolder(const CloudFileHandler &parentFolder)
+std::chrono::milliseconds Self::operationDeadline(const QString &operationType) const
+{
+    //
+    //  Cloud file operation includes file transfer, its time depends on file size and rate limits.
+    //
+    if (operationType == QLatin1String("CloudFileOperation") || operationType.contains(QLatin1String("Upload"))
+        || operationType.contains(QLatin1String("Download"))) {
+        return std::chrono::minutes(30);
+    }
+    return OperationQueue::operationDeadline(operationType);
+}
+
+void Self::onPushListFolder(const CloudFileHandler &parentFolder, bool forceOnline)
 {
     auto source = std::make_shared<CloudFileOperationSource>(SourceType::ListFolder);
     source->setPriority(OperationSource::Priority::Highest);
     source->setFolder(parentFolder);
+    source->setForceOnline(forceOnline);
+    addSource(std::move(source));
+}
+
+void Self::onPrefetchRequested(const CloudFileHandler &folder)
+{
+    auto source = std::make_shared<CloudFileOperationSource>(SourceType::PrefetchFolder);
+    source->setFolder(folder);
     addSource(std::move(source));
 }
 
@@ -36,6 +36,8 @@
 
 #include <QFileInfo>
 
+#include <algorithm>
+
 #include "CloudFilesQueue.h"
 #include "FileUtils.h"
 
@@ -43,6 +45,12 @@ using namespace vm;
 
 Q_LOGGING_CATEGORY(lcCloudFilesQueueListener, "cloudfiles-listener");
 
+// Maximum number of folder prefetches that run within the cloud files queue at once
+static constexpr int kMaxRunningFolderPrefetches = 2;
+
+// Maximum number of folders that wait for prefetch
+static constexpr size_t kMaxPendingFolderPrefetches = 32;
+
 bool CloudFilesQueueListener::preRunCloudFile(CloudFileOperationSource *source)
 {
     Q_UNUSED(source)
@@ -265,3 +273,53 @@ void CloudFolderUpdateWatcher::clear()
     QMutexLocker locker(&m_mutex);
     m_items.clear();
 }
+
+CloudFolderPrefetcher::CloudFolderPrefetcher(QObject *parent) : CloudFilesQueueListener(parent)
+{
+    connect(this, &CloudFolderPrefetcher::prefetchFinished, this, &CloudFolderPrefetcher::onPrefetchFinished);
+}
+
+void CloudFolderPrefetcher::prefetch(const CloudFiles &folders)
+{
+    // Children of the previously listed folder are not interesting anymore
+    m_pending.clear();
+    for (auto &folder : folders) {
+        if (m_pending.size() == kMaxPendingFolderPrefetches) {
+            qCDebug(lcCloudFilesQueueListener) << "Too many folders to prefetch, skipped:" << folders.size()
+                                               << "=>" << kMaxPendingFolderPrefetches;
+            break;
+        }
+        m_pending.push_back(folder);
+    }
+    submitPending();
+}
+
+void CloudFolderPrefetcher::postRunCloudFile(CloudFileOperationSource *source)
+{
+    if (source->type() == SourceType::PrefetchFolder) {
+        emit prefetchFinished(QPrivateSignal());
+    }
+}
+
+void CloudFolderPrefetcher::clear()
+{
+    m_pending.clear();
+    m_runningCount = 0;
+}
+
+void CloudFolderPrefetcher::onPrefetchFinished()
+{
+    m_runningCount = std::max(0, m_runningCount - 1);
+    submitPending();
+}
+
+void CloudFolderPrefetcher::submitPending()
+{
+    while (!m_pending.empty() && m_runningCount < kMaxRunningFolderPrefetches) {
+        const auto folder = m_pending.front();
+        m_pending.pop_front();
+        ++m_runningCount;
+        qCDebug(lcCloudFilesQueueListener) << "Prefetching folder:" << folder->name();
+        emit prefetchRequested(folder);
+    }
+}
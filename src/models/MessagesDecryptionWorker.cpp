@@ -0,0 +1,254 @@
+//  Copyright (C) 2015-2020 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+#include "models/MessagesDecryptionWorker.h"
+
+#include "MessagesTable.h"
+#include "UserDatabase.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+
+using namespace vm;
+using Self = MessagesDecryptionWorker;
+
+Q_LOGGING_CATEGORY(lcMessagesDecryptionWorker, "messages-decryption-worker");
+
+Self::MessagesDecryptionWorker(Messenger *messenger, UserDatabase *userDatabase, QObject *parent)
+    : QObject(parent), m_messenger(messenger), m_userDatabase(userDatabase)
+{
+    connect(m_messenger, &Messenger::messageReceived, this, &Self::onMessageReceived);
+    connect(m_messenger, &Messenger::userWasFound, this, &Self::onUserWasFound);
+    connect(m_messenger, &Messenger::onlineStatusChanged, this, &Self::onOnlineStatusChanged);
+    connect(m_messenger, &Messenger::newGroupChatLoaded, this, &Self::onGroupChatLoaded);
+    connect(m_messenger, &Messenger::signedOut, this, &Self::onSignedOut);
+    connect(m_userDatabase, &UserDatabase::opened, this, &Self::onDatabaseOpened);
+}
+
+Self::~MessagesDecryptionWorker()
+{
+    //
+    //  Running batches refer to this worker, so they have to finish first.
+    //
+    for (auto &future : m_decryptionFutures) {
+        future.waitForFinished();
+    }
+}
+
+void Self::onDatabaseOpened()
+{
+    connect(m_userDatabase->messagesTable(), &MessagesTable::encryptedMessagesFetched, this,
+            &Self::onEncryptedMessagesFetched, Qt::UniqueConnection);
+    m_userDatabase->messagesTable()->fetchEncryptedMessages();
+}
+
+void Self::onEncryptedMessagesFetched(const ModifiableMessages &messages)
+{
+    qCDebug(lcMessagesDecryptionWorker) << "Indexed" << messages.size() << "encrypted messages";
+    for (const auto &message : messages) {
+        addPendingMessage(message);
+    }
+
+    if (m_messenger->isOnline()) {
+        decryptAllMessages();
+    }
+}
+
+void Self::onMessageReceived(const ModifiableMessageHandler &message)
+{
+    if (message->contentType() == MessageContentType::Encrypted) {
+        addPendingMessage(message);
+    }
+}
+
+void Self::onUserWasFound(const UserHandler &user)
+{
+    //
+    //  Lookups hit the cache most of the time, so only senders with untried messages start a batch.
+    //
+    decryptSenderMessages(user->id());
+}
+
+void Self::onOnlineStatusChanged(bool isOnline)
+{
+    if (isOnline) {
+        decryptAllMessages();
+    }
+}
+
+void Self::onGroupChatLoaded(const GroupHandler &group)
+{
+    auto groupMessagesIt = m_deferredGroupMessages.find(group->id());
+    if (groupMessagesIt == m_deferredGroupMessages.end()) {
+        return;
+    }
+
+    //
+    //  Group keys are available now, so deferred messages are tried once again.
+    //
+    auto messages = std::move(groupMessagesIt->second);
+    m_deferredGroupMessages.erase(groupMessagesIt);
+    qCDebug(lcMessagesDecryptionWorker) << "Retrying" << messages.size() << "messages of loaded group:" << group->id();
+    for (const auto &message : messages) {
+        m_triedMessageIds.erase(message->id());
+        addPendingMessage(message);
+    }
+    decryptAllMessages();
+}
+
+void Self::onSignedOut()
+{
+    m_pendingMessages.clear();
+    m_pendingMessageIds.clear();
+    m_deferredGroupMessages.clear();
+    m_triedMessageIds.clear();
+    m_processingSenders.clear();
+}
+
+void Self::onSenderMessagesProcessed(const UserId &senderId, const ModifiableMessages &messages,
+                                     bool isSenderFound, const MessageUpdates &messageUpdates)
+{
+    if (m_processingSenders.erase(senderId) == 0) {
+        // Batch was started before sign out.
+        return;
+    }
+
+    //
+    //  Sender was not resolved, so messages were not tried and wait for the next lookup.
+    //
+    if (!isSenderFound) {
+        for (const auto &message : messages) {
+            addPendingMessage(message);
+        }
+        return;
+    }
+
+    //
+    //  Messages that are still encrypted are not tried again on every sender lookup.
+    //
+    for (const auto &message : messages) {
+        const auto isProcessed =
+                std::any_of(messageUpdates.cbegin(), messageUpdates.cend(), [&message](const auto &update) {
+                    return MessageUpdateGetMessageId(update) == message->id();
+                });
+        if (!isProcessed) {
+            deferMessage(message);
+        }
+    }
+
+    if (!messageUpdates.empty()) {
+        qCInfo(lcMessagesDecryptionWorker) << "Processed" << messageUpdates.size() << "encrypted messages from:"
+                                           << senderId;
+        emit messagesDecrypted(messageUpdates);
+    }
+}
+
+void Self::addPendingMessage(const ModifiableMessageHandler &message)
+{
+    if (m_triedMessageIds.count(message->id()) > 0) {
+        return;
+    }
+
+    if (m_pendingMessageIds.insert(message->id()).second) {
+        m_pendingMessages[message->senderId()].push_back(message);
+    }
+}
+
+void Self::deferMessage(const ModifiableMessageHandler &message)
+{
+    m_triedMessageIds.insert(message->id());
+    if (const auto groupChatInfo = message->groupChatInfo()) {
+        m_deferredGroupMessages[groupChatInfo->groupId()].push_back(message);
+    } else {
+        qCDebug(lcMessagesDecryptionWorker) << "Message stays encrypted till the next session:" << message->id();
+    }
+}
+
+void Self::decryptSenderMessages(const UserId &senderId)
+{
+    if (m_processingSenders.count(senderId) > 0) {
+        return;
+    }
+
+    auto senderMessagesIt = m_pendingMessages.find(senderId);
+    if (senderMessagesIt == m_pendingMessages.end()) {
+        return;
+    }
+
+    Messenger *messenger = m_messenger;
+    if (!messenger) {
+        return;
+    }
+
+    auto messages = std::move(senderMessagesIt->second);
+    m_pendingMessages.erase(senderMessagesIt);
+    for (const auto &message : messages) {
+        m_pendingMessageIds.erase(message->id());
+    }
+    m_processingSenders.insert(senderId);
+
+    qCDebug(lcMessagesDecryptionWorker) << "Decrypting" << messages.size() << "messages from:" << senderId;
+
+    m_decryptionFutures.erase(std::remove_if(m_decryptionFutures.begin(), m_decryptionFutures.end(),
+                                             [](const auto &future) { return future.isFinished(); }),
+                              m_decryptionFutures.end());
+
+    //
+    //  The destructor waits for the batch, so the result is passed back to the worker thread safely.
+    //
+    m_decryptionFutures.push_back(QtConcurrent::run([this, messenger, senderId, messages = std::move(messages)]() {
+        auto messageUpdates = messenger->decryptStoredMessages(senderId, messages);
+        QMetaObject::invokeMethod(
+                this,
+                [this, senderId, messages, messageUpdates = std::move(messageUpdates)]() {
+                    onSenderMessagesProcessed(senderId, messages, messageUpdates.has_value(),
+                                              messageUpdates.value_or(MessageUpdates()));
+                },
+                Qt::QueuedConnection);
+    }));
+}
+
+void Self::decryptAllMessages()
+{
+    std::vector<UserId> senderIds;
+    senderIds.reserve(m_pendingMessages.size());
+    for (const auto &[senderId, messages] : m_pendingMessages) {
+        senderIds.push_back(senderId);
+    }
+
+    for (const auto &senderId : senderIds) {
+        decryptSenderMessages(senderId);
+    }
+}
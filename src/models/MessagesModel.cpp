@@ -46,6 +46,11 @@
 using namespace vm;
 using Self = MessagesModel;
 
+//
+//  Number of rows above and below the visible range which messages are considered near the viewport.
+//
+static constexpr int kNearbyRowCount = 10;
+
 Self::MessagesModel(Messenger *messenger, QObject *parent) : ListModel(parent, false), m_messenger(messenger)
 {
     qRegisterMetaType<MessagesModel *>("MessagesModel*");
@@ -98,6 +103,7 @@ MessageHandler Self::getMessage(const int row) const
 void Self::clearChat()
 {
     m_currentChat = nullptr;
+    emit viewportClosed();
 }
 
 void Self::clearMessages()
@@ -149,6 +155,39 @@ QString MessagesModel::lastMessageSenderId() const
     return messageIndex.isValid() ? getMessage(messageIndex.row())->senderId() : QString();
 }
 
+void Self::setVisibleRange(int firstProxyRow, int lastProxyRow)
+{
+    const auto proxyRowCount = m_proxy->rowCount();
+    if (!m_currentChat || proxyRowCount == 0 || firstProxyRow < 0 || lastProxyRow < firstProxyRow) {
+        return;
+    }
+
+    ModifiableMessages visibleMessages;
+    ModifiableMessages nearbyMessages;
+
+    const auto beginRow = std::max(0, firstProxyRow - kNearbyRowCount);
+    const auto endRow = std::min(proxyRowCount - 1, lastProxyRow + kNearbyRowCount);
+    for (auto proxyRow = beginRow; proxyRow <= endRow; ++proxyRow) {
+        const auto index = sourceIndex(proxyRow);
+        if (!index.isValid()) {
+            continue;
+        }
+
+        const auto &message = m_messages.at(index.row());
+        if (message->contentType() != MessageContentType::Picture) {
+            continue;
+        }
+
+        if (proxyRow >= firstProxyRow && proxyRow <= lastProxyRow) {
+            visibleMessages.push_back(message);
+        } else {
+            nearbyMessages.push_back(message);
+        }
+    }
+
+    emit viewportChanged(m_currentChat->id(), visibleMessages, nearbyMessages);
+}
+
 int Self::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
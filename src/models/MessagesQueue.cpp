@@ -34,6 +34,7 @@
 
 #include "models/MessagesQueue.h"
 
+#include "AttachmentPrefetcher.h"
 #include "MessagesQueueListeners.h"
 #include "MessageOperation.h"
 #include "MessageOperationFactory.h"
@@ -52,7 +53,8 @@ Self::MessagesQueue(Messenger *messenger, UserDatabase *userDatabase, QObject *p
     : OperationQueue(lcMessagesQueue(), parent),
       m_messenger(messenger),
       m_userDatabase(userDatabase),
-      m_factory(new MessageOperationFactory(messenger, this))
+      m_factory(new MessageOperationFactory(messenger, this)),
+      m_prefetcher(new AttachmentPrefetcher(this))
 {
     connect(m_messenger, &Messenger::onlineStatusChanged, this, &MessagesQueue::onOnlineStatusChanged);
     connect(m_messenger, &Messenger::signedOut, this, &MessagesQueue::stop);
@@ -60,7 +62,11 @@ Self::MessagesQueue(Messenger *messenger, UserDatabase *userDatabase, QObject *p
     connect(this, &Self::pushMessage, this, &Self::onPushMessage);
     connect(this, &Self::pushMessageDownload, this, &Self::onPushMessageDownload);
     connect(this, &Self::pushMessagePreload, this, &Self::onPushMessagePreload);
+    connect(this, &Self::pushViewport, m_prefetcher, &AttachmentPrefetcher::setViewport);
+    connect(this, &Self::closeViewport, m_prefetcher, &AttachmentPrefetcher::closeViewport);
+    connect(m_prefetcher, &AttachmentPrefetcher::prefetchRequested, this, &Self::onPrefetchRequested);
 
+    addListener(m_prefetcher);
     addListener(new UniqueMessageDownloadOperationFilter(this));
 }
 
@@ -110,6 +116,21 @@ qsizetype Self::maxAttemptCount() const
     return 3;
 }
 
+std::chrono::milliseconds Self::operationDeadline(const QString &operationType) const
+{
+    //
+    //  Message operation includes attachment transfers, their time depends on file size and rate limits.
+    //
+    if (operationType == QLatin1String("MessageOperation") || operationType.contains(QLatin1String("Upload"))
+        || operationType.contains(QLatin1String("Download")) || operationType.contains(QLatin1String("Load"))) {
+        return std::chrono::minutes(30);
+    }
+    if (operationType == QLatin1String("SendMessageOperation")) {
+        return std::chrono::minutes(1);
+    }
+    return OperationQueue::operationDeadline(operationType);
+}
+
 void Self::onDatabaseOpened()
 {
     start();
@@ -137,7 +158,7 @@ void Self::onPushMessage(const ModifiableMessageHandler &message)
 {
     if (message->isIncoming() || message->isOutgoingCopyFromOtherDevice()) {
         if (message->contentType() == MessageContentType::Picture) {
-            pushMessagePreload(message);
+            m_prefetcher->pushArrived(message);
         }
     } else {
         addSource(std::make_shared<MessageOperationSource>(message));
@@ -158,12 +179,11 @@ void Self::onPushMessageDownload(const ModifiableMessageHandler &message, const
 void Self::onPushMessagePreload(const ModifiableMessageHandler &message)
 {
     Q_ASSERT(message->contentType() == MessageContentType::Picture);
-    if (message->createdAt().addDays(6) <= QDateTime::currentDateTime()) {
-        qCDebug(lcMessagesQueue) << "Message preload is outdated. Id:" << message->id()
-                                 << "Date:" << message->createdAt();
-        return;
-    }
+    m_prefetcher->pushVisible(message);
+}
 
+void Self::onPrefetchRequested(const ModifiableMessageHandler &message)
+{
     DownloadParameter parameter;
     parameter.type = DownloadParameter::Type::Preload;
     addSource(std::make_shared<MessageOperationSource>(message, std::move(parameter)));
@@ -40,11 +40,13 @@
 #include "CloudFilesTransfersModel.h"
 #include "CloudFilesQueue.h"
 #include "DiscoveredContactsModel.h"
+#include "MessagesDecryptionWorker.h"
 #include "MessagesModel.h"
 #include "MessagesQueue.h"
 #include "FileLoader.h"
 #include "UserDatabase.h"
 #include "Messenger.h"
+#include "Settings.h"
 
 using namespace vm;
 
@@ -59,11 +61,15 @@ Models::Models(Messenger *messenger, Settings *settings, UserDatabase *userDatab
       m_cloudFilesTransfers(new CloudFilesTransfersModel(this)),
       m_cloudFilesQueue(new CloudFilesQueue(messenger, userDatabase, this)),
       m_fileLoader(messenger->fileLoader()),
-      m_messagesQueue(new MessagesQueue(messenger, userDatabase, this))
+      m_messagesQueue(new MessagesQueue(messenger, userDatabase, this)),
+      m_messagesDecryptionWorker(new MessagesDecryptionWorker(messenger, userDatabase, this))
 
 {
     connect(m_messagesQueue, &MessagesQueue::notificationCreated, this, &Models::notificationCreated);
     connect(m_cloudFilesQueue, &CloudFilesQueue::notificationCreated, this, &Models::notificationCreated);
+
+    m_messagesQueue->setStuckOperationsCancelEnabled(settings->cancelStuckOperationsEnabled());
+    m_cloudFilesQueue->setStuckOperationsCancelEnabled(settings->cancelStuckOperationsEnabled());
 }
 
 Models::~Models() { }
@@ -157,3 +163,13 @@ MessagesQueue *Models::messagesQueue()
 {
     return m_messagesQueue;
 }
+
+const MessagesDecryptionWorker *Models::messagesDecryptionWorker() const
+{
+    return m_messagesDecryptionWorker;
+}
+
+MessagesDecryptionWorker *Models::messagesDecryptionWorker()
+{
+    return m_messagesDecryptionWorker;
+}
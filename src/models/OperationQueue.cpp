@@ -35,21 +35,47 @@
 #include "OperationQueue.h"
 
 #include <QtConcurrent>
+#include <QTimer>
 
+#include "Metrics.h"
 #include "Operation.h"
+#include "OperationMonitor.h"
 
 using namespace vm;
 using Self = OperationQueue;
 
+namespace {
+constexpr std::chrono::seconds kWatchdogInterval(5);
+constexpr std::chrono::minutes kDefaultOperationDeadline(2);
+} // namespace
+
 Self::OperationQueue(const QLoggingCategory &category, QObject *parent)
-    : QObject(parent), m_category(category), m_threadPool(new QThreadPool(this))
+    : QObject(parent),
+      m_category(category),
+      m_threadPool(new QThreadPool(this)),
+      m_monitor(std::make_unique<OperationMonitor>(QString::fromLatin1(category.categoryName()))),
+      m_watchdogTimer(new QTimer(this))
 {
+    const Metrics::Labels labels { { "queue", QString::fromLatin1(category.categoryName()) } };
+    auto metrics = Metrics::instance();
+    m_depthGauge = metrics->gauge("operation_queue_depth", labels);
+    m_retryCounter = metrics->counter("operation_queue_retries_total", labels);
+    m_exhaustedCounter = metrics->counter("operation_queue_exhausted_retries_total", labels);
+    m_runLatency = metrics->histogram("operation_queue_run_microseconds", labels);
+    m_waitLatency = metrics->histogram("operation_queue_wait_microseconds", labels);
+    m_attempts = metrics->histogram("operation_queue_attempts", labels);
+    m_runningGauge = metrics->gauge("operation_queue_running", labels);
+    m_runningMaxGauge = metrics->gauge("operation_queue_running_max", labels);
+
     qRegisterMetaType<vm::OperationSourcePtr>("OperationSourcePtr");
     qRegisterMetaType<vm::OperationQueue::PostFunction>("PostFunction");
 
     m_threadPool->setMaxThreadCount(5);
 
     connect(this, &OperationQueue::operationFailed, this, &OperationQueue::onOperationFailed);
+
+    m_watchdogTimer->setInterval(kWatchdogInterval);
+    connect(m_watchdogTimer, &QTimer::timeout, this, &Self::onWatchdogTimeout);
 }
 
 Self::~OperationQueue()
@@ -60,6 +86,7 @@ Self::~OperationQueue()
 void Self::start()
 {
     m_isStopped = false;
+    m_watchdogTimer->start();
 }
 
 void Self::run()
@@ -79,6 +106,7 @@ void Self::stop()
         listener->clear();
     }
     m_isStopped = true;
+    m_watchdogTimer->stop();
     emit stopRequested(QPrivateSignal());
     m_threadPool->waitForDone();
 }
@@ -94,11 +122,23 @@ void Self::addListener(OperationQueueListenerPtr listener)
     connect(listener, &OperationQueueListener::notificationCreated, this, &Self::notificationCreated);
 }
 
+void Self::setStuckOperationsCancelEnabled(bool enabled)
+{
+    m_isStuckCancelEnabled = enabled;
+}
+
+std::chrono::milliseconds Self::operationDeadline(const QString &operationType) const
+{
+    Q_UNUSED(operationType)
+    return kDefaultOperationDeadline;
+}
+
 void Self::addSourceImpl(OperationSourcePtr source, const bool run)
 {
     if (!source->isValid()) {
         return;
     }
+    source->markEnqueued();
     m_sources.push_back(std::move(source));
     if (run) {
         this->run();
@@ -109,24 +149,44 @@ void Self::runSource(OperationSourcePtr source)
 {
     auto threadPool =
             (source->priority() == OperationSource::Priority::Highest) ? QThreadPool::globalInstance() : &*m_threadPool;
+    m_depthGauge->add(1);
     QtConcurrent::run(threadPool, [=, source = std::move(source)]() {
         // Skip if queue is stopped
         if (m_isStopped) {
             qCDebug(m_category) << "Operation was skipped because queue was stopped";
+            m_depthGauge->add(-1);
             return;
         }
-        // Pre-run listeners
-        for (auto listener : m_listeners) {
-            if (!listener->preRun(source)) {
+        // Pre-run listeners, listeners that accepted the source are notified when another one rejects it
+        for (auto listenerIt = m_listeners.begin(); listenerIt != m_listeners.end(); ++listenerIt) {
+            if (!(*listenerIt)->preRun(source)) {
+                for (auto acceptedIt = m_listeners.begin(); acceptedIt != listenerIt; ++acceptedIt) {
+                    (*acceptedIt)->postRun(source);
+                }
+                m_depthGauge->add(-1);
                 return;
             }
         }
+        m_waitLatency->record(static_cast<quint64>(source->queueWait().count()));
         // Perform operation
         auto op = createOperation(source);
-        op->start();
-        op->waitForDone();
-        if (op->status() == Operation::Status::Failed) {
-            emit operationFailed(source, QPrivateSignal());
+        op->setMonitor(m_monitor.get());
+        const auto runningCount = ++m_runningCount;
+        m_runningGauge->set(runningCount);
+        if (runningCount > m_runningMaxGauge->value()) {
+            m_runningMaxGauge->set(runningCount);
+        }
+        {
+            MetricLatencyTimer latencyTimer(m_runLatency);
+            op->start();
+            op->waitForDone();
+        }
+        m_runningGauge->set(--m_runningCount);
+        if (op->status() == Operation::Status::Finished) {
+            m_attempts->record(static_cast<quint64>(source->attemptCount() + 1));
+        } else if (op->status() == Operation::Status::Failed) {
+            emit operationFailed(source, op->type(), OperationMonitor::failureReasonCode(op), op->failureReason(),
+                                 QPrivateSignal());
         } else if (op->status() == Operation::Status::Invalid) {
             invalidateOperation(source);
         }
@@ -135,17 +195,28 @@ void Self::runSource(OperationSourcePtr source)
         for (auto listener : m_listeners) {
             listener->postRun(source);
         }
+        m_depthGauge->add(-1);
     });
 }
 
-void Self::onOperationFailed(OperationSourcePtr source)
+void Self::onOperationFailed(OperationSourcePtr source, const QString &operationType, const QString &reasonCode,
+                             const QString &reason)
 {
     if (source->attemptCount() < maxAttemptCount()) {
-        qCDebug(m_category) << "Enqueued failed operation source:" << source->toString();
+        qCDebug(m_category) << "Enqueued failed operation source:" << source->toString() << "reason:" << reason;
         source->incAttemptCount();
+        m_retryCounter->increment();
+        m_monitor->recordRetry(operationType, reasonCode, reason);
         addSourceImpl(std::move(source), false);
     } else if (source->attemptCount() == maxAttemptCount()) {
         qCDebug(m_category) << "Failed operation was invalidated:" << source->toString();
+        m_exhaustedCounter->increment();
         invalidateOperation(source);
     }
 }
+
+void Self::onWatchdogTimeout()
+{
+    m_monitor->checkStuckOperations([this](const QString &operationType) { return operationDeadline(operationType); },
+                                    m_isStuckCancelEnabled);
+}
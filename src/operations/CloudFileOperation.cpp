@@ -45,6 +45,7 @@ CloudFileOperation::CloudFileOperation(Messenger *messenger, CloudFolderUpdateWa
     : NetworkOperation(parent, messenger->isOnline()), m_messenger(messenger), m_watcher(watcher)
 {
     setName(QLatin1String("CloudFile(%1)").arg(QString::number(++m_nameCounter)));
+    setTransferPriority(TransferPriority::Background);
 }
 
 Messenger *CloudFileOperation::messenger()
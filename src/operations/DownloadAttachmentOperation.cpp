@@ -51,6 +51,9 @@ Self::DownloadAttachmentOperation(MessageOperation *parent, const Settings *sett
 {
     setName((parameter.type == Parameter::Type::Download) ? QLatin1String("DownloadAttachment")
                                                           : QLatin1String("PreloadAttachment"));
+    if (parameter.type == Parameter::Type::Preload) {
+        setTransferPriority(TransferPriority::Preload);
+    }
 }
 
 bool Self::populateChildren()
@@ -60,7 +60,7 @@ void DownloadFileOperation::run()
     if (!openFileHandle(QFile::WriteOnly)) {
         return;
     }
-    m_fileLoader->startDownload(m_url, fileHandle(),
+    m_fileLoader->startDownload(m_url, fileHandle(), transferPriority(),
                                 std::bind(&DownloadFileOperation::connectReply, this, std::placeholders::_1));
 }
 
@@ -41,6 +41,8 @@
 #include "operations/EncryptFileOperation.h"
 #include "operations/UploadFileOperation.h"
 
+#include <QFileInfo>
+
 using namespace vm;
 
 EncryptUploadFileOperation::EncryptUploadFileOperation(NetworkOperation *parent, Messenger *messenger,
@@ -70,6 +72,11 @@ bool EncryptUploadFileOperation::populateChildren()
     connect(uploadOp, &UploadFileOperation::uploaded, this, &EncryptUploadFileOperation::uploaded);
     appendChild(uploadOp);
 
+    const QFileInfo sourceInfo(m_sourcePath);
+    if (sourceInfo.exists()) {
+        uploadOp->prefetchUploadSlot(sourceInfo.size());
+    }
+
     return true;
 }
 
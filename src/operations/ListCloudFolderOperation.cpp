@@ -44,11 +44,16 @@
 using namespace vm;
 using Self = vm::ListCloudFolderOperation;
 
-Self::ListCloudFolderOperation(CloudFileOperation *parent, const CloudFileHandler &parentFolder,
+// Cached listing of unchanged folder is shown without online listing during this time.
+// Folder date isn't updated when nested folders are changed, so it can't be trusted forever.
+static constexpr qint64 kMaxCachedListingAgeSec = 5 * 60;
+
+Self::ListCloudFolderOperation(CloudFileOperation *parent, const CloudFileHandler &parentFolder, const Mode mode,
                                UserDatabase *userDatabase)
     : Operation(QLatin1String("ListCloudFolder"), parent),
       m_parent(parent),
       m_parentFolder(parentFolder),
+      m_mode(mode),
       m_userDatabase(userDatabase)
 {
     connect(m_userDatabase->cloudFilesTable(), &CloudFilesTable::fetched, this, &Self::onDatabaseListFetched);
@@ -66,13 +71,24 @@ void ListCloudFolderOperation::onCloudListFetched(const CloudFileRequestId reque
                                                   const ModifiableCloudFileHandler &parentFolder,
                                                   const ModifiableCloudFiles &files)
 {
-    Q_UNUSED(parentFolder)
     if (m_requestId != requestId) {
         return;
     }
 
-    m_parent->updateCloudFiles(buildDifference(parentFolder, files));
-    deleteObsoleteLocalFiles(files);
+    parentFolder->setListedUpdatedAt(parentFolder->updatedAt());
+    parentFolder->setListedAt(QDateTime::currentDateTime());
+
+    const auto update = buildDifference(parentFolder, files);
+    m_parent->updateCloudFiles(update);
+    if (m_wasListed && (m_mode != Mode::Refresh)) {
+        deleteObsoleteLocalFiles(update);
+    } else {
+        deleteObsoleteLocalFiles(files);
+    }
+
+    if (m_mode != Mode::Prefetch) {
+        emit childFoldersOutdated(findOutdatedChildFolders(files));
+    }
 
     finish();
 }
@@ -86,41 +102,51 @@ void ListCloudFolderOperation::onCloudListFetchErrorOccurred(CloudFileRequestId
     fail();
 }
 
+bool Self::isCachedListingActual(const CloudFileHandler &listedFolder) const
+{
+    if (listedFolder->isRoot() || isListingChanged(listedFolder, listedFolder->updatedAt())) {
+        return false;
+    }
+    if (m_mode == Mode::Prefetch) {
+        return true;
+    }
+    return listedFolder->listedAt().secsTo(QDateTime::currentDateTime()) < kMaxCachedListingAgeSec;
+}
+
+CloudFiles Self::findOutdatedChildFolders(const ModifiableCloudFiles &files) const
+{
+    CloudFiles folders;
+    for (auto &file : files) {
+        if (!file->isFolder()) {
+            continue;
+        }
+        const auto cachedFile = m_cachedFilesById.value(QString(file->id()));
+        if (!cachedFile || isListingChanged(cachedFile, file->updatedAt())) {
+            folders.push_back(file);
+        }
+    }
+    return folders;
+}
+
 CloudListCloudFolderUpdate ListCloudFolderOperation::buildDifference(const CloudFileHandler &parentFolder,
                                                                      const ModifiableCloudFiles &files) const
 {
     CloudListCloudFolderUpdate update;
     update.parentFolder = parentFolder;
-    auto oldFiles = m_cachedFiles;
-    std::sort(std::begin(oldFiles), std::end(oldFiles), fileIdLess);
-    auto newFiles = files;
-    std::sort(std::begin(newFiles), std::end(newFiles), fileIdLess);
-    const auto oldSize = oldFiles.size();
-    const auto newSize = newFiles.size();
-    size_t oldI = 0;
-    size_t newI = 0;
-    while (oldI < oldSize && newI < newSize) {
-        const auto &oldFile = oldFiles[oldI];
-        const auto &newFile = newFiles[newI];
-        if (fileIdLess(oldFile, newFile)) {
-            update.deleted.push_back(oldFile);
-            ++oldI;
-        } else if (fileIdLess(newFile, oldFile)) {
+    QSet<QString> listedIds;
+    for (auto &newFile : files) {
+        listedIds << QString(newFile->id());
+        const auto oldFile = m_cachedFilesById.value(QString(newFile->id()));
+        if (!oldFile) {
             update.added.push_back(newFile);
-            ++newI;
-        } else {
-            if (fileUpdated(oldFile, newFile)) {
-                update.updated.push_back(newFile);
-            }
-            ++oldI;
-            ++newI;
+        } else if (fileUpdated(oldFile, newFile)) {
+            update.updated.push_back(newFile);
         }
     }
-    if (oldI < oldSize) {
-        update.deleted.insert(update.deleted.end(), oldFiles.begin() + oldI, oldFiles.end());
-    }
-    if (newI < newSize) {
-        update.added.insert(update.added.end(), newFiles.begin() + newI, newFiles.end());
+    for (auto &oldFile : m_cachedFiles) {
+        if (!listedIds.contains(QString(oldFile->id()))) {
+            update.deleted.push_back(oldFile);
+        }
     }
     return update;
 }
@@ -149,37 +175,67 @@ void ListCloudFolderOperation::deleteObsoleteLocalFiles(const ModifiableCloudFil
     }
 }
 
+void ListCloudFolderOperation::deleteObsoleteLocalFiles(const CloudListCloudFolderUpdate &update)
+{
+    for (auto &file : update.deleted) {
+        removeLocalFile(file);
+    }
+    // Renamed files
+    for (auto &file : update.updated) {
+        const auto oldFile = m_cachedFilesById.value(QString(file->id()));
+        if (oldFile && oldFile->localPath().toLower() != file->localPath().toLower()) {
+            removeLocalFile(oldFile);
+        }
+    }
+}
+
 void Self::onDatabaseListFetched(const CloudFileHandler &parentFolder, const ModifiableCloudFiles &cloudFiles)
 {
     if (m_parentFolder->id() != parentFolder->id()) {
         return;
     }
+    // Folder can be fetched by another listing at the same time
+    disconnect(m_userDatabase->cloudFilesTable(), &CloudFilesTable::fetched, this, &Self::onDatabaseListFetched);
 
     m_cachedFiles = cloudFiles;
+    m_wasListed = parentFolder->listedUpdatedAt().isValid();
 
     // Always update local paths
     const QDir parentDir(parentFolder->localPath());
     for (auto &cloudFile : m_cachedFiles) {
         cloudFile->setLocalPath(parentDir.filePath(cloudFile->name()));
+        m_cachedFilesById.insert(QString(cloudFile->id()), cloudFile);
     }
 
-    CachedListCloudFolderUpdate update;
-    update.parentFolder = parentFolder;
-    update.files = m_cachedFiles;
-    m_parent->updateCloudFiles(update);
+    if (m_mode != Mode::Prefetch) {
+        CachedListCloudFolderUpdate update;
+        update.parentFolder = parentFolder;
+        update.files = m_cachedFiles;
+        m_parent->updateCloudFiles(update);
+    }
 
-    if (m_parent->messenger()->isOnline()) {
+    if ((m_mode != Mode::Refresh) && isCachedListingActual(parentFolder)) {
+        qCDebug(lcOperation) << "Cloud folder is not changed, online listing is skipped:" << parentFolder->name();
+        if (m_mode != Mode::Prefetch) {
+            emit childFoldersOutdated(findOutdatedChildFolders(m_cachedFiles));
+        }
+        finish();
+    } else if (m_parent->messenger()->isOnline()) {
         m_requestId = m_parent->cloudFileSystem()->fetchList(m_parentFolder);
     } else {
         qCDebug(lcOperation) << "Network is offline";
-        emit onlineListingFailed();
+        if (m_mode != Mode::Prefetch) {
+            emit onlineListingFailed();
+        }
         fail();
     }
 }
 
-bool Self::fileIdLess(const ModifiableCloudFileHandler &lhs, const ModifiableCloudFileHandler &rhs)
+bool Self::isListingChanged(const CloudFileHandler &listedFolder, const QDateTime &updatedAt)
 {
-    return lhs->id() < rhs->id();
+    // Dates are stored in seconds
+    const auto listedUpdatedAt = listedFolder->listedUpdatedAt();
+    return !listedUpdatedAt.isValid() || (listedUpdatedAt.toTime_t() != updatedAt.toTime_t());
 }
 
 bool Self::fileUpdated(const ModifiableCloudFileHandler &lhs, const ModifiableCloudFileHandler &rhs)
@@ -188,3 +244,12 @@ bool Self::fileUpdated(const ModifiableCloudFileHandler &lhs, const ModifiableCl
     // TODO(fpohtmeh): revert localPath comparision once we remove DB column for it
     return lhs->updatedAt() < rhs->updatedAt() || lhs->localPath() != rhs->localPath();
 }
+
+void Self::removeLocalFile(const CloudFileHandler &file)
+{
+    if (file->isFolder()) {
+        FileUtils::removeDir(file->localPath());
+    } else {
+        FileUtils::removeFile(file->localPath());
+    }
+}
@@ -63,3 +63,21 @@ void NetworkOperation::setIsOnline(bool isOnline)
     m_isOnline = isOnline;
     preRun();
 }
+
+TransferPriority NetworkOperation::transferPriority() const
+{
+    if (m_transferPriority) {
+        return *m_transferPriority;
+    }
+
+    if (auto parentOp = dynamic_cast<const NetworkOperation *>(parent())) {
+        return parentOp->transferPriority();
+    }
+
+    return TransferPriority::Interactive;
+}
+
+void NetworkOperation::setTransferPriority(TransferPriority priority)
+{
+    m_transferPriority = priority;
+}
@@ -34,7 +34,9 @@
 
 #include "operations/Operation.h"
 
+#include "OperationMonitor.h"
 #include "TimeProfiler.h"
+#include "Tracer.h"
 
 #include <QEventLoop>
 
@@ -46,6 +48,9 @@ Operation::Operation(const QString &name, QObject *parent) : QObject(parent), m_
 
 Operation::~Operation()
 {
+    if (m_monitor) {
+        m_monitor->onDestroyed(this);
+    }
     cleanupOnce();
 }
 
@@ -69,6 +74,7 @@ void Operation::stop()
     if (!m_children.empty()) {
         m_children.front()->stop();
     } else if (m_status == Status::Started) {
+        m_failureReason = QLatin1String("Stopped");
         fail();
     }
     qCDebug(lcOperation) << "Stopped operation:" << this;
@@ -131,6 +137,32 @@ Operation::Status Operation::status() const
     return m_status;
 }
 
+QString Operation::type() const
+{
+    if (metaObject() == &Operation::staticMetaObject) {
+        return name();
+    }
+    return QString::fromLatin1(metaObject()->className()).section(QLatin1String("::"), -1);
+}
+
+QString Operation::failureReason() const
+{
+    return m_failureReason;
+}
+
+QString Operation::failedOperationType() const
+{
+    return m_failedOperationType.isEmpty() ? type() : m_failedOperationType;
+}
+
+void Operation::setMonitor(OperationMonitor *monitor)
+{
+    m_monitor = monitor;
+    for (auto child : m_children) {
+        child->setMonitor(monitor);
+    }
+}
+
 void Operation::appendChild(Operation *child)
 {
     connectChild(child);
@@ -151,6 +183,7 @@ void Operation::fail()
 
 void Operation::failAndNotify(const QString &notification)
 {
+    m_failureReason = notification;
     fail();
     emit notificationCreated(notification, true);
 }
@@ -163,6 +196,7 @@ void Operation::invalidate()
 
 void Operation::invalidateAndNotify(const QString &notification)
 {
+    m_failureReason = notification;
     invalidate();
     emit notificationCreated(notification, true);
 }
@@ -224,8 +258,11 @@ void Operation::connectChild(Operation *child)
     if (m_timeProfiler) {
         child->setTimeProfiler(m_timeProfiler);
     }
-    connect(child, &Operation::failed, this, &Operation::fail);
-    connect(child, &Operation::invalidated, this, &Operation::invalidate);
+    if (m_monitor) {
+        child->setMonitor(m_monitor);
+    }
+    connect(child, &Operation::failed, this, [this, child]() { onChildFailed(child); });
+    connect(child, &Operation::invalidated, this, [this, child]() { onChildInvalidated(child); });
     connect(child, &Operation::finished, this, &Operation::startNextChild);
     connect(child, &Operation::notificationCreated, this, &Operation::notificationCreated);
 }
@@ -245,6 +282,9 @@ bool Operation::setStatus(const Operation::Status &status)
             return false;
         }
         m_status = status;
+        m_failureReason.clear();
+        m_failedOperationType.clear();
+        reportStatus(status);
         emit started();
         return true;
     case Status::Failed:
@@ -253,6 +293,7 @@ bool Operation::setStatus(const Operation::Status &status)
             return false;
         }
         m_status = status;
+        reportStatus(status);
         emit failed();
         return true;
     case Status::Invalid:
@@ -261,6 +302,7 @@ bool Operation::setStatus(const Operation::Status &status)
             return false;
         }
         m_status = status;
+        reportStatus(status);
         emit invalidated();
         return true;
     case Status::Finished:
@@ -269,6 +311,7 @@ bool Operation::setStatus(const Operation::Status &status)
             return false;
         }
         m_status = status;
+        reportStatus(status);
         emit finished();
         return true;
     default:
@@ -276,6 +319,56 @@ bool Operation::setStatus(const Operation::Status &status)
     }
 }
 
+void Operation::reportStatus(const Status &status)
+{
+    traceStatus(status);
+    if (m_monitor) {
+        m_monitor->onStatusChanged(this, status);
+    }
+}
+
+void Operation::traceStatus(const Status &status)
+{
+    auto tracer = Tracer::instance();
+    if (!tracer->isEnabled()) {
+        return;
+    }
+
+    //
+    //  Operation span covers the time from start till the final status, even across threads.
+    //
+    const auto spanId = reinterpret_cast<quintptr>(this);
+    if (status == Status::Started) {
+        m_traceName = fullName();
+        tracer->beginAsyncSpan("operation", m_traceName, spanId);
+    } else if (!m_traceName.isEmpty()) {
+        const auto statusName = (status == Status::Finished) ? "finished"
+                : (status == Status::Failed)                 ? "failed"
+                                                             : "invalid";
+        tracer->endAsyncSpan("operation", m_traceName, spanId, { { "status", QLatin1String(statusName) } });
+        m_traceName.clear();
+    }
+}
+
+void Operation::onChildFailed(Operation *child)
+{
+    setChildFailureReason(child);
+    fail();
+}
+
+void Operation::onChildInvalidated(Operation *child)
+{
+    setChildFailureReason(child);
+    invalidate();
+}
+
+void Operation::setChildFailureReason(Operation *child)
+{
+    const auto childReason = child->failureReason();
+    m_failureReason = childReason.isEmpty() ? child->type() : (child->type() + QLatin1String(": ") + childReason);
+    m_failedOperationType = child->failedOperationType();
+}
+
 void Operation::startNextChild()
 {
     // Drop used children
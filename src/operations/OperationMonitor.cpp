@@ -0,0 +1,173 @@
+//  Copyright (C) 2015-2021 Virgil Security, Inc.
+//
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//      (1) Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the following disclaimer.
+//
+//      (2) Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in
+//      the documentation and/or other materials provided with the
+//      distribution.
+//
+//      (3) Neither the name of the copyright holder nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+//  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+//  IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+//  Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+
+
+#include "operations/OperationMonitor.h"
+
+#include "Metrics.h"
+
+Q_LOGGING_CATEGORY(lcOperationMonitor, "operation-monitor");
+
+using namespace vm;
+using Self = OperationMonitor;
+
+Self::OperationMonitor(const QString &queueName) : m_queueName(queueName) { }
+
+void Self::onStatusChanged(Operation *operation, Operation::Status status)
+{
+    QMutexLocker locker(&m_mutex);
+    if (status == Operation::Status::Started) {
+        auto &running = m_running[operation];
+        running.type = operation->type();
+        running.fullName = operation->fullName();
+        running.timer.start();
+        running.isStuck = false;
+        running.isCancelled = false;
+        return;
+    }
+
+    const auto it = m_running.find(operation);
+    if (it == m_running.end()) {
+        return;
+    }
+    const auto running = std::move(it->second);
+    m_running.erase(it);
+
+    auto &metrics = typeMetrics(running.type);
+    metrics.runTime->record(static_cast<quint64>(running.timer.nsecsElapsed() / 1000));
+    if (status == Operation::Status::Finished) {
+        metrics.finished->increment();
+        return;
+    }
+    if (status == Operation::Status::Failed) {
+        metrics.failed->increment();
+    } else {
+        metrics.invalid->increment();
+    }
+    if (running.isCancelled) {
+        recordFailureReason(running.type, QStringLiteral("cancelled_stuck"), QStringLiteral("Cancelled as stuck"));
+    } else {
+        recordFailureReason(running.type, failureReasonCode(operation), operation->failureReason());
+    }
+}
+
+void Self::onDestroyed(Operation *operation)
+{
+    QMutexLocker locker(&m_mutex);
+    m_running.erase(operation);
+}
+
+void Self::recordRetry(const QString &operationType, const QString &reasonCode, const QString &reason)
+{
+    qCInfo(lcOperationMonitor).noquote() << "Retry" << operationType << "of" << m_queueName << "failed by"
+                                         << reasonCode << "with reason:" << reason;
+    Metrics::instance()
+            ->counter("operation_retry_reasons_total",
+                      { { "queue", m_queueName }, { "operation", operationType }, { "reason", reasonCode } })
+            ->increment();
+}
+
+QString Self::failureReasonCode(const Operation *operation)
+{
+    const auto reason = operation->failureReason();
+    if (reason == QLatin1String("Stopped") || reason.endsWith(QLatin1String(": Stopped"))) {
+        return QStringLiteral("stopped");
+    }
+    return operation->failedOperationType();
+}
+
+void Self::checkStuckOperations(const DeadlineFunction &deadline, bool cancel)
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto &[operation, running] : m_running) {
+        if (running.isStuck) {
+            continue;
+        }
+        const auto typeDeadline = deadline(running.type);
+        if (typeDeadline.count() <= 0 || running.timer.elapsed() < typeDeadline.count()) {
+            continue;
+        }
+        running.isStuck = true;
+        auto &metrics = typeMetrics(running.type);
+        metrics.stuck->increment();
+        qCWarning(lcOperationMonitor).noquote() << "Operation" << running.fullName << "is started for"
+                                                << running.timer.elapsed() << "ms, deadline is"
+                                                << typeDeadline.count() << "ms";
+        if (!cancel) {
+            continue;
+        }
+        //
+        //  Operation lives in the thread of the queue pool and removes itself from the running list
+        //  under the same mutex on destruction, so it is alive while the stop is posted to its thread.
+        //
+        running.isCancelled = true;
+        metrics.cancelled->increment();
+        auto op = operation;
+        QMetaObject::invokeMethod(op, [op]() { op->stop(); }, Qt::QueuedConnection);
+    }
+}
+
+Self::TypeMetrics &Self::typeMetrics(const QString &type)
+{
+    auto it = m_typeMetrics.find(type);
+    if (it != m_typeMetrics.end()) {
+        return it->second;
+    }
+
+    auto metrics = Metrics::instance();
+    const Metrics::Labels labels { { "queue", m_queueName }, { "operation", type } };
+    const auto statusLabels = [&labels](const char *status) {
+        auto result = labels;
+        result.insert(QLatin1String("status"), QLatin1String(status));
+        return result;
+    };
+    TypeMetrics typeMetrics;
+    typeMetrics.runTime = metrics->histogram("operation_run_microseconds", labels);
+    typeMetrics.finished = metrics->counter("operation_status_total", statusLabels("finished"));
+    typeMetrics.failed = metrics->counter("operation_status_total", statusLabels("failed"));
+    typeMetrics.invalid = metrics->counter("operation_status_total", statusLabels("invalid"));
+    typeMetrics.stuck = metrics->counter("operation_stuck_total", labels);
+    typeMetrics.cancelled = metrics->counter("operation_stuck_cancelled_total", labels);
+    return m_typeMetrics.emplace(type, typeMetrics).first->second;
+}
+
+void Self::recordFailureReason(const QString &type, const QString &reasonCode, const QString &reason)
+{
+    qCDebug(lcOperationMonitor).noquote() << "Operation" << type << "of" << m_queueName << "failed by" << reasonCode
+                                          << "with reason:" << reason;
+    Metrics::instance()
+            ->counter("operation_failure_reasons_total",
+                      { { "queue", m_queueName }, { "operation", type }, { "reason", reasonCode } })
+            ->increment();
+}
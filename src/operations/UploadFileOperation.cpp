@@ -65,6 +65,11 @@ void Self::run()
     m_fileLoader->requestUploadSlot(m_requestId, filePath());
 }
 
+void Self::prefetchUploadSlot(qint64 sourceFileSize)
+{
+    m_fileLoader->prefetchUploadSlot(m_requestId, sourceFileSize);
+}
+
 void UploadFileOperation::startUploadToSlot(const QUrl &putUrl, const QUrl &getUrl)
 {
     m_putUrl = putUrl;
@@ -79,9 +84,16 @@ void Self::connectReply(QNetworkReply *reply)
     connect(reply, &QNetworkReply::uploadProgress, this, &LoadFileOperation::setProgress);
 }
 
+void Self::cleanup()
+{
+    LoadFileOperation::cleanup();
+    m_fileLoader->releaseUploadSlot(m_requestId);
+}
+
 void Self::startUpload()
 {
-    m_fileLoader->startUpload(m_putUrl, fileHandle(), std::bind(&Self::connectReply, this, std::placeholders::_1));
+    m_fileLoader->startUpload(m_putUrl, fileHandle(), transferPriority(),
+                              std::bind(&Self::connectReply, this, std::placeholders::_1));
 }
 
 void Self::onSlotRequestFinished(const QString &requestId, const QString &slotId)
@@ -42,8 +42,15 @@ Item {
         interactive: true
         boundsBehavior: Flickable.DragOverBounds
 
-        onCountChanged: chatList.countChangedController()
-        onContentYChanged: chatList.autoFlickToBottomController()
+        onCountChanged: {
+            chatList.countChangedController()
+            visibleRangeTimer.restart()
+        }
+        onContentYChanged: {
+            chatList.autoFlickToBottomController()
+            visibleRangeTimer.restart()
+        }
+        onHeightChanged: visibleRangeTimer.restart()
 
         ScrollBar.vertical: MessageListViewScrollBar {}
 
@@ -82,6 +89,13 @@ Item {
 
     MessagesFlickToBottomButton {}
 
+    Timer {
+        id: visibleRangeTimer
+        interval: 150
+        repeat: false
+        onTriggered: chatList.reportVisibleRange()
+    }
+
     // OTHER
     Component {
         id: messageDelegate
@@ -123,6 +137,30 @@ Item {
     QtObject {
         id: chatList
 
+        function rowAt(y) {
+            const x = messagesListView.width / 2
+            let row = messagesListView.indexAt(x, y)
+            if (row === -1) {
+                row = messagesListView.indexAt(x, y + messagesListView.spacing)
+            }
+            return row
+        }
+
+        function reportVisibleRange() {
+            if (messagesListView.count === 0) {
+                return
+            }
+            let topRow = rowAt(messagesListView.contentY)
+            let bottomRow = rowAt(messagesListView.contentY + messagesListView.height - 1)
+            if (topRow === -1) {
+                topRow = messagesListView.count - 1
+            }
+            if (bottomRow === -1) {
+                bottomRow = 0
+            }
+            models.messages.setVisibleRange(Math.min(topRow, bottomRow), Math.max(topRow, bottomRow))
+        }
+
         function init() {
             isReady = true
             flick.setBotomContentY()
@@ -0,0 +1,5 @@
+ALTER TABLE cloudFiles
+ADD COLUMN listedUpdatedAt INT;
+
+ALTER TABLE cloudFiles
+ADD COLUMN listedAt INT
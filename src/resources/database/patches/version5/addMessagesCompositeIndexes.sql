@@ -0,0 +1,7 @@
+DROP INDEX IF EXISTS messagesIdxChatId;
+
+CREATE INDEX messagesIdxChatIdCreatedAt ON messages(chatId, createdAt);
+
+CREATE INDEX messagesIdxChatIdStage ON messages(chatId, stage);
+
+CREATE INDEX messagesIdxIsOutgoingStageCreatedAt ON messages(isOutgoing, stage, createdAt)
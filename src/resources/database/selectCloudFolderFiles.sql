@@ -12,7 +12,9 @@ SELECT
     publicKey AS cloudFilePublicKey,
     localPath AS cloudFileLocalPath,
     fingerprint AS cloudFileFingerprint,
-    sharedGroupId AS cloudFileSharedGroupId
+    sharedGroupId AS cloudFileSharedGroupId,
+    listedUpdatedAt AS cloudFileListedUpdatedAt,
+    listedAt AS cloudFileListedAt
 FROM
     cloudFiles
 WHERE
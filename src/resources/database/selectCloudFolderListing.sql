@@ -0,0 +1,7 @@
+SELECT
+    listedUpdatedAt AS cloudFileListedUpdatedAt,
+    listedAt AS cloudFileListedAt
+FROM
+    cloudFiles
+WHERE
+    cloudFiles.id = :folderId
@@ -0,0 +1,22 @@
+SELECT
+    messages.id AS messageId,
+    messages.recipientId AS messageRecipientId,
+    messages.senderId AS messageSenderId,
+    messages.chatId AS messageChatId,
+    messages.createdAt AS messageCreatedAt,
+    messages.isOutgoing AS messageIsOutgoing,
+    messages.stage AS messageStage,
+    messages.contentType as messageContentType,
+    messages.body AS messageBody,
+    messages.ciphertext AS messageCiphertext,
+    chats.type AS messageChatType,
+    senderContacts.username as messageSenderUsername,
+    recipientContacts.username as messageRecipientUsername
+FROM messages
+INNER JOIN chats ON chats.id = messages.chatId
+LEFT JOIN contacts  AS senderContacts ON senderContacts.userId = messages.senderId
+LEFT JOIN contacts  AS recipientContacts ON recipientContacts.userId = messages.recipientId
+WHERE messages.isOutgoing = 0
+    AND messages.stage = "received"
+    AND messages.contentType = "encrypted"
+ORDER BY messages.senderId, messages.createdAt
@@ -0,0 +1,5 @@
+UPDATE cloudFiles
+SET
+    listedUpdatedAt = :listedUpdatedAt,
+    listedAt = :listedAt
+WHERE id = :id
@@ -0,0 +1,3 @@
+UPDATE messages
+SET stage = :stage, contentType = :contentType, body = :body, ciphertext = NULL
+WHERE id = :id AND isOutgoing = 0 AND contentType = "encrypted"
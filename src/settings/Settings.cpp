@@ -59,6 +59,23 @@ static const QString kChatListLandscapeWidth = "ChatListLandscapeWidth";
 static const QString kSessionId = "SessionId";
 static const QString kSignedInUsername = "SignedInUsername";
 
+static const QString kFeaturesGroup = "Features";
+static const QString kCompactMessageEnvelope = "CompactMessageEnvelope";
+static const QString kMessageCompressionThreshold = "MessageCompressionThreshold";
+static const QString kMaxTransfersPerHost = "MaxTransfersPerHost";
+static const QString kHttp2Transfers = "Http2Transfers";
+static const QString kInteractiveTransferRateLimit = "InteractiveTransferRateLimit";
+static const QString kPreloadTransferRateLimit = "PreloadTransferRateLimit";
+static const QString kBackgroundTransferRateLimit = "BackgroundTransferRateLimit";
+static const QString kGlobalTransferRateLimit = "GlobalTransferRateLimit";
+static const QString kTracing = "Tracing";
+static const QString kMetricsDumpInterval = "MetricsDumpInterval";
+static const QString kMetricsPort = "MetricsPort";
+static const QString kDatabaseProfiling = "DatabaseProfiling";
+static const QString kSlowQueryThreshold = "SlowQueryThreshold";
+static const QString kTimeToChatListTarget = "TimeToChatListTarget";
+static const QString kCancelStuckOperations = "CancelStuckOperations";
+
 using namespace vm;
 using namespace platform;
 
@@ -302,6 +319,81 @@ bool Settings::timeProfilerEnabled() const
     return false;
 }
 
+bool Settings::tracingEnabled() const
+{
+    return groupValue(kFeaturesGroup, kTracing, false).toBool();
+}
+
+std::chrono::seconds Settings::metricsDumpInterval() const
+{
+    return std::chrono::seconds(qMax(0, groupValue(kFeaturesGroup, kMetricsDumpInterval, 0).toInt()));
+}
+
+quint16 Settings::metricsPort() const
+{
+    return static_cast<quint16>(groupValue(kFeaturesGroup, kMetricsPort, 0).toUInt());
+}
+
+bool Settings::databaseProfilingEnabled() const
+{
+    return groupValue(kFeaturesGroup, kDatabaseProfiling, false).toBool();
+}
+
+std::chrono::milliseconds Settings::slowQueryThreshold() const
+{
+    return std::chrono::milliseconds(qMax(0, groupValue(kFeaturesGroup, kSlowQueryThreshold, 100).toInt()));
+}
+
+std::chrono::milliseconds Settings::timeToChatListTarget() const
+{
+    return std::chrono::milliseconds(qMax(0, groupValue(kFeaturesGroup, kTimeToChatListTarget, 2000).toInt()));
+}
+
+bool Settings::cancelStuckOperationsEnabled() const
+{
+    return groupValue(kFeaturesGroup, kCancelStuckOperations, false).toBool();
+}
+
+bool Settings::compactMessageEnvelopeEnabled() const
+{
+    return groupValue(kFeaturesGroup, kCompactMessageEnvelope, false).toBool();
+}
+
+int Settings::messageCompressionThreshold() const
+{
+    return groupValue(kFeaturesGroup, kMessageCompressionThreshold, 1024).toInt();
+}
+
+int Settings::maxTransfersPerHost() const
+{
+    return qMax(1, groupValue(kFeaturesGroup, kMaxTransfersPerHost, 4).toInt());
+}
+
+bool Settings::http2TransfersEnabled() const
+{
+    return groupValue(kFeaturesGroup, kHttp2Transfers, true).toBool();
+}
+
+qint64 Settings::interactiveTransferRateLimit() const
+{
+    return groupValue(kFeaturesGroup, kInteractiveTransferRateLimit, 0).toLongLong();
+}
+
+qint64 Settings::preloadTransferRateLimit() const
+{
+    return groupValue(kFeaturesGroup, kPreloadTransferRateLimit, 0).toLongLong();
+}
+
+qint64 Settings::backgroundTransferRateLimit() const
+{
+    return groupValue(kFeaturesGroup, kBackgroundTransferRateLimit, 0).toLongLong();
+}
+
+qint64 Settings::globalTransferRateLimit() const
+{
+    return groupValue(kFeaturesGroup, kGlobalTransferRateLimit, 0).toLongLong();
+}
+
 QRect Settings::windowGeometry() const
 {
     return groupValue(kLastSessionGroup, kWindowGeometryId).toRect();